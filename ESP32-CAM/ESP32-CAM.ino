@@ -2,33 +2,69 @@
 #include "esp_init.h"
 #include "host.h"
 #include "client.h"
+#include "pipeline.h"
+#include "metrics.h"
+#include "control.h"
+#include "boot.h"
+#include "duty_cycle.h"
 #include <Arduino.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <esp_system.h>
 
 const char *CONFIG_FILE_PATH = "/config.json";
 esp_config_t esp_config;
-int counter = 0;
 
+/*
+  Boot sequence (boot.h): straight to capturing with a stored config, the portal
+  only on demand or when the config does not get the device online.
+*/
+static boot_t boot;
+static wifi_ap_cache_t ap_cache;
+static bool wifi_connected = false;
+static bool control_started = false;
 
 /*
- * ------------------------------------------------------------------------------
- * PROGRAM START
- * ------------------------------------------------------------------------------
+  Deep sleep between frames (duty_cycle.h). Only the RTC memory survives the sleep,
+  duty_state holds what the next wake needs to be quick.
 */
-void setup() {
-  Serial.begin(115200);
-  Serial.setDebugOutput(true);
-  Serial.println();
-  delay(200);
+RTC_DATA_ATTR static duty_state_t duty_state;
+static const duty_power_t duty_power = DUTY_POWER_DEFAULT;
 
-  Serial.println("------ ESP STARTED ------");
+/*
+  Resetting the device twice within DOUBLE_RESET_WINDOW_MS opens the portal.
+  The flag file marks a boot that has not lived that long yet.
+*/
+#define DOUBLE_RESET_FILE "/double_reset"
+#define DOUBLE_RESET_WINDOW_MS 3000
+static bool double_reset_armed = false;
 
-  strlcpy(esp_config.CONFIG_FILE, CONFIG_FILE_PATH, sizeof(esp_config.CONFIG_FILE));
+static bool portalRequestedByDoubleReset() {
+  /* a brownout right after power-up is not someone pressing reset */
+  bool requested = esp_reset_reason() != ESP_RST_BROWNOUT && halFsExists(DOUBLE_RESET_FILE);
+  if (requested) {
+    halFsRemove(DOUBLE_RESET_FILE);
+  } else {
+    double_reset_armed = halFsWriteFile(DOUBLE_RESET_FILE, (const uint8_t *)"1", 1);
+  }
+  return requested;
+}
 
-  /*
-    ESP opens WiFi access point to receive the configuration from user input
+/* this boot lived long enough: the next reset is a single one */
+static void disarmDoubleReset() {
+  if (double_reset_armed && millis() > DOUBLE_RESET_WINDOW_MS) {
+    double_reset_armed = false;
+    halFsRemove(DOUBLE_RESET_FILE);
+  }
+}
 
+static void openPortal() {
+  if (portalOpen()) {
+    return;
+  }
+  /*
     Once connected go to:
-    
+
           ==============================
           ===== http://192.168.4.1 ===== -> ESP softAP() endpoint
           ==============================
@@ -38,85 +74,276 @@ void setup() {
   Serial.println("[ESP] OPENING ACCESS POINT");
   Serial.println("------ Connect on http://192.168.4.1 to configure ------");
   setupAccessPoint();
+}
 
+static void runBootActions(uint32_t actions) {
+  if (actions & BOOT_DO_OPEN_PORTAL) {
+    openPortal();
+  }
+  if (actions & BOOT_DO_FORGET_AP) {
+    Serial.println("---- cached access point did not answer, scanning");
+    forgetWifiApCache();
+  }
+  if (actions & BOOT_DO_CONNECT_FAST) {
+    startWifiConnection(&esp_config.wifi_config, &ap_cache);
+  }
+  if (actions & BOOT_DO_CONNECT_SCAN) {
+    startWifiConnection(&esp_config.wifi_config, NULL);
+  }
+  if (actions & BOOT_DO_SAVE_AP) {
+    Serial.printf("---- Connected. IP: %s\n", WiFi.localIP().toString().c_str());
+    metricsMarkBoot(BOOT_MARK_WIFI, millis());
+    saveWifiApCache(esp_config.wifi_config.SSID);
+    tuneWifiForLatency();
+  }
+  if (actions & BOOT_DO_START_NTP) {
+    startTimeSync();
+  }
+  if (actions & BOOT_DO_START_PIPELINE) {
+    Serial.println("STARTING CAMERA STREAM");
+    /* capture and upload run in their own tasks from here on; numbering goes on after a deep sleep */
+    startPipeline(&esp_config, duty_state.sequence);
+  }
 
-  Serial.println("[ESP] INITIALIZING ESP");
+  /* camera settings can be changed from here on without a restart (control.h) */
+  if (!control_started && boot.pipeline_started && wifi_connected) {
+    control_started = true;
+    startControlServer(&esp_config);
+  }
+}
 
-  if (!loadConfig(&esp_config)) {
-    Serial.println("-- Failed to configure ESP");
+/*
+  Boot actions of a deep sleep wake: only the connect. The access point goes into RTC
+  memory (the flash copy is only rewritten when it changed), NTP is only asked when
+  the clock is unset or has drifted for DUTY_TIME_SYNC_MS. No portal and no pipeline
+  tasks, the frame is taken by runDutyCycle().
+*/
+static void runDutyBootActions(uint32_t actions) {
+  if (actions & BOOT_DO_FORGET_AP) {
+    Serial.println("---- cached access point did not answer, scanning");
+    duty_state.channel = 0;
+  }
+  if (actions & BOOT_DO_CONNECT_FAST) {
+    startWifiConnection(&esp_config.wifi_config, &ap_cache);
+  }
+  if (actions & BOOT_DO_CONNECT_SCAN) {
+    startWifiConnection(&esp_config.wifi_config, NULL);
   }
+  if (actions & BOOT_DO_SAVE_AP) {
+    Serial.printf("---- Connected. IP: %s\n", WiFi.localIP().toString().c_str());
+    metricsMarkBoot(BOOT_MARK_WIFI, millis());
+    if (duty_state.channel != WiFi.channel() || memcmp(duty_state.bssid, WiFi.BSSID(), sizeof(duty_state.bssid)) != 0) {
+      memcpy(duty_state.bssid, WiFi.BSSID(), sizeof(duty_state.bssid));
+      duty_state.channel = (uint8_t)WiFi.channel();
+      saveWifiApCache(esp_config.wifi_config.SSID);
+    }
+  }
+  if (actions & BOOT_DO_START_NTP) {
+    struct tm now;
+    uint32_t clock = dutyNow(&duty_state, millis());
+    if (dutyTimeSyncDue(&duty_state, halLocalTime(&now, 0), clock)) {
+      duty_state.time_sync_ms = clock;
+      startTimeSync();
+    }
+  }
+}
 
-  /*
-    initialization of ESP + cam
-  */
-  initEspPinout();
-  initEspCamera(esp_config.RESOLUTION);
-  configure_camera_sensor(&esp_config);
+/* feeds the Wi-Fi state into the boot sequence */
+static void pollBoot(bool duty_wake) {
+  disarmDoubleReset();
 
-  Serial.printf("[ESP] CONFIGURING WIFI CONNECTION TO %s\n", esp_config.wifi_config.SSID);
-  setupWifiConnection(&esp_config.wifi_config);
+  bool connected = WiFi.status() == WL_CONNECTED;
+  boot_event_t event = connected == wifi_connected ? BOOT_EVENT_TICK
+                     : connected ? BOOT_EVENT_CONNECTED : BOOT_EVENT_DISCONNECTED;
+  wifi_connected = connected;
+  boot_state_t before = boot.state;
 
-  Serial.println("[ESP] SETUP COMPLETE");
-  Serial.println("");
-  Serial.println("---------------------");
-  Serial.println("");
-  Serial.println("STARTING CAMERA STREAM");
+  uint32_t actions = bootStep(&boot, event, millis());
+  if (duty_wake) {
+    runDutyBootActions(actions);
+  } else {
+    runBootActions(actions);
+  }
+  if (boot.state != before) {
+    Serial.printf("[BOOT] %s -> %s\n", bootStateName(before), bootStateName(boot.state));
+  }
 }
 
+/* the sleep ends this boot; the next wake starts over in setup() */
+static void sleepUntilNextCapture(uint32_t capture_ms, uint32_t delay_ms) {
+  /* a power-on boot still counts a second reset within the window */
+  while (double_reset_armed && millis() <= DOUBLE_RESET_WINDOW_MS) {
+    delay(10);
+  }
+  disarmDoubleReset();
 
-void loop() {
+  sleepEspCamera();
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
 
-  Serial.println("");
-  Serial.printf("-- Trying to capture and post image number %d\n", counter++);
+  uint32_t awake_ms = millis();
+  uint32_t sleep_ms = dutyEndWake(&duty_state, capture_ms, awake_ms, delay_ms);
+  dutyStateSeal(&duty_state);
 
-  int httpCode = postImage(esp_config.UPLOAD_URL);
-  if (httpCode == -1) {
-    Serial.println("---- Camera error. Could not capture image");
-    return;
-  } else if (httpCode == -2) {
-    Serial.println("---- Network error. Could not start the host connection");
-    return;
-  }  else if (httpCode == -3) {
-    Serial.println("---- Data error. Could not send the complete image");
-    return;
-  } else if (httpCode == -4) {
-    Serial.println("---- HTTP error. Invalid or missing HTTP response");
-    return;
+  Serial.printf("[POWER] awake %lu ms (average %lu ms), sleeping %lu ms\n", (unsigned long)awake_ms,
+                (unsigned long)dutyWakeCost(&duty_state), (unsigned long)sleep_ms);
+  Serial.flush();
+  esp_sleep_enable_timer_wakeup((uint64_t)sleep_ms * 1000ULL);
+  esp_deep_sleep_start();
+}
+
+/*
+  One frame per wake: Wi-Fi connects to the access point kept in RTC memory (no scan)
+  while the camera starts and captures, then the frame is uploaded over the resumed
+  TLS session and the device sleeps until the next frame is due. Does not return.
+*/
+static void runDutyCycle() {
+  Serial.printf("[POWER] deep sleep between frames, wake %lu, frame %lu\n",
+                (unsigned long)duty_state.wakes, (unsigned long)duty_state.sequence);
+
+  bool ap_cached = duty_state.channel != 0;
+  if (ap_cached) {
+    memcpy(ap_cache.bssid, duty_state.bssid, sizeof(ap_cache.bssid));
+    ap_cache.channel = duty_state.channel;
+    strlcpy(ap_cache.ssid, esp_config.wifi_config.SSID, sizeof(ap_cache.ssid));
+  } else {
+    ap_cached = loadWifiApCache(esp_config.wifi_config.SSID, &ap_cache);
   }
+  runDutyBootActions(bootInit(&boot, true, false, ap_cached, millis()));
 
-  Serial.printf("---- %s responded with status: %d\n", esp_config.UPLOAD_URL, httpCode);
+  loadUploadTrust();
+  setChunkedUpload(esp_config.CHUNKED_UPLOAD);
+  if (duty_state.session_len > 0 && !halUploadTransport()->loadSession(duty_state.session, duty_state.session_len)) {
+    Serial.println("---- TLS session from before the sleep not usable, full handshake");
+  }
 
-  switch (httpCode) {
-    case 200:
-    case 201:
-        Serial.println("------ Success");
-        break;
+  int queue_depth = 1, batch_size = 1;
+  initEspPinout();
+  initEspCamera(&esp_config, &queue_depth, &batch_size);
+  configure_camera_sensor(&esp_config);
+  uint32_t capture_ms = 0;
+  camera_fb_t *fb = pipelineCaptureWake(&esp_config, &duty_state, &capture_ms);
 
-    case 400:
-        Serial.println("------ Bad Request");
-        break;
+  /* gives up after BOOT_FAST_CONNECT_MS + BOOT_SCAN_CONNECT_MS at most */
+  while (boot.state == BOOT_WIFI_FAST || boot.state == BOOT_WIFI_SCAN) {
+    pollBoot(true);
+    delay(10);
+  }
+  bool online = boot.state == BOOT_RUN;
+  uint32_t delay_ms = pipelineUploadWake(fb, online, &duty_state);
 
-    case 401:
-    case 403:
-        Serial.println("------ Unauthorized or Forbidden");
-        break;
+  if (online) {
+    duty_state.offline_wakes = 0;
+    duty_state.session_len = halUploadTransport()->saveSession(duty_state.session, sizeof(duty_state.session));
+  } else {
+    duty_state.offline_wakes++;
+  }
+  sleepUntilNextCapture(capture_ms, delay_ms);
+}
 
-    case 404:
-        Serial.println("------ URL Not Found");
-        break;
+/*
+ * ------------------------------------------------------------------------------
+ * PROGRAM START
+ * ------------------------------------------------------------------------------
+*/
+void setup() {
+  Serial.begin(115200);
+  Serial.setDebugOutput(true);
+  Serial.println();
 
-    case 500:
-    case 502:
-    case 503:
-        Serial.println("------ Server-side error");
-        break;
+  Serial.println("------ ESP STARTED ------");
 
-    default:
-        Serial.printf("------ Unexpected response code: %d\n", httpCode);
-        break;
+  strlcpy(esp_config.CONFIG_FILE, CONFIG_FILE_PATH, sizeof(esp_config.CONFIG_FILE));
+
+  Serial.println("[ESP] INITIALIZING ESP");
+  bool config_ok = loadConfig(&esp_config);
+  metricsMarkBoot(BOOT_MARK_CONFIG, millis());
+
+  /* a timer wake is not someone pressing reset, and must not write the flash every frame */
+  bool timer_wake = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+  bool portal_requested = !timer_wake && portalRequestedByDoubleReset();
+
+  uint32_t config_crc = dutyConfigCrc(esp_config.wifi_config.SSID, esp_config.UPLOAD_URL);
+  if (!timer_wake || !dutyStateValid(&duty_state, config_crc)) {
+    dutyStateInit(&duty_state, config_crc, esp_config.CAMERA.value[CAMERA_SET_INTERVAL]);
+  }
+  power_mode_t power_mode = POWER_ALWAYS_ON;
+  if (config_ok && !portal_requested) {
+    power_mode = dutyChooseMode(esp_config.POWER_MODE, timer_wake, &duty_power, esp_config.CAMERA.value[CAMERA_SET_INTERVAL],
+                                dutyWakeCost(&duty_state), DUTY_BUSY_MS);
   }
+  if (power_mode == POWER_DEEP_SLEEP) {
+    runDutyCycle();
+  }
+  if (timer_wake) {
+    Serial.println("[POWER] deep sleep no longer pays off, staying on");
+  }
+
+  bool ap_cached = config_ok && loadWifiApCache(esp_config.wifi_config.SSID, &ap_cache);
+
+  /*
+    Wi-Fi connects in the background from here on, while the camera is initialized
+  */
+  runBootActions(bootInit(&boot, config_ok, portal_requested, ap_cached, millis()));
+
+  if (boot.state == BOOT_PORTAL_WAIT) {
+    /* nothing to capture for yet */
+    Serial.println("-- No stored configuration, waiting for the configuration form");
+    waitForPortalSave();
+    if (!loadConfig(&esp_config)) {
+      Serial.println("-- Failed to configure ESP");
+    }
+    runBootActions(bootStep(&boot, BOOT_EVENT_CONFIG_SAVED, millis()));
+  }
+  loadUploadTrust();
+  setChunkedUpload(esp_config.CHUNKED_UPLOAD);
+
+  /*
+    initialization of ESP + cam
+  */
+  initEspPinout();
+  /* the pipeline uses the queue depth and batch size the frame buffers allow */
+  initEspCamera(&esp_config, &esp_config.QUEUE_DEPTH, &esp_config.BATCH_SIZE);
+  configure_camera_sensor(&esp_config);
 
-  Serial.printf("-- Finished capturing and posting image %d\n", counter);
+  /*
+    capturing starts once the device is online or gave up on the first connect
+    (at most BOOT_FAST_CONNECT_MS + BOOT_SCAN_CONNECT_MS); NTP does not hold it up
+  */
+  while (!boot.pipeline_started) {
+    pollBoot(false);
+    delay(10);
+  }
 
-  delay(esp_config.CAPTURE_INTERVAL);
+  Serial.printf("[ESP] SETUP COMPLETE after %lu ms\n", (unsigned long)millis());
 }
+
+
+void loop() {
+  /* all work happens in the pipeline tasks (see pipeline.cpp); here only the connection is watched */
+  pollBoot(false);
+
+  /*
+    Latency histograms and counters are pulled on demand instead of printed per frame:
+      "metrics"       -> JSON snapshot
+      "metrics reset" -> start a new measurement window
+      "portal"        -> open the configuration portal
+  */
+  if (Serial.available()) {
+    String command = Serial.readStringUntil('\n');
+    command.trim();
+
+    if (command == "metrics") {
+      static char snapshot[METRICS_SNAPSHOT_MAX];
+      if (metricsSnapshotJson(snapshot, sizeof(snapshot), millis()) > 0) {
+        Serial.println(snapshot);
+      }
+    } else if (command == "metrics reset") {
+      metricsReset();
+    } else if (command == "portal") {
+      openPortal();
+    }
+  }
+
+  delay(100);
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "boot.h"
+
+static uint32_t enter(boot_t *boot, boot_state_t state, uint32_t now_ms) {
+  boot->state = state;
+  boot->state_since = now_ms;
+  switch (state) {
+    case BOOT_PORTAL_WAIT: return BOOT_DO_OPEN_PORTAL;
+    case BOOT_WIFI_FAST:   return BOOT_DO_CONNECT_FAST;
+    case BOOT_WIFI_SCAN:   return BOOT_DO_CONNECT_SCAN;
+    default:               return 0;
+  }
+}
+
+/* capturing starts once, whichever comes first: online or given up */
+static uint32_t startOnce(boot_t *boot) {
+  uint32_t actions = 0;
+  if (!boot->pipeline_started) {
+    boot->pipeline_started = true;
+    actions |= BOOT_DO_START_PIPELINE;
+  }
+  return actions;
+}
+
+static uint32_t openPortalOnce(boot_t *boot) {
+  if (boot->portal_open) return 0;
+  boot->portal_open = true;
+  return BOOT_DO_OPEN_PORTAL;
+}
+
+uint32_t bootInit(boot_t *boot, bool config_ok, bool portal_requested, bool ap_cached, uint32_t now_ms) {
+  *boot = boot_t();
+  boot->started = now_ms;
+
+  if (!config_ok) {
+    boot->portal_open = true;
+    return enter(boot, BOOT_PORTAL_WAIT, now_ms);
+  }
+  uint32_t actions = portal_requested ? openPortalOnce(boot) : 0;
+  return actions | enter(boot, ap_cached ? BOOT_WIFI_FAST : BOOT_WIFI_SCAN, now_ms);
+}
+
+static uint32_t onConnected(boot_t *boot, uint32_t now_ms) {
+  uint32_t actions = BOOT_DO_SAVE_AP | startOnce(boot);
+  if (!boot->ntp_started) {
+    boot->ntp_started = true;
+    actions |= BOOT_DO_START_NTP;
+  }
+  if (!boot->connected_once) {
+    boot->connected_once = true;
+    boot->connect_ms = now_ms - boot->started;
+  }
+  return actions | enter(boot, BOOT_RUN, now_ms);
+}
+
+uint32_t bootStep(boot_t *boot, boot_event_t event, uint32_t now_ms) {
+  uint32_t elapsed = now_ms - boot->state_since;
+
+  switch (boot->state) {
+    case BOOT_PORTAL_WAIT:
+      /* the portal stays open; the next save restarts the device (host.cpp) */
+      return event == BOOT_EVENT_CONFIG_SAVED ? enter(boot, BOOT_WIFI_SCAN, now_ms) : 0;
+
+    case BOOT_WIFI_FAST:
+      if (event == BOOT_EVENT_CONNECTED) return onConnected(boot, now_ms);
+      /* the access point moved to another channel or is gone: scan for the SSID */
+      if (event == BOOT_EVENT_DISCONNECTED || elapsed >= BOOT_FAST_CONNECT_MS) {
+        boot->fast_failures++;
+        return BOOT_DO_FORGET_AP | enter(boot, BOOT_WIFI_SCAN, now_ms);
+      }
+      return 0;
+
+    case BOOT_WIFI_SCAN:
+      if (event == BOOT_EVENT_CONNECTED) return onConnected(boot, now_ms);
+      if (elapsed >= BOOT_SCAN_CONNECT_MS) {
+        boot->scan_failures++;
+        /* a config that never got online may be wrong: let someone fix it */
+        uint32_t actions = startOnce(boot) | (!boot->connected_once ? openPortalOnce(boot) : 0);
+        return actions | enter(boot, BOOT_OFFLINE, now_ms);
+      }
+      return 0;
+
+    case BOOT_OFFLINE:
+      if (event == BOOT_EVENT_CONNECTED) return onConnected(boot, now_ms);
+      return elapsed >= BOOT_OFFLINE_RETRY_MS ? enter(boot, BOOT_WIFI_SCAN, now_ms) : 0;
+
+    case BOOT_RUN:
+      return event == BOOT_EVENT_DISCONNECTED ? enter(boot, BOOT_WIFI_SCAN, now_ms) : 0;
+  }
+  return 0;
+}
+
+const char *bootStateName(boot_state_t state) {
+  switch (state) {
+    case BOOT_PORTAL_WAIT: return "portal_wait";
+    case BOOT_WIFI_FAST:   return "wifi_fast";
+    case BOOT_WIFI_SCAN:   return "wifi_scan";
+    case BOOT_OFFLINE:     return "offline";
+    case BOOT_RUN:         return "run";
+  }
+  return "?";
+}
@@ -0,0 +1,84 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Boot sequence
+
+  With a stored configuration the device goes straight to capturing. The portal
+  is only opened when it is asked for (double reset, "portal" on the serial
+  console) or when the configuration is missing or does not get the device online:
+
+    no usable config          -> PORTAL_WAIT: portal open, nothing to capture for yet
+    cached access point       -> WIFI_FAST: connect to its BSSID on its channel, no scan
+    fast connect failed/none  -> WIFI_SCAN: connect by SSID with a full scan
+    scan connect failed       -> OFFLINE: capture into the offline buffer, portal open,
+                                 reconnect every BOOT_OFFLINE_RETRY_MS
+    connected                 -> RUN (a lost connection goes back to WIFI_SCAN)
+
+  The pipeline starts as soon as the device either is online or gave up on the
+  first connect, so a missing access point never keeps the camera from capturing.
+
+  Plain C++ without WiFi or RTOS calls: events and time are passed in, the returned
+  actions are carried out by the caller (ESP32-CAM.ino), so host/boot_sim.cpp drives the
+  exact same logic.
+*/
+#define BOOT_FAST_CONNECT_MS 3000
+#define BOOT_SCAN_CONNECT_MS 15000
+#define BOOT_OFFLINE_RETRY_MS 30000
+
+typedef enum {
+  BOOT_PORTAL_WAIT = 0,
+  BOOT_WIFI_FAST,
+  BOOT_WIFI_SCAN,
+  BOOT_OFFLINE,
+  BOOT_RUN
+} boot_state_t;
+
+typedef enum {
+  BOOT_EVENT_TICK = 0,        /* nothing happened, only time passed */
+  BOOT_EVENT_CONNECTED,
+  BOOT_EVENT_DISCONNECTED,
+  BOOT_EVENT_CONFIG_SAVED     /* the portal form was saved, the config is usable now */
+} boot_event_t;
+
+/* actions for the caller, as a bit set */
+#define BOOT_DO_OPEN_PORTAL     (1u << 0)
+#define BOOT_DO_CONNECT_FAST    (1u << 1)   /* WiFi.begin() with the cached BSSID and channel */
+#define BOOT_DO_CONNECT_SCAN    (1u << 2)   /* WiFi.begin() by SSID */
+#define BOOT_DO_FORGET_AP       (1u << 3)   /* the cached access point did not answer */
+#define BOOT_DO_SAVE_AP         (1u << 4)   /* remember the access point we are connected to */
+#define BOOT_DO_START_PIPELINE  (1u << 5)
+#define BOOT_DO_START_NTP       (1u << 6)   /* asynchronous, frames are named from uptime until it is set */
+
+typedef struct {
+  boot_state_t state;
+  uint32_t started;          /* in the caller's millisecond clock */
+  uint32_t state_since;
+  bool portal_open;
+  bool pipeline_started;
+  bool ntp_started;
+  bool connected_once;
+
+  /* statistics */
+  uint32_t connect_ms;       /* bootInit() until the first connection */
+  uint32_t fast_failures;
+  uint32_t scan_failures;
+} boot_t;
+
+/*
+  config_ok: a stored config with Wi-Fi credentials and an upload URL
+  portal_requested: double reset or a "portal" request before the restart
+  ap_cached: a BSSID and channel from the last connection to this SSID
+  Returns the first actions.
+*/
+uint32_t bootInit(boot_t *boot, bool config_ok, bool portal_requested, bool ap_cached, uint32_t now_ms);
+
+/* feeds one event; returns the actions for the caller */
+uint32_t bootStep(boot_t *boot, boot_event_t event, uint32_t now_ms);
+
+const char *bootStateName(boot_state_t state);
+
+#endif
@@ -0,0 +1,160 @@
+#include "camera_settings.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+  Ranges are the ones the OV2640 driver accepts. The defaults of the first five
+  are what loadConfig() has always used.
+*/
+static const camera_setting_desc_t SETTINGS[CAMERA_SETTING_COUNT] = {
+  { "resolution",    FRAMESIZE_QVGA, FRAMESIZE_UXGA, FRAMESIZE_VGA },
+  { "interval_ms",   10,             3600000,        300 },
+  { "vflip",         0,              1,              1 },
+  { "hmirror",       0,              1,              0 },
+  { "brightness",    -2,             2,              1 },
+  { "contrast",      -2,             2,              0 },
+  { "saturation",    -2,             2,              -1 },
+  { "auto_exposure", 0,              1,              1 },
+  { "ae_level",      -2,             2,              0 },
+  { "exposure",      0,              1200,           300 },
+  { "auto_gain",     0,              1,              1 },
+  { "gain",          0,              30,             0 },
+  { "awb",           0,              1,              1 },
+  { "wb_mode",       0,              4,              0 },
+};
+
+static const struct {
+  const char *name;
+  framesize_t framesize;
+} FRAMESIZES[] = {
+  { "qvga", FRAMESIZE_QVGA },
+  { "vga",  FRAMESIZE_VGA },
+  { "svga", FRAMESIZE_SVGA },
+  { "sxga", FRAMESIZE_SXGA },
+  { "uxga", FRAMESIZE_UXGA },
+};
+#define FRAMESIZE_NAMES (sizeof(FRAMESIZES) / sizeof(FRAMESIZES[0]))
+
+const camera_setting_desc_t *cameraSettingDesc(camera_setting_t setting) {
+  return setting < CAMERA_SETTING_COUNT ? &SETTINGS[setting] : NULL;
+}
+
+int cameraSettingIndex(const char *key) {
+  for (int i = 0; i < CAMERA_SETTING_COUNT; i++) {
+    if (strcmp(SETTINGS[i].key, key) == 0) return i;
+  }
+  return -1;
+}
+
+void cameraSettingsDefaults(camera_settings_t *settings) {
+  for (int i = 0; i < CAMERA_SETTING_COUNT; i++) {
+    settings->value[i] = SETTINGS[i].fallback;
+  }
+}
+
+const char *cameraFramesizeName(framesize_t framesize) {
+  for (size_t i = 0; i < FRAMESIZE_NAMES; i++) {
+    if (FRAMESIZES[i].framesize == framesize) return FRAMESIZES[i].name;
+  }
+  return NULL;
+}
+
+framesize_t cameraFramesizeFromName(const char *name) {
+  for (size_t i = 0; i < FRAMESIZE_NAMES; i++) {
+    if (strcasecmp(FRAMESIZES[i].name, name) == 0) return FRAMESIZES[i].framesize;
+  }
+  return FRAMESIZE_INVALID;
+}
+
+/*
+  -----------------------------
+  ---------- UPDATES ----------
+  -----------------------------
+*/
+camera_update_result_t cameraSettingSet(camera_settings_t *settings, const char *key, long value) {
+  int i = cameraSettingIndex(key);
+  if (i < 0) {
+    return CAMERA_UPDATE_UNKNOWN_KEY;
+  }
+  if (value < SETTINGS[i].min || value > SETTINGS[i].max) {
+    return CAMERA_UPDATE_OUT_OF_RANGE;
+  }
+  /* frame sizes between the named ones are not offered */
+  if (i == CAMERA_SET_FRAMESIZE && !cameraFramesizeName((framesize_t)value)) {
+    return CAMERA_UPDATE_BAD_VALUE;
+  }
+  settings->value[i] = (int32_t)value;
+  return CAMERA_UPDATE_OK;
+}
+
+camera_update_result_t cameraSettingSetString(camera_settings_t *settings, const char *key, const char *value) {
+  int i = cameraSettingIndex(key);
+  if (i < 0) {
+    return CAMERA_UPDATE_UNKNOWN_KEY;
+  }
+  if (i == CAMERA_SET_FRAMESIZE) {
+    framesize_t framesize = cameraFramesizeFromName(value);
+    if (framesize == FRAMESIZE_INVALID) {
+      return CAMERA_UPDATE_BAD_VALUE;
+    }
+    settings->value[i] = framesize;
+    return CAMERA_UPDATE_OK;
+  }
+
+  /* optional sign, digits, nothing else */
+  const char *digits = value[0] == '-' ? value + 1 : value;
+  size_t count = 0;
+  while (isdigit((unsigned char)digits[count])) count++;
+  if (count == 0 || count > 9 || digits[count] != '\0') {
+    return CAMERA_UPDATE_BAD_VALUE;
+  }
+  return cameraSettingSet(settings, key, strtol(value, NULL, 10));
+}
+
+const char *cameraUpdateError(camera_update_result_t result) {
+  switch (result) {
+    case CAMERA_UPDATE_OK:           return "ok";
+    case CAMERA_UPDATE_UNKNOWN_KEY:  return "unknown setting";
+    case CAMERA_UPDATE_OUT_OF_RANGE: return "value out of range";
+    default:                         return "invalid value";
+  }
+}
+
+/*
+  -----------------------------
+  ------- DIFF + APPLY --------
+  -----------------------------
+*/
+uint32_t cameraSettingsDiff(const camera_settings_t *from, const camera_settings_t *to) {
+  uint32_t changes = 0;
+  for (int i = 0; i < CAMERA_SETTING_COUNT; i++) {
+    if (from->value[i] != to->value[i]) changes |= 1u << i;
+  }
+  return changes;
+}
+
+bool cameraSettingsNeedReinit(uint32_t changes, const camera_settings_t *next, framesize_t init_framesize) {
+  return (changes & (1u << CAMERA_SET_FRAMESIZE)) && next->value[CAMERA_SET_FRAMESIZE] > init_framesize;
+}
+
+bool cameraSettingsApply(const camera_settings_t *settings, uint32_t changes, camera_set_fn set, void *ctx) {
+  bool ok = true;
+  for (int i = 0; i < CAMERA_SETTING_COUNT; i++) {
+    if (i == CAMERA_SET_INTERVAL || !(changes & (1u << i))) continue;
+    if (!set(ctx, (camera_setting_t)i, settings->value[i])) ok = false;
+  }
+  return ok;
+}
+
+void cameraSettingsJson(portal_json_t *json, const camera_settings_t *settings) {
+  for (int i = 0; i < CAMERA_SETTING_COUNT; i++) {
+    if (i == CAMERA_SET_FRAMESIZE) {
+      const char *name = cameraFramesizeName((framesize_t)settings->value[i]);
+      portalJsonString(json, SETTINGS[i].key, name ? name : "");
+    } else {
+      portalJsonInt(json, SETTINGS[i].key, settings->value[i]);
+    }
+  }
+}
@@ -0,0 +1,97 @@
+#ifndef CAMERA_SETTINGS_H
+#define CAMERA_SETTINGS_H
+
+#include "hal.h"
+#include "portal_page.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Camera settings that can be changed while the device runs (control.cpp), and
+  how a change is applied. Plain C++ without sensor or RTOS calls: the sensor is
+  reached through a callback, so host/camera_settings_check.cpp runs the same logic.
+
+  Every setting is an int in a fixed table (camera_settings.cpp) with its API key,
+  its range and its default; its key in config.json is in the config table
+  (config.cpp). The order of the table is the order the sensor gets the values
+  in: the automatic modes come before the manual values they override.
+*/
+typedef enum {
+  CAMERA_SET_FRAMESIZE = 0,     /* framesize_t; "resolution" by name in JSON */
+  CAMERA_SET_INTERVAL,          /* capture interval in ms, not a sensor setting */
+  CAMERA_SET_VFLIP,
+  CAMERA_SET_HMIRROR,
+  CAMERA_SET_BRIGHTNESS,
+  CAMERA_SET_CONTRAST,
+  CAMERA_SET_SATURATION,
+  CAMERA_SET_AUTO_EXPOSURE,
+  CAMERA_SET_AE_LEVEL,
+  CAMERA_SET_EXPOSURE,          /* only used with auto exposure off */
+  CAMERA_SET_AUTO_GAIN,
+  CAMERA_SET_GAIN,              /* only used with auto gain off */
+  CAMERA_SET_AWB,
+  CAMERA_SET_WB_MODE,
+  CAMERA_SETTING_COUNT
+} camera_setting_t;
+
+typedef struct {
+  int32_t value[CAMERA_SETTING_COUNT];
+} camera_settings_t;
+
+typedef struct {
+  const char *key;          /* API key */
+  int32_t min;
+  int32_t max;
+  int32_t fallback;
+} camera_setting_desc_t;
+
+typedef enum {
+  CAMERA_UPDATE_OK = 0,
+  CAMERA_UPDATE_UNKNOWN_KEY,
+  CAMERA_UPDATE_OUT_OF_RANGE,
+  CAMERA_UPDATE_BAD_VALUE
+} camera_update_result_t;
+
+/* sets one sensor value; false if the sensor refused it */
+typedef bool (*camera_set_fn)(void *ctx, camera_setting_t setting, int32_t value);
+
+const camera_setting_desc_t *cameraSettingDesc(camera_setting_t setting);
+
+/* -1 for an unknown API key */
+int cameraSettingIndex(const char *key);
+
+void cameraSettingsDefaults(camera_settings_t *settings);
+
+/*
+  Sets the setting behind an API key. A value out of range or an unknown key leaves
+  settings untouched. SetString takes the frame size by name ("vga", "uxga", ...)
+  and every other setting as a decimal number.
+*/
+camera_update_result_t cameraSettingSet(camera_settings_t *settings, const char *key, long value);
+camera_update_result_t cameraSettingSetString(camera_settings_t *settings, const char *key, const char *value);
+const char *cameraUpdateError(camera_update_result_t result);
+
+/* frame sizes accepted by name; NULL / FRAMESIZE_INVALID for anything else */
+const char *cameraFramesizeName(framesize_t framesize);
+framesize_t cameraFramesizeFromName(const char *name);
+
+/* bit (1 << setting) for every setting that differs */
+uint32_t cameraSettingsDiff(const camera_settings_t *from, const camera_settings_t *to);
+
+/*
+  The frame buffers are allocated for the frame size the camera was initialized
+  with. A smaller one is set on the running sensor, only a larger one needs
+  esp_camera_deinit() / esp_camera_init().
+*/
+bool cameraSettingsNeedReinit(uint32_t changes, const camera_settings_t *next, framesize_t init_framesize);
+
+/*
+  Hands every changed sensor setting (not the interval) to set, in table order.
+  Returns false if one was refused; the others are still tried.
+*/
+bool cameraSettingsApply(const camera_settings_t *settings, uint32_t changes, camera_set_fn set, void *ctx);
+
+/* adds every setting under its API key to an open JSON object */
+void cameraSettingsJson(portal_json_t *json, const camera_settings_t *settings);
+
+#endif
@@ -0,0 +1,30 @@
+#include "circle_result.h"
+
+static uint16_t readU16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool circleResultParse(const uint8_t *body, size_t len, circle_result_t *result) {
+  if (!body || len < CIRCLE_RESULT_HEADER || body[0] != CIRCLE_RESULT_VERSION) {
+    return false;
+  }
+
+  uint16_t count = readU16(body + 2);
+  if (len != CIRCLE_RESULT_HEADER + (size_t)count * CIRCLE_RESULT_RECORD) {
+    return false;
+  }
+
+  result->records = body + CIRCLE_RESULT_HEADER;
+  result->count = count;
+  return true;
+}
+
+void circleResultGet(const circle_result_t *result, size_t i, circle_t *circle) {
+  const uint8_t *record = result->records + i * CIRCLE_RESULT_RECORD;
+  uint16_t radius = readU16(record + 4);
+
+  circle->x = readU16(record);
+  circle->y = readU16(record + 2);
+  circle->radius = radius & ~CIRCLE_RESULT_FILLED;
+  circle->filled = (radius & CIRCLE_RESULT_FILLED) != 0;
+}
@@ -0,0 +1,52 @@
+#ifndef CIRCLE_RESULT_H
+#define CIRCLE_RESULT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Binary detection result, the compact alternative to the JSON response.
+
+  The firmware asks for it in the Accept header of every upload; the backend
+  answers a successful single-image upload with it (services/circle_result.py)
+  and everything else (errors, batches, older backends) with JSON.
+
+  Layout, all little-endian:
+
+    offset 0   uint8   version (CIRCLE_RESULT_VERSION)
+    offset 1   uint8   flags (0, reserved)
+    offset 2   uint16  count
+    offset 4   count records of CIRCLE_RESULT_RECORD bytes:
+                 uint16 x, uint16 y, uint16 radius (bits 0..14) | filled (bit 15)
+
+  The body is read where it lies: no document, no allocation, no copy.
+*/
+#define CIRCLE_RESULT_MIME "application/vnd.hivehive.circles"
+#define CIRCLE_RESULT_VERSION 1
+#define CIRCLE_RESULT_HEADER 4
+#define CIRCLE_RESULT_RECORD 6
+#define CIRCLE_RESULT_FILLED 0x8000
+
+typedef struct {
+  uint16_t x;
+  uint16_t y;
+  uint16_t radius;
+  bool filled;
+} circle_t;
+
+/* view into a received body */
+typedef struct {
+  const uint8_t *records;
+  uint16_t count;
+} circle_result_t;
+
+/*
+  Checks version and length of a binary body and points result at its records.
+  Returns false for anything that is not exactly one complete result.
+*/
+bool circleResultParse(const uint8_t *body, size_t len, circle_result_t *result);
+
+/* record i (< result->count) */
+void circleResultGet(const circle_result_t *result, size_t i, circle_t *circle);
+
+#endif
@@ -1,13 +1,73 @@
-#include "esp_camera.h"
 #include "client.h"
+#include "circle_result.h"
+#include "http_request.h"
+#include "http_response.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include <time.h>
-#include <HTTPClient.h>
-#include <WiFi.h>
-#include <WifiClientSecure.h>
-#include <Arduino.h>
 #include <ArduinoJson.h>
 
-static WiFiClientSecure client;
+/*
+  Body of the upload response; larger bodies are cut off. The binary result
+  needs 4 + 6 bytes per circle (up to 169 circles), JSON about 50 per circle.
+*/
+#define RESPONSE_BODY_MAX 1024
+#define RESPONSE_TIMEOUT_MS 5000
+
+static upload_feedback_t last_feedback;
+
+const upload_feedback_t *lastUploadFeedback() {
+  return &last_feedback;
+}
+
+/*
+  Staging buffer for coalescing headers/tail with the image into full TLS records.
+  Allocated once (PSRAM if available), never per request.
+*/
+static uint8_t *staging_buffer = NULL;
+static size_t staging_cap = 0;
+
+static uint8_t *getStagingBuffer() {
+  if (!staging_buffer) {
+    staging_cap = HTTP_WRITE_MAX;
+    staging_buffer = (uint8_t *)halAllocLarge(staging_cap);
+    if (!staging_buffer) {
+      static uint8_t fallback[1024];
+      staging_buffer = fallback;
+      staging_cap = sizeof(fallback);
+    }
+  }
+  return staging_buffer;
+}
+
+/* sent with every upload, see halDeviceId(); read once */
+static const char *deviceId() {
+  static char device_id[HAL_DEVICE_ID_MAX] = "";
+  if (!device_id[0]) {
+    halDeviceId(device_id, sizeof(device_id));
+    halLog("---- device id: %s\n", device_id);
+  }
+  return device_id;
+}
+
+/*
+  Transport hook for httpWriteGather(); remembers when the first write
+  (the one carrying the request headers) went out.
+*/
+typedef struct {
+  HalTransport *transport;
+  uint32_t first_write_end;
+} upload_ctx_t;
+
+static size_t writeToTransport(void *ctx, const uint8_t *data, size_t len) {
+  upload_ctx_t *upload = (upload_ctx_t *)ctx;
+  size_t written = upload->transport->write(data, len);
+  if (!upload->first_write_end) upload->first_write_end = halMillis();
+  return written;
+}
 
 /*
   Extracts
@@ -16,79 +76,127 @@ static WiFiClientSecure client;
     - endpoint path
   from a given URL and sets it to the Url struct.
 */
-static url_t splitUrl(const char* urlChars) {
-  url_t url;
-  
+bool splitUrl(const char* urlChars, url_t *url) {
   /* default port + path if given URL does not contain any */
-  url.port = 443; // https
-  url.path = "/";
-  
+  url->port = 443; // https
+  strcpy(url->path, "/");
+
   /*
     Finds the position of the trailing '://' after http/https
     and sets the position of the host address to right after the double slash.
 
-    If no '://' found, the URL most likely starts without 'http(s)://' so hostIndex is 0
+    If no '://' found, the URL most likely starts without 'http(s)://' so host starts at the beginning
   */
-  String urlString(urlChars);
-  int doubleslashPosition = urlString.indexOf("://");
-  int hostIndex = doubleslashPosition >= 0 ? doubleslashPosition + 3 : 0;
-  
-  /* 
+  const char *doubleslash = strstr(urlChars, "://");
+  const char *host = doubleslash ? doubleslash + 3 : urlChars;
+
+  /*
     Finds start of the path (first '/' after hostname).
-    Extracts host (+ port) between hostIndex and first slash
+    Extracts host (+ port) between host start and first slash
 
-    If no '/' the full String after hostIndex is set to the host
+    If no '/' the full rest of the URL is the host
   */
-  int slash = urlString.indexOf('/', hostIndex);
-  String host = slash >= 0 ? urlString.substring(hostIndex, slash) : urlString.substring(hostIndex);
-  
+  const char *slash = strchr(host, '/');
+  size_t hostLength = slash ? (size_t)(slash - host) : strlen(host);
+
   /*
     If slash is found, everything after that is set to the Url path
   */
-  if (slash >= 0) {
-    url.path = urlString.substring(slash);
+  if (slash) {
+    if (strlen(slash) >= sizeof(url->path)) return false;
+    strcpy(url->path, slash);
   }
 
   /*
     Separates host address and port and sets the Url struct host and port accordingly.
-    
+
     If no port is found, just the URL host is set.
   */
-  int colon = host.indexOf(':');
-  if (colon >= 0) {
-    url.host = host.substring(0, colon);
-    url.port = host.substring(colon + 1).toInt();
-  } else {
-      url.host = host;
-  }  
-  return url;
+  const char *colon = (const char *)memchr(host, ':', hostLength);
+  if (colon) {
+    url->port = (uint16_t)atoi(colon + 1);
+    hostLength = colon - host;
+  }
+  if (hostLength >= sizeof(url->host)) return false;
+  memcpy(url->host, host, hostLength);
+  url->host[hostLength] = '\0';
+  return true;
 }
 
 /*
-  Creates unique filename of format: esp_capture_YYYYMMDDhhmmss.jpg
+  Creates unique filename of format: esp_capture_YYYYMMDD_hhmmss_<sequence>.jpg
+  The time is the capture time of the frame, not the upload time, so frames
+  uploaded late from the store keep their real name.
 */
-String createFileName() {
+void createFileName(char *buf, size_t len, const frame_info_t *info) {
   struct tm timeinfo;
-  bool localTimeAvailable = getLocalTime(&timeinfo, 200); /* up to 200ms timeout for getting the local tikme */
+  /* captured before the clock was set (NTP runs in the background after boot) */
+  uint32_t timestamp = info->timestamp == 0 && info->uptime_ms != 0 ? halWallTime(info->uptime_ms) : info->timestamp;
+  time_t captured = (time_t)timestamp;
 
-  char buf[64];
-  if (localTimeAvailable) {
-    snprintf(buf, sizeof(buf),
-             "esp_capture_%04d%02d%02d_%02d%02d%02d.jpg",
+  if (timestamp != 0 && localtime_r(&captured, &timeinfo)) {
+    snprintf(buf, len,
+             "esp_capture_%04d%02d%02d_%02d%02d%02d_%u.jpg",
              timeinfo.tm_year + 1900,
              timeinfo.tm_mon + 1,
              timeinfo.tm_mday,
              timeinfo.tm_hour,
              timeinfo.tm_min,
-             timeinfo.tm_sec);
+             timeinfo.tm_sec,
+             (unsigned)info->sequence);
   } else {
-    /* Fallback if local time not available: add millis (miliseconds since boot) so names stay unique */
-    snprintf(buf, sizeof(buf), "esp_capture_unknown_%lu.jpg", (unsigned long)millis());
-    Serial.println("WARNING: Unable to get local time while creating image filename.");
+    /* Fallback if local time not available: add the capture time in ms since boot so names stay unique */
+    uint32_t uptime_ms = info->uptime_ms ? info->uptime_ms : halMillis();
+    snprintf(buf, len, "esp_capture_unknown_%lu_%u.jpg", (unsigned long)uptime_ms, (unsigned)info->sequence);
+    halLog("WARNING: Unable to get local time while creating image filename.\n");
   }
 
-  Serial.printf("------ file name: %s\n", buf);
-  return String(buf);
+  halLog("------ file name: %s\n", buf);
+}
+
+/*
+  Loads the TLS trust anchors for the upload connection from the filesystem:
+    TLS_CA_FILE   PEM CA certificate (or the server's self-signed certificate)
+    TLS_PIN_FILE  SHA-256 of the server's public key as 64 hex digits (':' and spaces allowed)
+*/
+static bool parsePin(const char *text, uint8_t *pin) {
+  size_t digits = 0;
+  for (const char *p = text; *p && digits < 64; p++) {
+    int value;
+    if (*p >= '0' && *p <= '9') value = *p - '0';
+    else if (*p >= 'a' && *p <= 'f') value = *p - 'a' + 10;
+    else if (*p >= 'A' && *p <= 'F') value = *p - 'A' + 10;
+    else continue;
+
+    if (digits % 2 == 0) pin[digits / 2] = value << 4;
+    else pin[digits / 2] |= value;
+    digits++;
+  }
+  return digits == 64;
+}
+
+void loadUploadTrust() {
+  static char ca_pem[TLS_CA_MAX];
+  long ca_len = halFsReadFile(TLS_CA_FILE, (uint8_t *)ca_pem, sizeof(ca_pem) - 1);
+  if (ca_len > 0) {
+    ca_pem[ca_len] = '\0';
+    halLog("-- TLS: verifying the server with %s\n", TLS_CA_FILE);
+  }
+
+  static uint8_t pin[32];
+  char pin_text[128];
+  long pin_len = halFsReadFile(TLS_PIN_FILE, (uint8_t *)pin_text, sizeof(pin_text) - 1);
+  bool pinned = false;
+  if (pin_len > 0) {
+    pin_text[pin_len] = '\0';
+    pinned = parsePin(pin_text, pin);
+    halLog(pinned ? "-- TLS: server public key pinned\n" : "---- TLS: %s is not a SHA-256 hex digest, ignored\n", TLS_PIN_FILE);
+  }
+
+  if (ca_len <= 0 && !pinned) {
+    halLog("---- TLS: no %s or %s, the server is not authenticated\n", TLS_CA_FILE, TLS_PIN_FILE);
+  }
+  halUploadTransport()->setTrust(ca_len > 0 ? ca_pem : NULL, pinned ? pin : NULL);
 }
 
 /*
@@ -97,182 +205,375 @@ String createFileName() {
   -> filled or not filled
   -> position
 */
-void printResponse(String response) {
+static void printHeader(int count) {
+  halLog("----------------------------------------------------------------------\n");
+  halLog("------------------------- RESPONSE -----------------------------------\n");
+  halLog("------------------------------------------------------------\n");
+  halLog("--------------------- %d circles found ---------------------\n", count);
+  halLog("------------------------------------------------------------\n");
+}
+
+static void printCircle(int i, int x, int y, int radius, const char *status) {
+  halLog("--------------------- Circle[%d] radius: %d ---------------------\n", i+1, radius);
+  halLog("--------------------- Circle[%d] status: %s ---------------------\n", i+1, status);
+  halLog("----------------- Circle[%d] position: (%d, %d)------------------\n", i+1, x, y);
+  halLog("------------------------------------------------------------\n");
+}
+
+/* binary result (circle_result.h), read straight from the response buffer */
+static void printBinaryResponse(const uint8_t *response, size_t length) {
+  circle_result_t result;
+  if (!circleResultParse(response, length, &result)) {
+    halLog("------ binary result parse error (%u bytes)\n", (unsigned)length);
+    return;
+  }
+
+  printHeader(result.count);
+  for (size_t i = 0; i < result.count; i++) {
+    circle_t circle;
+    circleResultGet(&result, i, &circle);
+    printCircle((int)i, circle.x, circle.y, circle.radius, circle.filled ? "filled" : "unfilled");
+  }
+  halLog("----------------------------------------------------------------------\n");
+}
+
+/* JSON result, from backends without the binary format */
+static void printJsonResponse(const char *response, size_t length) {
   DynamicJsonDocument doc(1024);
-  DeserializationError error = deserializeJson(doc, response);
+  DeserializationError error = deserializeJson(doc, response, length);
 
   if (error) {
-    Serial.print("------ JSON parse error: ");
-    Serial.println(error.c_str());
+    halLog("------ JSON parse error: %s\n", error.c_str());
   } else {
-    Serial.println("----------------------------------------------------------------------");
-    Serial.println("------------------------- RESPONSE -----------------------------------");
-    Serial.println("------------------------------------------------------------");
-    Serial.printf("--------------------- %d circles found ---------------------\n", doc["circles"].size());
-    Serial.println("------------------------------------------------------------");
+    printHeader((int)doc["circles"].size());
 
-    for (int i = 0; i < doc["circles"].size(); i++) {
+    for (int i = 0; i < (int)doc["circles"].size(); i++) {
       int radius = doc["circles"][i]["radius"];
       const char* status = doc["circles"][i]["status"];
       int x = doc["circles"][i]["x"];
       int y = doc["circles"][i]["y"];
 
-      Serial.printf("--------------------- Circle[%d] radius: %d ---------------------\n", i+1, radius);
-      Serial.printf("--------------------- Circle[%d] status: %s ---------------------\n", i+1, status);
-      Serial.printf("----------------- Circle[%d] position: (%d, %d)------------------\n", i+1, x, y);
-      Serial.println("------------------------------------------------------------");
+      printCircle(i, x, y, radius, status);
     }
 
     const char* message = doc["message"];
-    Serial.printf("---- Response message: %s\n ----\n", message);
-    Serial.println("----------------------------------------------------------------------");
+    halLog("---- Response message: %s\n ----\n", message);
+    halLog("----------------------------------------------------------------------\n");
+  }
+}
+
+static void printResponse(const http_response_t *res) {
+  if (strcasecmp(res->content_type, CIRCLE_RESULT_MIME) == 0) {
+    printBinaryResponse(res->body, res->body_len);
+  } else {
+    printJsonResponse((const char *)res->body, res->body_len);
   }
 }
 
-int postImage(char *UPLOAD_URL) {
-  unsigned long __t_all_start = millis();
+/* NETWORK.CHUNKED: Transfer-Encoding: chunked instead of Content-Length */
+static bool chunked_upload = false;
 
+void setChunkedUpload(bool chunked) {
+  chunked_upload = chunked;
+  halLog("-- upload body: %s\n", chunked ? "chunked" : "Content-Length");
+}
+
+/* connects (or reuses the kept-alive connection); false on a network error */
+static bool ensureConnected(HalTransport *client, const url_t *url) {
+  if (client->connected()) {
+    return true;
+  }
+
+  uint32_t __t_conn_start = halMillis();
+  metricsCount(COUNTER_RECONNECTS);
+  if (!client->connect(url->host, url->port)) {
+    return false;
+  }
+  metricsRecordStage(client->sessionResumed() ? STAGE_CONNECT_RESUMED : STAGE_CONNECT, halMillis() - __t_conn_start);
+  return true;
+}
+
+static void countWrites(const http_write_stats_t *stats) {
+  metricsCount(COUNTER_PARTIAL_WRITES, stats->partial_writes);
+  metricsCount(COUNTER_BYTES_SENT, stats->bytes);
+}
+
+/* bookkeeping once the whole request went out */
+static void recordUpload(const upload_ctx_t *upload, const http_write_stats_t *stats, uint32_t upload_start) {
+  uint32_t __t_upload_end = halMillis();
+  last_feedback.bytes_sent = stats->bytes;
+  last_feedback.upload_ms = __t_upload_end - upload_start;
+  metricsRecordStage(STAGE_HEADER, upload->first_write_end - upload_start);
+  metricsRecordStage(STAGE_UPLOAD, __t_upload_end - upload->first_write_end);
+}
+
+/*
+  Reads the response to the request just sent.
+  The result is only printed for single images; batch responses are not needed on the device.
+*/
+static int readResponse(HalTransport *client, bool print) {
   /*
-    Image is captured through ESP API
+    HTTP response
 
-    flash is activated
+    The parser is fed whatever the socket has right now and reports as soon as
+    the body is complete (Content-Length or chunked), so a keep-alive connection
+    never has to run into the idle timeout.
   */
-  digitalWrite(4, HIGH);
-  camera_fb_t *fb = esp_camera_fb_get();
-  if (!fb) { 
-    digitalWrite(4, LOW);
-    return -1; 
+  static uint8_t response_body[RESPONSE_BODY_MAX];
+  uint8_t rx[256];
+  http_response_t res;
+  httpResponseInit(&res, response_body, sizeof(response_body));
+
+  uint32_t __t_upload_end = halMillis();
+  uint32_t __t_resp_wait_end = 0;
+  uint32_t start = halMillis();
+  while (!httpResponseDone(&res)) {
+    int available = client->available();
+    if (available > 0) {
+      if (!__t_resp_wait_end) __t_resp_wait_end = halMillis();
+
+      int n = client->read(rx, (size_t)available < sizeof(rx) ? (size_t)available : sizeof(rx));
+      if (n > 0) {
+        metricsCount(COUNTER_BYTES_RECEIVED, n);
+        httpResponseFeed(&res, rx, n);
+        start = halMillis();   // reset timeout on progress
+      }
+    } else if (!client->connected()) {
+      httpResponseFinish(&res);
+    } else if (halMillis() - start > RESPONSE_TIMEOUT_MS) {
+      break;
+    } else {
+      halDelay(1);
+    }
+  }
+  if (__t_resp_wait_end) {
+    last_feedback.first_byte_ms = __t_resp_wait_end - __t_upload_end;
+    metricsRecordStage(STAGE_FIRST_BYTE, __t_resp_wait_end - __t_upload_end);
+    metricsRecordStage(STAGE_BODY_READ, halMillis() - __t_resp_wait_end);
+  }
+
+  int code = res.status_code > 0 ? res.status_code : -4;
+  last_feedback.retry_after_s = res.retry_after_s;
+  if (print && httpResponseDone(&res) && !httpResponseFailed(&res)) {
+    printResponse(&res);
   }
-  delay(100);
-  digitalWrite(4, LOW);
 
   /*
-    This little beast creates the HTTP request
+    On an incomplete or broken response or "Connection: close", close so the next
+    iteration can start fresh. A complete response keeps the connection, whatever
+    its status: the stream is still in sync, and a new TLS handshake is the most
+    expensive thing the upload path does.
   */
-  String filename = createFileName();
-  const String boundary = "----esp32_boundary";
+  if (httpResponseFailed(&res) || !httpResponseDone(&res) || !res.keep_alive) {
+    client->stop();
+  }
 
-  const String head =
-    String("--") + boundary + "\r\n" +
-    "Content-Disposition: form-data; name=\"image\"; filename=\"" + filename + "\"\r\n" +
-    "Content-Type: image/jpeg\r\n\r\n";
+  return code;
+}
 
-  const String tail = "\r\n--" + boundary + "--\r\n";
+/*
+  Sends a rendered (Content-Length) request and reads the response.
+*/
+static int sendRequest(const url_t *url, http_request_t *req, bool print) {
+  HalTransport *client = halUploadTransport();
+  if (!ensureConnected(client, url)) {
+    // Connection failed
+    return -2;
+  }
 
-  size_t contentLength = head.length() + fb->len + tail.length();
+  /*
+    POST request: headers + body with the image (fb) header + data
+  */
+  uint32_t __t_upload_start = halMillis();
+  uint8_t *staging = getStagingBuffer();
+  upload_ctx_t upload = { client, 0 };
+  http_write_stats_t write_stats;
+  bool complete = httpWriteGather(req->segments, req->segment_count, staging, staging_cap,
+                                  writeToTransport, &upload, &write_stats);
+  countWrites(&write_stats);
+  if (!complete) {
+    // Error while sending data
+    client->stop();             // <-- close on error so next call reconnects
+    return -3;
+  }
+  recordUpload(&upload, &write_stats, __t_upload_start);
 
-  /* prepare server connection */
-  url_t url = splitUrl(UPLOAD_URL);
+  return readResponse(client, print);
+}
 
-  // Initialize persistent client only once
-  static bool clientInitialized = false;
-  if (!clientInitialized) {
-    client.setInsecure();      // TODO: add proper certificate later
-    client.setNoDelay(true);   // disables Nagle
-    client.setTimeout(8000);
-    clientInitialized = true;
+/*
+  Writes the multipart body of a chunked request (httpStreamPart/Write/Flush).
+*/
+typedef bool (*stream_body_fn)(http_stream_t *stream, void *ctx);
+
+/*
+  Sends a chunked request whose body is produced by body() and reads the response.
+*/
+static int sendStream(const url_t *url, stream_body_fn body, void *ctx, bool print) {
+  HalTransport *client = halUploadTransport();
+  if (!ensureConnected(client, url)) {
+    return -2;
   }
 
-  /*
-    Ensure TCP connection (reuse if already connected)
-  */
-  unsigned long __t_conn_start = millis();
-  if (!client.connected()) {
-    if (!client.connect(url.host.c_str(), url.port)) {
-      // Connection failed
-      esp_camera_fb_return(fb);
-      return -2;
+  uint32_t __t_upload_start = halMillis();
+  uint8_t *staging = getStagingBuffer();
+  upload_ctx_t upload = { client, 0 };
+  http_stream_t stream;
+  bool complete = httpStreamBegin(&stream, url->host, url->path, deviceId(), staging, staging_cap,
+                                  writeToTransport, &upload)
+                  && body(&stream, ctx)
+                  && httpStreamEnd(&stream);
+  countWrites(&stream.stats);
+  if (!complete) {
+    client->stop();
+    return -3;
+  }
+  recordUpload(&upload, &stream.stats, __t_upload_start);
+
+  return readResponse(client, print);
+}
+
+/* complete frames, one part each */
+typedef struct {
+  camera_fb_t **fbs;
+  const frame_info_t *infos;
+  size_t count;
+} frames_body_t;
+
+static bool writeFrames(http_stream_t *stream, void *ctx) {
+  frames_body_t *frames = (frames_body_t *)ctx;
+  for (size_t i = 0; i < frames->count; i++) {
+    char filename[64];
+    createFileName(filename, sizeof(filename), &frames->infos[i]);
+    if (!httpStreamPart(stream, filename, frames->infos[i].roi_x, frames->infos[i].roi_y) ||
+        !httpStreamWrite(stream, frames->fbs[i]->buf, frames->fbs[i]->len)) {
+      return false;
     }
   }
-  unsigned long __t_conn_end = millis();
-  //Serial.println(String("---- TCP connect took ") + String((__t_conn_end - __t_conn_start) / 1000.0f, 3) + " seconds");
+  return true;
+}
 
-  /*
-    POST request header
-  */
-  unsigned long __t_hdr_start = millis();
-  client.print(String("POST ") + url.path + " HTTP/1.1\r\n");
-  client.print(String("Host: ") + url.host + "\r\n");
+/* one frame that is still being produced: every slice goes out as its own chunk */
+typedef struct {
+  const frame_info_t *info;
+  frame_slice_fn next;
+  void *ctx;
+} slices_body_t;
+
+static bool writeSlices(http_stream_t *stream, void *ctx) {
+  slices_body_t *slices = (slices_body_t *)ctx;
+  char filename[64];
+  createFileName(filename, sizeof(filename), slices->info);
+  if (!httpStreamPart(stream, filename, slices->info->roi_x, slices->info->roi_y)) {
+    return false;
+  }
+
+  size_t len;
+  const uint8_t *slice;
+  while ((slice = slices->next(slices->ctx, &len)) != NULL) {
+    if (!httpStreamWrite(stream, slice, len) || !httpStreamFlush(stream)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  // For HTTP/1.1 keep-alive is default, but being explicit doesn't hurt
-  client.print("Connection: keep-alive\r\n");
+int postImage(char *UPLOAD_URL, camera_fb_t *fb, const frame_info_t *info) {
+  uint32_t __t_all_start = halMillis();
+  memset(&last_feedback, 0, sizeof(last_feedback));
 
-  client.print(String("Content-Type: multipart/form-data; boundary=") + boundary + "\r\n");
-  client.print(String("Content-Length: ") + contentLength + "\r\n\r\n");
-  unsigned long __t_hdr_end = millis();
-  //Serial.println(String("---- POST headers took ") + String((__t_hdr_end - __t_hdr_start) / 1000.0f, 3) + " seconds");
+  /* prepare server connection */
+  url_t url;
+  if (!splitUrl(UPLOAD_URL, &url)) {
+    return -2;
+  }
 
   /*
-    Body with the image (fb) header + data
+    This little beast creates the HTTP request
+
+    Request line, headers and the multipart part header are rendered into one
+    buffer; together with the frame buffer and the closing boundary they form
+    a gather list that is written without any String concatenation.
   */
-  unsigned long __t_upload_start = millis();
-  client.print(head);
-  size_t sent = 0;
-  while (sent < fb->len) {
-    size_t chunk = client.write(fb->buf + sent, min((size_t)16384, fb->len - sent));
-    if (chunk == 0) {
-      // Error while sending data
-      unsigned long __t_upload_err = millis();
-      //Serial.println(String("---- upload (partial) took ") + String((__t_upload_err - __t_upload_start) / 1000.0f, 3) + " seconds");
-      client.stop();              // <-- close on error so next call reconnects
-      esp_camera_fb_return(fb);
+  int code;
+  if (chunked_upload) {
+    frames_body_t frames = { &fb, info, 1 };
+    code = sendStream(&url, writeFrames, &frames, true);
+  } else {
+    char filename[64];
+    createFileName(filename, sizeof(filename), info);
+
+    http_image_part_t image = { filename, fb->buf, fb->len, info->roi_x, info->roi_y };
+    static http_request_t req;
+    if (!buildImageRequest(&req, url.host, url.path, deviceId(), &image)) {
       return -3;
     }
-    sent += chunk;
+    code = sendRequest(&url, &req, true);
   }
-  client.print(tail);
-  unsigned long __t_upload_end = millis();
-  //Serial.println(String("---- upload took ") + String((__t_upload_end - __t_upload_start) / 1000.0f, 3) + " seconds");
 
-  /*
-    HTTP response
-  */
-  unsigned long __t_resp_wait_start = millis();
-  String status = client.readStringUntil('\n');
-  unsigned long __t_resp_wait_end = millis();
-
-  // Skip headers
-  while (client.connected()) {
-    String line = client.readStringUntil('\n');
-    if (line == "\r" || line.length() == 0) {
-      // Empty line = end of headers
-      break;
-    }
+  uint32_t __t_all_end = halMillis();
+  halLog("---- total post took %.3f seconds\n", (__t_all_end - __t_all_start) / 1000.0f);
+
+  return code;
+}
+
+int postBatch(char *UPLOAD_URL, camera_fb_t **fbs, const frame_info_t *infos, size_t count) {
+  uint32_t __t_all_start = halMillis();
+  memset(&last_feedback, 0, sizeof(last_feedback));
+
+  url_t url;
+  if (!splitUrl(UPLOAD_URL, &url)) {
+    return -2;
   }
 
-  // Read the JSON body
-  String response = "";
-  unsigned long start = millis();
-  while (client.connected() || client.available()) {
-    if (client.available()) {
-      char c = client.read();
-      response += c;
-      start = millis();      // reset timeout on progress
-    } else if (millis() - start > 5000) { // timeout (optional)
-      break;
-    }
+  if (count > HTTP_BATCH_MAX) {
+    return -3;
   }
 
-  printResponse(response);
+  if (chunked_upload) {
+    frames_body_t frames = { fbs, infos, count };
+    int code = sendStream(&url, writeFrames, &frames, false);
+    halLog("---- total post of %u images took %.3f seconds\n", (unsigned)count, (halMillis() - __t_all_start) / 1000.0f);
+    return code;
+  }
 
-  int code = -4;
-  if (status.startsWith("HTTP/1.1 ")) {
-    code = status.substring(9, 12).toInt();
+  /* one part per frame, each pointing straight into its frame buffer */
+  static char filenames[HTTP_BATCH_MAX][64];
+  http_image_part_t images[HTTP_BATCH_MAX];
+  for (size_t i = 0; i < count; i++) {
+    createFileName(filenames[i], sizeof(filenames[i]), &infos[i]);
+    images[i].filename = filenames[i];
+    images[i].jpeg = fbs[i]->buf;
+    images[i].len = fbs[i]->len;
+    images[i].roi_x = infos[i].roi_x;
+    images[i].roi_y = infos[i].roi_y;
   }
 
-  // On bad status code, close so the next iteration can start fresh
-  if (code < 200 || code >= 300) {
-    client.stop();
+  static http_request_t req;
+  if (!buildBatchRequest(&req, url.host, url.path, deviceId(), images, count)) {
+    return -3;
   }
-  // On success, we keep the connection open and reuse it next time
 
-  /*
-    ALWAYS free the image from memory otherwise the fun won't last for a long time...
-  */
-  esp_camera_fb_return(fb);
+  int code = sendRequest(&url, &req, false);
+
+  uint32_t __t_all_end = halMillis();
+  halLog("---- total post of %u images took %.3f seconds\n", (unsigned)count, (__t_all_end - __t_all_start) / 1000.0f);
 
-  unsigned long __t_all_end = millis();
-  Serial.println(String("---- total capture+post took ") + String((__t_all_end - __t_all_start) / 1000.0f, 3) + " seconds");
+  return code;
+}
+
+int postImageStream(char *UPLOAD_URL, const frame_info_t *info, frame_slice_fn next, void *ctx) {
+  uint32_t __t_all_start = halMillis();
+  memset(&last_feedback, 0, sizeof(last_feedback));
+
+  url_t url;
+  if (!splitUrl(UPLOAD_URL, &url)) {
+    return -2;
+  }
 
+  slices_body_t slices = { info, next, ctx };
+  int code = sendStream(&url, writeSlices, &slices, true);
+
+  halLog("---- total post took %.3f seconds\n", (halMillis() - __t_all_start) / 1000.0f);
   return code;
-}
\ No newline at end of file
+}
@@ -1,14 +1,73 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
-#include <Arduino.h>
+#include "hal.h"
 
 typedef struct {
-  String host;
+  char host[64];
   uint16_t port;
-  String path;
+  char path[128];
 } url_t;
 
-int postImage(char *UPLOAD_URL);
+/*
+  Extracts host, port and path from an upload URL.
+  Returns false if the host or path does not fit into url_t.
+*/
+bool splitUrl(const char *urlChars, url_t *url);
+
+#define TLS_CA_FILE "/ca.pem"
+#define TLS_PIN_FILE "/tls_pin.txt"
+#define TLS_CA_MAX 4096
+
+/*
+  Reads TLS_CA_FILE / TLS_PIN_FILE (if present) and hands them to the upload transport.
+  Call once after the filesystem is mounted.
+*/
+void loadUploadTrust();
+
+/*
+  Posts an already captured frame. The caller keeps ownership of fb
+  and has to hand it back with halCameraFbReturn().
+  info names the file on the server (capture time + sequence number).
+*/
+int postImage(char *UPLOAD_URL, camera_fb_t *fb, const frame_info_t *info);
+
+/*
+  Posts count (1..HTTP_BATCH_MAX) frames as one multipart request with one "image"
+  part per frame. Same ownership rules and return codes as postImage(); the
+  per-image results in the response are not parsed.
+*/
+int postBatch(char *UPLOAD_URL, camera_fb_t **fbs, const frame_info_t *infos, size_t count);
+
+/*
+  Sends the upload bodies of postImage()/postBatch() with Transfer-Encoding: chunked
+  instead of a Content-Length (NETWORK.CHUNKED). Off by default.
+*/
+void setChunkedUpload(bool chunked);
+
+/*
+  Source of a frame that is still being produced: blocks until the next slice is
+  there, returns it and its length, NULL after the last slice.
+*/
+typedef const uint8_t *(*frame_slice_fn)(void *ctx, size_t *len);
+
+/*
+  Posts one frame as a chunked request while it is produced: every slice goes out
+  as its own chunk as soon as next() returns it. Same return codes as postImage().
+*/
+int postImageStream(char *UPLOAD_URL, const frame_info_t *info, frame_slice_fn next, void *ctx);
+
+/*
+  What the last postImage()/postBatch() saw of the server and the link,
+  for the capture scheduler and the quality controller
+*/
+typedef struct {
+  size_t bytes_sent;        /* whole request, 0 if it was not sent completely */
+  uint32_t upload_ms;       /* first write until the last byte was accepted */
+  uint32_t first_byte_ms;   /* end of upload until the first response byte, 0 if none arrived */
+  uint32_t retry_after_s;   /* Retry-After header, 0 if absent */
+} upload_feedback_t;
+
+const upload_feedback_t *lastUploadFeedback();
 
 #endif
\ No newline at end of file
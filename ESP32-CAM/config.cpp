@@ -0,0 +1,514 @@
+#include "config.h"
+#include "http_request.h"
+#include "portal_request.h"
+#include <ArduinoJson.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* -------------------------------- */
+/* ------------ SCHEMA ------------ */
+/* -------------------------------- */
+static const char *const QUEUE_POLICY_NAMES[] = { "block", "drop_oldest" };      /* frame_queue_policy_t */
+static const char *const CAPTURE_FORMAT_NAMES[] = { "jpeg", "grayscale" };        /* capture_format_t */
+static const char *const POWER_MODE_NAMES[] = { "auto", "always_on", "deep_sleep" };   /* power_mode_t */
+
+#define TEXT(section, key, form, member, flags) \
+  { section, key, form, CONFIG_TEXT, offsetof(esp_config_t, member), sizeof(((esp_config_t *)0)->member), \
+    0, 0, 0, NULL, flags }
+#define INT(section, key, form, member, min, max, fallback) \
+  { section, key, form, CONFIG_INT, offsetof(esp_config_t, member), 0, min, max, fallback, NULL, 0 }
+#define CHOICE(section, key, form, member, names, fallback) \
+  { section, key, form, CONFIG_CHOICE, offsetof(esp_config_t, member), 0, \
+    0, (int32_t)(sizeof(names) / sizeof(names[0])) - 1, fallback, names, 0 }
+#define CAMERA(key, form, setting) \
+  { "CAMERA", key, form, CONFIG_CAMERA, setting, 0, 0, 0, 0, NULL, 0 }
+
+/*
+  Table order is file order. The defaults are the ones loadConfig() has always
+  used; the ranges are what the code behind each field copes with.
+*/
+static constexpr config_field_t FIELDS[] = {
+  TEXT("NETWORK",  "SSID",                   "ssid",       wifi_config.SSID,     CONFIG_REQUIRED),
+  TEXT("NETWORK",  "PASSWORD",               "password",   wifi_config.PASSWORD, 0),
+  TEXT("NETWORK",  "UPLOAD_URL",             "upload_url", UPLOAD_URL,           CONFIG_REQUIRED),
+  INT("NETWORK",   "CHUNKED",                "chunked",    CHUNKED_UPLOAD,       0, 1, 0),
+
+  CAMERA(          "RESOLUTION",             "res",        CAMERA_SET_FRAMESIZE),
+  CAMERA(          "CAPTURE_INTERVAL_IN_MS", "interval",   CAMERA_SET_INTERVAL),
+  CAMERA(          "VERTICAL_FLIP",          "vflip",      CAMERA_SET_VFLIP),
+  CAMERA(          "HORIZONTAL_MIRROR",      NULL,         CAMERA_SET_HMIRROR),
+  CAMERA(          "BRIGHTNESS",             "bright",     CAMERA_SET_BRIGHTNESS),
+  CAMERA(          "CONTRAST",               NULL,         CAMERA_SET_CONTRAST),
+  CAMERA(          "SATURATION",             "sat",        CAMERA_SET_SATURATION),
+  CAMERA(          "AUTO_EXPOSURE",          NULL,         CAMERA_SET_AUTO_EXPOSURE),
+  CAMERA(          "AE_LEVEL",               NULL,         CAMERA_SET_AE_LEVEL),
+  CAMERA(          "EXPOSURE",               NULL,         CAMERA_SET_EXPOSURE),
+  CAMERA(          "AUTO_GAIN",              NULL,         CAMERA_SET_AUTO_GAIN),
+  CAMERA(          "GAIN",                   NULL,         CAMERA_SET_GAIN),
+  CAMERA(          "AWB",                    NULL,         CAMERA_SET_AWB),
+  CAMERA(          "WB_MODE",                NULL,         CAMERA_SET_WB_MODE),
+  INT("CAMERA",    "QUEUE_DEPTH",            "qdepth",     QUEUE_DEPTH,          1, FRAME_QUEUE_MAX_DEPTH, 1),
+  CHOICE("CAMERA", "QUEUE_POLICY",           "qpolicy",    QUEUE_POLICY,         QUEUE_POLICY_NAMES, FRAME_QUEUE_DROP_OLDEST),
+  INT("CAMERA",    "MAX_FRAME_BYTES",        "fbytes",     MAX_FRAME_BYTES,      0, 1048576, 0),
+  INT("CAMERA",    "MAX_UPLOAD_MS",          "fms",        MAX_UPLOAD_MS,        0, 600000, 0),
+  INT("CAMERA",    "BATCH_SIZE",             "bsize",      BATCH_SIZE,           1, HTTP_BATCH_MAX, 1),
+  INT("CAMERA",    "BATCH_TIMEOUT_MS",       "btime",      BATCH_TIMEOUT_MS,     0, 3600000, 5000),
+  CHOICE("CAMERA", "PIXEL_FORMAT",           "pixfmt",     CAPTURE_FORMAT,       CAPTURE_FORMAT_NAMES, CAPTURE_JPEG),
+  INT("CAMERA",    "ROI_LEFT",               "roix",       ROI_LEFT,             0, ROI_REFERENCE_WIDTH - 1, 0),
+  INT("CAMERA",    "ROI_TOP",                "roiy",       ROI_TOP,              0, ROI_REFERENCE_HEIGHT - 1, 0),
+  INT("CAMERA",    "ROI_WIDTH",              "roiw",       ROI_WIDTH,            0, ROI_REFERENCE_WIDTH, 0),
+  INT("CAMERA",    "ROI_HEIGHT",             "roih",       ROI_HEIGHT,           0, ROI_REFERENCE_HEIGHT, 0),
+
+  INT("STORE",     "RAM_KB",                 "sram",       STORE_RAM_KB,         0, 4096, 1024),
+  INT("STORE",     "SPILL",                  "sspill",     STORE_SPILL,          0, 1, 0),
+
+  INT("MOTION",    "THRESHOLD",              "mthr",       MOTION_THRESHOLD,     0, 1000, 0),
+  INT("MOTION",    "KEEPALIVE_S",            "mkeep",      MOTION_KEEPALIVE_S,   0, 86400, 300),
+
+  TEXT("CONTROL",  "TOKEN",                  NULL,         CONTROL_TOKEN,        0),
+
+  CHOICE("POWER",  "MODE",                   "pmode",      POWER_MODE,           POWER_MODE_NAMES, POWER_AUTO),
+};
+#define FIELD_COUNT (sizeof(FIELDS) / sizeof(FIELDS[0]))
+
+#undef TEXT
+#undef INT
+#undef CHOICE
+#undef CAMERA
+
+/* ---- checks of the table, at compile time ---- */
+static constexpr bool sameText(const char *a, const char *b) {
+  return !a || !b ? !a && !b : *a == *b && (*a == '\0' || sameText(a + 1, b + 1));
+}
+
+static constexpr bool fieldValid(const config_field_t &f) {
+  return f.type == CONFIG_INT    ? f.min <= f.fallback && f.fallback <= f.max
+       : f.type == CONFIG_TEXT   ? f.size > 1
+       : f.type == CONFIG_CHOICE ? f.names != NULL && f.fallback >= 0 && f.fallback <= f.max
+       : f.offset < CAMERA_SETTING_COUNT;
+}
+
+/* field i clashes with none of the fields before it: key, form name, and its section ended before */
+static constexpr bool fieldClashes(size_t i, size_t j) {
+  return j < i && ((sameText(FIELDS[i].section, FIELDS[j].section) && sameText(FIELDS[i].key, FIELDS[j].key)) ||
+                   (FIELDS[i].form && sameText(FIELDS[i].form, FIELDS[j].form)) ||
+                   (j + 1 < i && sameText(FIELDS[i].section, FIELDS[j].section) &&
+                    !sameText(FIELDS[i].section, FIELDS[i - 1].section)) ||
+                   fieldClashes(i, j + 1));
+}
+
+static constexpr bool fieldsValid(size_t i) {
+  return i == FIELD_COUNT || (fieldValid(FIELDS[i]) && !fieldClashes(i, 0) && fieldsValid(i + 1));
+}
+
+static constexpr uint32_t cameraFields(size_t i) {
+  return i == FIELD_COUNT ? 0
+       : (FIELDS[i].type == CONFIG_CAMERA ? 1u << FIELDS[i].offset : 0) | cameraFields(i + 1);
+}
+
+static constexpr size_t cameraFieldCount(size_t i) {
+  return i == FIELD_COUNT ? 0 : (FIELDS[i].type == CONFIG_CAMERA ? 1 : 0) + cameraFieldCount(i + 1);
+}
+
+static_assert(fieldsValid(0), "config table: default out of range, key or form name twice, or a section split");
+static_assert(cameraFields(0) == (1u << CAMERA_SETTING_COUNT) - 1 && cameraFieldCount(0) == CAMERA_SETTING_COUNT,
+              "config table: every camera setting exactly once");
+
+size_t configFieldCount() {
+  return FIELD_COUNT;
+}
+
+const config_field_t *configField(size_t i) {
+  return i < FIELD_COUNT ? &FIELDS[i] : NULL;
+}
+
+const config_field_t *configFormField(const char *form) {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    if (FIELDS[i].form && strcmp(FIELDS[i].form, form) == 0) return &FIELDS[i];
+  }
+  return NULL;
+}
+
+static const config_field_t *findField(const char *section, const char *key) {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    if (strcmp(FIELDS[i].section, section) == 0 && strcmp(FIELDS[i].key, key) == 0) return &FIELDS[i];
+  }
+  return NULL;
+}
+
+/* -------------------------------- */
+/* ------------ FIELDS ------------ */
+/* -------------------------------- */
+static int *intField(esp_config_t *config, const config_field_t *field) {
+  return (int *)((uint8_t *)config + field->offset);
+}
+
+static char *textField(esp_config_t *config, const config_field_t *field) {
+  return (char *)config + field->offset;
+}
+
+/* optional sign, digits, nothing else, within long */
+static bool parseInt(const char *text, long *value) {
+  const char *digits = text[0] == '-' ? text + 1 : text;
+  if (!isdigit((unsigned char)digits[0])) return false;
+  char *end;
+  errno = 0;
+  *value = strtol(text, &end, 10);
+  return *end == '\0' && errno == 0;
+}
+
+bool configFieldSet(esp_config_t *config, const config_field_t *field, const char *text) {
+  long value;
+  switch (field->type) {
+    case CONFIG_INT:
+      if (!parseInt(text, &value) || value < field->min || value > field->max) return false;
+      *intField(config, field) = (int)value;
+      return true;
+
+    case CONFIG_TEXT:
+      if (strlen(text) >= field->size) return false;
+      memcpy(textField(config, field), text, strlen(text) + 1);
+      return true;
+
+    case CONFIG_CHOICE:
+      for (int32_t i = 0; i <= field->max; i++) {
+        if (strcasecmp(field->names[i], text) == 0) {
+          *intField(config, field) = (int)i;
+          return true;
+        }
+      }
+      return false;
+
+    case CONFIG_CAMERA: {
+      const camera_setting_desc_t *desc = cameraSettingDesc((camera_setting_t)field->offset);
+      return cameraSettingSetString(&config->CAMERA, desc->key, text) == CAMERA_UPDATE_OK;
+    }
+  }
+  return false;
+}
+
+static void fieldDefault(esp_config_t *config, const config_field_t *field) {
+  switch (field->type) {
+    case CONFIG_INT:
+    case CONFIG_CHOICE:
+      *intField(config, field) = field->fallback;
+      break;
+    case CONFIG_TEXT:
+      textField(config, field)[0] = '\0';
+      break;
+    case CONFIG_CAMERA:
+      config->CAMERA.value[field->offset] = cameraSettingDesc((camera_setting_t)field->offset)->fallback;
+      break;
+  }
+}
+
+void configDefaults(esp_config_t *config) {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    fieldDefault(config, &FIELDS[i]);
+  }
+}
+
+bool configComplete(const esp_config_t *config) {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    const config_field_t *field = &FIELDS[i];
+    if ((field->flags & CONFIG_REQUIRED) && ((const char *)config + field->offset)[0] == '\0') {
+      halLog("------ Could not read %s.%s from config file.\n", field->section, field->key);
+      return false;
+    }
+  }
+  return true;
+}
+
+void configRoi(const esp_config_t *config, roi_t *roi) {
+  *roi = { (uint16_t)config->ROI_LEFT, (uint16_t)config->ROI_TOP, (uint16_t)config->ROI_WIDTH, (uint16_t)config->ROI_HEIGHT };
+}
+
+/* -------------------------------- */
+/* ------------ LOADING ----------- */
+/* -------------------------------- */
+static constexpr size_t sectionCount(size_t i) {
+  return i == FIELD_COUNT ? 0 : (i == 0 || !sameText(FIELDS[i].section, FIELDS[i - 1].section)) + sectionCount(i + 1);
+}
+
+/*
+  The file is parsed by ArduinoJson in the buffer it was read into: strings stay
+  there (decoded in place), the document only holds one slot per member. It has
+  room for every field and section of the table, and as many members again for
+  keys the table does not know.
+*/
+#define CONFIG_JSON_MEMBERS (2 * (FIELD_COUNT + sectionCount(0)))
+typedef StaticJsonDocument<JSON_OBJECT_SIZE(CONFIG_JSON_MEMBERS)> config_document_t;
+
+/* strings for text, choices and the frame size, integers (or booleans) for the rest */
+static bool wantsString(const config_field_t *field) {
+  return field->type == CONFIG_TEXT || field->type == CONFIG_CHOICE ||
+         (field->type == CONFIG_CAMERA && field->offset == CAMERA_SET_FRAMESIZE);
+}
+
+static void fieldLoad(esp_config_t *config, const config_field_t *field, JsonVariantConst value) {
+  char number[24];
+  const char *text = NULL;
+  if (value.isNull()) {
+    return;   /* missing or null: the default */
+  } else if (wantsString(field)) {
+    if (value.is<const char *>()) text = value.as<const char *>();
+  } else if (value.is<bool>()) {
+    text = value.as<bool>() ? "1" : "0";
+  } else if (value.is<long>()) {
+    snprintf(number, sizeof(number), "%ld", value.as<long>());
+    text = number;
+  } else if (value.is<double>()) {
+    /* a fraction, or beyond long */
+    halLog("------ %s.%s out of range or too long, using the default\n", field->section, field->key);
+    return;
+  }
+
+  if (!text) {
+    halLog("------ %s.%s has the wrong type, using the default\n", field->section, field->key);
+  } else if (!configFieldSet(config, field, text)) {
+    halLog("------ %s.%s out of range or too long, using the default\n", field->section, field->key);
+  }
+}
+
+/* what the table does not know is logged, not kept */
+static void logUnknown(JsonObjectConst root) {
+  for (JsonPairConst section : root) {
+    if (!section.value().is<JsonObjectConst>()) {
+      halLog("------ %s is not a config section, ignored\n", section.key().c_str());
+      continue;
+    }
+    for (JsonPairConst member : section.value().as<JsonObjectConst>()) {
+      if (!findField(section.key().c_str(), member.key().c_str())) {
+        halLog("------ %s.%s is not a config field, ignored\n", section.key().c_str(), member.key().c_str());
+      }
+    }
+  }
+}
+
+config_load_t configParse(esp_config_t *config, char *text, size_t len) {
+  static config_document_t doc;
+  configDefaults(config);
+
+  /* a UTF-8 byte order mark, as some editors write it */
+  if (len >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0) {
+    text += 3;
+    len -= 3;
+  }
+
+  DeserializationError error = deserializeJson(doc, text, len, DeserializationOption::NestingLimit(CONFIG_JSON_DEPTH));
+  if (error == DeserializationError::TooDeep) return CONFIG_LOAD_TOO_DEEP;
+  if (error == DeserializationError::NoMemory) return CONFIG_LOAD_TOO_LARGE;
+  if (error || !doc.is<JsonObject>()) return CONFIG_LOAD_SYNTAX;
+
+  JsonObjectConst root = doc.as<JsonObjectConst>();
+  logUnknown(root);
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    fieldLoad(config, &FIELDS[i], root[FIELDS[i].section][FIELDS[i].key]);
+  }
+  return CONFIG_LOAD_OK;
+}
+
+config_load_t configLoadFile(const char *path, esp_config_t *config, char *buf, size_t cap) {
+  long length = configReadFile(path, (uint8_t *)buf, cap);
+  if (length < 0) {
+    configDefaults(config);
+    if (!halFsExists(path)) {
+      return CONFIG_LOAD_MISSING;
+    }
+    halLog("------ %s is larger than %u bytes, using defaults\n", path, (unsigned)cap);
+    return CONFIG_LOAD_TOO_LARGE;
+  }
+
+  config_load_t result = configParse(config, buf, (size_t)length);
+  if (result != CONFIG_LOAD_OK) {
+    halLog("------ %s is %s, using defaults\n", path, configLoadError(result));
+  }
+  return result;
+}
+
+const char *configLoadError(config_load_t result) {
+  switch (result) {
+    case CONFIG_LOAD_OK:        return "ok";
+    case CONFIG_LOAD_MISSING:   return "not found";
+    case CONFIG_LOAD_TOO_LARGE: return "too large";
+    case CONFIG_LOAD_SYNTAX:    return "not valid JSON";
+    case CONFIG_LOAD_TOO_DEEP:  return "nested too deep";
+  }
+  return "?";
+}
+
+bool loadConfig(esp_config_t *esp_config) {
+  static char file[CONFIG_FILE_MAX];
+
+  if (!halFsBegin()) {
+    halLog("-- SPIFFS mount failed\n");
+    configDefaults(esp_config);
+    return false;
+  }
+
+  config_load_t result = configLoadFile(esp_config->CONFIG_FILE, esp_config, file, sizeof(file));
+  if (result == CONFIG_LOAD_MISSING) {
+    halLog("%s not found\n", esp_config->CONFIG_FILE);
+  }
+  if (result != CONFIG_LOAD_OK) {
+    return false;
+  }
+  return configComplete(esp_config);
+}
+
+/* -------------------------------- */
+/* ------------ SAVING ------------ */
+/* -------------------------------- */
+/* the value of a field in the file and the form: a choice and the frame size by name */
+static void fieldJson(portal_json_t *json, const char *key, const esp_config_t *config, const config_field_t *field) {
+  esp_config_t *fields = (esp_config_t *)config;
+  switch (field->type) {
+    case CONFIG_INT:
+      portalJsonInt(json, key, *intField(fields, field));
+      break;
+    case CONFIG_TEXT:
+      portalJsonString(json, key, textField(fields, field));
+      break;
+    case CONFIG_CHOICE: {
+      int value = *intField(fields, field);
+      portalJsonString(json, key, field->names[value >= 0 && value <= field->max ? value : field->fallback]);
+      break;
+    }
+    case CONFIG_CAMERA:
+      if (field->offset == CAMERA_SET_FRAMESIZE) {
+        const char *name = cameraFramesizeName((framesize_t)config->CAMERA.value[field->offset]);
+        portalJsonString(json, key, name ? name : "vga");
+      } else {
+        portalJsonInt(json, key, config->CAMERA.value[field->offset]);
+      }
+      break;
+  }
+}
+
+size_t configWriteJson(const esp_config_t *config, char *buf, size_t cap) {
+  portal_json_t json;
+  portalJsonBegin(&json, buf, cap);
+
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    if (i == 0 || strcmp(FIELDS[i].section, FIELDS[i - 1].section) != 0) {
+      if (i > 0) portalJsonClose(&json);
+      portalJsonOpen(&json, FIELDS[i].section);
+    }
+    fieldJson(&json, FIELDS[i].key, config, &FIELDS[i]);
+  }
+  portalJsonClose(&json);
+  return portalJsonEnd(&json);
+}
+
+bool configSaveFile(const char *path, const esp_config_t *config, char *buf, size_t cap) {
+  size_t len = configWriteJson(config, buf, cap);
+  if (len == 0) {
+    halLog("---- config does not fit into %u bytes, %s not saved\n", (unsigned)cap, path);
+    return false;
+  }
+  return configWriteAtomic(path, (const uint8_t *)buf, len);
+}
+
+bool saveCameraSettings(const char *path, const camera_settings_t *settings) {
+  static char file[CONFIG_FILE_MAX];
+  static esp_config_t config;
+
+  /* keep the rest of the file; without one there is nothing to keep */
+  config_load_t result = configLoadFile(path, &config, file, sizeof(file));
+  if (result != CONFIG_LOAD_OK && result != CONFIG_LOAD_MISSING) {
+    halLog("---- %s is %s, camera settings not saved\n", path, configLoadError(result));
+    return false;
+  }
+  config.CAMERA = *settings;
+  return configSaveFile(path, &config, file, sizeof(file));
+}
+
+/* -------------------------------- */
+/* ------------- FORM ------------- */
+/* -------------------------------- */
+#define FORM_VALUE_MAX 256
+
+int configApplyForm(esp_config_t *config, const char *form) {
+  int refused = 0;
+  char value[FORM_VALUE_MAX];
+
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    const config_field_t *field = &FIELDS[i];
+    if (!field->form || !portalFormValue(form, field->form, value, sizeof(value))) continue;
+
+    if (!configFieldSet(config, field, value)) {
+      halLog("---- form field %s '%s' refused, %s.%s kept\n", field->form, value, field->section, field->key);
+      refused++;
+    }
+  }
+  return refused;
+}
+
+void configFormJson(portal_json_t *json, const esp_config_t *config) {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    if (FIELDS[i].form) fieldJson(json, FIELDS[i].form, config, &FIELDS[i]);
+  }
+
+  /* the ranges the page puts on its number inputs */
+  for (int bound = 0; bound < 2; bound++) {
+    portalJsonOpen(json, bound == 0 ? "min" : "max");
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+      const config_field_t *field = &FIELDS[i];
+      if (!field->form) continue;
+      if (field->type == CONFIG_INT) {
+        portalJsonInt(json, field->form, bound == 0 ? field->min : field->max);
+      } else if (field->type == CONFIG_CAMERA && field->offset != CAMERA_SET_FRAMESIZE) {
+        const camera_setting_desc_t *desc = cameraSettingDesc((camera_setting_t)field->offset);
+        portalJsonInt(json, field->form, bound == 0 ? desc->min : desc->max);
+      }
+    }
+    portalJsonClose(json);
+  }
+}
+
+/* -------------------------------- */
+/* -------- ATOMIC REPLACE -------- */
+/* -------------------------------- */
+#define CONFIG_PATH_MAX 48
+
+bool configWriteAtomic(const char *path, const uint8_t *data, size_t len) {
+  char fresh[CONFIG_PATH_MAX], backup[CONFIG_PATH_MAX];
+  snprintf(fresh, sizeof(fresh), "%s.new", path);
+  snprintf(backup, sizeof(backup), "%s.bak", path);
+
+  if (!halFsWriteFile(fresh, data, len)) {
+    halFsRemove(fresh);
+    return false;
+  }
+  if (halFsExists(path)) {
+    halFsRemove(backup);
+    if (!halFsRename(path, backup)) {
+      halFsRemove(fresh);
+      return false;
+    }
+  }
+  if (!halFsRename(fresh, path)) {
+    /* the old content is still complete under the backup name */
+    return false;
+  }
+  halFsRemove(backup);
+  return true;
+}
+
+long configReadFile(const char *path, uint8_t *buf, size_t cap) {
+  if (halFsExists(path)) {
+    return halFsReadFile(path, buf, cap);
+  }
+  char backup[CONFIG_PATH_MAX];
+  snprintf(backup, sizeof(backup), "%s.bak", path);
+  long length = halFsReadFile(backup, buf, cap);
+  if (length >= 0) {
+    halLog("-- %s missing, using %s\n", path, backup);
+  }
+  return length;
+}
@@ -0,0 +1,175 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "hal.h"
+#include "frame_queue.h"
+#include "camera_settings.h"
+#include "duty_cycle.h"
+#include "portal_page.h"
+#include "roi.h"
+
+/* config.json is read in one go into a buffer of this size */
+#define CONFIG_FILE_MAX 2048
+
+/* bearer token of the control endpoint (control.cpp), empty = endpoint off */
+#define CONFIG_TOKEN_MAX 65
+
+typedef struct {
+  char SSID[64];
+  char PASSWORD[64];
+} wifi_configuration_t;
+
+typedef struct {
+  char CONFIG_FILE[32];
+  wifi_configuration_t wifi_config;
+  char UPLOAD_URL[128];
+  int CHUNKED_UPLOAD;
+  camera_settings_t CAMERA;   /* resolution, interval and sensor controls */
+  int QUEUE_DEPTH;
+  frame_queue_policy_t QUEUE_POLICY;
+  int MAX_FRAME_BYTES;
+  int MAX_UPLOAD_MS;
+  int BATCH_SIZE;
+  int BATCH_TIMEOUT_MS;
+  capture_format_t CAPTURE_FORMAT;
+  int ROI_LEFT;               /* region of interest in UXGA pixels (roi.h), 0 width = whole frame */
+  int ROI_TOP;
+  int ROI_WIDTH;
+  int ROI_HEIGHT;
+  int STORE_RAM_KB;
+  int STORE_SPILL;
+  int MOTION_THRESHOLD;
+  int MOTION_KEEPALIVE_S;
+  char CONTROL_TOKEN[CONFIG_TOKEN_MAX];
+  power_mode_t POWER_MODE;    /* deep sleep between frames (duty_cycle.h) */
+} esp_config_t;
+
+
+/*
+  Schema of config.json
+
+  Every field of the file is one entry of a fixed table in config.cpp: its
+  section and key, its field in the portal form, where it lives in esp_config_t,
+  its range and its default. Loading, checking, saving and the values of the
+  portal form (GET /settings) all walk that table, so a new field is added in
+  one place. Static assertions check the table when it is compiled: defaults in
+  range, sections in one piece, no key or form field twice, every camera setting
+  (camera_settings.cpp) listed once.
+
+  The file is read into one buffer of CONFIG_FILE_MAX bytes and parsed there by
+  ArduinoJson: strings are decoded in place, and a static document sized from
+  the table only holds the members. The table is then walked against the
+  document. A missing field keeps its default; a value of the wrong type or out
+  of range is logged and keeps it too. Keys the table does not know are logged,
+  and are not written back by a save.
+*/
+#define CONFIG_JSON_DEPTH 8       /* objects/arrays inside each other, the top level counts */
+
+typedef enum {
+  CONFIG_INT = 0,     /* int, min..max */
+  CONFIG_TEXT,        /* char[size]; longer values are refused, not cut */
+  CONFIG_CHOICE,      /* enum kept as int, names[0..max] in the file and the form */
+  CONFIG_CAMERA       /* setting of camera_settings_t, range and default in camera_settings.cpp */
+} config_type_t;
+
+#define CONFIG_REQUIRED 0x01      /* CONFIG_TEXT: must not be empty */
+
+typedef struct {
+  const char *section;
+  const char *key;
+  const char *form;            /* field of the portal form and GET /settings, NULL = not in the form */
+  config_type_t type;
+  uint16_t offset;             /* into esp_config_t; CONFIG_CAMERA: the camera_setting_t */
+  uint16_t size;               /* CONFIG_TEXT: size of the buffer */
+  int32_t min;
+  int32_t max;
+  int32_t fallback;
+  const char *const *names;    /* CONFIG_CHOICE */
+  uint8_t flags;
+} config_field_t;
+
+typedef enum {
+  CONFIG_LOAD_OK = 0,
+  CONFIG_LOAD_MISSING,         /* no file */
+  CONFIG_LOAD_TOO_LARGE,       /* larger than the buffer, or more members than the document holds */
+  CONFIG_LOAD_SYNTAX,          /* not one JSON object */
+  CONFIG_LOAD_TOO_DEEP         /* nested deeper than CONFIG_JSON_DEPTH */
+} config_load_t;
+
+size_t configFieldCount();
+const config_field_t *configField(size_t i);
+
+/* NULL if no field has this form name */
+const config_field_t *configFormField(const char *form);
+
+/*
+  Sets a field from text (form value, or a JSON string or number). A value that
+  does not parse, is out of range or does not fit leaves the field as it was.
+*/
+bool configFieldSet(esp_config_t *config, const config_field_t *field, const char *text);
+
+/* every field at its default; CONFIG_FILE is left alone */
+void configDefaults(esp_config_t *config);
+
+/*
+  Parses text (len bytes, changed by the call) into config, starting from the
+  defaults. On an error config holds the defaults. Not reentrant: one document
+  serves every caller.
+*/
+config_load_t configParse(esp_config_t *config, char *text, size_t len);
+
+/* reads path (configReadFile()) into buf and parses it; config holds the defaults unless CONFIG_LOAD_OK */
+config_load_t configLoadFile(const char *path, esp_config_t *config, char *buf, size_t cap);
+const char *configLoadError(config_load_t result);
+
+/* false (and logged) if a CONFIG_REQUIRED field is empty */
+bool configComplete(const esp_config_t *config);
+
+/* CAMERA.ROI_LEFT/TOP/WIDTH/HEIGHT as a roi_t */
+void configRoi(const esp_config_t *config, roi_t *roi);
+
+/* the whole config as JSON, in table order; returns the length, 0 if it does not fit */
+size_t configWriteJson(const esp_config_t *config, char *buf, size_t cap);
+
+/* configWriteJson() into buf, then configWriteAtomic() */
+bool configSaveFile(const char *path, const esp_config_t *config, char *buf, size_t cap);
+
+/*
+  Applies the fields of a URL-encoded form (portal_request.h) that the table has a
+  form name for. A field the form does not carry keeps its value, a refused one is
+  logged and keeps it too. Returns the number of refused fields.
+*/
+int configApplyForm(esp_config_t *config, const char *form);
+
+/*
+  Adds every form field to an open JSON object under its form name, and the ranges
+  of the number fields as "min" and "max" objects.
+*/
+void configFormJson(portal_json_t *json, const esp_config_t *config);
+
+/* config->CONFIG_FILE, with the required fields */
+bool loadConfig(esp_config_t *esp_config);
+
+/*
+  Writes the camera settings into the CAMERA section of the config file,
+  keeping every other field of the table. Fails without writing if the file
+  is there but does not parse.
+*/
+bool saveCameraSettings(const char *path, const camera_settings_t *settings);
+
+/*
+  Replaces a file so that a power loss at any point leaves either the complete
+  old or the complete new content:
+
+    1. write <path>.new
+    2. rename <path> -> <path>.bak (SPIFFS cannot rename onto an existing file)
+    3. rename <path>.new -> <path>
+    4. remove <path>.bak
+
+  configReadFile() reads <path>, or <path>.bak if the power went between 2 and 3.
+  A <path>.new left over from a cut during 1 is never read.
+*/
+bool configWriteAtomic(const char *path, const uint8_t *data, size_t len);
+long configReadFile(const char *path, uint8_t *buf, size_t cap);
+
+#endif
@@ -0,0 +1,211 @@
+#include "control.h"
+#include "pipeline.h"
+#include "portal_request.h"
+#include "portal_page.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/*
+  One client at a time: the endpoint is for an operator or a script, not a browser
+  with parallel connections. Requests are parsed with the portal's parser
+  (portal_request.cpp) and answered through portal_page.cpp.
+*/
+#define CONTROL_READ_CHUNK 256
+#define CONTROL_POLL_MS 20
+#define CONTROL_CLIENT_TIMEOUT_MS 5000
+#define CONTROL_ANSWER_MAX 1024
+
+static WiFiServer control_server(CONTROL_PORT);
+static const esp_config_t *control_config;   /* token and file name; CAMERA is only the boot state */
+
+static size_t writeToClient(void *ctx, const uint8_t *data, size_t len) {
+  return ((WiFiClient *)ctx)->write(data, len);
+}
+
+/* compares every byte, so the time of the answer tells nothing about the token */
+static bool tokenMatches(const char *authorization) {
+  static const char prefix[] = "Bearer ";
+  if (strncmp(authorization, prefix, sizeof(prefix) - 1) != 0) {
+    return false;
+  }
+  const char *given = authorization + sizeof(prefix) - 1;
+  const char *token = control_config->CONTROL_TOKEN;
+  size_t given_len = strlen(given);
+  size_t token_len = strlen(token);
+
+  uint8_t diff = given_len != token_len;
+  for (size_t i = 0; i < token_len; i++) {
+    diff |= (uint8_t)token[i] ^ (uint8_t)(i < given_len ? given[i] : 0);
+  }
+  return diff == 0;
+}
+
+static void sendJson(WiFiClient &client, int status, const char *extra_headers, const char *json, size_t len,
+                     bool head_only = false) {
+  portalSendResponse(status, "application/json", extra_headers, (const uint8_t *)json, len, head_only,
+                     writeToClient, &client, NULL);
+}
+
+static void sendJsonError(WiFiClient &client, int status, const char *error, const char *setting = NULL) {
+  char json[160];
+  portal_json_t out;
+  portalJsonBegin(&out, json, sizeof(json));
+  portalJsonString(&out, "error", error);
+  if (setting) {
+    portalJsonString(&out, "setting", setting);
+  }
+  size_t len = portalJsonEnd(&out);
+  sendJson(client, status, status == 401 ? "WWW-Authenticate: Bearer\r\n" : NULL, json, len);
+}
+
+/*
+  -----------------------------
+  ---------- CAMERA -----------
+  -----------------------------
+*/
+static void sendSettings(WiFiClient &client, int status, const char *result, bool saved, bool head_only) {
+  static char json[CONTROL_ANSWER_MAX];
+  camera_settings_t settings;
+  pipelineCameraSettings(&settings);
+
+  portal_json_t out;
+  portalJsonBegin(&out, json, sizeof(json));
+  cameraSettingsJson(&out, &settings);
+  if (result) {
+    portalJsonString(&out, "result", result);
+    portalJsonInt(&out, "saved", saved);
+  }
+  size_t len = portalJsonEnd(&out);
+  if (len == 0) {
+    sendJsonError(client, 500, "answer too large");
+    return;
+  }
+  sendJson(client, status, "Cache-Control: no-store\r\n", json, len, head_only);
+}
+
+static void updateCamera(WiFiClient &client, const portal_request_t *req) {
+  static StaticJsonDocument<CONTROL_ANSWER_MAX> doc;
+  if (deserializeJson(doc, (const char *)req->form, req->form_len) || !doc.is<JsonObject>()) {
+    sendJsonError(client, 400, "body must be a JSON object");
+    return;
+  }
+
+  camera_settings_t current, next;
+  pipelineCameraSettings(&current);
+  next = current;
+
+  /* all or nothing: the first bad setting rejects the whole request */
+  for (JsonPair setting : doc.as<JsonObject>()) {
+    const char *key = setting.key().c_str();
+    JsonVariant value = setting.value();
+    camera_update_result_t result = value.is<const char *>() ? cameraSettingSetString(&next, key, value.as<const char *>())
+                                  : value.is<long>() || value.is<bool>() ? cameraSettingSet(&next, key, value.as<long>())
+                                  : CAMERA_UPDATE_BAD_VALUE;
+    if (result != CAMERA_UPDATE_OK) {
+      sendJsonError(client, 400, cameraUpdateError(result), key);
+      return;
+    }
+  }
+
+  if (cameraSettingsDiff(&current, &next) == 0) {
+    sendSettings(client, 200, "unchanged", false, false);
+    return;
+  }
+
+  Serial.println("-- Camera settings changed through the control endpoint");
+  pipeline_update_t update = pipelineUpdateCamera(&next);
+
+  /* store what the camera runs with now; a pending change is stored as requested */
+  camera_settings_t applied = next;
+  if (update != PIPELINE_UPDATE_PENDING) {
+    pipelineCameraSettings(&applied);
+  }
+  bool saved = saveCameraSettings(control_config->CONFIG_FILE, &applied);
+  if (!saved) {
+    Serial.println("---- Could not save the camera settings");
+  }
+
+  switch (update) {
+    case PIPELINE_UPDATE_APPLIED: sendSettings(client, 200, "applied", saved, false); break;
+    case PIPELINE_UPDATE_REINIT:  sendSettings(client, 200, "reinitialized", saved, false); break;
+    case PIPELINE_UPDATE_PENDING: sendSettings(client, 202, "pending", saved, false); break;
+    default:                      sendSettings(client, 500, "failed", saved, false); break;
+  }
+}
+
+/*
+  -----------------------------
+  ---------- SERVER -----------
+  -----------------------------
+*/
+static void handleRequest(WiFiClient &client, const portal_request_t *req) {
+  if (portalRequestFailed(req)) {
+    portalSendError(req->error, writeToClient, &client);
+    return;
+  }
+  /* the softAP side belongs to the configuration portal */
+  if (client.localIP() != WiFi.localIP()) {
+    sendJsonError(client, 403, "station interface only");
+    return;
+  }
+  if (!tokenMatches(req->authorization)) {
+    sendJsonError(client, 401, "missing or wrong token");
+    return;
+  }
+  if (strcmp(req->path, "/camera") != 0) {
+    sendJsonError(client, 404, "unknown path");
+    return;
+  }
+
+  if (strcmp(req->method, "POST") == 0) {
+    updateCamera(client, req);
+  } else {
+    sendSettings(client, 200, NULL, false, strcmp(req->method, "HEAD") == 0);
+  }
+}
+
+static void controlTask(void *arg) {
+  static portal_request_t req;
+  uint8_t buf[CONTROL_READ_CHUNK];
+
+  control_server.begin();
+  for (;;) {
+    WiFiClient client = control_server.available();
+    if (!client) {
+      vTaskDelay(pdMS_TO_TICKS(CONTROL_POLL_MS));
+      continue;
+    }
+    client.setNoDelay(true);
+
+    portalRequestInit(&req);
+    uint32_t last_activity = millis();
+    while (!portalRequestDone(&req) && client.connected() && millis() - last_activity < CONTROL_CLIENT_TIMEOUT_MS) {
+      int n = client.available() > 0 ? client.read(buf, sizeof(buf)) : 0;
+      if (n > 0) {
+        portalRequestFeed(&req, buf, n);
+        last_activity = millis();
+      } else {
+        vTaskDelay(pdMS_TO_TICKS(5));
+      }
+    }
+
+    if (portalRequestDone(&req)) {
+      handleRequest(client, &req);
+    }
+    client.stop();
+  }
+}
+
+void startControlServer(const esp_config_t *esp_config) {
+  control_config = esp_config;
+  if (!esp_config->CONTROL_TOKEN[0]) {
+    Serial.println("-- control endpoint off (no CONTROL.TOKEN in the config)");
+    return;
+  }
+
+  Serial.printf("-- control endpoint on http://%s:%d/camera\n", WiFi.localIP().toString().c_str(), CONTROL_PORT);
+  xTaskCreatePinnedToCore(controlTask, "control", 6144, NULL, 1, NULL, 0);
+}
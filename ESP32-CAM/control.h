@@ -0,0 +1,24 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include "config.h"
+
+#define CONTROL_PORT 8080
+
+/*
+  Control endpoint on the station interface: changes the camera settings while the
+  device runs, without the access point and without a restart.
+
+    GET  /camera   current settings as JSON (keys: see camera_settings.cpp)
+    POST /camera   JSON object with the settings to change, e.g.
+                   {"resolution": "sxga", "auto_exposure": 0, "exposure": 400}
+
+  Every request needs "Authorization: Bearer <CONTROL.TOKEN>" from config.json;
+  without a token the endpoint is not started. A change is applied by the capture
+  task (pipelineUpdateCamera()) and then written into config.json, so it survives
+  a restart. esp_config->CAMERA is not touched: it is read by the loop task
+  without a lock, and the running settings are pipelineCameraSettings().
+*/
+void startControlServer(const esp_config_t *esp_config);
+
+#endif
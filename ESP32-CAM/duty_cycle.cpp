@@ -0,0 +1,133 @@
+#include "duty_cycle.h"
+#include "frame_store.h"
+#include <stddef.h>
+#include <string.h>
+
+/* averages are kept in ms * 16 and follow a quarter of each new sample */
+#define AVG_SHIFT 4
+
+static uint32_t average(uint32_t avg, uint32_t sample_ms) {
+  uint32_t sample = sample_ms << AVG_SHIFT;
+  return avg == 0 ? sample : avg - (avg >> 2) + (sample >> 2);
+}
+
+static uint32_t stateCrc(const duty_state_t *state) {
+  return crc32Update(0, (const uint8_t *)state, offsetof(duty_state_t, crc));
+}
+
+/* -------------------------------- */
+/* ------------ STATE ------------- */
+/* -------------------------------- */
+uint32_t dutyConfigCrc(const char *ssid, const char *upload_url) {
+  uint32_t crc = crc32Update(0, (const uint8_t *)ssid, strlen(ssid) + 1);
+  return crc32Update(crc, (const uint8_t *)upload_url, strlen(upload_url) + 1);
+}
+
+void dutyStateInit(duty_state_t *state, uint32_t config_crc, uint32_t interval_ms) {
+  memset(state, 0, sizeof(*state));
+  state->config_crc = config_crc;
+  schedulerInit(&state->scheduler, interval_ms);
+}
+
+void dutyStateSeal(duty_state_t *state) {
+  state->magic = DUTY_STATE_MAGIC;
+  state->version = DUTY_STATE_VERSION;
+  state->size = sizeof(*state);
+  state->crc = stateCrc(state);
+}
+
+bool dutyStateValid(const duty_state_t *state, uint32_t config_crc) {
+  return state->magic == DUTY_STATE_MAGIC && state->version == DUTY_STATE_VERSION &&
+         state->size == sizeof(*state) && state->crc == stateCrc(state) &&
+         state->config_crc == config_crc &&
+         state->session_len <= sizeof(state->session) && state->channel <= 14 &&
+         state->scheduler.target_ms > 0;
+}
+
+/* -------------------------------- */
+/* ------------ TIMING ------------ */
+/* -------------------------------- */
+uint32_t dutyNow(const duty_state_t *state, uint32_t millis_now) {
+  return state->clock_ms + millis_now;
+}
+
+uint32_t dutyWakeCost(const duty_state_t *state) {
+  return state->awake_avg ? state->awake_avg >> AVG_SHIFT : DUTY_WAKE_MS;
+}
+
+bool dutyTimeSyncDue(const duty_state_t *state, bool time_set, uint32_t now) {
+  return !time_set || now - state->time_sync_ms >= DUTY_TIME_SYNC_MS;
+}
+
+uint32_t dutyEndWake(duty_state_t *state, uint32_t capture_ms, uint32_t awake_ms, uint32_t delay_ms) {
+  state->awake_avg = average(state->awake_avg, awake_ms + DUTY_BOOT_MS);
+  state->lead_avg = average(state->lead_avg, capture_ms + DUTY_BOOT_MS);
+
+  /* wake up early enough that the capture, not the wake, falls on the interval */
+  uint32_t lead = state->lead_avg >> AVG_SHIFT;
+  uint32_t sleep_ms = delay_ms > lead + DUTY_MIN_SLEEP_MS ? delay_ms - lead : DUTY_MIN_SLEEP_MS;
+
+  state->clock_ms += awake_ms + sleep_ms + DUTY_BOOT_MS;
+  state->last_sleep_ms = sleep_ms;
+  state->wakes++;
+  return sleep_ms;
+}
+
+/* -------------------------------- */
+/* ------------ POWER ------------- */
+/* -------------------------------- */
+uint32_t dutyAverageUa(const duty_power_t *power, power_mode_t mode, uint32_t interval_ms,
+                       uint32_t wake_ms, uint32_t busy_ms) {
+  uint64_t charge;   /* µA * ms per frame */
+
+  if (mode == POWER_DEEP_SLEEP) {
+    if (interval_ms < wake_ms + DUTY_MIN_SLEEP_MS) interval_ms = wake_ms + DUTY_MIN_SLEEP_MS;
+    charge = (uint64_t)power->active_ua * wake_ms + (uint64_t)power->sleep_ua * (interval_ms - wake_ms);
+  } else {
+    if (interval_ms == 0) interval_ms = 1;
+    if (busy_ms > interval_ms) busy_ms = interval_ms;
+    charge = (uint64_t)power->active_ua * busy_ms + (uint64_t)power->idle_ua * (interval_ms - busy_ms);
+  }
+  return (uint32_t)(charge / interval_ms);
+}
+
+power_mode_t dutyChooseMode(power_mode_t configured, bool sleeping, const duty_power_t *power,
+                            uint32_t interval_ms, uint32_t wake_ms, uint32_t busy_ms) {
+  if (configured != POWER_AUTO) {
+    return configured;
+  }
+  /* sleeping would capture less often than configured */
+  if (interval_ms < wake_ms + DUTY_MIN_SLEEP_MS) {
+    return POWER_ALWAYS_ON;
+  }
+
+  uint64_t on = dutyAverageUa(power, POWER_ALWAYS_ON, interval_ms, wake_ms, busy_ms);
+  uint64_t asleep = dutyAverageUa(power, POWER_DEEP_SLEEP, interval_ms, wake_ms, busy_ms);
+  if (sleeping) {
+    return on * 100 < asleep * (100 - DUTY_HYSTERESIS_PCT) ? POWER_ALWAYS_ON : POWER_DEEP_SLEEP;
+  }
+  return asleep * 100 < on * (100 - DUTY_HYSTERESIS_PCT) ? POWER_DEEP_SLEEP : POWER_ALWAYS_ON;
+}
+
+uint32_t dutyBreakEvenMs(const duty_power_t *power, uint32_t wake_ms, uint32_t busy_ms) {
+  if (power->idle_ua <= power->sleep_ua) {
+    return UINT32_MAX;
+  }
+  /* active*wake + sleep*(T - wake) = active*busy + idle*(T - busy), solved for T */
+  int64_t numerator = (int64_t)power->active_ua * ((int64_t)wake_ms - busy_ms) +
+                      (int64_t)power->idle_ua * busy_ms - (int64_t)power->sleep_ua * wake_ms;
+  int64_t interval = numerator / (int64_t)(power->idle_ua - power->sleep_ua);
+  if (interval < (int64_t)wake_ms + DUTY_MIN_SLEEP_MS) {
+    interval = (int64_t)wake_ms + DUTY_MIN_SLEEP_MS;
+  }
+  return interval > UINT32_MAX ? UINT32_MAX : (uint32_t)interval;
+}
+
+const char *powerModeName(power_mode_t mode) {
+  switch (mode) {
+    case POWER_AUTO:       return "auto";
+    case POWER_ALWAYS_ON:  return "always_on";
+    case POWER_DEEP_SLEEP: return "deep_sleep";
+  }
+  return "?";
+}
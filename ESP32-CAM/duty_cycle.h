@@ -0,0 +1,137 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "scheduler.h"
+
+/*
+  Deep-sleep duty cycling
+
+  With long capture intervals the device spends most of its time waiting. Instead
+  of waiting awake (Wi-Fi associated, camera powered) it can deep-sleep between two
+  frames: every wake boots, captures one frame, uploads it and goes back to sleep.
+
+  Only the RTC memory survives the sleep, so everything the next wake needs to be
+  quick is kept there in duty_state_t: the frame number, the scheduler (backoffs
+  and Retry-After carry over), the BSSID and channel of the access point (no scan),
+  the TLS session (resumed handshake) and the measured cost of a wake. The state is
+  sealed with a CRC before sleeping; a power-on boot, a firmware with another layout
+  or another network/server finds it invalid and starts fresh.
+
+  Whether sleeping pays off depends on the interval: a wake costs a full boot, the
+  camera start and a Wi-Fi join, so below a break-even interval staying awake is
+  cheaper. dutyChooseMode() compares the average current of both modes.
+
+  Plain C++ without RTC or sleep calls: time is passed in, so the firmware
+  (ESP32-CAM.ino, pipeline.cpp) and host/duty_cycle_sim.cpp drive the exact same logic.
+*/
+#define DUTY_STATE_MAGIC 0x44555459u      /* "DUTY" */
+#define DUTY_STATE_VERSION 1
+
+/* a session with the server certificate kept for pinning is about 1.5 KB */
+#define DUTY_TLS_SESSION_MAX 2048
+
+#define DUTY_BOOT_MS 250              /* timer wake to setup(): ROM, bootloader, app start */
+#define DUTY_WAKE_MS 2500             /* cost of a wake until one was measured */
+#define DUTY_BUSY_MS 500              /* awake time of one frame when always on (capture + upload) */
+#define DUTY_MIN_SLEEP_MS 1000        /* shorter sleeps are not worth the boot */
+#define DUTY_HYSTERESIS_PCT 10        /* the other mode must be this much cheaper to switch */
+#define DUTY_TIME_SYNC_MS 3600000     /* the RTC slow clock drifts; NTP again after this long */
+
+typedef enum {
+  POWER_AUTO = 0,          /* deep sleep when it draws less current than staying awake */
+  POWER_ALWAYS_ON,
+  POWER_DEEP_SLEEP
+} power_mode_t;
+
+/* currents of the board, for the mode decision */
+typedef struct {
+  uint32_t active_ua;      /* awake: CPU, Wi-Fi and camera on */
+  uint32_t idle_ua;        /* always on, between two frames (no modem sleep, camera powered) */
+  uint32_t sleep_ua;       /* deep sleep, camera powered down */
+} duty_power_t;
+
+/* AI-Thinker ESP32-CAM: the regulator and the PSRAM keep deep sleep in the mA range */
+#define DUTY_POWER_DEFAULT { 160000, 110000, 6000 }
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t config_crc;       /* network and server the state belongs to */
+
+  uint32_t wakes;
+  uint32_t sequence;         /* number of the next frame */
+  uint32_t clock_ms;         /* device clock at millis() == 0 of this wake, ms since the state was created */
+  uint32_t last_sleep_ms;
+  uint32_t time_sync_ms;     /* device clock of the last NTP request */
+  uint32_t offline_wakes;    /* wakes in a row without a connection */
+
+  /* averages in ms * 16, 0 = not measured yet */
+  uint32_t awake_avg;        /* timer wake to sleep, DUTY_BOOT_MS included */
+  uint32_t lead_avg;         /* timer wake to capture, DUTY_BOOT_MS included */
+
+  /* access point of the last connection */
+  uint8_t bssid[6];
+  uint8_t channel;           /* 0 = none */
+
+  scheduler_t scheduler;
+
+  uint32_t session_len;      /* 0 = no TLS session */
+  uint8_t session[DUTY_TLS_SESSION_MAX];
+
+  uint32_t crc;              /* over everything above */
+} duty_state_t;
+
+/* identifies network and server; a state (AP, TLS session) for another one is not used */
+uint32_t dutyConfigCrc(const char *ssid, const char *upload_url);
+
+/* fresh state: frame 0, scheduler at interval_ms, nothing cached */
+void dutyStateInit(duty_state_t *state, uint32_t config_crc, uint32_t interval_ms);
+
+/* fills in magic, version, size and CRC; call last before sleeping */
+void dutyStateSeal(duty_state_t *state);
+
+/* true if state was sealed by this firmware for this config (RTC memory after a timer wake) */
+bool dutyStateValid(const duty_state_t *state, uint32_t config_crc);
+
+/* device clock of this wake, for the scheduler */
+uint32_t dutyNow(const duty_state_t *state, uint32_t millis_now);
+
+/* expected time awake per frame in deep sleep, boot included */
+uint32_t dutyWakeCost(const duty_state_t *state);
+
+/* true if this wake should ask NTP for the time */
+bool dutyTimeSyncDue(const duty_state_t *state, bool time_set, uint32_t now);
+
+/*
+  Ends a wake: feeds the measured times into the averages, advances the clock to
+  the next wake and returns how long to sleep. capture_ms and awake_ms are millis()
+  of the capture and of now, delay_ms the scheduler's delay until the next capture.
+  The wake is started early by the expected time from wake to capture.
+*/
+uint32_t dutyEndWake(duty_state_t *state, uint32_t capture_ms, uint32_t awake_ms, uint32_t delay_ms);
+
+/*
+  Average current of one mode at one frame every interval_ms, in µA.
+  wake_ms: awake time per frame in deep sleep, busy_ms: the same when always on.
+  Deep sleep cannot capture faster than wake_ms + DUTY_MIN_SLEEP_MS.
+*/
+uint32_t dutyAverageUa(const duty_power_t *power, power_mode_t mode, uint32_t interval_ms,
+                       uint32_t wake_ms, uint32_t busy_ms);
+
+/*
+  POWER_ALWAYS_ON or POWER_DEEP_SLEEP for a configured mode. POWER_AUTO sleeps when it
+  draws less current and the interval leaves room for it; sleeping is the mode the
+  device is in now, the other one has to be DUTY_HYSTERESIS_PCT cheaper to switch.
+*/
+power_mode_t dutyChooseMode(power_mode_t configured, bool sleeping, const duty_power_t *power,
+                            uint32_t interval_ms, uint32_t wake_ms, uint32_t busy_ms);
+
+/* shortest interval at which deep sleep draws less than always on */
+uint32_t dutyBreakEvenMs(const duty_power_t *power, uint32_t wake_ms, uint32_t busy_ms);
+
+const char *powerModeName(power_mode_t mode);
+
+#endif
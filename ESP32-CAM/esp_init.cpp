@@ -1,10 +1,8 @@
 #include "esp_camera.h"
 #include "esp_wifi.h"
+#include "driver/gpio.h"
 #include "esp_init.h"
 #include <Arduino.h>
-#include <ArduinoJson.h>
-#include <FS.h>
-#include <SPIFFS.h>
 #include <WiFi.h>
 
 /* 
@@ -50,29 +48,176 @@ static const char* NTP2 = "time.google.com";
   camera types
 */
 camera_config_t config;
-sensor_t *sensor;
 int initialized = 0;
 
+/*
+  Raw frames are one byte per pixel and not compressed by the sensor; the camera
+  driver only delivers them reliably up to SVGA.
+*/
+#define GRAYSCALE_MAX_FRAMESIZE FRAMESIZE_SVGA
+
 /* -------------------------------- */
 /* ---------- CAMERA SETUP ---------- */
 /* -------------------------------- */
+/* camera_set_fn for the running sensor */
+static bool setSensor(void *ctx, camera_setting_t setting, int32_t value) {
+  sensor_t *s = (sensor_t *)ctx;
+  switch (setting) {
+    case CAMERA_SET_FRAMESIZE:     return s->set_framesize(s, (framesize_t)value) == 0;
+    case CAMERA_SET_VFLIP:         return s->set_vflip(s, value) == 0;          // some cameras mount upside-down
+    case CAMERA_SET_HMIRROR:       return s->set_hmirror(s, value) == 0;
+    case CAMERA_SET_BRIGHTNESS:    return s->set_brightness(s, value) == 0;
+    case CAMERA_SET_CONTRAST:      return s->set_contrast(s, value) == 0;
+    case CAMERA_SET_SATURATION:    return s->set_saturation(s, value) == 0;
+    case CAMERA_SET_AUTO_EXPOSURE: return s->set_exposure_ctrl(s, value) == 0;
+    case CAMERA_SET_AE_LEVEL:      return s->set_ae_level(s, value) == 0;
+    case CAMERA_SET_EXPOSURE:      return s->set_aec_value(s, value) == 0;
+    case CAMERA_SET_AUTO_GAIN:     return s->set_gain_ctrl(s, value) == 0;
+    case CAMERA_SET_GAIN:          return s->set_agc_gain(s, value) == 0;
+    case CAMERA_SET_AWB:           return s->set_whitebal(s, value) == 0;
+    case CAMERA_SET_WB_MODE:       return s->set_wb_mode(s, value) == 0;
+    default:                       return true;
+  }
+}
+
+/*
+  Sets the changed sensor settings (see camera_settings.h); the frame size must not
+  exceed the one the camera was initialized with.
+*/
+bool applyCameraSettings(const camera_settings_t *settings, uint32_t changes) {
+  sensor_t *s = initialized ? esp_camera_sensor_get() : NULL;
+  if (!s) {
+    Serial.println("---- Error when configuring camera sensor: Camera not initialized yet");
+    return false;
+  }
+  return cameraSettingsApply(settings, changes, setSensor, s);
+}
+
 void configure_camera_sensor(esp_config_t *esp_config) {
-  if (initialized) {
-    sensor = esp_camera_sensor_get();
+  /* the frame size is already set by esp_camera_init() */
+  uint32_t all = ((1u << CAMERA_SETTING_COUNT) - 1) & ~(1u << CAMERA_SET_FRAMESIZE);
+  applyCameraSettings(&esp_config->CAMERA, all);
+}
 
-    sensor->set_vflip(sensor, esp_config->vertical_flip);                     // Flips the image vertically (some cameras mount upside-down)
-    sensor->set_brightness(sensor, esp_config->brightness);           // Slightly increases brightness
-    sensor->set_saturation(sensor, esp_config->saturation);           // Reduces color saturation (for less "washed-out" images)
+framesize_t getInitFramesize() {
+  return config.frame_size;
+}
 
-    /* --- we can add more here --- */
-    /* https://randomnerdtutorials.com/esp32-cam-ov2640-camera-settings/ */
-  } else {
-    Serial.println("---- Error when configuring camera sensor: Camera not initialized yet");
+/*
+  Re-initializes the camera for a larger frame size. Every frame buffer must have
+  been returned. If the new size cannot be allocated, the old one is restored.
+*/
+bool reinitEspCamera(framesize_t framesize) {
+  if (config.pixel_format == PIXFORMAT_GRAYSCALE && framesize > GRAYSCALE_MAX_FRAMESIZE) {
+    Serial.printf("---- frame size %d is too large for grayscale capture\n", (int)framesize);
+    return false;
   }
+  framesize_t previous = config.frame_size;
+  esp_camera_deinit();
+  initialized = 0;
+
+  config.frame_size = framesize;
+  esp_err_t err = esp_camera_init(&config);
+  if (err != ESP_OK) {
+    Serial.printf("---- camera re-init at frame size %d failed: 0x%x\n", (int)framesize, err);
+    config.frame_size = previous;
+    if (esp_camera_init(&config) != ESP_OK) {
+      return false;
+    }
+    initialized = 1;
+    return false;
+  }
+  initialized = 1;
+  Serial.printf("---- camera re-initialized at frame size %d\n", (int)framesize);
+  return true;
 }
 
-void initEspCamera(framesize_t resolution) {
-  config.frame_size = resolution;
+void getCameraSetting(int *quality, framesize_t *framesize) {
+  sensor_t *s = esp_camera_sensor_get();
+  *quality = s ? s->status.quality : config.jpeg_quality;
+  *framesize = s ? s->status.framesize : config.frame_size;
+}
+
+/*
+  Changes quality / frame size at runtime. The frame size must not exceed the one the
+  camera was initialized with, the frame buffers are allocated for that one.
+*/
+void setCameraSetting(int quality, framesize_t framesize) {
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s) {
+    return;
+  }
+  if (s->status.framesize != framesize) {
+    s->set_framesize(s, framesize);
+  }
+  if (s->status.quality != quality) {
+    s->set_quality(s, quality);
+  }
+}
+
+/*
+  Image is captured through ESP API
+
+  flash is activated
+*/
+camera_fb_t *captureImage() {
+  digitalWrite(LED_GPIO_NUM, HIGH);
+  camera_fb_t *fb = halCameraFbGet();
+  if (!fb) {
+    digitalWrite(LED_GPIO_NUM, LOW);
+    return NULL;
+  }
+  delay(100);
+  digitalWrite(LED_GPIO_NUM, LOW);
+  return fb;
+}
+
+/*
+  PSRAM the frame buffers have to leave to the rest of the firmware: the offline
+  store (STORE.RAM_KB) is added to this, which covers its spill segment, the upload
+  staging buffer and the motion thumbnail.
+*/
+#define CAMERA_PSRAM_RESERVE (192 * 1024)
+
+/* the driver's JPEG frame buffer: width * height / 5 bytes (esp32-camera, cam_hal.c) */
+static size_t jpegBufferSize(framesize_t framesize) {
+  return (size_t)resolution[framesize].width * resolution[framesize].height / 5;
+}
+
+/*
+  One buffer per queue slot, one per frame being uploaded, and a spare. With
+  CAMERA_GRAB_LATEST the driver needs a free buffer to capture into: without the
+  spare a full queue plus the uploaded frames hold all of them, esp_camera_fb_get()
+  waits until an upload returns one, and drop_oldest behaves like block.
+
+  If that is more than fit, the batch shrinks first, then the queue; returns the
+  buffer count, at least 3 (queue 1, batch 1, spare).
+*/
+static int frameBuffersFor(int fit, int *queue_depth, int *batch_size) {
+  *batch_size = max(1, *batch_size);
+  while (*queue_depth + *batch_size + 1 > fit && *batch_size > 1) (*batch_size)--;
+  while (*queue_depth + *batch_size + 1 > fit && *queue_depth > 1) (*queue_depth)--;
+  return *queue_depth + *batch_size + 1;
+}
+
+/* frame buffers that fit into the free PSRAM next to the offline store */
+static int frameBuffersFit(const esp_config_t *esp_config) {
+  size_t reserve = (size_t)esp_config->STORE_RAM_KB * 1024 + CAMERA_PSRAM_RESERVE;
+  size_t free_psram = ESP.getFreePsram();
+  size_t budget = free_psram > reserve ? free_psram - reserve : 0;
+  return (int)(budget / jpegBufferSize(config.frame_size));
+}
+
+/*
+  With CAPTURE_GRAYSCALE the sensor delivers raw luma and halCameraFbGet() crops
+  and encodes the ROI (roi.h); queued frames are then encoded copies, so a single
+  raw buffer is enough.
+
+  queue_depth and batch_size are lowered to what the frame buffers allow: first to
+  what fits into the PSRAM, then once more for every init that fails for lack of it.
+*/
+void initEspCamera(const esp_config_t *esp_config, int *queue_depth, int *batch_size) {
+  config.frame_size = (framesize_t)esp_config->CAMERA.value[CAMERA_SET_FRAMESIZE];
   config.pixel_format = PIXFORMAT_JPEG;
   config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
   config.fb_location = CAMERA_FB_IN_PSRAM;
@@ -81,7 +226,6 @@ void initEspCamera(framesize_t resolution) {
 
   if (psramFound()) {
     config.jpeg_quality = 10;
-    config.fb_count = 2;
     config.grab_mode = CAMERA_GRAB_LATEST;
   } else {
     // this is just a fallback... don't know if the psram will ever not be found
@@ -92,8 +236,44 @@ void initEspCamera(framesize_t resolution) {
     config.fb_location  = CAMERA_FB_IN_DRAM;
   }
 
+  if (esp_config->CAPTURE_FORMAT == CAPTURE_GRAYSCALE && !psramFound()) {
+    Serial.println("---- grayscale capture needs PSRAM, capturing JPEG");
+  } else if (esp_config->CAPTURE_FORMAT == CAPTURE_GRAYSCALE) {
+    if (config.frame_size > GRAYSCALE_MAX_FRAMESIZE) {
+      Serial.printf("---- frame size %d is too large for grayscale capture, using SVGA\n", (int)config.frame_size);
+      config.frame_size = GRAYSCALE_MAX_FRAMESIZE;
+    }
+    config.pixel_format = PIXFORMAT_GRAYSCALE;
+    config.fb_count = 1;
+    config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
+  }
+  roi_t roi;
+  configRoi(esp_config, &roi);
+  halCameraCrop(config.pixel_format == PIXFORMAT_GRAYSCALE ? &roi : NULL);
+
+  if (config.grab_mode == CAMERA_GRAB_LATEST) {
+    int wanted_queue = *queue_depth, wanted_batch = *batch_size;
+    config.fb_count = frameBuffersFor(frameBuffersFit(esp_config), queue_depth, batch_size);
+    if (*queue_depth != wanted_queue || *batch_size != wanted_batch) {
+      Serial.printf("---- PSRAM for %d frame buffers only: queue depth %d, batch %d\n",
+                    config.fb_count, *queue_depth, *batch_size);
+    }
+  }
+
   Serial.println("-- initializing ESP camera");
   esp_err_t err = esp_camera_init(&config);
+  while (err != ESP_OK && config.fb_count > 1) {
+    /* one buffer less; below queue 1 + batch 1 + spare a single buffer, captured into when empty */
+    int fewer = config.fb_count - 1;
+    config.fb_count = frameBuffersFor(fewer, queue_depth, batch_size);
+    if (config.fb_count > fewer) {
+      config.fb_count = 1;
+      config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
+    }
+    Serial.printf("---- camera init failed: 0x%x, retrying with %d frame buffers (queue depth %d, batch %d)\n",
+                  err, config.fb_count, *queue_depth, *batch_size);
+    err = esp_camera_init(&config);
+  }
   if (err != ESP_OK) {
     Serial.printf("---- camera init failed: 0x%x\n", err);
     while (true) delay(1000);
@@ -127,31 +307,47 @@ void initEspPinout() {
   config.pin_pwdn = PWDN_GPIO_NUM;
   config.pin_reset = RESET_GPIO_NUM;
   config.xclk_freq_hz = 20000000;
+
+  /* released from the deep sleep hold of sleepEspCamera() */
+  gpio_hold_dis((gpio_num_t)PWDN_GPIO_NUM);
+  gpio_hold_dis((gpio_num_t)LED_GPIO_NUM);
   pinMode(LED_GPIO_NUM, OUTPUT);
 }
 
+/*
+  Before deep sleep: the sensor goes into power-down and the flash LED stays off.
+  Without the hold both pins float during the sleep and the sensor keeps drawing current.
+*/
+void sleepEspCamera() {
+  if (initialized) {
+    esp_camera_deinit();
+    initialized = 0;
+  }
+  pinMode(PWDN_GPIO_NUM, OUTPUT);
+  digitalWrite(PWDN_GPIO_NUM, HIGH);
+  digitalWrite(LED_GPIO_NUM, LOW);
+  gpio_hold_en((gpio_num_t)PWDN_GPIO_NUM);
+  gpio_hold_en((gpio_num_t)LED_GPIO_NUM);
+  gpio_deep_sleep_hold_en();
+}
+
 /* -------------------------------- */
 /* ---------- WIFI SETUP ---------- */
 /* -------------------------------- */
-void setupTime() {
+/*
+  Access point of the last connection. With its BSSID and channel the next
+  boot connects without scanning all channels.
+*/
+#define WIFI_AP_CACHE_FILE "/wifi_ap.bin"
+#define WIFI_AP_CACHE_MAGIC 0x57494649u
+
+void startTimeSync() {
   /*
-    Sets local time based on CEST from time servers (pool.ntp.org and time.google.com)
+    Sets local time based on CEST from time servers (pool.ntp.org and time.google.com).
+    SNTP answers in the background; until then frames are named by their time since
+    boot and get their wall time once it is set (halWallTime()).
   */
-  if (WiFi.status() == WL_CONNECTED) {
-    configTzTime(TZ_EU_CENTRAL, NTP1, NTP2);
-
-    struct tm tmcheck;
-    const uint32_t start = millis();
-    while (!getLocalTime(&tmcheck, 500 /*ms timeout*/)) {
-      if (millis() - start > 5000) {
-        Serial.println("------ WARNING: NTP time sync timed out.");
-        Serial.println("------ Could not sync time from NTP servers. Local time will be unavailable.");
-        break;
-      }
-    }
-  } else {
-    Serial.println("------ WiFi not available, could not sync time from NTP servers. Local time will be unavailable.");
-  }
+  configTzTime(TZ_EU_CENTRAL, NTP1, NTP2);
 }
 
 void tuneWifiForLatency() {
@@ -160,96 +356,48 @@ void tuneWifiForLatency() {
   //WiFi.setTxPower(WIFI_POWER_19_5dBm);     // Max TX power (if allowed)
 }
 
-void setupWifiConnection(wifi_configuration_t *wifi_config) {
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(wifi_config->SSID, wifi_config->PASSWORD);
-  Serial.printf("---- connecting to %s", wifi_config->SSID);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
-  }
-  Serial.printf("\n---- Connected. IP: %s\n", WiFi.localIP().toString().c_str());
-
-  setupTime();
-
-  tuneWifiForLatency();
-}
-
-/* -------------------------------- */
-/* ---------- ESP CONFIG ---------- */
-/* -------------------------------- */
-framesize_t getResolutionFromString(String resolutionString) {
-    resolutionString.toLowerCase();
-    if (resolutionString == "qvga") { return FRAMESIZE_QVGA; }
-    if (resolutionString == "vga") { return FRAMESIZE_VGA; }
-    if (resolutionString == "svga") { return FRAMESIZE_SVGA; }
-    if (resolutionString == "sxga") { return FRAMESIZE_SXGA; }
-    if (resolutionString == "uxga") { return FRAMESIZE_UXGA; }
-
-    /* fallback */
-    Serial.printf("------ Resolution '%s' is not supported. Using Default resolution VGA.\n", resolutionString);
-    return FRAMESIZE_VGA;
-}
-
-bool loadConfig(esp_config_t *esp_config) {
-  /* DEFAULTS */
-  esp_config->RESOLUTION = FRAMESIZE_VGA;
-  esp_config->CAPTURE_INTERVAL = 300;
-  esp_config->vertical_flip = 1;
-  esp_config->brightness = 1;
-  esp_config->saturation = -1;
-
-  if (!SPIFFS.begin(true)) {
-    Serial.println("-- SPIFFS mount failed");
+bool loadWifiApCache(const char *ssid, wifi_ap_cache_t *cache) {
+  if (halFsReadFile(WIFI_AP_CACHE_FILE, (uint8_t *)cache, sizeof(*cache)) != (long)sizeof(*cache)) {
     return false;
   }
+  /* a cache for another network is of no use */
+  return cache->magic == WIFI_AP_CACHE_MAGIC && cache->channel >= 1 && cache->channel <= 14 &&
+         strncmp(cache->ssid, ssid, sizeof(cache->ssid)) == 0;
+}
 
+void saveWifiApCache(const char *ssid) {
+  wifi_ap_cache_t cache = {};
+  cache.magic = WIFI_AP_CACHE_MAGIC;
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+  cache.channel = (uint8_t)WiFi.channel();
+  strlcpy(cache.ssid, ssid, sizeof(cache.ssid));
 
-  File file = SPIFFS.open(esp_config->CONFIG_FILE, "r");
-  if (!file) {
-    Serial.printf("%s not found\n", esp_config->CONFIG_FILE);
-    return false;
+  /* only write the flash when the access point changed */
+  wifi_ap_cache_t stored;
+  if (loadWifiApCache(ssid, &stored) && memcmp(&stored, &cache, sizeof(cache)) == 0) {
+    return;
   }
-
-  StaticJsonDocument<512> esp_config_doc;
-  DeserializationError err = deserializeJson(esp_config_doc, file);
-  file.close();
-  if (err) {
-    Serial.println("JSON parse error");
-    return false;
+  if (!halFsWriteFile(WIFI_AP_CACHE_FILE, (const uint8_t *)&cache, sizeof(cache))) {
+    Serial.println("---- Could not store the access point for the next boot");
   }
+}
 
-  strlcpy(
-    esp_config->wifi_config.SSID,
-    esp_config_doc["NETWORK"]["SSID"] | "",
-    sizeof(esp_config->wifi_config.SSID)
-  );
-  strlcpy(
-    esp_config->wifi_config.PASSWORD,
-    esp_config_doc["NETWORK"]["PASSWORD"] | "",
-    sizeof(esp_config->wifi_config.PASSWORD)
-  );
-  strlcpy(
-    esp_config->UPLOAD_URL,
-    esp_config_doc["NETWORK"]["UPLOAD_URL"] | "",
-    sizeof(esp_config->UPLOAD_URL)
-  );
-  
-  esp_config->RESOLUTION =getResolutionFromString(esp_config_doc["CAMERA"]["RESOLUTION"]);
-  esp_config->CAPTURE_INTERVAL = esp_config_doc["CAMERA"]["CAPTURE_INTERVAL_IN_MS"];
-  esp_config->vertical_flip = esp_config_doc["CAMERA"]["VERTICAL_FLIP"];
-  esp_config->brightness = esp_config_doc["CAMERA"]["BRIGHTNESS"];
-  esp_config->saturation = esp_config_doc["CAMERA"]["SATURATION"];
-  
-  if (!esp_config->wifi_config.SSID) {
-    Serial.println("------ Could not read SSID from config file.");
-    return false;
-  } else if (!esp_config->wifi_config.PASSWORD) {
-    Serial.println("------ Could not read PASSWORD from config file.");
-    return false;
-  } else if (!esp_config->UPLOAD_URL) {
-    Serial.println("------ Could not read UPLOAD_URL from config file.");
-    return false;
+void forgetWifiApCache() {
+  halFsRemove(WIFI_AP_CACHE_FILE);
+}
+
+void startWifiConnection(wifi_configuration_t *wifi_config, const wifi_ap_cache_t *cache) {
+  /* keeps the access point of the portal if it is open */
+  WiFi.persistent(false);                  // the config lives in config.json, no NVS write per connect
+  WiFi.enableSTA(true);
+  WiFi.setAutoReconnect(false);            // reconnects are driven by the boot sequence (boot.h)
+  WiFi.disconnect();
+
+  if (cache) {
+    Serial.printf("---- connecting to %s on channel %u\n", wifi_config->SSID, (unsigned)cache->channel);
+    WiFi.begin(wifi_config->SSID, wifi_config->PASSWORD, cache->channel, cache->bssid);
+  } else {
+    Serial.printf("---- connecting to %s\n", wifi_config->SSID);
+    WiFi.begin(wifi_config->SSID, wifi_config->PASSWORD);
   }
-  return true;
-}
\ No newline at end of file
+}
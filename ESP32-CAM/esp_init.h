@@ -2,28 +2,44 @@
 #define ESP_INIT_H
 
 #include "esp_camera.h"
+#include "config.h"
 
-typedef struct {
-  char SSID[64];
-  char PASSWORD[64];
-} wifi_configuration_t;
-
-typedef struct {
-  char CONFIG_FILE[32];
-  wifi_configuration_t wifi_config;
-  char UPLOAD_URL[128];
-  framesize_t RESOLUTION;
-  int CAPTURE_INTERVAL;
-  int vertical_flip;
-  int brightness;
-  int saturation;
-} esp_config_t;
-
-
-bool loadConfig(esp_config_t *esp_config);
 void initEspPinout();
-void initEspCamera(framesize_t resolution);
+/* lowers queue_depth and batch_size if their frame buffers do not fit into the PSRAM */
+void initEspCamera(const esp_config_t *esp_config, int *queue_depth, int *batch_size);
+camera_fb_t *captureImage();
+
+/* camera powered down for deep sleep; initEspPinout() + initEspCamera() bring it back */
+void sleepEspCamera();
 void configure_camera_sensor(esp_config_t *esp_config);
-void setupWifiConnection(wifi_configuration_t *wifi_config);
+
+/* live changes (control.cpp through the pipeline) */
+bool applyCameraSettings(const camera_settings_t *settings, uint32_t changes);
+framesize_t getInitFramesize();
+bool reinitEspCamera(framesize_t framesize);
+
+/* jpeg quality and frame size the sensor currently uses */
+void getCameraSetting(int *quality, framesize_t *framesize);
+void setCameraSetting(int quality, framesize_t framesize);
+
+/* access point of the last connection to ssid */
+typedef struct {
+  uint32_t magic;
+  uint8_t bssid[6];
+  uint8_t channel;
+  char ssid[33];
+} wifi_ap_cache_t;
+
+bool loadWifiApCache(const char *ssid, wifi_ap_cache_t *cache);
+void saveWifiApCache(const char *ssid);
+void forgetWifiApCache();
+
+/*
+  Starts connecting and returns right away; WiFi.status() tells when it is done.
+  With a cache the access point is joined by BSSID on its channel, without a scan.
+*/
+void startWifiConnection(wifi_configuration_t *wifi_config, const wifi_ap_cache_t *cache);
+void tuneWifiForLatency();
+void startTimeSync();
 
 #endif
\ No newline at end of file
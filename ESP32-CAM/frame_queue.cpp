@@ -0,0 +1,64 @@
+#include "frame_queue.h"
+#include <string.h>
+#include <strings.h>
+
+void frameQueueInit(frame_queue_t *queue, size_t depth, frame_queue_policy_t policy) {
+  memset(queue, 0, sizeof(*queue));
+
+  /* clamp depth to [1, FRAME_QUEUE_MAX_DEPTH] */
+  if (depth < 1) depth = 1;
+  if (depth > FRAME_QUEUE_MAX_DEPTH) depth = FRAME_QUEUE_MAX_DEPTH;
+
+  queue->depth = depth;
+  queue->policy = policy;
+}
+
+bool frameQueuePush(frame_queue_t *queue, void *frame, void **evicted) {
+  if (evicted) *evicted = NULL;
+
+  if (queue->count == queue->depth) {
+    if (queue->policy == FRAME_QUEUE_BLOCK) {
+      return false;
+    }
+
+    /* drop the oldest frame to make room for the new one */
+    if (evicted) *evicted = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % queue->depth;
+    queue->count--;
+    queue->dropped++;
+  }
+
+  queue->slots[(queue->head + queue->count) % queue->depth] = frame;
+  queue->count++;
+  queue->pushed++;
+  if (queue->count > queue->high_water) {
+    queue->high_water = queue->count;
+  }
+  return true;
+}
+
+bool frameQueuePop(frame_queue_t *queue, void **frame) {
+  if (queue->count == 0) {
+    return false;
+  }
+
+  *frame = queue->slots[queue->head];
+  queue->slots[queue->head] = NULL;
+  queue->head = (queue->head + 1) % queue->depth;
+  queue->count--;
+  queue->popped++;
+  return true;
+}
+
+size_t frameQueueCount(const frame_queue_t *queue) {
+  return queue->count;
+}
+
+frame_queue_policy_t getQueuePolicyFromString(const char *policyString) {
+  if (policyString && strcasecmp(policyString, "block") == 0) {
+    return FRAME_QUEUE_BLOCK;
+  }
+
+  /* fallback: always keep the freshest frames */
+  return FRAME_QUEUE_DROP_OLDEST;
+}
@@ -0,0 +1,57 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Upper bound for the configurable queue depth.
+  Every queued frame pins one camera frame buffer in PSRAM, so keep this small.
+*/
+#define FRAME_QUEUE_MAX_DEPTH 4
+
+typedef enum {
+  FRAME_QUEUE_BLOCK = 0,       /* producer waits until the consumer frees a slot */
+  FRAME_QUEUE_DROP_OLDEST = 1  /* producer evicts the oldest queued frame */
+} frame_queue_policy_t;
+
+/*
+  Bounded FIFO of frame pointers.
+
+  Not synchronized: the caller serializes every call (pipeline.cpp holds its queue
+  mutex around them). Knows nothing about the camera, so the same logic runs inside
+  the FreeRTOS pipeline and in a plain Linux process (host/frame_queue_bench.cpp).
+*/
+typedef struct {
+  void *slots[FRAME_QUEUE_MAX_DEPTH];
+  size_t depth;
+  size_t head;
+  size_t count;
+  frame_queue_policy_t policy;
+
+  /* statistics */
+  uint32_t pushed;
+  uint32_t popped;
+  uint32_t dropped;
+  size_t high_water;
+} frame_queue_t;
+
+void frameQueueInit(frame_queue_t *queue, size_t depth, frame_queue_policy_t policy);
+
+/*
+  Returns false if the queue is full and the policy is FRAME_QUEUE_BLOCK.
+  With FRAME_QUEUE_DROP_OLDEST the push always succeeds; the evicted frame (or NULL)
+  is handed back through *evicted so the caller can release it.
+*/
+bool frameQueuePush(frame_queue_t *queue, void *frame, void **evicted);
+
+/*
+  Returns false if the queue is empty.
+*/
+bool frameQueuePop(frame_queue_t *queue, void **frame);
+
+size_t frameQueueCount(const frame_queue_t *queue);
+
+frame_queue_policy_t getQueuePolicyFromString(const char *policyString);
+
+#endif
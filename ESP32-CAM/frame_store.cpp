@@ -0,0 +1,381 @@
+#include "frame_store.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SEGMENT_MAGIC 0x47534848  /* "HHSG" */
+#define RECORD_MAGIC  0x32464848  /* "HHF2": with the ROI offset; "HHFR" records are dropped */
+
+typedef struct {
+  uint32_t magic;
+  uint32_t generation;
+  uint32_t pending_end;
+  uint32_t crc;           /* over the three fields above */
+} segment_header_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t timestamp;
+  uint32_t len;
+  uint16_t roi_x;
+  uint16_t roi_y;
+  uint32_t crc;           /* over the JPEG bytes */
+} record_header_t;
+
+/*
+  -----------------------------
+  ---------- HELPERS ----------
+  -----------------------------
+*/
+
+/* CRC-32 (IEEE), nibble table: small enough for flash, fast enough for a few frames */
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+    crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+static size_t align4(size_t len) {
+  return (len + 3) & ~(size_t)3;
+}
+
+static void segmentPath(int index, char *path, size_t len) {
+  snprintf(path, len, FRAME_STORE_DIR "/seg%d.bin", index);
+}
+
+static bool writeSegmentHeader(frame_store_t *store, int index) {
+  store_segment_t *segment = &store->segments[index];
+  segment_header_t header = { SEGMENT_MAGIC, segment->generation, segment->pending_end, 0 };
+  header.crc = crc32Update(0, (const uint8_t *)&header, offsetof(segment_header_t, crc));
+
+  char path[32];
+  segmentPath(index, path, sizeof(path));
+  return halFsWriteAt(path, 0, (const uint8_t *)&header, sizeof(header));
+}
+
+static store_ram_entry_t *ramAt(frame_store_t *store, size_t i) {
+  return &store->ram[(store->ram_first + i) % FRAME_STORE_MAX_RAM_FRAMES];
+}
+
+/*
+  -----------------------------
+  ---------- FLASH ------------
+  -----------------------------
+*/
+
+/*
+  Rebuilds the in-memory index of one segment after a reboot.
+  The record chain is walked up to pending_end; anything that does not parse
+  (torn write, foreign data) cuts the segment off at the last good record.
+*/
+static void recoverSegment(frame_store_t *store, int index) {
+  store_segment_t *segment = &store->segments[index];
+  memset(segment, 0, sizeof(*segment));
+
+  char path[32];
+  segmentPath(index, path, sizeof(path));
+
+  segment_header_t header;
+  if (halFsReadAt(path, 0, (uint8_t *)&header, sizeof(header)) != (long)sizeof(header) ||
+      header.magic != SEGMENT_MAGIC ||
+      header.crc != crc32Update(0, (const uint8_t *)&header, offsetof(segment_header_t, crc)) ||
+      header.pending_end < sizeof(header) || header.pending_end > FRAME_STORE_SEGMENT_SIZE) {
+    return;
+  }
+
+  segment->generation = header.generation;
+  uint32_t offset = sizeof(header);
+  while (offset + sizeof(record_header_t) <= header.pending_end && segment->count < FRAME_STORE_SEGMENT_RECORDS) {
+    record_header_t record;
+    if (halFsReadAt(path, offset, (uint8_t *)&record, sizeof(record)) != (long)sizeof(record) ||
+        record.magic != RECORD_MAGIC ||
+        offset + sizeof(record) + record.len > header.pending_end) {
+      break;
+    }
+    segment->offsets[segment->count++] = offset;
+    offset += sizeof(record) + align4(record.len);
+  }
+  segment->pending_end = offset;
+
+  if (segment->pending_end != header.pending_end) {
+    store->corrupt++;
+    writeSegmentHeader(store, index);
+  }
+}
+
+/*
+  Picks the segment that takes the next record of `size` bytes:
+  the active one if it has room, otherwise an unused/empty one,
+  otherwise the oldest generation is recycled (its frames are lost).
+*/
+static int segmentForWrite(frame_store_t *store, size_t size) {
+  int active = store->active;
+  if (active >= 0) {
+    store_segment_t *segment = &store->segments[active];
+    if (segment->pending_end + size <= FRAME_STORE_SEGMENT_SIZE && segment->count < FRAME_STORE_SEGMENT_RECORDS) {
+      return active;
+    }
+  }
+
+  int target = -1;
+  for (int i = 0; i < FRAME_STORE_SEGMENTS; i++) {
+    if (i != active && store->segments[i].count == 0) {
+      target = i;
+      break;
+    }
+  }
+  if (target < 0) {
+    for (int i = 0; i < FRAME_STORE_SEGMENTS; i++) {
+      if (i == active) continue;
+      if (target < 0 || store->segments[i].generation < store->segments[target].generation) {
+        target = i;
+      }
+    }
+    store->dropped += store->segments[target].count;
+  }
+
+  store_segment_t *segment = &store->segments[target];
+  memset(segment, 0, sizeof(*segment));
+  segment->generation = store->next_generation++;
+  segment->pending_end = sizeof(segment_header_t);
+  if (!writeSegmentHeader(store, target)) {
+    return -1;
+  }
+  store->active = target;
+  return target;
+}
+
+static bool spillFrame(frame_store_t *store, const uint8_t *jpeg, size_t len, const frame_info_t *info) {
+  size_t size = sizeof(record_header_t) + align4(len);
+  if (sizeof(segment_header_t) + size > FRAME_STORE_SEGMENT_SIZE) {
+    return false;
+  }
+
+  int index = segmentForWrite(store, size);
+  if (index < 0) {
+    return false;
+  }
+  store_segment_t *segment = &store->segments[index];
+
+  char path[32];
+  segmentPath(index, path, sizeof(path));
+
+  /* the uptime is not stored (it means nothing after a reboot), so fix the wall time now if it is known */
+  uint32_t timestamp = info->timestamp == 0 && info->uptime_ms != 0 ? halWallTime(info->uptime_ms) : info->timestamp;
+  record_header_t record = { RECORD_MAGIC, info->sequence, timestamp, (uint32_t)len, info->roi_x, info->roi_y,
+                             crc32Update(0, jpeg, len) };
+  uint32_t offset = segment->pending_end;
+
+  /* record first, header last: until pending_end moves the record does not exist */
+  if (!halFsWriteAt(path, offset, (const uint8_t *)&record, sizeof(record)) ||
+      !halFsWriteAt(path, offset + sizeof(record), jpeg, len)) {
+    return false;
+  }
+  segment->pending_end = offset + size;
+  segment->offsets[segment->count++] = offset;
+  if (!writeSegmentHeader(store, index)) {
+    segment->count--;
+    segment->pending_end = offset;
+    return false;
+  }
+
+  store->spilled++;
+  return true;
+}
+
+/* records are consumed newest first, so removing one just moves pending_end back */
+static void popSegmentRecord(frame_store_t *store, int index) {
+  store_segment_t *segment = &store->segments[index];
+  segment->pending_end = segment->offsets[--segment->count];
+  writeSegmentHeader(store, index);
+}
+
+static int newestSegment(const frame_store_t *store) {
+  int newest = -1;
+  for (int i = 0; i < FRAME_STORE_SEGMENTS; i++) {
+    if (store->segments[i].count == 0) continue;
+    if (newest < 0 || store->segments[i].generation > store->segments[newest].generation) {
+      newest = i;
+    }
+  }
+  return newest;
+}
+
+/*
+  -----------------------------
+  ----------- RAM -------------
+  -----------------------------
+*/
+
+/*
+  Returns the arena offset where len bytes fit, -1 if they don't without evicting.
+*/
+static long ramFind(frame_store_t *store, size_t len) {
+  if (store->ram_count == 0) {
+    return len <= store->arena_cap ? 0 : -1;
+  }
+  if (store->ram_count == FRAME_STORE_MAX_RAM_FRAMES) {
+    return -1;
+  }
+
+  const store_ram_entry_t *oldest = ramAt(store, 0);
+  const store_ram_entry_t *newest = ramAt(store, store->ram_count - 1);
+  size_t write_pos = newest->offset + align4(newest->len);
+
+  if (newest->offset >= oldest->offset) {
+    /* [ free | oldest ... newest | free ] */
+    if (write_pos + len <= store->arena_cap) return write_pos;
+    if (len <= oldest->offset) return 0;
+  } else if (write_pos + len <= oldest->offset) {
+    /* [ ... newest | free | oldest ... ] */
+    return write_pos;
+  }
+  return -1;
+}
+
+static void evictOldestRam(frame_store_t *store) {
+  store_ram_entry_t *oldest = ramAt(store, 0);
+
+  if (!(store->spill && spillFrame(store, store->arena + oldest->offset, oldest->len, &oldest->info))) {
+    store->dropped++;
+  }
+  store->ram_first = (store->ram_first + 1) % FRAME_STORE_MAX_RAM_FRAMES;
+  store->ram_count--;
+}
+
+/*
+  -----------------------------
+  ----------- API -------------
+  -----------------------------
+*/
+void frameStoreInit(frame_store_t *store, uint8_t *arena, size_t arena_cap,
+                    uint8_t *scratch, size_t scratch_cap, bool spill) {
+  memset(store, 0, sizeof(*store));
+  store->arena = arena;
+  store->arena_cap = arena ? arena_cap : 0;
+  store->scratch = scratch;
+  store->scratch_cap = scratch ? scratch_cap : 0;
+  store->spill = spill && scratch;
+  store->active = -1;
+  store->next_generation = 1;
+
+  if (!store->spill) {
+    return;
+  }
+
+  for (int i = 0; i < FRAME_STORE_SEGMENTS; i++) {
+    recoverSegment(store, i);
+    if (store->segments[i].generation >= store->next_generation) {
+      store->next_generation = store->segments[i].generation + 1;
+    }
+  }
+  store->active = newestSegment(store);
+}
+
+bool frameStorePut(frame_store_t *store, const uint8_t *jpeg, size_t len, const frame_info_t *info) {
+  if (len > store->arena_cap) {
+    /* too big for RAM, may still fit into a segment */
+    if (store->spill && spillFrame(store, jpeg, len, info)) {
+      store->stored++;
+      return true;
+    }
+    store->dropped++;
+    return false;
+  }
+
+  long offset;
+  while ((offset = ramFind(store, len)) < 0) {
+    evictOldestRam(store);
+  }
+
+  memcpy(store->arena + offset, jpeg, len);
+  store_ram_entry_t *entry = &store->ram[(store->ram_first + store->ram_count) % FRAME_STORE_MAX_RAM_FRAMES];
+  entry->offset = offset;
+  entry->len = len;
+  entry->info = *info;
+  store->ram_count++;
+  store->stored++;
+  return true;
+}
+
+bool frameStorePeekNewest(frame_store_t *store, stored_frame_t *frame) {
+  if (store->ram_count > 0) {
+    const store_ram_entry_t *newest = ramAt(store, store->ram_count - 1);
+    frame->data = store->arena + newest->offset;
+    frame->len = newest->len;
+    frame->info = newest->info;
+    frame->source = STORED_RAM;
+    frame->segment = -1;
+    return true;
+  }
+
+  int index;
+  while ((index = newestSegment(store)) >= 0) {
+    store_segment_t *segment = &store->segments[index];
+    uint32_t offset = segment->offsets[segment->count - 1];
+
+    char path[32];
+    segmentPath(index, path, sizeof(path));
+
+    record_header_t record;
+    bool ok = halFsReadAt(path, offset, (uint8_t *)&record, sizeof(record)) == (long)sizeof(record) &&
+              record.magic == RECORD_MAGIC && record.len <= store->scratch_cap &&
+              halFsReadAt(path, offset + sizeof(record), store->scratch, record.len) == (long)record.len &&
+              crc32Update(0, store->scratch, record.len) == record.crc;
+
+    frame->data = store->scratch;
+    frame->len = record.len;
+    frame->info.sequence = record.sequence;
+    frame->info.timestamp = record.timestamp;
+    frame->info.uptime_ms = 0;   /* the record may be from an earlier boot */
+    frame->info.roi_x = record.roi_x;
+    frame->info.roi_y = record.roi_y;
+    frame->source = STORED_FLASH;
+    frame->segment = index;
+
+    if (ok) {
+      return true;
+    }
+
+    /* unreadable record: drop it and try the next one */
+    store->corrupt++;
+    popSegmentRecord(store, index);
+  }
+  return false;
+}
+
+void frameStoreAck(frame_store_t *store, const stored_frame_t *frame) {
+  if (frame->source == STORED_RAM) {
+    if (store->ram_count == 0) return;
+    store->ram_count--;
+  } else {
+    if (store->segments[frame->segment].count == 0) return;
+    popSegmentRecord(store, frame->segment);
+  }
+  store->drained++;
+}
+
+void frameStoreFlush(frame_store_t *store) {
+  if (!store->spill) {
+    return;
+  }
+  /* oldest first, so the newest frame ends up on top of the newest segment */
+  while (store->ram_count > 0) {
+    evictOldestRam(store);
+  }
+}
+
+size_t frameStoreCount(const frame_store_t *store) {
+  size_t count = store->ram_count;
+  for (int i = 0; i < FRAME_STORE_SEGMENTS; i++) {
+    count += store->segments[i].count;
+  }
+  return count;
+}
@@ -0,0 +1,102 @@
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include "hal.h"
+
+/*
+  Store-and-forward buffer for frames that could not be uploaded.
+
+  Two tiers:
+    RAM   - ring of JPEGs in one caller-provided arena (PSRAM). When it is full the
+            oldest frame is either dropped or, with spill enabled, moved to flash.
+    FLASH - FRAME_STORE_SEGMENTS log-structured segment files. Each starts with a
+            header holding a generation number and pending_end; records are only
+            valid below pending_end, so a crash while appending leaves the segment
+            consistent. When all segments are full the oldest generation is recycled.
+
+  Frames are handed out newest first (RAM, then the newest segment backwards), so
+  after an outage the most recent state of the hive reaches the server first.
+*/
+#define FRAME_STORE_DIR "/store"
+#define FRAME_STORE_MAX_RAM_FRAMES 64
+#define FRAME_STORE_SEGMENTS 4
+#define FRAME_STORE_SEGMENT_SIZE (192 * 1024)
+#define FRAME_STORE_SEGMENT_RECORDS 48
+
+typedef struct {
+  uint32_t offset;
+  uint32_t len;
+  frame_info_t info;
+} store_ram_entry_t;
+
+typedef struct {
+  uint32_t generation;   /* 0 = never used */
+  uint32_t pending_end;  /* end of the valid, not yet uploaded records */
+  uint16_t count;
+  uint32_t offsets[FRAME_STORE_SEGMENT_RECORDS];
+} store_segment_t;
+
+typedef enum {
+  STORED_RAM = 0,
+  STORED_FLASH
+} stored_source_t;
+
+/*
+  Frame returned by frameStorePeekNewest(); data stays valid until the next store call.
+*/
+typedef struct {
+  const uint8_t *data;
+  size_t len;
+  frame_info_t info;
+  stored_source_t source;
+  int segment;
+} stored_frame_t;
+
+typedef struct {
+  /* RAM tier */
+  uint8_t *arena;
+  size_t arena_cap;
+  store_ram_entry_t ram[FRAME_STORE_MAX_RAM_FRAMES];
+  size_t ram_first;
+  size_t ram_count;
+
+  /* FLASH tier */
+  bool spill;
+  store_segment_t segments[FRAME_STORE_SEGMENTS];
+  uint32_t next_generation;
+  int active;
+  uint8_t *scratch;      /* flash frames are read back into this buffer */
+  size_t scratch_cap;
+
+  /* statistics */
+  uint32_t stored;
+  uint32_t spilled;
+  uint32_t dropped;
+  uint32_t drained;
+  uint32_t corrupt;
+} frame_store_t;
+
+/*
+  scratch is only needed with spill enabled. With spill enabled the flash segments
+  left behind by a previous boot are recovered here.
+*/
+void frameStoreInit(frame_store_t *store, uint8_t *arena, size_t arena_cap,
+                    uint8_t *scratch, size_t scratch_cap, bool spill);
+
+/* copies the frame; returns false if it was dropped */
+bool frameStorePut(frame_store_t *store, const uint8_t *jpeg, size_t len, const frame_info_t *info);
+
+/* returns false if the store is empty */
+bool frameStorePeekNewest(frame_store_t *store, stored_frame_t *frame);
+
+/* removes the frame returned by the last frameStorePeekNewest() */
+void frameStoreAck(frame_store_t *store, const stored_frame_t *frame);
+
+/* moves every RAM frame to flash (e.g. before a restart); no-op without spill */
+void frameStoreFlush(frame_store_t *store);
+
+size_t frameStoreCount(const frame_store_t *store);
+
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t len);
+
+#endif
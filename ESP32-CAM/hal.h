@@ -0,0 +1,189 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "roi.h"
+
+/*
+  Hardware abstraction layer
+
+  The upload path (client.cpp), the config loader (config.cpp) and the pure
+  components only talk to the hardware through the functions below.
+
+    hal_esp32.cpp -> ESP32-CAM (esp_camera, mbedtls over WiFiClient, SPIFFS, millis)
+    hal_host.cpp  -> Linux stand-ins (JPEG files, POSIX sockets or OpenSSL, a directory, clock_gettime)
+
+  Exactly one of the two is compiled, selected by the ARDUINO define.
+*/
+
+#ifdef ARDUINO
+#include "esp_camera.h"
+#else
+/*
+  Host builds have no esp32-camera component; mirror the parts of its types that are used.
+*/
+typedef enum {
+  FRAMESIZE_96X96, FRAMESIZE_QQVGA, FRAMESIZE_QCIF, FRAMESIZE_HQVGA, FRAMESIZE_240X240,
+  FRAMESIZE_QVGA, FRAMESIZE_CIF, FRAMESIZE_HVGA, FRAMESIZE_VGA, FRAMESIZE_SVGA,
+  FRAMESIZE_XGA, FRAMESIZE_HD, FRAMESIZE_SXGA, FRAMESIZE_UXGA, FRAMESIZE_INVALID
+} framesize_t;
+
+typedef struct {
+  uint8_t *buf;
+  size_t len;
+  size_t width;
+  size_t height;
+} camera_fb_t;
+#endif
+
+/*
+  Metadata the firmware keeps for every captured frame
+*/
+typedef struct {
+  uint32_t sequence;
+  uint32_t timestamp;   /* capture time in seconds since epoch, 0 if the clock is not set */
+  uint32_t uptime_ms;   /* capture time in ms since boot (halMillis() clock), 0 if unknown */
+  uint16_t roi_x;       /* position of the frame in the captured one, 0/0 if not cropped (roi.h) */
+  uint16_t roi_y;
+} frame_info_t;
+
+/* -------------------------------- */
+/* ------------ CAMERA ------------ */
+/* -------------------------------- */
+camera_fb_t *halCameraFbGet();
+void halCameraFbReturn(camera_fb_t *fb);
+
+/* wall-clock capture time of fb (seconds since epoch), 0 if the clock is not set */
+uint32_t halFrameTimestamp(const camera_fb_t *fb);
+
+/* monotonic capture time of fb in the halMillis() clock, also valid before NTP */
+uint32_t halFrameUptime(const camera_fb_t *fb);
+
+/*
+  Grayscale capture (roi.h): with a roi, halCameraFbGet() cuts it out of every raw
+  frame and returns it JPEG-encoded, so the rest of the firmware still only sees
+  JPEG frames; NULL turns it off. The camera must deliver PIXFORMAT_GRAYSCALE
+  (esp_init.cpp); call before the first capture.
+*/
+void halCameraCrop(const roi_t *roi);
+
+/* position of fb in the captured frame, 0/0 if it was not cropped */
+void halFrameOffset(const camera_fb_t *fb, uint16_t *x, uint16_t *y);
+
+/*
+  Encodes an 8 bit grayscale image as JPEG at quality (1..100). *jpeg is allocated
+  by the encoder, free() it. False if the encoder failed.
+*/
+bool halJpegEncodeGray(const uint8_t *gray, uint16_t w, uint16_t h, int quality, uint8_t **jpeg, size_t *len);
+
+/*
+  Decodes a JPEG frame at 1/8 scale into 8 bit luma, max_w bytes per row.
+  Cheap: at this scale only the DC coefficient of every 8x8 block is needed.
+  Sets *w / *h to the thumbnail size (clipped to max_w x max_h); false if the
+  frame could not be decoded.
+*/
+bool halJpegLuma(const camera_fb_t *fb, uint8_t *luma, uint16_t max_w, uint16_t max_h, uint16_t *w, uint16_t *h);
+
+/* -------------------------------- */
+/* ---------- TRANSPORT ---------- */
+/* -------------------------------- */
+/*
+  Byte stream to the upload server. Mirrors the subset of Arduino's Client
+  that the upload path uses.
+*/
+class HalTransport {
+public:
+  virtual ~HalTransport() {}
+  virtual bool connect(const char *host, uint16_t port) = 0;
+  virtual bool connected() = 0;
+  virtual void stop() = 0;
+
+  /* returns bytes accepted, 0 on error */
+  virtual size_t write(const uint8_t *data, size_t len) = 0;
+
+  /* bytes that can be read without blocking */
+  virtual int available() = 0;
+
+  /* returns bytes read, <= 0 if nothing was available */
+  virtual int read(uint8_t *buf, size_t len) = 0;
+
+  /*
+    TLS only. ca_pem (NUL-terminated) enables certificate verification, pin_sha256
+    (32 bytes) pins the SHA-256 of the server's public key (SubjectPublicKeyInfo DER).
+    Either may be NULL; with neither the connection is encrypted but not authenticated.
+  */
+  virtual void setTrust(const char * /* ca_pem */, const uint8_t * /* pin_sha256 */) {}
+
+  /* TLS only: drop the cached session, the next connect does a full handshake */
+  virtual void forgetSession() {}
+
+  /* TLS only: true if the last connect resumed a cached session instead of a full handshake */
+  virtual bool sessionResumed() { return false; }
+
+  /*
+    TLS only: the cached session as bytes, to keep it where the transport does not
+    survive (RTC memory over deep sleep, duty_cycle.h). saveSession() returns its
+    length, 0 without a session or if it does not fit into cap. loadSession() makes
+    it the session offered on the next connect; call it after setTrust().
+  */
+  virtual size_t saveSession(uint8_t * /* buf */, size_t /* cap */) { return 0; }
+  virtual bool loadSession(const uint8_t * /* buf */, size_t /* len */) { return false; }
+};
+
+/* transport used for uploads (TLS on the ESP32, plain TCP or TLS on the host) */
+HalTransport *halUploadTransport();
+
+/* -------------------------------- */
+/* ---------- FILESYSTEM ---------- */
+/* -------------------------------- */
+bool halFsBegin();
+bool halFsExists(const char *path);
+
+/* returns the number of bytes read, -1 if the file is missing or larger than cap */
+long halFsReadFile(const char *path, uint8_t *buf, size_t cap);
+
+bool halFsWriteFile(const char *path, const uint8_t *data, size_t len);
+
+/* random access for log-structured files; WriteAt creates the file if needed */
+long halFsSize(const char *path);
+long halFsReadAt(const char *path, size_t offset, uint8_t *buf, size_t len);
+bool halFsWriteAt(const char *path, size_t offset, const uint8_t *data, size_t len);
+bool halFsRemove(const char *path);
+
+/* fails if to exists (SPIFFS); a single metadata update, so a power loss leaves either name */
+bool halFsRename(const char *from, const char *to);
+
+/* -------------------------------- */
+/* ------------ CLOCK ------------ */
+/* -------------------------------- */
+uint32_t halMillis();
+void halDelay(uint32_t ms);
+
+/* wall clock; false if it has not been set (e.g. no NTP sync yet) */
+bool halLocalTime(struct tm *timeinfo, uint32_t timeout_ms);
+
+/*
+  Seconds since epoch at the moment uptime_ms of the halMillis() clock, 0 if the
+  wall clock is not set yet. Frames captured before NTP answered get their real
+  time this way once it did.
+*/
+uint32_t halWallTime(uint32_t uptime_ms);
+
+/* -------------------------------- */
+/* ------------ SYSTEM ------------ */
+/* -------------------------------- */
+/* one-time allocation of a large buffer (PSRAM on the ESP32), NULL on failure */
+void *halAllocLarge(size_t len);
+
+/*
+  Stable ID of this camera, "esp32cam-" + the 12 hex digits of its factory MAC.
+  The backend keeps results and previews per ID.
+*/
+#define HAL_DEVICE_ID_MAX 32
+void halDeviceId(char *buf, size_t len);
+
+void halLog(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+#endif
@@ -0,0 +1,558 @@
+#ifdef ARDUINO
+
+#include "hal.h"
+#include <stdarg.h>
+#include <Arduino.h>
+#include <FS.h>
+#include <SPIFFS.h>
+#include <WiFiClient.h>
+#include <esp_mac.h>
+#include <esp_timer.h>
+#include <esp_jpg_decode.h>
+#include <img_converters.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/version.h>
+#include <mbedtls/x509_crt.h>
+
+/*
+  ESP32-CAM implementation of hal.h
+*/
+
+/* -------------------------------- */
+/* ------------ CAMERA ------------ */
+/* -------------------------------- */
+/*
+  A cropped frame: the encoded ROI in a camera_fb_t of its own (first member, so
+  the rest of the firmware can use it like a driver frame) plus its position.
+  The raw frame goes back to the driver as soon as the ROI is encoded.
+*/
+typedef struct {
+  camera_fb_t fb;
+  uint16_t x;
+  uint16_t y;
+} cropped_fb_t;
+
+static bool crop_enabled = false;
+static roi_t crop_roi;
+
+void halCameraCrop(const roi_t *roi) {
+  crop_enabled = roi != NULL;
+  if (roi) crop_roi = *roi;
+}
+
+static camera_fb_t *cropFrame(camera_fb_t *raw) {
+  roi_t fit;
+  if (raw->format != PIXFORMAT_GRAYSCALE || raw->len < raw->width * raw->height ||
+      !roiFit(&crop_roi, raw->width, raw->height, &fit)) {
+    Serial.printf("---- cannot crop a %ux%u frame (format %d)\n", (unsigned)raw->width, (unsigned)raw->height, (int)raw->format);
+    return NULL;
+  }
+  cropped_fb_t *frame = (cropped_fb_t *)calloc(1, sizeof(*frame));
+  if (!frame) return NULL;
+
+  sensor_t *s = esp_camera_sensor_get();
+  int quality = roiEncodeQuality(s ? s->status.quality : 10);
+  roiCrop(raw->buf, raw->width, &fit);
+  if (!halJpegEncodeGray(raw->buf, fit.w, fit.h, quality, &frame->fb.buf, &frame->fb.len)) {
+    Serial.println("---- encoding the ROI failed");
+    free(frame);
+    return NULL;
+  }
+
+  frame->fb.width = fit.w;
+  frame->fb.height = fit.h;
+  frame->fb.format = PIXFORMAT_JPEG;
+  frame->fb.timestamp = raw->timestamp;
+  frame->x = fit.x;
+  frame->y = fit.y;
+  return &frame->fb;
+}
+
+camera_fb_t *halCameraFbGet() {
+  camera_fb_t *fb = esp_camera_fb_get();
+  if (!fb || !crop_enabled) {
+    return fb;
+  }
+  camera_fb_t *cropped = cropFrame(fb);
+  esp_camera_fb_return(fb);
+  return cropped;
+}
+
+void halCameraFbReturn(camera_fb_t *fb) {
+  if (!crop_enabled) {
+    esp_camera_fb_return(fb);
+    return;
+  }
+  free(fb->buf);
+  free(fb);
+}
+
+void halFrameOffset(const camera_fb_t *fb, uint16_t *x, uint16_t *y) {
+  *x = crop_enabled ? ((const cropped_fb_t *)fb)->x : 0;
+  *y = crop_enabled ? ((const cropped_fb_t *)fb)->y : 0;
+}
+
+uint32_t halFrameTimestamp(const camera_fb_t *fb) {
+  struct tm timeinfo;
+  if (!getLocalTime(&timeinfo, 0)) {
+    return 0;
+  }
+
+  /* fb->timestamp is taken from esp_timer (time since boot) when the frame was grabbed */
+  int64_t captured_us = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+  int64_t age_s = (esp_timer_get_time() - captured_us) / 1000000LL;
+  return (uint32_t)(time(NULL) - age_s);
+}
+
+uint32_t halFrameUptime(const camera_fb_t *fb) {
+  /* esp_timer is the clock behind millis() */
+  return (uint32_t)(((int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec) / 1000LL);
+}
+
+typedef struct {
+  const camera_fb_t *fb;
+  uint8_t *luma;
+  uint16_t max_w, max_h;
+  uint16_t w, h;
+} luma_decode_t;
+
+static size_t lumaRead(void *arg, size_t index, uint8_t *buf, size_t len) {
+  const camera_fb_t *fb = ((luma_decode_t *)arg)->fb;
+  if (index >= fb->len) return 0;
+  if (len > fb->len - index) len = fb->len - index;
+  if (buf) memcpy(buf, fb->buf + index, len);
+  return len;
+}
+
+/* called per decoded block with RGB888 pixels; NULL data marks start and end */
+static bool lumaWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data) {
+  luma_decode_t *decode = (luma_decode_t *)arg;
+  if (!data) return true;
+
+  for (uint16_t row = 0; row < h && y + row < decode->max_h; row++) {
+    const uint8_t *pixel = data + (size_t)row * w * 3;
+    uint8_t *out = decode->luma + (size_t)(y + row) * decode->max_w + x;
+    for (uint16_t col = 0; col < w && x + col < decode->max_w; col++, pixel += 3) {
+      /* (R + 2G + B) / 4 is close enough to luma and does not care about the channel order */
+      out[col] = (pixel[0] + 2 * pixel[1] + pixel[2]) >> 2;
+    }
+  }
+  if (x + w > decode->w) decode->w = x + w < decode->max_w ? x + w : decode->max_w;
+  if (y + h > decode->h) decode->h = y + h < decode->max_h ? y + h : decode->max_h;
+  return true;
+}
+
+bool halJpegLuma(const camera_fb_t *fb, uint8_t *luma, uint16_t max_w, uint16_t max_h, uint16_t *w, uint16_t *h) {
+  luma_decode_t decode = { fb, luma, max_w, max_h, 0, 0 };
+  if (esp_jpg_decode(fb->len, JPG_SCALE_8X, lumaRead, lumaWrite, &decode) != ESP_OK) {
+    return false;
+  }
+  *w = decode.w;
+  *h = decode.h;
+  return decode.w > 0 && decode.h > 0;
+}
+
+bool halJpegEncodeGray(const uint8_t *gray, uint16_t w, uint16_t h, int quality, uint8_t **jpeg, size_t *len) {
+  uint8_t *out = NULL;
+  size_t out_len = 0;
+  if (!fmt2jpg((uint8_t *)gray, (size_t)w * h, w, h, PIXFORMAT_GRAYSCALE, quality, &out, &out_len)) {
+    return false;
+  }
+  /* fmt2jpg() allocates a fixed 128 KB; queued frames only keep what they use */
+  uint8_t *shrunk = (uint8_t *)realloc(out, out_len);
+  *jpeg = shrunk ? shrunk : out;
+  *len = out_len;
+  return true;
+}
+
+/* -------------------------------- */
+/* ---------- TRANSPORT ---------- */
+/* -------------------------------- */
+/*
+  TLS straight on mbedtls, with WiFiClient as the socket.
+
+  WiFiClientSecure frees its whole mbedtls context on stop() and has no way to keep
+  the session, so every reconnect was a full handshake (hundreds of ms to seconds).
+  Here the session (ID or ticket) of the last handshake is kept and offered on the
+  next connect, which turns the handshake into one round trip without any RSA/ECDHE.
+
+  Whether the server took the offered session is told by sessionReused(). A session
+  remembers whether its server key matched the pin, also across saveSession() and
+  loadSession(): without the peer certificate (MBEDTLS_SSL_KEEP_PEER_CERTIFICATE off)
+  only a resumed session that was pinned when it was established passes the pin.
+*/
+#define TLS_HANDSHAKE_TIMEOUT_MS 8000
+#define TLS_IO_TIMEOUT_MS 8000
+
+class TlsTransport : public HalTransport {
+public:
+  void setTrust(const char *ca_pem, const uint8_t *pin_sha256) override {
+    initOnce();
+    if (ca_pem) {
+      /* PEM must include the terminating NUL in the length */
+      has_ca = mbedtls_x509_crt_parse(&ca, (const unsigned char *)ca_pem, strlen(ca_pem) + 1) == 0;
+      if (!has_ca) Serial.println("---- TLS: could not parse the CA certificate, not verifying");
+    }
+    has_pin = pin_sha256 != NULL;
+    if (has_pin) memcpy(pin, pin_sha256, sizeof(pin));
+
+    mbedtls_ssl_conf_authmode(&conf, has_ca ? MBEDTLS_SSL_VERIFY_REQUIRED : MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_ca_chain(&conf, has_ca ? &ca : NULL, NULL);
+    forgetSession();
+  }
+
+  bool connect(const char *host, uint16_t port) override {
+    initOnce();
+    stop();
+    resumed = false;
+
+    if (!tcp.connect(host, port)) {
+      return false;
+    }
+    tcp.setNoDelay(true);   // disables Nagle
+
+    mbedtls_ssl_init(&ssl);
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0 || mbedtls_ssl_set_hostname(&ssl, host) != 0) {
+      return fail("setup");
+    }
+    mbedtls_ssl_set_bio(&ssl, &tcp, sendCallback, receiveCallback, NULL);
+    open = true;
+
+    bool offered = has_session && mbedtls_ssl_set_session(&ssl, &session) == 0;
+
+    uint32_t start = millis();
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
+      if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+          millis() - start > TLS_HANDSHAKE_TIMEOUT_MS) {
+        /* the session may be what the server choked on */
+        forgetSession();
+        return fail("handshake");
+      }
+      delay(1);
+    }
+
+    mbedtls_ssl_session established;
+    mbedtls_ssl_session_init(&established);
+    bool got = mbedtls_ssl_get_session(&ssl, &established) == 0;
+    bool reused = offered && got && sessionReused(&established);
+
+    if (has_pin && !pinMatches(reused)) {
+      mbedtls_ssl_session_free(&established);
+      forgetSession();
+      return fail("public key pin mismatch");
+    }
+
+    /* the new session replaces the old one; it was pinned if a pin is set, it passed above */
+    resumed = reused;
+    forgetSession();
+    if (got) {
+      session = established;
+      has_session = true;
+      session_pinned = has_pin;
+    } else {
+      mbedtls_ssl_session_free(&established);
+    }
+    return true;
+  }
+
+  bool connected() override { return open && tcp.connected(); }
+
+  void stop() override {
+    if (open) {
+      mbedtls_ssl_close_notify(&ssl);
+      mbedtls_ssl_free(&ssl);
+      open = false;
+    }
+    tcp.stop();
+  }
+
+  size_t write(const uint8_t *data, size_t len) override {
+    if (!open) return 0;
+    uint32_t start = millis();
+    while (true) {
+      int ret = mbedtls_ssl_write(&ssl, data, len);
+      if (ret > 0) return ret;
+      if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+          millis() - start > TLS_IO_TIMEOUT_MS) {
+        return 0;
+      }
+      delay(1);
+    }
+  }
+
+  int available() override {
+    if (!open) return 0;
+    /* a zero-length read processes a pending record without consuming application data */
+    if (mbedtls_ssl_get_bytes_avail(&ssl) == 0 && tcp.available() > 0) {
+      mbedtls_ssl_read(&ssl, NULL, 0);
+    }
+    return mbedtls_ssl_get_bytes_avail(&ssl);
+  }
+
+  int read(uint8_t *buf, size_t len) override {
+    if (!open) return -1;
+    int ret = mbedtls_ssl_read(&ssl, buf, len);
+    return ret > 0 ? ret : -1;
+  }
+
+  void forgetSession() override {
+    if (has_session) mbedtls_ssl_session_free(&session);
+    has_session = false;
+    session_pinned = false;
+  }
+
+  bool sessionResumed() override { return resumed; }
+
+  /*
+    mbedtls_ssl_session_save/load exist since mbedtls 2.19; load rejects a session of
+    another build. The saved session is preceded by the pin it was checked against
+    (zeros if none), so a loaded one only counts as pinned under the same pin.
+  */
+  size_t saveSession(uint8_t *buf, size_t cap) override {
+#if MBEDTLS_VERSION_NUMBER >= 0x02130000
+    size_t len = 0;
+    if (has_session && cap > sizeof(pin) &&
+        mbedtls_ssl_session_save(&session, buf + sizeof(pin), cap - sizeof(pin), &len) == 0) {
+      if (session_pinned) {
+        memcpy(buf, pin, sizeof(pin));
+      } else {
+        memset(buf, 0, sizeof(pin));
+      }
+      return sizeof(pin) + len;
+    }
+#endif
+    return 0;
+  }
+
+  bool loadSession(const uint8_t *buf, size_t len) override {
+    forgetSession();
+#if MBEDTLS_VERSION_NUMBER >= 0x02130000
+    if (len <= sizeof(pin)) return false;
+    mbedtls_ssl_session_init(&session);
+    has_session = mbedtls_ssl_session_load(&session, buf + sizeof(pin), len - sizeof(pin)) == 0;
+    if (!has_session) mbedtls_ssl_session_free(&session);
+    session_pinned = has_session && has_pin && memcmp(buf, pin, sizeof(pin)) == 0;
+#endif
+    return has_session;
+  }
+
+private:
+  WiFiClient tcp;
+  mbedtls_ssl_context ssl;
+  mbedtls_ssl_config conf;
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_x509_crt ca;
+  mbedtls_ssl_session session;
+  uint8_t pin[32];
+
+  bool initialized = false;
+  bool open = false;
+  bool has_ca = false;
+  bool has_pin = false;
+  bool has_session = false;
+  bool session_pinned = false;   /* the server key of session matched the pin */
+  bool resumed = false;
+
+  void initOnce() {
+    if (initialized) return;
+    initialized = true;
+
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_x509_crt_init(&ca);
+
+    mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0);
+    mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  }
+
+  bool fail(const char *what) {
+    Serial.printf("---- TLS %s failed\n", what);
+    stop();
+    return false;
+  }
+
+  /*
+    The server accepted the offered session. mbedtls 3 says so; before, a resumed
+    TLS 1.2 session keeps the master secret, a full handshake derives a new one.
+  */
+  bool sessionReused(const mbedtls_ssl_session *established) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    (void)established;
+    return mbedtls_ssl_session_reused(&ssl) == 1;
+#else
+    return memcmp(established->master, session.master, sizeof(session.master)) == 0;
+#endif
+  }
+
+  /* SHA-256 over the server's SubjectPublicKeyInfo, as printed by `openssl pkey -pubin -outform der | sha256sum` */
+  bool pinMatches(bool reused) {
+    const mbedtls_x509_crt *peer = mbedtls_ssl_get_peer_cert(&ssl);
+    if (!peer) {
+      /* no certificate kept: only a resumed session whose key was checked when it was established */
+      return reused && session_pinned;
+    }
+    uint8_t der[1024];
+    int len = mbedtls_pk_write_pubkey_der((mbedtls_pk_context *)&peer->pk, der, sizeof(der));
+    if (len <= 0) return false;
+
+    uint8_t hash[32];
+    mbedtls_sha256(der + sizeof(der) - len, len, hash, 0);   // DER is written at the end of the buffer
+    return memcmp(hash, pin, sizeof(hash)) == 0;
+  }
+
+  static int sendCallback(void *ctx, const unsigned char *buf, size_t len) {
+    WiFiClient *tcp = (WiFiClient *)ctx;
+    if (!tcp->connected()) return MBEDTLS_ERR_SSL_CONN_EOF;
+    size_t n = tcp->write(buf, len);
+    return n > 0 ? (int)n : MBEDTLS_ERR_SSL_WANT_WRITE;
+  }
+
+  static int receiveCallback(void *ctx, unsigned char *buf, size_t len) {
+    WiFiClient *tcp = (WiFiClient *)ctx;
+    int n = tcp->read(buf, len);
+    if (n > 0) return n;
+    return tcp->connected() ? MBEDTLS_ERR_SSL_WANT_READ : 0;   // 0 = connection closed
+  }
+};
+
+HalTransport *halUploadTransport() {
+  static TlsTransport transport;
+  return &transport;
+}
+
+/* -------------------------------- */
+/* ---------- FILESYSTEM ---------- */
+/* -------------------------------- */
+bool halFsBegin() {
+  return SPIFFS.begin(true);   // true = format if mount fails
+}
+
+bool halFsExists(const char *path) {
+  return SPIFFS.exists(path);
+}
+
+long halFsReadFile(const char *path, uint8_t *buf, size_t cap) {
+  File file = SPIFFS.open(path, "r");
+  if (!file) {
+    return -1;
+  }
+  size_t size = file.size();
+  if (size > cap) {
+    file.close();
+    return -1;
+  }
+  size_t n = file.read(buf, size);
+  file.close();
+  return n == size ? (long)n : -1;
+}
+
+bool halFsWriteFile(const char *path, const uint8_t *data, size_t len) {
+  File file = SPIFFS.open(path, "w");
+  if (!file) {
+    return false;
+  }
+  size_t n = file.write(data, len);
+  file.close();
+  return n == len;
+}
+
+long halFsSize(const char *path) {
+  if (!SPIFFS.exists(path)) {
+    return -1;
+  }
+  File file = SPIFFS.open(path, "r");
+  if (!file) {
+    return -1;
+  }
+  long size = file.size();
+  file.close();
+  return size;
+}
+
+long halFsReadAt(const char *path, size_t offset, uint8_t *buf, size_t len) {
+  File file = SPIFFS.open(path, "r");
+  if (!file) {
+    return -1;
+  }
+  long n = file.seek(offset) ? (long)file.read(buf, len) : -1;
+  file.close();
+  return n;
+}
+
+bool halFsWriteAt(const char *path, size_t offset, const uint8_t *data, size_t len) {
+  File file = SPIFFS.open(path, SPIFFS.exists(path) ? "r+" : "w+");
+  if (!file) {
+    return false;
+  }
+  bool ok = file.seek(offset) && file.write(data, len) == len;
+  file.close();
+  return ok;
+}
+
+bool halFsRemove(const char *path) {
+  return SPIFFS.remove(path);
+}
+
+bool halFsRename(const char *from, const char *to) {
+  return SPIFFS.rename(from, to);
+}
+
+/* -------------------------------- */
+/* ------------ CLOCK ------------ */
+/* -------------------------------- */
+uint32_t halMillis() {
+  return millis();
+}
+
+void halDelay(uint32_t ms) {
+  delay(ms);
+}
+
+bool halLocalTime(struct tm *timeinfo, uint32_t timeout_ms) {
+  return getLocalTime(timeinfo, timeout_ms);
+}
+
+uint32_t halWallTime(uint32_t uptime_ms) {
+  struct tm timeinfo;
+  if (!getLocalTime(&timeinfo, 0)) {
+    return 0;
+  }
+  return (uint32_t)(time(NULL) - (millis() - uptime_ms) / 1000);
+}
+
+/* -------------------------------- */
+/* ------------ SYSTEM ------------ */
+/* -------------------------------- */
+void *halAllocLarge(size_t len) {
+  return psramFound() ? ps_malloc(len) : malloc(len);
+}
+
+void halDeviceId(char *buf, size_t len) {
+  /* base MAC from eFuse: fixed per chip, readable before WiFi is up */
+  uint8_t mac[6] = { 0 };
+  esp_efuse_mac_get_default(mac);
+  snprintf(buf, len, "esp32cam-%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+void halLog(const char *format, ...) {
+  char line[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  Serial.print(line);
+}
+
+#endif
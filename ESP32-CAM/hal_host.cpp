@@ -0,0 +1,719 @@
+#ifndef ARDUINO
+
+#include "hal.h"
+#include <dirent.h>
+#include <errno.h>
+#include <netdb.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <linux/if_packet.h>
+#ifdef HIVEHIVE_HOST_TLS
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+#ifdef HIVEHIVE_HOST_JPEG
+#include <setjmp.h>
+#include <jpeglib.h>
+#endif
+
+/*
+  Linux stand-ins for hal.h, used to run the firmware's upload path as a host binary.
+
+    HIVEHIVE_FRAMES   directory with *.jpg files served round-robin as camera frames
+                      (default: ../circle_evaluation/input)
+    HIVEHIVE_FS_ROOT  directory that plays the role of SPIFFS (default: ./spiffs)
+    HIVEHIVE_DEVICE_ID  device ID sent with every upload (default: from this machine's MAC)
+
+  The transport is plain TCP; point UPLOAD_URL at http://localhost:4444/upload.
+  Built with -DHIVEHIVE_HOST_TLS (and -lssl -lcrypto) it is TLS, see OpenSslTransport.
+  halJpegLuma(), halJpegEncodeGray() and grayscale capture need libjpeg: -DHIVEHIVE_HOST_JPEG
+  and -ljpeg, otherwise they always fail.
+*/
+
+static const char *envOr(const char *name, const char *fallback) {
+  const char *value = getenv(name);
+  return value && *value ? value : fallback;
+}
+
+/* -------------------------------- */
+/* ------------ CAMERA ------------ */
+/* -------------------------------- */
+#define HOST_MAX_FRAMES 256
+
+static char frame_paths[HOST_MAX_FRAMES][512];
+static size_t frame_count = 0;
+static size_t next_frame = 0;
+
+static int comparePaths(const void *a, const void *b) {
+  return strcmp((const char *)a, (const char *)b);
+}
+
+static void scanFrames() {
+  const char *dir_path = envOr("HIVEHIVE_FRAMES", "../circle_evaluation/input");
+  DIR *dir = opendir(dir_path);
+  if (!dir) {
+    halLog("---- camera stand-in: cannot open %s\n", dir_path);
+    return;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL && frame_count < HOST_MAX_FRAMES) {
+    const char *ext = strrchr(entry->d_name, '.');
+    if (ext && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0)) {
+      snprintf(frame_paths[frame_count++], sizeof(frame_paths[0]), "%s/%s", dir_path, entry->d_name);
+    }
+  }
+  closedir(dir);
+  qsort(frame_paths, frame_count, sizeof(frame_paths[0]), comparePaths);
+}
+
+/* a frame and its position in the file it was read from (grayscale capture) */
+typedef struct {
+  camera_fb_t fb;
+  uint16_t x;
+  uint16_t y;
+} host_fb_t;
+
+static bool crop_enabled = false;
+static roi_t crop_roi;
+
+/* JPEG section below */
+static bool cropFrame(host_fb_t *frame);
+
+void halCameraCrop(const roi_t *roi) {
+  crop_enabled = roi != NULL;
+  if (roi) crop_roi = *roi;
+}
+
+camera_fb_t *halCameraFbGet() {
+  if (frame_count == 0) scanFrames();
+  if (frame_count == 0) return NULL;
+
+  const char *path = frame_paths[next_frame];
+  next_frame = (next_frame + 1) % frame_count;
+
+  FILE *file = fopen(path, "rb");
+  if (!file) return NULL;
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  host_fb_t *frame = (host_fb_t *)calloc(1, sizeof(host_fb_t));
+  frame->fb.buf = (uint8_t *)malloc(size > 0 ? size : 1);
+  frame->fb.len = size > 0 ? fread(frame->fb.buf, 1, size, file) : 0;
+  fclose(file);
+
+  /* the file plays the sensor's raw frame: decoded to gray, cropped and encoded again */
+  if (crop_enabled && !cropFrame(frame)) {
+    halCameraFbReturn(&frame->fb);
+    return NULL;
+  }
+  return &frame->fb;
+}
+
+void halCameraFbReturn(camera_fb_t *fb) {
+  if (!fb) return;
+  free(fb->buf);
+  free(fb);
+}
+
+void halFrameOffset(const camera_fb_t *fb, uint16_t *x, uint16_t *y) {
+  *x = ((const host_fb_t *)fb)->x;
+  *y = ((const host_fb_t *)fb)->y;
+}
+
+uint32_t halFrameTimestamp(const camera_fb_t * /* fb */) {
+  return (uint32_t)time(NULL);
+}
+
+/* host frames are read from disk when they are taken, so now is the capture time */
+uint32_t halFrameUptime(const camera_fb_t * /* fb */) {
+  return halMillis();
+}
+
+#ifdef HIVEHIVE_HOST_JPEG
+/* libjpeg reports errors through a callback that must not return */
+typedef struct {
+  struct jpeg_error_mgr mgr;
+  jmp_buf escape;
+} jpeg_error_t;
+
+static void jpegError(j_common_ptr cinfo) {
+  longjmp(((jpeg_error_t *)cinfo->err)->escape, 1);
+}
+
+bool halJpegLuma(const camera_fb_t *fb, uint8_t *luma, uint16_t max_w, uint16_t max_h, uint16_t *w, uint16_t *h) {
+  struct jpeg_decompress_struct cinfo;
+  jpeg_error_t error;
+  cinfo.err = jpeg_std_error(&error.mgr);
+  error.mgr.error_exit = jpegError;
+  if (setjmp(error.escape)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, fb->buf, fb->len);
+  jpeg_read_header(&cinfo, TRUE);
+
+  /* 1/8 scale: libjpeg then only uses the DC coefficients, like the ESP32 decoder */
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = 8;
+  cinfo.out_color_space = JCS_GRAYSCALE;
+  cinfo.dct_method = JDCT_IFAST;
+  cinfo.do_fancy_upsampling = FALSE;
+  jpeg_start_decompress(&cinfo);
+
+  uint8_t row[4096];
+  *w = cinfo.output_width < max_w ? cinfo.output_width : max_w;
+  *h = 0;
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW rows[1] = { cinfo.output_width <= sizeof(row) ? row : NULL };
+    if (!rows[0]) break;
+    jpeg_read_scanlines(&cinfo, rows, 1);
+    if (*h < max_h) {
+      memcpy(luma + (size_t)*h * max_w, row, *w);
+      (*h)++;
+    }
+  }
+
+  jpeg_abort_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return *h > 0;
+}
+
+bool halJpegEncodeGray(const uint8_t *gray, uint16_t w, uint16_t h, int quality, uint8_t **jpeg, size_t *len) {
+  struct jpeg_compress_struct cinfo;
+  jpeg_error_t error;
+  unsigned char *out = NULL;
+  unsigned long out_len = 0;
+  cinfo.err = jpeg_std_error(&error.mgr);
+  error.mgr.error_exit = jpegError;
+  if (setjmp(error.escape)) {
+    jpeg_destroy_compress(&cinfo);
+    free(out);
+    return false;
+  }
+
+  jpeg_create_compress(&cinfo);
+  jpeg_mem_dest(&cinfo, &out, &out_len);
+  cinfo.image_width = w;
+  cinfo.image_height = h;
+  cinfo.input_components = 1;
+  cinfo.in_color_space = JCS_GRAYSCALE;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW rows[1] = { (JSAMPROW)gray + (size_t)cinfo.next_scanline * w };
+    jpeg_write_scanlines(&cinfo, rows, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+
+  *jpeg = out;
+  *len = out_len;
+  return true;
+}
+
+/* whole file to 8 bit gray, the ESP32's raw frame; malloc'd, NULL if it cannot be decoded */
+static uint8_t *decodeGray(const uint8_t *jpeg, size_t len, uint16_t *w, uint16_t *h) {
+  struct jpeg_decompress_struct cinfo;
+  jpeg_error_t error;
+  uint8_t *volatile gray = NULL;   /* set after setjmp(), freed after longjmp() */
+  cinfo.err = jpeg_std_error(&error.mgr);
+  error.mgr.error_exit = jpegError;
+  if (setjmp(error.escape)) {
+    jpeg_destroy_decompress(&cinfo);
+    free(gray);
+    return NULL;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, jpeg, len);
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_GRAYSCALE;
+  jpeg_start_decompress(&cinfo);
+  if (cinfo.output_width > UINT16_MAX || cinfo.output_height > UINT16_MAX) {
+    jpeg_destroy_decompress(&cinfo);
+    return NULL;
+  }
+
+  *w = cinfo.output_width;
+  *h = cinfo.output_height;
+  gray = (uint8_t *)malloc((size_t)*w * *h);
+  while (gray && cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW rows[1] = { gray + (size_t)cinfo.output_scanline * *w };
+    jpeg_read_scanlines(&cinfo, rows, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return gray;
+}
+
+static bool cropFrame(host_fb_t *frame) {
+  uint16_t w, h;
+  uint8_t *gray = decodeGray(frame->fb.buf, frame->fb.len, &w, &h);
+  roi_t fit;
+  bool ok = gray && roiFit(&crop_roi, w, h, &fit);
+  uint8_t *jpeg = NULL;
+  size_t len = 0;
+  if (ok) {
+    roiCrop(gray, w, &fit);
+    /* no sensor here: its PSRAM default quality */
+    ok = halJpegEncodeGray(gray, fit.w, fit.h, roiEncodeQuality(10), &jpeg, &len);
+  }
+  free(gray);
+  if (!ok) {
+    halLog("---- camera stand-in: cannot crop frame\n");
+    return false;
+  }
+
+  free(frame->fb.buf);
+  frame->fb.buf = jpeg;
+  frame->fb.len = len;
+  frame->fb.width = fit.w;
+  frame->fb.height = fit.h;
+  frame->x = fit.x;
+  frame->y = fit.y;
+  return true;
+}
+#else
+bool halJpegLuma(const camera_fb_t *, uint8_t *, uint16_t, uint16_t, uint16_t *, uint16_t *) {
+  return false;
+}
+
+bool halJpegEncodeGray(const uint8_t *, uint16_t, uint16_t, int, uint8_t **, size_t *) {
+  return false;
+}
+
+static bool cropFrame(host_fb_t *) {
+  halLog("---- camera stand-in: grayscale capture needs -DHIVEHIVE_HOST_JPEG\n");
+  return false;
+}
+#endif
+
+/* -------------------------------- */
+/* ---------- TRANSPORT ---------- */
+/* -------------------------------- */
+class SocketTransport : public HalTransport {
+public:
+  bool connect(const char *host, uint16_t port) override {
+    stop();
+
+    char port_string[8];
+    snprintf(port_string, sizeof(port_string), "%u", port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *result;
+    if (getaddrinfo(host, port_string, &hints, &result) != 0) {
+      return false;
+    }
+    for (struct addrinfo *ai = result; ai; ai = ai->ai_next) {
+      fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (fd < 0) continue;
+      if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+      close(fd);
+      fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd >= 0) {
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // same as setNoDelay(true)
+    }
+    return fd >= 0;
+  }
+
+  bool connected() override {
+    if (fd < 0) return false;
+    char c;
+    ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      return available() > 0;
+    }
+    return true;
+  }
+
+  void stop() override {
+    if (fd >= 0) close(fd);
+    fd = -1;
+  }
+
+  size_t write(const uint8_t *data, size_t len) override {
+    if (fd < 0) return 0;
+    ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+    return n > 0 ? (size_t)n : 0;
+  }
+
+  int available() override {
+    int pending = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &pending) != 0) return 0;
+    return pending;
+  }
+
+  int read(uint8_t *buf, size_t len) override {
+    if (fd < 0) return -1;
+    ssize_t n = recv(fd, buf, len, MSG_DONTWAIT);
+    return n > 0 ? (int)n : -1;
+  }
+
+  int descriptor() const { return fd; }
+
+private:
+  int fd = -1;
+};
+
+#ifdef HIVEHIVE_HOST_TLS
+/*
+  TLS over SocketTransport with OpenSSL, built with -DHIVEHIVE_HOST_TLS -lssl -lcrypto.
+  Mirrors the ESP32's mbedtls transport: the session of the last connection is kept
+  and offered on the next connect. HIVEHIVE_TLS12=1 caps the protocol at TLS 1.2,
+  which is what mbedtls 2.x on the ESP32 speaks.
+*/
+class OpenSslTransport : public HalTransport {
+public:
+  void setTrust(const char *ca_pem, const uint8_t *pin_sha256) override {
+    initOnce();
+    if (ca_pem) {
+      BIO *bio = BIO_new_mem_buf(ca_pem, -1);
+      X509 *cert;
+      while ((cert = PEM_read_bio_X509(bio, NULL, NULL, NULL)) != NULL) {
+        X509_STORE_add_cert(SSL_CTX_get_cert_store(ctx), cert);
+        X509_free(cert);
+        has_ca = true;
+      }
+      BIO_free(bio);
+      ERR_clear_error();
+    }
+    SSL_CTX_set_verify(ctx, has_ca ? SSL_VERIFY_PEER : SSL_VERIFY_NONE, NULL);
+
+    has_pin = pin_sha256 != NULL;
+    if (has_pin) memcpy(pin, pin_sha256, sizeof(pin));
+    forgetSession();
+  }
+
+  bool connect(const char *host, uint16_t port) override {
+    initOnce();
+    stop();
+    resumed = false;
+
+    if (!tcp.connect(host, port)) {
+      return false;
+    }
+    ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, tcp.descriptor());
+    SSL_set_tlsext_host_name(ssl, host);
+    SSL_set_app_data(ssl, this);
+    if (session) SSL_set_session(ssl, session);
+
+    bool handshake = SSL_connect(ssl) == 1;
+    if (!handshake || (has_pin && !pinMatches())) {
+      halLog("---- TLS handshake with %s failed: %s\n", host, handshake ? "public key pin mismatch" : "handshake error");
+      forgetSession();
+      stop();
+      return false;
+    }
+    resumed = SSL_session_reused(ssl);
+
+    /* non-blocking from here on, like the reads of SocketTransport */
+    fcntl(tcp.descriptor(), F_SETFL, fcntl(tcp.descriptor(), F_GETFL) | O_NONBLOCK);
+    return true;
+  }
+
+  bool connected() override { return ssl && (SSL_pending(ssl) > 0 || tcp.connected()); }
+
+  void stop() override {
+    if (ssl) {
+      SSL_shutdown(ssl);
+      SSL_free(ssl);
+      ssl = NULL;
+    }
+    tcp.stop();
+  }
+
+  size_t write(const uint8_t *data, size_t len) override {
+    if (!ssl) return 0;
+    while (true) {
+      int n = SSL_write(ssl, data, len);
+      if (n > 0) return n;
+      int err = SSL_get_error(ssl, n);
+      if (err != SSL_ERROR_WANT_WRITE && err != SSL_ERROR_WANT_READ) return 0;
+      usleep(1000);
+    }
+  }
+
+  int available() override {
+    if (!ssl) return 0;
+    if (SSL_pending(ssl) == 0 && tcp.available() > 0) {
+      /* processes the next record (or a session ticket) without consuming data */
+      char c;
+      SSL_peek(ssl, &c, 1);
+    }
+    return SSL_pending(ssl);
+  }
+
+  int read(uint8_t *buf, size_t len) override {
+    if (!ssl) return -1;
+    int n = SSL_read(ssl, buf, len);
+    return n > 0 ? n : -1;
+  }
+
+  void forgetSession() override {
+    if (session) SSL_SESSION_free(session);
+    session = NULL;
+  }
+
+  bool sessionResumed() override { return resumed; }
+
+  size_t saveSession(uint8_t *buf, size_t cap) override {
+    int len = session ? i2d_SSL_SESSION(session, NULL) : 0;
+    if (len <= 0 || (size_t)len > cap) return 0;
+    unsigned char *out = buf;
+    return i2d_SSL_SESSION(session, &out);
+  }
+
+  bool loadSession(const uint8_t *buf, size_t len) override {
+    forgetSession();
+    const unsigned char *in = buf;
+    session = d2i_SSL_SESSION(NULL, &in, (long)len);
+    return session != NULL;
+  }
+
+private:
+  SocketTransport tcp;
+  SSL_CTX *ctx = NULL;
+  SSL *ssl = NULL;
+  SSL_SESSION *session = NULL;
+  uint8_t pin[32];
+  bool has_ca = false;
+  bool has_pin = false;
+  bool resumed = false;
+
+  void initOnce() {
+    if (ctx) return;
+    ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    if (getenv("HIVEHIVE_TLS12") && atoi(getenv("HIVEHIVE_TLS12"))) {
+      SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    }
+    /* TLS 1.3 tickets arrive after the handshake; keep whichever session comes last */
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, newSession);
+  }
+
+  static int newSession(SSL *ssl, SSL_SESSION *new_session) {
+    OpenSslTransport *self = (OpenSslTransport *)SSL_get_app_data(ssl);
+    self->forgetSession();
+    self->session = new_session;
+    return 1;   // we keep the reference
+  }
+
+  bool pinMatches() {
+    X509 *peer = SSL_get1_peer_certificate(ssl);
+    if (!peer) return false;
+    unsigned char *der = NULL;
+    int len = i2d_X509_PUBKEY(X509_get_X509_PUBKEY(peer), &der);
+    X509_free(peer);
+    if (len <= 0) return false;
+
+    unsigned char hash[32];
+    SHA256(der, len, hash);
+    OPENSSL_free(der);
+    return memcmp(hash, pin, sizeof(hash)) == 0;
+  }
+};
+
+HalTransport *halUploadTransport() {
+  static OpenSslTransport transport;
+  return &transport;
+}
+#else
+HalTransport *halUploadTransport() {
+  static SocketTransport transport;
+  return &transport;
+}
+#endif
+
+/* -------------------------------- */
+/* ---------- FILESYSTEM ---------- */
+/* -------------------------------- */
+static void hostPath(const char *path, char *out, size_t len) {
+  snprintf(out, len, "%s%s%s", envOr("HIVEHIVE_FS_ROOT", "spiffs"), path[0] == '/' ? "" : "/", path);
+}
+
+/* SPIFFS has a flat namespace where "/store/seg0.bin" is just a name; create the directory here */
+static void makeParentDir(const char *full) {
+  char dir[512];
+  snprintf(dir, sizeof(dir), "%s", full);
+  char *slash = strrchr(dir, '/');
+  if (slash && slash != dir) {
+    *slash = '\0';
+    mkdir(dir, 0755);
+  }
+}
+
+bool halFsBegin() {
+  const char *root = envOr("HIVEHIVE_FS_ROOT", "spiffs");
+  return mkdir(root, 0755) == 0 || errno == EEXIST;
+}
+
+bool halFsExists(const char *path) {
+  char full[512];
+  hostPath(path, full, sizeof(full));
+  return access(full, F_OK) == 0;
+}
+
+long halFsReadFile(const char *path, uint8_t *buf, size_t cap) {
+  char full[512];
+  hostPath(path, full, sizeof(full));
+
+  FILE *file = fopen(full, "rb");
+  if (!file) return -1;
+
+  size_t n = fread(buf, 1, cap, file);
+  bool larger = fgetc(file) != EOF;
+  fclose(file);
+  return larger ? -1 : (long)n;
+}
+
+bool halFsWriteFile(const char *path, const uint8_t *data, size_t len) {
+  char full[512];
+  hostPath(path, full, sizeof(full));
+
+  FILE *file = fopen(full, "wb");
+  if (!file) return false;
+  size_t n = fwrite(data, 1, len, file);
+  return fclose(file) == 0 && n == len;
+}
+
+long halFsSize(const char *path) {
+  char full[512];
+  hostPath(path, full, sizeof(full));
+
+  struct stat st;
+  return stat(full, &st) == 0 ? (long)st.st_size : -1;
+}
+
+long halFsReadAt(const char *path, size_t offset, uint8_t *buf, size_t len) {
+  char full[512];
+  hostPath(path, full, sizeof(full));
+
+  FILE *file = fopen(full, "rb");
+  if (!file) return -1;
+  long n = fseek(file, offset, SEEK_SET) == 0 ? (long)fread(buf, 1, len, file) : -1;
+  fclose(file);
+  return n;
+}
+
+bool halFsWriteAt(const char *path, size_t offset, const uint8_t *data, size_t len) {
+  char full[512];
+  hostPath(path, full, sizeof(full));
+
+  FILE *file = fopen(full, "r+b");
+  if (!file) {
+    makeParentDir(full);
+    file = fopen(full, "w+b");
+  }
+  if (!file) return false;
+  bool ok = fseek(file, offset, SEEK_SET) == 0 && fwrite(data, 1, len, file) == len;
+  return fclose(file) == 0 && ok;
+}
+
+bool halFsRemove(const char *path) {
+  char full[512];
+  hostPath(path, full, sizeof(full));
+  return unlink(full) == 0;
+}
+
+bool halFsRename(const char *from, const char *to) {
+  char full_from[512], full_to[512];
+  hostPath(from, full_from, sizeof(full_from));
+  hostPath(to, full_to, sizeof(full_to));
+  /* same contract as SPIFFS, which does not replace an existing file */
+  if (access(full_to, F_OK) == 0) {
+    return false;
+  }
+  return rename(full_from, full_to) == 0;
+}
+
+/* -------------------------------- */
+/* ------------ CLOCK ------------ */
+/* -------------------------------- */
+uint32_t halMillis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000ULL);
+}
+
+void halDelay(uint32_t ms) {
+  usleep(ms * 1000);
+}
+
+bool halLocalTime(struct tm *timeinfo, uint32_t /* timeout_ms */) {
+  time_t now = time(NULL);
+  return localtime_r(&now, timeinfo) != NULL;
+}
+
+uint32_t halWallTime(uint32_t uptime_ms) {
+  return (uint32_t)(time(NULL) - (halMillis() - uptime_ms) / 1000);
+}
+
+/* -------------------------------- */
+/* ------------ SYSTEM ------------ */
+/* -------------------------------- */
+void *halAllocLarge(size_t len) {
+  return malloc(len);
+}
+
+/* HIVEHIVE_DEVICE_ID, so several stand-ins can run on one machine, or the first MAC found */
+void halDeviceId(char *buf, size_t len) {
+  const char *configured = envOr("HIVEHIVE_DEVICE_ID", NULL);
+  if (configured) {
+    snprintf(buf, len, "%s", configured);
+    return;
+  }
+
+  uint8_t mac[6] = { 0 };
+  struct ifaddrs *interfaces = NULL;
+  if (getifaddrs(&interfaces) == 0) {
+    for (struct ifaddrs *it = interfaces; it; it = it->ifa_next) {
+      if (!it->ifa_addr || it->ifa_addr->sa_family != AF_PACKET) continue;
+      const struct sockaddr_ll *link = (const struct sockaddr_ll *)it->ifa_addr;
+      if (link->sll_halen != 6 || memcmp(link->sll_addr, mac, 6) == 0) continue;  /* loopback is all zero */
+      memcpy(mac, link->sll_addr, 6);
+      break;
+    }
+    freeifaddrs(interfaces);
+  }
+  snprintf(buf, len, "esp32cam-%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+void halLog(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  fflush(stdout);
+}
+
+#endif
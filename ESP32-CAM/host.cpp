@@ -1,393 +1,155 @@
+#include "host.h"
+#include "portal_handler.h"
+#include "portal_page.h"
 #include <WiFi.h>
 #include <SPIFFS.h>
 #include <FS.h>
-#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 const char *HOST_SSID = "ESP32-Access-Point";
 const char *HOST_PASSWORD = "esp-12345";
 
 WiFiServer server(80); // port 80
-int server_running = 0;
-String sessionToken;
 
-String header;
-
-String cfg_ssid           = "";
-String cfg_password       = "";
-String cfg_upload_url     = "";
-String cfg_resolution     = "VGA";
-int    cfg_interval_ms    = 300;
-int    cfg_vflip          = 0;
-int    cfg_brightness     = 0;
-int    cfg_saturation     = 0;
+static size_t writeToClient(void *ctx, const uint8_t *data, size_t len) {
+  return ((WiFiClient *)ctx)->write(data, len);
+}
 
 
 /*
-  -----------------------------
-  ---------- HELPERS ----------
-  -----------------------------
+  --------------------------------------
+  -------- RUN THE ACCESS POINT --------
+  --------------------------------------
+
+  The portal task polls the server and all open connections every PORTAL_POLL_MS
+  and never waits on a single client: each connection has its own request parser
+  (portal_request.cpp) with fixed buffers, and is closed once it is answered
+  (portal_handler.cpp) or has been silent for PORTAL_CLIENT_TIMEOUT_MS.
 */
-String urlDecode(const String& src) {
-  String decoded = "";
-  char c;
-  for (size_t i = 0; i < src.length(); i++) {
-    c = src[i];
-    if (c == '+') {
-      decoded += ' ';
-    } else if (c == '%' && i + 2 < src.length()) {
-      char h1 = src[i + 1];
-      char h2 = src[i + 2];
-      int hi = isdigit(h1) ? h1 - '0' : toupper(h1) - 'A' + 10;
-      int lo = isdigit(h2) ? h2 - '0' : toupper(h2) - 'A' + 10;
-      decoded += char(hi * 16 + lo);
-      i += 2;
-    } else {
-      decoded += c;
+#define PORTAL_MAX_CLIENTS 4
+#define PORTAL_READ_CHUNK 256
+#define PORTAL_POLL_MS 10
+#define PORTAL_CLIENT_TIMEOUT_MS 5000
+#define PORTAL_RESTART_DELAY_MS 500   /* lets the redirect leave before the restart */
+
+typedef struct {
+  WiFiClient client;
+  portal_request_t req;
+  uint32_t last_activity;
+  bool open;
+} portal_conn_t;
+
+static portal_conn_t conns[PORTAL_MAX_CLIENTS];
+static uint32_t portal_last_activity = 0;
+
+static SemaphoreHandle_t portal_saved;
+static volatile bool portal_waiting = false;
+static volatile bool portal_open = false;
+
+static void acceptClients() {
+  for (WiFiClient client = server.available(); client; client = server.available()) {
+    portal_conn_t *conn = NULL;
+    for (int i = 0; i < PORTAL_MAX_CLIENTS && !conn; i++) {
+      if (!conns[i].open) conn = &conns[i];
+    }
+    if (!conn) {
+      portalSendError(503, writeToClient, &client);
+      client.stop();
+      continue;
     }
+
+    conn->client = client;
+    conn->client.setNoDelay(true);   /* the response goes out in a couple of large writes */
+    conn->open = true;
+    conn->last_activity = millis();
+    portalRequestInit(&conn->req);
+    portal_last_activity = conn->last_activity;
   }
-  return decoded;
 }
 
-String getParam(const String& query, const String& name) {
-  String key = name + "=";
-  int start = query.indexOf(key);
-  if (start < 0) return "";
-  start += key.length();
-  int end = query.indexOf('&', start);
-  if (end < 0) end = query.length();
-  String value = query.substring(start, end);
-  return urlDecode(value);
+static void closeClient(portal_conn_t *conn) {
+  conn->client.stop();
+  conn->open = false;
 }
 
 /*
-  -------------------------------------
-  -- LOAD EXISTING CONFIG TO PREFILL --
-  -------------------------------------
+  Reads what the client sent so far; answers and closes it once the request is complete.
+  Returns true if the request saved a new configuration.
 */
-void loadConfig() {
-  if (!SPIFFS.exists("/config.json")) {
-    Serial.println("config.json not found, using defaults");
-    return;
+static bool serviceClient(portal_conn_t *conn) {
+  uint8_t buf[PORTAL_READ_CHUNK];
+  while (!portalRequestDone(&conn->req) && conn->client.available() > 0) {
+    int n = conn->client.read(buf, sizeof(buf));
+    if (n <= 0) break;
+    portalRequestFeed(&conn->req, buf, n);
+    conn->last_activity = millis();
+    portal_last_activity = conn->last_activity;
   }
 
-  File f = SPIFFS.open("/config.json", "r");
-  if (!f) {
-    Serial.println("Failed to open config.json");
-    return;
+  if (portalRequestDone(&conn->req)) {
+    bool saved = portalHandleRequest(&conn->req, writeToClient, &conn->client);
+    closeClient(conn);
+    return saved;
   }
-
-  StaticJsonDocument<512> doc;
-  DeserializationError err = deserializeJson(doc, f);
-  f.close();
-  if (err) {
-    Serial.print("Failed to parse config.json: ");
-    Serial.println(err.f_str());
-    return;
+  if (!conn->client.connected() || millis() - conn->last_activity > PORTAL_CLIENT_TIMEOUT_MS) {
+    closeClient(conn);
   }
-
-  cfg_ssid        = doc["NETWORK"]["SSID"]           | "";
-  cfg_password    = doc["NETWORK"]["PASSWORD"]       | "";
-  cfg_upload_url  = doc["NETWORK"]["UPLOAD_URL"]     | "";
-
-  cfg_interval_ms = doc["CAMERA"]["CAPTURE_INTERVAL_IN_MS"] | 0;
-  cfg_resolution  = doc["CAMERA"]["RESOLUTION"]              | "VGA";
-  cfg_vflip       = doc["CAMERA"]["VERTICAL_FLIP"]          | 0;
-  cfg_brightness  = doc["CAMERA"]["BRIGHTNESS"]             | 0;
-  cfg_saturation  = doc["CAMERA"]["SATURATION"]             | 0;
+  return false;
 }
 
 /*
-  ----------------------------------
-  -- UPDATE JSON CONFIG ON DEVICE --
-  ----------------------------------
+  A saved form either releases setup() (first boot, see waitForPortalSave()) or,
+  when the device already runs on a stored config, restarts it to apply the new one.
 */
-void saveConfig() {
-  StaticJsonDocument<512> doc;
-
-  JsonObject net  = doc.createNestedObject("NETWORK");
-  JsonObject cam  = doc.createNestedObject("CAMERA");
-
-  net["SSID"]        = cfg_ssid;
-  net["PASSWORD"]    = cfg_password;
-  net["UPLOAD_URL"]  = cfg_upload_url;
-
-  cam["CAPTURE_INTERVAL_IN_MS"] = cfg_interval_ms;
-  cam["RESOLUTION"]             = cfg_resolution;
-  cam["VERTICAL_FLIP"]          = cfg_vflip;
-  cam["BRIGHTNESS"]             = cfg_brightness;
-  cam["SATURATION"]             = cfg_saturation;
-
-  File f = SPIFFS.open("/config.json", "w");
-  if (!f) {
-    Serial.println("Failed to open config.json for writing");
+static void configSaved() {
+  if (portal_waiting) {
+    Serial.println("---- configuration saved");
+    xSemaphoreGive(portal_saved);
     return;
   }
-  if (serializeJson(doc, f) == 0) {
-    Serial.println("Failed to write JSON to file");
-  }
-  f.close();
-}
-
-/*
-  ----------------------------------
-  -------- HTML CONFIG FORM --------
-  ----------------------------------
-*/
-void sendConfigForm(WiFiClient &client, bool saved = false) {
-  // Optional: split cfg_upload_url into base + endpoint for pre-filling
-  String uploadBase = cfg_upload_url;
-  String uploadEndpoint = "";
-  int lastSlash = uploadBase.lastIndexOf('/');
-  if (lastSlash > 7) { // after "http://", "https://"
-    uploadEndpoint = uploadBase.substring(lastSlash + 1);
-    uploadBase = uploadBase.substring(0, lastSlash);
-  }
-
-  client.println("HTTP/1.1 200 OK");
-  client.println("Content-type:text/html");
-  client.println("Connection: close");
-  client.println();
-  client.println("<!DOCTYPE html><html><head>");
-  client.println("<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">");
-  client.println("<title>ESP32 Config</title>");
-  client.println(
-    "<style>"
-    "body{margin:0;padding:20px;font-family:Helvetica,Arial,sans-serif;background:#f5f5f5;}"
-    ".card{max-width:520px;margin:40px auto;background:#fff;border-radius:10px;"
-      "box-shadow:0 2px 8px rgba(0,0,0,0.12);padding:24px 26px;box-sizing:border-box;}"
-    "h1{margin-top:0;font-size:24px;text-align:center;}"
-    "h2{margin-top:24px;font-size:18px;border-bottom:1px solid #eee;padding-bottom:4px;}"
-    "label{display:block;margin-top:14px;font-weight:bold;font-size:14px;}"
-    "input,select{width:100%;padding:8px 10px;margin-top:6px;border-radius:6px;"
-      "border:1px solid #ccc;box-sizing:border-box;font-size:14px;}"
-    "input:focus,select:focus{outline:none;border-color:#1976d2;box-shadow:0 0 0 2px rgba(25,118,210,0.18);}"
-    "button{margin-top:22px;width:100%;padding:10px 0;font-size:16px;border:none;"
-      "border-radius:999px;background:#1976d2;color:#fff;cursor:pointer;font-weight:bold;}"
-    "button:hover{background:#1458a3;}"
-    ".message{padding:10px 12px;border-radius:6px;background:#e8f5e9;color:#1b5e20;"
-      "border:1px solid #c8e6c9;margin-top:10px;margin-bottom:10px;font-size:14px;}"
-    ".hint{font-size:12px;color:#777;margin-top:4px;}"
-    ".inline{display:flex;gap:8px;}"
-    ".inline > div{flex:1;}"
-    "</style>"
-  );
-  client.println("</head><body>");
-  client.println("<div class=\"card\">");
-  client.println("<h1>ESP32 Configuration</h1>");
-
-  if (saved) {
-    client.println("<div class=\"message\"><b>Config saved.</b> You can close this page.</div>");
-  }
-
-  // Use POST so SSID/password/URL won't appear in the browser's URL bar
-  client.println("<form action=\"/save\" method=\"POST\" autocomplete=\"off\">");
-  client.println("<input type=\"hidden\" name=\"session\" value=\"" + sessionToken + "\">");
-  
-  // --- Network section ---
-  client.println("<h2>Network</h2>");
-
-  client.println("<label for=\"ssid\">SSID</label>");
-  client.println("<input id=\"ssid\" type=\"text\" name=\"ssid\" value=\"" + cfg_ssid + "\">");
-
-  client.println("<label for=\"password\">Password</label>");
-  client.println("<input id=\"password\" type=\"password\" name=\"password\" value=\"" + cfg_password + "\">");
-  client.println("<div class=\"hint\">Password will be sent in the request body (not visible in the address bar).</div>");
-
-  client.println("<label for=\"upload_base\">Upload URL</label>");
-  client.println("<div class=\"inline\">");
-  client.println("<div>");
-  client.println("<input id=\"upload_base\" type=\"text\" name=\"upload_base\" "
-                 "placeholder=\"http://example.com\" value=\"" + uploadBase + "\">");
-  client.println("<div class=\"hint\">Base URL</div>");
-  client.println("</div>");
-  client.println("<div>");
-  client.println("<input id=\"upload_endpoint\" type=\"text\" name=\"upload_endpoint\" "
-                 "placeholder=\"upload\" value=\"" + uploadEndpoint + "\">");
-  client.println("<div class=\"hint\">Endpoint (path)</div>");
-  client.println("</div>");
-  client.println("</div>");
-  client.println("<div class=\"hint\">Server can combine these as "
-                 "<code>http://example.com/upload</code>.</div>");
-
-  // --- Camera section ---
-  client.println("<h2>Camera</h2>");
-
-  client.println("<label for=\"interval\">Capture interval (ms)</label>");
-  client.println("<input id=\"interval\" type=\"number\" name=\"interval\" min=\"10\" "
-                 "value=\"" + String(cfg_interval_ms) + "\">");
-
-  client.println("<label for=\"res\">Resolution</label>");
-  client.println("<select id=\"res\" name=\"res\">");
-  client.println("<option value=\"qvga\""  + String(cfg_resolution.equalsIgnoreCase("qvga")  ? " selected" : "") + ">QVGA - 320 x 240</option>");
-  client.println("<option value=\"vga\""   + String(cfg_resolution.equalsIgnoreCase("vga")   ? " selected" : "") + ">VGA - 640 x 480</option>");
-  client.println("<option value=\"qxga\""  + String(cfg_resolution.equalsIgnoreCase("qxga")  ? " selected" : "") + ">QXGA - 800 x 600</option>");
-  client.println("<option value=\"sxga\""  + String(cfg_resolution.equalsIgnoreCase("sxga")  ? " selected" : "") + ">SXGA - 1280 x 1024</option>");
-  client.println("<option value=\"uxga\""  + String(cfg_resolution.equalsIgnoreCase("uxga")  ? " selected" : "") + ">UXGA - 1600 x 1200</option>");
-  client.println("</select>");
-  client.println("<div class=\"hint\">Form will submit values like <code>qvga</code>, "
-                 "<code>vga</code>, <code>sxga</code>, etc.</div>");
-
-  client.println("<label for=\"vflip\">Vertical flip (0/1)</label>");
-  client.println("<input id=\"vflip\" type=\"number\" name=\"vflip\" min=\"0\" max=\"1\" "
-                 "value=\"" + String(cfg_vflip) + "\">");
-
-  client.println("<label for=\"bright\">Brightness</label>");
-  client.println("<input id=\"bright\" type=\"number\" name=\"bright\" "
-                 "value=\"" + String(cfg_brightness) + "\">");
-
-  client.println("<label for=\"sat\">Saturation</label>");
-  client.println("<input id=\"sat\" type=\"number\" name=\"sat\" "
-                 "value=\"" + String(cfg_saturation) + "\">");
-
-  client.println("<button type=\"submit\">Save configuration</button>");
-  client.println("</form>");
-
-  client.println("</div>"); // .card
-  client.println("</body></html>");
-  client.println();
+  Serial.println("---- configuration saved, restarting");
+  vTaskDelay(pdMS_TO_TICKS(PORTAL_RESTART_DELAY_MS));
+  ESP.restart();
 }
 
+static void portalTask(void *arg) {
+  portal_last_activity = millis();
 
-/*
-  --------------------------------------
-  -------- RUN THE ACCESS POINT --------
-  --------------------------------------
-*/
-void runAccessPoint() {
-  server_running = 1;
-  
-  while (server_running) {
-    WiFiClient client = server.available();
-    if (client) {
-      Serial.println("\n------ CLIENT CONNECTED ------");
-      String currentLine = "";
-      header = "";
-
-      while (client.connected()) {
-        if (client.available()) {
-          char c = client.read();
-          header += c;
-
-          if (c == '\n') {
-            // blank line: end of HTTP headers
-            if (currentLine.length() == 0) {
-
-              // --------- Parse method + path from first line ---------
-              // Example first line: "POST /save HTTP/1.1"
-              int methodEnd = header.indexOf(' ');
-              int pathStart = methodEnd + 1;
-              int pathEnd   = header.indexOf(' ', pathStart);
-
-              String method = header.substring(0, methodEnd);
-              String fullPath = header.substring(pathStart, pathEnd);  // "/save" or "/save?ssid=..."
-
-              bool isPost = method.equalsIgnoreCase("POST");
-              bool isGet  = method.equalsIgnoreCase("GET");
-
-              // --------- Extract Content-Length (for POST body) ---------
-              int contentLength = 0;
-              int clIndex = header.indexOf("Content-Length:");
-              if (clIndex != -1) {
-                int lineEnd = header.indexOf('\n', clIndex);
-                String clLine = header.substring(clIndex + 15, lineEnd); // after "Content-Length:"
-                clLine.trim();
-                contentLength = clLine.toInt();
-              }
-
-              // Read body if POST
-              String body = "";
-              if (isPost && contentLength > 0) {
-                while ((int)body.length() < contentLength) {
-                  if (client.available()) {
-                    char ch = client.read();
-                    body += ch;
-                  }
-                }
-              }
-
-              // --------- Handle /save ---------
-              if (fullPath.startsWith("/save")) {
-                String query;
-
-                if (isPost) {
-                  // For POST, form data is in body:
-                  // "ssid=...&password=...&upload_base=...&upload_endpoint=...&..."
-                  query = body;
-                } else if (isGet && fullPath.startsWith("/save?")) {
-                  // Backwards-compatible GET handler
-                  query = fullPath.substring(String("/save?").length());
-                }
-
-                // If we got some parameters, process them
-                if (query.length() > 0) {
-                  // Only treat as valid if session token matches
-                  String sessionParam = getParam(query, "session");
-                  if (sessionParam == sessionToken) {
-                    cfg_ssid        = getParam(query, "ssid");
-                    cfg_password    = getParam(query, "password");
-
-                    // NEW: split URL fields
-                    String uploadBase     = getParam(query, "upload_base");
-                    String uploadEndpoint = getParam(query, "upload_endpoint");
+  for (;;) {
+    acceptClients();
 
-                    // Normalise and combine into cfg_upload_url
-                    uploadBase.trim();
-                    uploadEndpoint.trim();
-
-                    if (uploadBase.endsWith("/")) {
-                      uploadBase.remove(uploadBase.length() - 1);
-                    }
-                    if (uploadEndpoint.startsWith("/")) {
-                      uploadEndpoint = uploadEndpoint.substring(1);
-                    }
-
-                    if (uploadBase.length() > 0 && uploadEndpoint.length() > 0) {
-                      cfg_upload_url = uploadBase + "/" + uploadEndpoint;
-                    } else {
-                      // if no endpoint, just store base
-                      cfg_upload_url = uploadBase;
-                    }
-
-                    cfg_interval_ms = getParam(query, "interval").toInt();
-                    cfg_resolution  = getParam(query, "res");
-                    cfg_vflip       = getParam(query, "vflip").toInt();
-                    cfg_brightness  = getParam(query, "bright").toInt();
-                    cfg_saturation  = getParam(query, "sat").toInt();
-
-                    saveConfig();
-                    sendConfigForm(client, true);
-                    server_running = 0;
-                  } else {
-                    // invalid / missing session -> just show form again
-                    sendConfigForm(client, false);
-                  }
-                } else {
-                  // /save but no params: show form
-                  sendConfigForm(client, false);
-                }
-
-              } else {
-                // Any other path -> show form
-                sendConfigForm(client, false);
-              }
-
-              break; // done handling request
-
-            } else {
-              currentLine = "";
-            }
-          } else if (c != '\r') {
-            currentLine += c;
-          }
-        }
+    bool busy = false;
+    for (int i = 0; i < PORTAL_MAX_CLIENTS; i++) {
+      if (!conns[i].open) continue;
+      busy = true;
+      if (serviceClient(&conns[i])) {
+        configSaved();
       }
+    }
 
-      client.stop();
-      // Serial.println("Client disconnected");
+    if (!busy && portalConfigured() && millis() - portal_last_activity > PORTAL_TIMEOUT_MS) {
+      break;
     }
+    vTaskDelay(pdMS_TO_TICKS(PORTAL_POLL_MS));
   }
 
-  Serial.println("Exiting runAccessPoint()");
+  server.end();
+  WiFi.softAPdisconnect(true);
+  portal_open = false;
+  Serial.printf("---- no portal request for %u s, access point closed\n", (unsigned)(PORTAL_TIMEOUT_MS / 1000));
+  vTaskDelete(NULL);
+}
+
+bool portalOpen() {
+  return portal_open;
+}
+
+void waitForPortalSave() {
+  portal_waiting = true;
+  xSemaphoreTake(portal_saved, portMAX_DELAY);
+  portal_waiting = false;
 }
 
 void setupAccessPoint() {
@@ -395,23 +157,27 @@ void setupAccessPoint() {
     Serial.println("SPIFFS mount failed");
   }
 
-  loadConfig();
-
-  sessionToken = String((uint32_t)esp_random(), HEX);
+  char session[PORTAL_SESSION_MAX];
+  snprintf(session, sizeof(session), "%08x", (unsigned)esp_random());
+  portalBegin(session);
 
+  /* the station side is connected by the boot sequence (boot.h) and keeps running */
   WiFi.mode(WIFI_AP_STA);
   bool ok = WiFi.softAP(HOST_SSID, HOST_PASSWORD, 1, 0);
   if (!ok) {
     Serial.println("!!! WiFi.softAP FAILED");
   }
 
-  WiFi.begin();
-
   IPAddress IP = WiFi.softAPIP();
   Serial.print("---- AccessPoint IP: ");
   Serial.print(IP);
 
   server.begin();
-  runAccessPoint();
-}
 
+  /* next to the capture pipeline, on the WiFi core and below its priority */
+  portal_open = true;
+  if (!portal_saved) {
+    portal_saved = xSemaphoreCreateBinary();
+  }
+  xTaskCreatePinnedToCore(portalTask, "portal", 6144, NULL, 1, NULL, 0);
+}
@@ -1,7 +1,28 @@
 #ifndef HOST_H
 #define HOST_H
 
+#include <stdint.h>
 
+/*
+  With a stored configuration the portal closes the access point after this long
+  without a request; without one it stays open until the form is saved.
+*/
+#define PORTAL_TIMEOUT_MS (5 * 60 * 1000UL)
+
+/*
+  Opens the access point and starts the configuration portal in a task of its own,
+  then returns. The portal serves several browsers at once and runs next to the
+  capture pipeline. A form saved while nobody waits in waitForPortalSave()
+  restarts the device, so the new configuration is applied.
+*/
 void setupAccessPoint();
 
-#endif // HOST_H
\ No newline at end of file
+/* true from setupAccessPoint() until the access point closed after PORTAL_TIMEOUT_MS */
+bool portalOpen();
+
+/*
+  Blocks until the form was saved (first boot without a stored configuration).
+*/
+void waitForPortalSave();
+
+#endif // HOST_H
@@ -0,0 +1,187 @@
+#include "boot.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+  Simulation of the boot sequence (boot.cpp), host only.
+
+    ./boot-sim            runs every scenario, exit code 1 if one breaks its expectations
+
+  Each scenario describes the world the device boots into: whether the cached
+  access point still answers, how long a connect with a full scan takes, when the
+  network is there at all, when the connection drops, when someone saves the portal
+  form. A virtual clock in 10 ms steps feeds the boot logic the Wi-Fi events its
+  own actions lead to, so a few minutes of boot run in microseconds.
+
+  Per scenario the summary shows when capturing started, when the device got online
+  and when the first frame was uploaded, next to the old sequence: portal first,
+  connect without a timeout, then up to 5 s of waiting for NTP.
+*/
+#define SIM_STEP_MS 10
+#define SIM_NEVER UINT32_MAX
+#define SIM_UPLOAD_MS 600           /* capture + upload of the first frame */
+#define SIM_LEGACY_NTP_WAIT_MS 5000
+
+typedef struct {
+  const char *name;
+  bool config_ok;
+  bool portal_requested;
+  bool ap_cached;
+  bool cache_valid;         /* the cached BSSID/channel still lead to the access point */
+  bool password_ok;
+  uint32_t fast_ms;         /* connect time with BSSID and channel */
+  uint32_t scan_ms;         /* connect time with a full scan */
+  uint32_t network_from;    /* the access point is up from here on */
+  uint32_t drop_at;         /* connection lost at this time, SIM_NEVER = never */
+  uint32_t save_at;         /* portal form saved at this time, SIM_NEVER = never */
+  uint32_t ntp_ms;          /* NTP answer after the connect */
+  uint32_t horizon_ms;
+
+  /* expectations */
+  boot_state_t final_state;
+  bool portal_expected;
+  uint32_t max_first_upload;   /* SIM_NEVER = no upload expected */
+} scenario_t;
+
+static const scenario_t SCENARIOS[] = {
+  { "cached access point",  true,  false, true,  true,  true, 400, 2500, 0,     SIM_NEVER, SIM_NEVER, 1200,  60000,
+    BOOT_RUN,     false, 1500 },
+  { "access point moved",   true,  false, true,  false, true, 400, 2500, 0,     SIM_NEVER, SIM_NEVER, 1200,  60000,
+    BOOT_RUN,     false, 7000 },
+  { "nothing cached",       true,  false, false, false, true, 400, 2500, 0,     SIM_NEVER, SIM_NEVER, 1200,  60000,
+    BOOT_RUN,     false, 4000 },
+  { "slow NTP",             true,  false, true,  true,  true, 400, 2500, 0,     SIM_NEVER, SIM_NEVER, 30000, 60000,
+    BOOT_RUN,     false, 1500 },
+  { "network down 90 s",    true,  false, true,  true,  true, 400, 2500, 90000, SIM_NEVER, SIM_NEVER, 1200,  180000,
+    BOOT_RUN,     true,  130000 },
+  { "wrong password",       true,  false, true,  true,  false, 400, 2500, 0,    SIM_NEVER, SIM_NEVER, 1200,  180000,
+    BOOT_OFFLINE, true,  SIM_NEVER },
+  { "connection drops",     true,  false, true,  true,  true, 400, 2500, 0,     20000,     SIM_NEVER, 1200,  180000,
+    BOOT_RUN,     false, 1500 },
+  { "portal on demand",     true,  true,  true,  true,  true, 400, 2500, 0,     SIM_NEVER, SIM_NEVER, 1200,  60000,
+    BOOT_RUN,     true,  1500 },
+  { "first boot",           false, false, false, false, true, 400, 2500, 0,     SIM_NEVER, 45000,     1200,  120000,
+    BOOT_RUN,     true,  50000 },
+};
+#define SCENARIO_COUNT (sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+
+typedef struct {
+  uint32_t pipeline_at;
+  uint32_t online_at;
+  uint32_t first_upload_at;
+  uint32_t ntp_at;
+  bool portal;
+} sim_result_t;
+
+static int failures = 0;
+
+static void check(bool ok, const scenario_t *sc, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s: %s\n", sc->name, what);
+    failures++;
+  }
+}
+
+/* connect time for an attempt started at t, SIM_NEVER if it cannot succeed */
+static uint32_t connectAt(const scenario_t *sc, uint32_t t, bool fast) {
+  if (!sc->password_ok || (fast && !sc->cache_valid)) return SIM_NEVER;
+  uint32_t from = t > sc->network_from ? t : sc->network_from;
+  return from + (fast ? sc->fast_ms : sc->scan_ms);
+}
+
+static void simulate(const scenario_t *sc, boot_t *boot, sim_result_t *res) {
+  memset(res, 0, sizeof(*res));
+  res->pipeline_at = res->online_at = res->first_upload_at = res->ntp_at = SIM_NEVER;
+
+  uint32_t connect_at = SIM_NEVER;
+  bool connected = false, dropped = false, saved = false;
+
+  uint32_t actions = bootInit(boot, sc->config_ok, sc->portal_requested, sc->ap_cached, 0);
+  for (uint32_t t = 0; t <= sc->horizon_ms; t += SIM_STEP_MS) {
+    if (actions & BOOT_DO_OPEN_PORTAL) res->portal = true;
+    if (actions & BOOT_DO_CONNECT_FAST) connect_at = connectAt(sc, t, true);
+    if (actions & BOOT_DO_CONNECT_SCAN) connect_at = connectAt(sc, t, false);
+    if ((actions & BOOT_DO_START_PIPELINE) && res->pipeline_at == SIM_NEVER) res->pipeline_at = t;
+    if ((actions & BOOT_DO_START_NTP) && res->ntp_at == SIM_NEVER) res->ntp_at = t + sc->ntp_ms;
+
+    /* the first frame goes out once capturing runs and the device is online */
+    if (res->first_upload_at == SIM_NEVER && connected && res->pipeline_at != SIM_NEVER) {
+      uint32_t ready = res->pipeline_at > res->online_at ? res->pipeline_at : res->online_at;
+      res->first_upload_at = ready + SIM_UPLOAD_MS;
+    }
+
+    boot_event_t event = BOOT_EVENT_TICK;
+    if (!saved && t >= sc->save_at) {
+      saved = true;
+      event = BOOT_EVENT_CONFIG_SAVED;
+    } else if (connected && !dropped && t >= sc->drop_at) {
+      dropped = true;
+      connected = false;
+      connect_at = SIM_NEVER;
+      event = BOOT_EVENT_DISCONNECTED;
+    } else if (!connected && t >= connect_at) {
+      connected = true;
+      connect_at = SIM_NEVER;
+      if (res->online_at == SIM_NEVER) res->online_at = t;
+      event = BOOT_EVENT_CONNECTED;
+    }
+    actions = bootStep(boot, event, t);
+  }
+}
+
+/* portal first (waits for the form without a config), connect without a timeout, then NTP */
+static uint32_t legacyFirstUpload(const scenario_t *sc) {
+  uint32_t start = sc->config_ok ? 0 : sc->save_at;
+  uint32_t online = connectAt(sc, start, false);
+  if (online == SIM_NEVER) return SIM_NEVER;
+  uint32_t ntp = sc->ntp_ms < SIM_LEGACY_NTP_WAIT_MS ? sc->ntp_ms : SIM_LEGACY_NTP_WAIT_MS;
+  return online + ntp + SIM_UPLOAD_MS;
+}
+
+static void printMs(uint32_t ms) {
+  if (ms == SIM_NEVER) {
+    printf(" %9s", "-");
+  } else {
+    printf(" %9.1f", ms / 1000.0);
+  }
+}
+
+int main() {
+  printf("%-22s %9s %9s %9s %9s %6s  %-11s %s\n", "scenario [s]", "capture", "online", "upload", "legacy",
+         "portal", "state", "fast/scan failures");
+
+  for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+    const scenario_t *sc = &SCENARIOS[i];
+    boot_t boot;
+    sim_result_t res;
+    simulate(sc, &boot, &res);
+
+    printf("%-22s", sc->name);
+    printMs(res.pipeline_at);
+    printMs(res.online_at);
+    printMs(res.first_upload_at);
+    printMs(legacyFirstUpload(sc));
+    printf(" %6s  %-11s %u/%u\n", res.portal ? "open" : "-", bootStateName(boot.state),
+           (unsigned)boot.fast_failures, (unsigned)boot.scan_failures);
+
+    check(boot.state == sc->final_state, sc, "final state");
+    check(res.portal == sc->portal_expected, sc, "portal opened only on demand or on failure");
+    check(sc->max_first_upload == SIM_NEVER ? res.first_upload_at == SIM_NEVER
+                                            : res.first_upload_at <= sc->max_first_upload,
+          sc, "time to first upload");
+    /* capturing never waits for more than a fast and a scan connect */
+    check(!sc->config_ok || res.pipeline_at <= BOOT_FAST_CONNECT_MS + BOOT_SCAN_CONNECT_MS + SIM_STEP_MS,
+          sc, "capturing starts without waiting for the network");
+    /* the first upload waits for capturing and the connection, nothing else (no NTP) */
+    uint32_t ready = res.pipeline_at > res.online_at ? res.pipeline_at : res.online_at;
+    check(res.first_upload_at == SIM_NEVER || res.first_upload_at <= ready + SIM_UPLOAD_MS + SIM_STEP_MS,
+          sc, "first upload does not wait for NTP");
+  }
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
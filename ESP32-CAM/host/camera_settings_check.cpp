@@ -0,0 +1,358 @@
+#include "camera_settings.h"
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+  Checks for the live camera settings (camera_settings.cpp) and for the way they are
+  stored (configWriteAtomic(), saveCameraSettings() in config.cpp), host only.
+
+    ./camera-settings-check               exit code 1 on failure
+
+  The first part covers what the control endpoint does with a request: parsing and
+  range checks, the diff against the running settings, when the camera needs a
+  re-init and the order the sensor gets the values in.
+
+  The second part runs against a flash stand-in in this file instead of hal_host.cpp.
+  It counts every write, rename and remove, and can cut the power before any of them:
+  that step and all later ones do not happen, and a cut write leaves half a file.
+  For every possible cut point the config file is then read back as after a reboot,
+  and has to hold the complete old or the complete new content.
+*/
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+/*
+  -----------------------------
+  ------- FLASH STAND-IN ------
+  -----------------------------
+*/
+#define FLASH_FILES 8
+#define FLASH_NAME_MAX 48
+
+typedef struct {
+  bool used;
+  char name[FLASH_NAME_MAX];
+  uint8_t data[CONFIG_FILE_MAX];
+  size_t len;
+} flash_file_t;
+
+static flash_file_t flash[FLASH_FILES];
+static int flash_ops = 0;
+static int flash_cut_at = -1;   /* -1 = never */
+
+static flash_file_t *flashFind(const char *path) {
+  for (int i = 0; i < FLASH_FILES; i++) {
+    if (flash[i].used && strcmp(flash[i].name, path) == 0) return &flash[i];
+  }
+  return NULL;
+}
+
+/* true if this mutation still happens; the first one at or after the cut does not */
+static bool flashPowered() {
+  int op = flash_ops++;
+  return flash_cut_at < 0 || op < flash_cut_at;
+}
+
+static void flashReset() {
+  memset(flash, 0, sizeof(flash));
+  flash_ops = 0;
+  flash_cut_at = -1;
+}
+
+/* power comes back: count from 0 again, nothing is cut */
+static void flashReboot() {
+  flash_ops = 0;
+  flash_cut_at = -1;
+}
+
+static void flashPut(const char *path, const char *content) {
+  flash_file_t *file = flashFind(path);
+  for (int i = 0; !file && i < FLASH_FILES; i++) {
+    if (!flash[i].used) file = &flash[i];
+  }
+  file->used = true;
+  snprintf(file->name, sizeof(file->name), "%s", path);
+  file->len = strlen(content);
+  memcpy(file->data, content, file->len);
+}
+
+bool halFsBegin() {
+  return true;
+}
+
+bool halFsExists(const char *path) {
+  return flashFind(path) != NULL;
+}
+
+long halFsReadFile(const char *path, uint8_t *buf, size_t cap) {
+  flash_file_t *file = flashFind(path);
+  if (!file || file->len > cap) return -1;
+  memcpy(buf, file->data, file->len);
+  return (long)file->len;
+}
+
+bool halFsWriteFile(const char *path, const uint8_t *data, size_t len) {
+  if (len > CONFIG_FILE_MAX) return false;
+  bool powered = flashPowered();
+  flash_file_t *file = flashFind(path);
+  for (int i = 0; !file && i < FLASH_FILES; i++) {
+    if (!flash[i].used) file = &flash[i];
+  }
+  /* the cut comes halfway through the data */
+  size_t written = powered ? len : len / 2;
+  file->used = true;
+  snprintf(file->name, sizeof(file->name), "%s", path);
+  memcpy(file->data, data, written);
+  file->len = written;
+  return powered;
+}
+
+bool halFsRemove(const char *path) {
+  if (!flashPowered()) return false;
+  flash_file_t *file = flashFind(path);
+  if (!file) return false;
+  file->used = false;
+  return true;
+}
+
+bool halFsRename(const char *from, const char *to) {
+  if (!flashPowered()) return false;
+  flash_file_t *file = flashFind(from);
+  if (!file || flashFind(to)) return false;
+  snprintf(file->name, sizeof(file->name), "%s", to);
+  return true;
+}
+
+void halLog(const char *format, ...) {
+  (void)format;
+}
+
+/*
+  -----------------------------
+  ---------- SETTINGS ---------
+  -----------------------------
+*/
+typedef struct {
+  camera_setting_t order[CAMERA_SETTING_COUNT];
+  int count;
+  int refuse;   /* setting the sensor refuses, -1 = none */
+} sensor_log_t;
+
+static bool recordSet(void *ctx, camera_setting_t setting, int32_t value) {
+  (void)value;
+  sensor_log_t *log = (sensor_log_t *)ctx;
+  log->order[log->count++] = setting;
+  return (int)setting != log->refuse;
+}
+
+static int positionOf(const sensor_log_t *log, camera_setting_t setting) {
+  for (int i = 0; i < log->count; i++) {
+    if (log->order[i] == setting) return i;
+  }
+  return -1;
+}
+
+static void checkTable() {
+  camera_settings_t settings;
+  cameraSettingsDefaults(&settings);
+  bool in_range = true, found = true;
+  for (int i = 0; i < CAMERA_SETTING_COUNT; i++) {
+    const camera_setting_desc_t *desc = cameraSettingDesc((camera_setting_t)i);
+    in_range = in_range && desc->min <= settings.value[i] && settings.value[i] <= desc->max;
+    found = found && cameraSettingIndex(desc->key) == i;
+  }
+  check(in_range, "defaults within their ranges");
+  check(found, "every API key found at its own index");
+  check(cameraSettingDesc(CAMERA_SETTING_COUNT) == NULL && cameraSettingIndex("iso") == -1, "unknown setting");
+  check(settings.value[CAMERA_SET_FRAMESIZE] == FRAMESIZE_VGA && settings.value[CAMERA_SET_INTERVAL] == 300 &&
+        settings.value[CAMERA_SET_VFLIP] == 1 && settings.value[CAMERA_SET_BRIGHTNESS] == 1 &&
+        settings.value[CAMERA_SET_SATURATION] == -1, "defaults of the settings loadConfig() always had");
+
+  for (int f = FRAMESIZE_QVGA; f <= FRAMESIZE_UXGA; f++) {
+    const char *name = cameraFramesizeName((framesize_t)f);
+    if (name) check(cameraFramesizeFromName(name) == f, "frame size name round trip");
+  }
+  check(cameraFramesizeFromName("UXGA") == FRAMESIZE_UXGA, "frame size names ignore case");
+  check(cameraFramesizeFromName("4k") == FRAMESIZE_INVALID, "unknown frame size name");
+}
+
+static void checkUpdates() {
+  camera_settings_t settings, before;
+  cameraSettingsDefaults(&settings);
+  before = settings;
+
+  check(cameraSettingSet(&settings, "gain", 30) == CAMERA_UPDATE_OK && settings.value[CAMERA_SET_GAIN] == 30,
+        "value at the top of its range");
+  check(cameraSettingSet(&settings, "brightness", -2) == CAMERA_UPDATE_OK, "value at the bottom of its range");
+  before = settings;
+  check(cameraSettingSet(&settings, "gain", 31) == CAMERA_UPDATE_OUT_OF_RANGE, "value above its range");
+  check(cameraSettingSet(&settings, "brightness", -3) == CAMERA_UPDATE_OUT_OF_RANGE, "value below its range");
+  check(cameraSettingSet(&settings, "iso", 100) == CAMERA_UPDATE_UNKNOWN_KEY, "unknown key");
+  check(cameraSettingSet(&settings, "resolution", FRAMESIZE_HVGA) == CAMERA_UPDATE_BAD_VALUE,
+        "frame size without a name");
+  check(memcmp(&settings, &before, sizeof(settings)) == 0, "a rejected value changes nothing");
+
+  check(cameraSettingSetString(&settings, "resolution", "SXGA") == CAMERA_UPDATE_OK &&
+        settings.value[CAMERA_SET_FRAMESIZE] == FRAMESIZE_SXGA, "frame size by name");
+  check(cameraSettingSetString(&settings, "resolution", "5") == CAMERA_UPDATE_BAD_VALUE, "frame size as a number string");
+  check(cameraSettingSetString(&settings, "exposure", "400") == CAMERA_UPDATE_OK &&
+        settings.value[CAMERA_SET_EXPOSURE] == 400, "number as a string");
+  check(cameraSettingSetString(&settings, "ae_level", "-1") == CAMERA_UPDATE_OK &&
+        settings.value[CAMERA_SET_AE_LEVEL] == -1, "negative number as a string");
+  before = settings;
+  const char *bad[] = { "", "-", "4a", " 4", "4 ", "+4", "0x10", "99999999999999999999" };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    check(cameraSettingSetString(&settings, "exposure", bad[i]) == CAMERA_UPDATE_BAD_VALUE, "malformed number");
+  }
+  check(cameraSettingSetString(&settings, "exposure", "1201") == CAMERA_UPDATE_OUT_OF_RANGE, "number string out of range");
+  check(memcmp(&settings, &before, sizeof(settings)) == 0, "a rejected string changes nothing");
+}
+
+static void checkDiffAndApply() {
+  camera_settings_t current, next;
+  cameraSettingsDefaults(&current);
+  next = current;
+  check(cameraSettingsDiff(&current, &next) == 0, "no diff between equal settings");
+
+  cameraSettingSet(&next, "exposure", 500);
+  cameraSettingSet(&next, "auto_exposure", 0);
+  cameraSettingSet(&next, "interval_ms", 1000);
+  uint32_t changes = cameraSettingsDiff(&current, &next);
+  check(changes == ((1u << CAMERA_SET_EXPOSURE) | (1u << CAMERA_SET_AUTO_EXPOSURE) | (1u << CAMERA_SET_INTERVAL)),
+        "diff has a bit for every changed setting");
+  check(!cameraSettingsNeedReinit(changes, &next, FRAMESIZE_VGA), "no re-init without a frame size change");
+
+  sensor_log_t log = { {}, 0, -1 };
+  check(cameraSettingsApply(&next, changes, recordSet, &log), "apply succeeds");
+  check(log.count == 2, "only the changed sensor settings are set, not the interval");
+  check(positionOf(&log, CAMERA_SET_AUTO_EXPOSURE) < positionOf(&log, CAMERA_SET_EXPOSURE),
+        "auto exposure is switched off before the manual exposure is set");
+
+  /* all at once, as after a re-init */
+  uint32_t all = (1u << CAMERA_SETTING_COUNT) - 1;
+  log = { {}, 0, CAMERA_SET_CONTRAST };
+  check(!cameraSettingsApply(&next, all, recordSet, &log), "a refused value fails the apply");
+  check(log.count == CAMERA_SETTING_COUNT - 1, "the other settings are still tried");
+  check(positionOf(&log, CAMERA_SET_AUTO_GAIN) < positionOf(&log, CAMERA_SET_GAIN) &&
+        positionOf(&log, CAMERA_SET_AWB) < positionOf(&log, CAMERA_SET_WB_MODE),
+        "automatic modes before the values they override");
+
+  /* frame buffers hold the frame size of the init */
+  next = current;
+  cameraSettingSet(&next, "resolution", FRAMESIZE_QVGA);
+  changes = cameraSettingsDiff(&current, &next);
+  check(!cameraSettingsNeedReinit(changes, &next, FRAMESIZE_VGA), "smaller frame size set live");
+  cameraSettingSet(&next, "resolution", FRAMESIZE_UXGA);
+  changes = cameraSettingsDiff(&current, &next);
+  check(cameraSettingsNeedReinit(changes, &next, FRAMESIZE_VGA), "larger frame size needs a re-init");
+  check(!cameraSettingsNeedReinit(changes, &next, FRAMESIZE_UXGA), "no re-init up to the size of the init");
+
+  char json[512];
+  portal_json_t out;
+  portalJsonBegin(&out, json, sizeof(json));
+  cameraSettingsJson(&out, &next);
+  check(portalJsonEnd(&out) > 0 && strstr(json, "\"resolution\":\"uxga\"") && strstr(json, "\"wb_mode\":0"),
+        "settings as JSON");
+}
+
+/*
+  -----------------------------
+  --------- PERSISTENCE -------
+  -----------------------------
+*/
+#define CONFIG_PATH "/config.json"
+
+static const char OLD_CONFIG[] =
+  "{\"NETWORK\":{\"SSID\":\"hive\",\"UPLOAD_URL\":\"https://example.com/upload\"},"
+  "\"CAMERA\":{\"RESOLUTION\":\"vga\",\"QUEUE_DEPTH\":2},\"CONTROL\":{\"TOKEN\":\"s3cret\"}}";
+static const char NEW_CONFIG[] =
+  "{\"NETWORK\":{\"SSID\":\"hive\",\"UPLOAD_URL\":\"https://example.com/upload\"},"
+  "\"CAMERA\":{\"RESOLUTION\":\"uxga\",\"QUEUE_DEPTH\":2},\"CONTROL\":{\"TOKEN\":\"s3cret\"}}";
+
+static bool readBackIs(const char *content) {
+  static uint8_t buf[CONFIG_FILE_MAX];
+  long len = configReadFile(CONFIG_PATH, buf, sizeof(buf));
+  return len == (long)strlen(content) && memcmp(buf, content, len) == 0;
+}
+
+static void checkAtomicReplace() {
+  flashReset();
+  flashPut(CONFIG_PATH, OLD_CONFIG);
+  check(configWriteAtomic(CONFIG_PATH, (const uint8_t *)NEW_CONFIG, strlen(NEW_CONFIG)) && readBackIs(NEW_CONFIG),
+        "replace without a cut");
+  check(!halFsExists(CONFIG_PATH ".new") && !halFsExists(CONFIG_PATH ".bak"), "no temporary file left");
+  int steps = flash_ops;
+
+  flashReset();
+  check(configWriteAtomic(CONFIG_PATH, (const uint8_t *)OLD_CONFIG, strlen(OLD_CONFIG)) && readBackIs(OLD_CONFIG),
+        "first write of a missing file");
+
+  /* a power cut before every step, then a reboot, then the next save */
+  for (int cut = 0; cut <= steps; cut++) {
+    flashReset();
+    flashPut(CONFIG_PATH, OLD_CONFIG);
+    flash_cut_at = cut;
+    bool done = configWriteAtomic(CONFIG_PATH, (const uint8_t *)NEW_CONFIG, strlen(NEW_CONFIG));
+    flashReboot();
+
+    char what[96];
+    snprintf(what, sizeof(what), "cut before step %d: old or new content, complete", cut);
+    check(readBackIs(OLD_CONFIG) || readBackIs(NEW_CONFIG), what);
+    snprintf(what, sizeof(what), "cut before step %d: reported success means the new content", cut);
+    check(!done || readBackIs(NEW_CONFIG), what);
+
+    snprintf(what, sizeof(what), "cut before step %d: the next save after the reboot works", cut);
+    check(configWriteAtomic(CONFIG_PATH, (const uint8_t *)OLD_CONFIG, strlen(OLD_CONFIG)) && readBackIs(OLD_CONFIG) &&
+          !halFsExists(CONFIG_PATH ".bak"), what);
+  }
+}
+
+static void checkSaveKeepsTheRest() {
+  flashReset();
+  flashPut(CONFIG_PATH, OLD_CONFIG);
+
+  camera_settings_t settings;
+  cameraSettingsDefaults(&settings);
+  cameraSettingSet(&settings, "resolution", FRAMESIZE_SXGA);
+  cameraSettingSet(&settings, "gain", 12);
+  check(saveCameraSettings(CONFIG_PATH, &settings), "camera settings saved");
+
+  static uint8_t buf[CONFIG_FILE_MAX + 1];
+  long len = configReadFile(CONFIG_PATH, buf, CONFIG_FILE_MAX);
+  buf[len < 0 ? 0 : len] = '\0';
+  const char *text = (const char *)buf;
+  check(strstr(text, "\"RESOLUTION\":\"sxga\"") && strstr(text, "\"GAIN\":12"), "changed settings in the file");
+  check(strstr(text, "\"QUEUE_DEPTH\":2") && strstr(text, "\"TOKEN\":\"s3cret\"") && strstr(text, "\"SSID\":\"hive\""),
+        "the rest of the file kept");
+
+  /* what loadConfig() reads back is what was saved */
+  esp_config_t esp_config;
+  snprintf(esp_config.CONFIG_FILE, sizeof(esp_config.CONFIG_FILE), "%s", CONFIG_PATH);
+  check(loadConfig(&esp_config) && memcmp(&esp_config.CAMERA, &settings, sizeof(settings)) == 0 &&
+        strcmp(esp_config.CONTROL_TOKEN, "s3cret") == 0, "saved settings loaded back");
+
+  flashPut(CONFIG_PATH, "{\"CAMERA\":");
+  check(!saveCameraSettings(CONFIG_PATH, &settings) && readBackIs("{\"CAMERA\":"), "a broken file is left alone");
+}
+
+int main() {
+  checkTable();
+  checkUpdates();
+  checkDiffAndApply();
+  checkAtomicReplace();
+  checkSaveKeepsTheRest();
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
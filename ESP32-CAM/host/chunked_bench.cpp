@@ -0,0 +1,382 @@
+#include "client.h"
+#include "circle_result.h"
+#include "hal.h"
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+  Time to first byte at the server, Content-Length upload against chunked upload, host only.
+
+    ./chunked-bench [rounds] [link_kbps] [readout_ms] [frame.jpg ...]
+
+  A camera stand-in produces every frame in BENCH_SLICE pieces, spread evenly over
+  readout_ms (the sensor reading out and compressing the frame). With a Content-Length
+  the frame can only go out once it is complete (postImage()); chunked, every slice is
+  sent as soon as it is there (postImageStream()). A sink server on loopback reads at
+  most link_kbps (0: as fast as loopback goes) and notes when the first and the last
+  byte of every request arrived, counted from the start of the capture.
+
+  Without files the frames are random stand-ins of the size of SXGA and UXGA JPEGs
+  (the sample images are UXGA, about 165 KB each).
+*/
+#define BENCH_SLICE 4096
+#define BENCH_ROUNDS_MAX 100
+#define BENCH_FRAMES_MAX 8
+
+static double nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void sleepUntil(double ms) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)(ms / 1e3);
+  ts.tv_nsec = (long)((ms - ts.tv_sec * 1e3) * 1e6);
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+/*
+  -----------------------------
+  ---------- SINK -------------
+  -----------------------------
+*/
+typedef struct {
+  int listen_fd;
+  uint16_t port;
+  uint32_t link_kbps;
+
+  pthread_mutex_t lock;
+  double first_byte;   /* of the last request, nowMs() */
+  double last_byte;
+} sink_t;
+
+/* buffered, optionally rate limited reads of one connection */
+typedef struct {
+  sink_t *sink;
+  int fd;
+  uint8_t buf[2048];
+  size_t pos;
+  size_t len;
+  bool started;        /* first byte of the current request seen */
+  double pace_start;
+  size_t paced;
+} reader_t;
+
+static bool fill(reader_t *r) {
+  size_t want = r->sink->link_kbps ? 1460 : sizeof(r->buf);
+  ssize_t n = recv(r->fd, r->buf, want, 0);
+  if (n <= 0) return false;
+  double now = nowMs();
+  r->pos = 0;
+  r->len = (size_t)n;
+
+  pthread_mutex_lock(&r->sink->lock);
+  if (!r->started) {
+    r->started = true;
+    r->sink->first_byte = now;
+    r->pace_start = now;
+    r->paced = 0;
+  }
+  r->sink->last_byte = now;
+  pthread_mutex_unlock(&r->sink->lock);
+
+  /* kbps are bits per ms */
+  if (r->sink->link_kbps) {
+    r->paced += n;
+    sleepUntil(r->pace_start + r->paced * 8.0 / r->sink->link_kbps);
+  }
+  return true;
+}
+
+static bool readLine(reader_t *r, char *line, size_t cap) {
+  size_t len = 0;
+  for (;;) {
+    if (r->pos == r->len && !fill(r)) return false;
+    char c = (char)r->buf[r->pos++];
+    if (c == '\n') break;
+    if (c != '\r' && len + 1 < cap) line[len++] = c;
+  }
+  line[len] = '\0';
+  return true;
+}
+
+static bool skip(reader_t *r, size_t count) {
+  while (count > 0) {
+    if (r->pos == r->len && !fill(r)) return false;
+    size_t n = r->len - r->pos < count ? r->len - r->pos : count;
+    r->pos += n;
+    count -= n;
+  }
+  return true;
+}
+
+/* reads one request and answers it with an empty detection result; false once the client is gone */
+static bool serveRequest(reader_t *r) {
+  char line[256];
+  size_t content_length = 0;
+  bool chunked = false;
+
+  r->started = false;
+  if (!readLine(r, line, sizeof(line))) return false;
+  while (readLine(r, line, sizeof(line)) && line[0]) {
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      content_length = strtoul(line + 15, NULL, 10);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line + 18, "chunked")) {
+      chunked = true;
+    }
+  }
+
+  if (chunked) {
+    for (;;) {
+      if (!readLine(r, line, sizeof(line))) return false;
+      size_t size = strtoul(line, NULL, 16);
+      if (size == 0) {
+        if (!readLine(r, line, sizeof(line))) return false;   /* no trailers, just the CRLF */
+        break;
+      }
+      if (!skip(r, size) || !readLine(r, line, sizeof(line))) return false;
+    }
+  } else if (!skip(r, content_length)) {
+    return false;
+  }
+
+  /* one write: a separate body would wait for the client's delayed ACK (Nagle) */
+  char answer[160];
+  int len = snprintf(answer, sizeof(answer),
+                     "HTTP/1.1 200 OK\r\nContent-Type: " CIRCLE_RESULT_MIME "\r\nContent-Length: %u\r\n\r\n",
+                     CIRCLE_RESULT_HEADER);
+  const uint8_t empty[CIRCLE_RESULT_HEADER] = { CIRCLE_RESULT_VERSION, 0, 0, 0 };
+  memcpy(answer + len, empty, sizeof(empty));
+  len += sizeof(empty);
+  return send(r->fd, answer, len, MSG_NOSIGNAL) == len;
+}
+
+static void *sinkRun(void *arg) {
+  sink_t *sink = (sink_t *)arg;
+  static reader_t reader;
+  for (;;) {
+    int fd = accept(sink->listen_fd, NULL, NULL);
+    if (fd < 0) return NULL;
+    memset(&reader, 0, sizeof(reader));
+    reader.sink = sink;
+    reader.fd = fd;
+    while (serveRequest(&reader)) {
+    }
+    close(fd);
+  }
+}
+
+static bool sinkStart(sink_t *sink, uint32_t link_kbps) {
+  memset(sink, 0, sizeof(*sink));
+  pthread_mutex_init(&sink->lock, NULL);
+  sink->link_kbps = link_kbps;
+
+  sink->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (sink->listen_fd < 0) return false;
+  /* a small receive window, so a slow link holds the sender back like on Wi-Fi */
+  int window = 16 * 1024;
+  setsockopt(sink->listen_fd, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  if (bind(sink->listen_fd, (struct sockaddr *)&addr, addr_len) != 0 ||
+      listen(sink->listen_fd, 1) != 0 ||
+      getsockname(sink->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+    return false;
+  }
+  sink->port = ntohs(addr.sin_port);
+
+  pthread_t thread;
+  return pthread_create(&thread, NULL, sinkRun, sink) == 0 && pthread_detach(thread) == 0;
+}
+
+/*
+  -----------------------------
+  --------- CAMERA ------------
+  -----------------------------
+*/
+typedef struct {
+  const uint8_t *frame;
+  size_t len;
+  size_t pos;
+  double start;        /* capture start, nowMs() */
+  double readout_ms;
+} sensor_t;
+
+/* frame_slice_fn: a slice is there once the readout has got past its end */
+static const uint8_t *nextSlice(void *ctx, size_t *len) {
+  sensor_t *sensor = (sensor_t *)ctx;
+  if (sensor->pos >= sensor->len) return NULL;
+
+  size_t n = sensor->len - sensor->pos < BENCH_SLICE ? sensor->len - sensor->pos : BENCH_SLICE;
+  sleepUntil(sensor->start + sensor->readout_ms * (sensor->pos + n) / sensor->len);
+  const uint8_t *slice = sensor->frame + sensor->pos;
+  sensor->pos += n;
+  *len = n;
+  return slice;
+}
+
+typedef struct {
+  const char *name;
+  uint8_t *data;
+  size_t len;
+} bench_frame_t;
+
+static bool loadFrame(bench_frame_t *frame, const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  frame->len = (size_t)ftell(f);
+  fseek(f, 0, SEEK_SET);
+  frame->data = (uint8_t *)malloc(frame->len);
+  bool ok = frame->data && fread(frame->data, 1, frame->len, f) == frame->len;
+  fclose(f);
+  const char *slash = strrchr(path, '/');
+  frame->name = slash ? slash + 1 : path;
+  return ok;
+}
+
+static void standInFrame(bench_frame_t *frame, const char *name, size_t len) {
+  frame->name = name;
+  frame->len = len;
+  frame->data = (uint8_t *)malloc(len);
+  for (size_t i = 0; i < len; i++) frame->data[i] = (uint8_t)rand();
+  frame->data[0] = 0xff;
+  frame->data[1] = 0xd8;
+  frame->data[len - 2] = 0xff;
+  frame->data[len - 1] = 0xd9;
+}
+
+/*
+  -----------------------------
+  --------- BENCHMARK ---------
+  -----------------------------
+*/
+typedef struct {
+  double first_byte[BENCH_ROUNDS_MAX];
+  double last_byte[BENCH_ROUNDS_MAX];
+  double answer[BENCH_ROUNDS_MAX];
+  int count;
+  int failed;
+} mode_times_t;
+
+/* one upload of frame; false if it did not get a 200 */
+static bool uploadOnce(sink_t *sink, char *url, const bench_frame_t *frame, bool chunked,
+                       double readout_ms, uint32_t sequence, mode_times_t *times) {
+  frame_info_t info = {};
+  info.sequence = sequence;
+  sensor_t sensor = { frame->data, frame->len, 0, nowMs(), readout_ms };
+
+  int code;
+  if (chunked) {
+    code = postImageStream(url, &info, nextSlice, &sensor);
+  } else {
+    /* the whole frame has to be read out before its length is known */
+    size_t len;
+    while (nextSlice(&sensor, &len)) {
+    }
+    camera_fb_t fb;
+    memset(&fb, 0, sizeof(fb));
+    fb.buf = frame->data;
+    fb.len = frame->len;
+    code = postImage(url, &fb, &info);
+  }
+  double done = nowMs();
+
+  if (code != 200) {
+    times->failed++;
+    return false;
+  }
+  pthread_mutex_lock(&sink->lock);
+  times->first_byte[times->count] = sink->first_byte - sensor.start;
+  times->last_byte[times->count] = sink->last_byte - sensor.start;
+  pthread_mutex_unlock(&sink->lock);
+  times->answer[times->count] = done - sensor.start;
+  times->count++;
+  return true;
+}
+
+static int compare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static double median(double *values, int count) {
+  if (count == 0) return 0;
+  qsort(values, count, sizeof(values[0]), compare);
+  return values[count / 2];
+}
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 10;
+  uint32_t link_kbps = argc > 2 ? (uint32_t)atoi(argv[2]) : 4000;
+  double readout_ms = argc > 3 ? atof(argv[3]) : 67;
+  if (rounds < 1) rounds = 1;
+  if (rounds > BENCH_ROUNDS_MAX) rounds = BENCH_ROUNDS_MAX;
+
+  bench_frame_t frames[BENCH_FRAMES_MAX];
+  int frame_count = 0;
+  for (int i = 4; i < argc && frame_count < BENCH_FRAMES_MAX; i++) {
+    if (!loadFrame(&frames[frame_count], argv[i])) return 1;
+    frame_count++;
+  }
+  if (frame_count == 0) {
+    srand(1);
+    standInFrame(&frames[frame_count++], "SXGA", 110 * 1024);
+    standInFrame(&frames[frame_count++], "UXGA", 165 * 1024);
+  }
+
+  static sink_t sink;
+  if (!sinkStart(&sink, link_kbps)) {
+    fprintf(stderr, "cannot start the sink server\n");
+    return 1;
+  }
+  char url[64];
+  snprintf(url, sizeof(url), "http://127.0.0.1:%u/upload", sink.port);
+
+  /* postImage() with a Content-Length, postImageStream() is always chunked */
+  setChunkedUpload(false);
+
+  static mode_times_t times[BENCH_FRAMES_MAX][2];
+  memset(times, 0, sizeof(times));
+  uint32_t sequence = 0;
+  for (int f = 0; f < frame_count; f++) {
+    /* alternate the modes, so both see the same machine load */
+    for (int r = 0; r < rounds; r++) {
+      for (int chunked = 0; chunked < 2; chunked++) {
+        uploadOnce(&sink, url, &frames[f], chunked, readout_ms, sequence++, &times[f][chunked]);
+      }
+    }
+  }
+
+  char link[32];
+  snprintf(link, sizeof(link), link_kbps ? "%u kbps" : "unlimited", (unsigned)link_kbps);
+  printf("\n%d rounds, readout %.0f ms, link %s, slices of %d bytes, medians in ms from capture start\n",
+         rounds, readout_ms, link, BENCH_SLICE);
+  printf("%-24s %8s %15s %11s %10s %9s %7s\n", "frame", "KB", "mode", "first byte", "last byte", "answer", "failed");
+  int failed = 0;
+  for (int f = 0; f < frame_count; f++) {
+    for (int chunked = 0; chunked < 2; chunked++) {
+      mode_times_t *t = &times[f][chunked];
+      failed += t->failed;
+      printf("%-24s %8.1f %15s %11.1f %10.1f %9.1f %7d\n", frames[f].name, frames[f].len / 1024.0,
+             chunked ? "chunked" : "Content-Length", median(t->first_byte, t->count),
+             median(t->last_byte, t->count), median(t->answer, t->count), t->failed);
+    }
+  }
+  return failed ? 1 : 0;
+}
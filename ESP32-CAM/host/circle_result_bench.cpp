@@ -0,0 +1,237 @@
+#include "circle_result.h"
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Round-trip test and parse-time benchmark of the binary detection result, host only.
+
+    ./circle-result-bench              checks + timings, exit code 1 on failure
+    ./circle-result-bench body.bin     prints a body saved from the backend, e.g.
+                                       curl -H "Accept: application/vnd.hivehive.circles" \
+                                            -F image=@frame.jpg -o body.bin http://host:4444/upload
+
+  The checks encode random and edge-case circle sets the way the backend does,
+  parse them back and compare, and make sure truncated, padded or foreign bodies
+  are rejected. The benchmark then times one response of 1..170 circles as the
+  device handles it: the binary result read in place against the JSON response
+  in a DynamicJsonDocument sized to fit (the firmware keeps 1024 bytes for it).
+*/
+#define BENCH_MAX_CIRCLES 170
+#define BENCH_JSON_MAX (64 * BENCH_MAX_CIRCLES + 256)
+
+static uint8_t body[CIRCLE_RESULT_HEADER + BENCH_MAX_CIRCLES * CIRCLE_RESULT_RECORD + 1];
+static char json[BENCH_JSON_MAX];
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static double nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* same layout as services/circle_result.py */
+static size_t encode(const circle_t *circles, size_t count, uint8_t *out) {
+  out[0] = CIRCLE_RESULT_VERSION;
+  out[1] = 0;
+  out[2] = count & 0xff;
+  out[3] = count >> 8;
+  uint8_t *p = out + CIRCLE_RESULT_HEADER;
+  for (size_t i = 0; i < count; i++) {
+    uint16_t radius = circles[i].radius | (circles[i].filled ? CIRCLE_RESULT_FILLED : 0);
+    uint16_t fields[3] = { circles[i].x, circles[i].y, radius };
+    for (int f = 0; f < 3; f++) {
+      *p++ = fields[f] & 0xff;
+      *p++ = fields[f] >> 8;
+    }
+  }
+  return p - out;
+}
+
+/* the JSON /upload answers with, timings included */
+static size_t encodeJson(const circle_t *circles, size_t count, char *out, size_t cap) {
+  size_t len = snprintf(out, cap, "{\"circles\":[");
+  for (size_t i = 0; i < count; i++) {
+    len += snprintf(out + len, cap - len, "%s{\"radius\":%u,\"status\":\"%s\",\"x\":%u,\"y\":%u}",
+                    i ? "," : "", circles[i].radius, circles[i].filled ? "filled" : "unfilled",
+                    circles[i].x, circles[i].y);
+  }
+  len += snprintf(out + len, cap - len,
+                  "],\"message\":\"Image esp_capture_20250101_120000_42.jpg uploaded successfully\","
+                  "\"timings\":{\"annotate\":3.1,\"decode\":5.42,\"hough\":81.07,\"publish\":0.35,\"stats\":1.9}}");
+  return len;
+}
+
+static void randomCircles(circle_t *circles, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    circles[i].x = rand() % 1600;
+    circles[i].y = rand() % 1200;
+    circles[i].radius = 5 + rand() % 100;
+    circles[i].filled = rand() % 2;
+  }
+}
+
+static bool sameCircles(const circle_result_t *result, const circle_t *circles, size_t count) {
+  if (result->count != count) return false;
+  for (size_t i = 0; i < count; i++) {
+    circle_t c;
+    circleResultGet(result, i, &c);
+    if (c.x != circles[i].x || c.y != circles[i].y || c.radius != circles[i].radius || c.filled != circles[i].filled) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  -----------------------------
+  ---------- CHECKS -----------
+  -----------------------------
+*/
+static void runChecks() {
+  static circle_t circles[BENCH_MAX_CIRCLES];
+  circle_result_t result;
+
+  /* random sets of every size */
+  for (size_t count = 0; count <= BENCH_MAX_CIRCLES; count++) {
+    randomCircles(circles, count);
+    size_t len = encode(circles, count, body);
+    check(circleResultParse(body, len, &result) && sameCircles(&result, circles, count), "random round trip");
+  }
+
+  /* extremes of every field */
+  circle_t edges[] = {
+    { 0, 0, 0, false },
+    { 65535, 65535, 0x7fff, true },
+    { 1, 65534, 0x7fff, false },
+    { 65535, 0, 0, true },
+  };
+  size_t count = sizeof(edges) / sizeof(edges[0]);
+  size_t len = encode(edges, count, body);
+  check(circleResultParse(body, len, &result) && sameCircles(&result, edges, count), "edge values round trip");
+
+  /* only exactly one complete result is accepted */
+  check(!circleResultParse(body, len - 1, &result), "truncated body rejected");
+  check(!circleResultParse(body, len + 1, &result), "padded body rejected");
+  check(!circleResultParse(body, 3, &result), "short header rejected");
+  check(!circleResultParse(NULL, 0, &result), "empty body rejected");
+  body[0] = CIRCLE_RESULT_VERSION + 1;
+  check(!circleResultParse(body, len, &result), "other version rejected");
+  const char *text = "{\"circles\":[]}";
+  check(!circleResultParse((const uint8_t *)text, strlen(text), &result), "JSON body rejected");
+
+  /* what the JSON parse in the old 1024 byte document keeps */
+  for (size_t n = 1; n <= BENCH_MAX_CIRCLES; n++) {
+    randomCircles(circles, n);
+    size_t json_len = encodeJson(circles, n, json, sizeof(json));
+    DynamicJsonDocument doc(1024);
+    DeserializationError error = deserializeJson(doc, json, json_len);
+    if (error || doc["circles"].size() != n) {
+      printf("JSON in DynamicJsonDocument(1024): fails from %u circles on (%s)\n",
+             (unsigned)n, error ? error.c_str() : "circles missing");
+      break;
+    }
+  }
+}
+
+/*
+  -----------------------------
+  --------- BENCHMARK ---------
+  -----------------------------
+*/
+static void runBenchmark() {
+  static circle_t circles[BENCH_MAX_CIRCLES];
+  const size_t sizes[] = { 1, 8, 32, 71, BENCH_MAX_CIRCLES };
+  const int rounds = 20000;
+
+  printf("%7s %9s %9s %12s %12s %13s\n", "circles", "bin B", "JSON B", "binary ns", "JSON ns", "JSON doc B");
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    size_t n = sizes[s];
+    randomCircles(circles, n);
+    size_t len = encode(circles, n, body);
+    size_t json_len = encodeJson(circles, n, json, sizeof(json));
+
+    /* the same work as printResponse(): every field of every circle */
+    volatile uint32_t sink = 0;
+    double start = nowNs();
+    for (int r = 0; r < rounds; r++) {
+      circle_result_t result;
+      if (!circleResultParse(body, len, &result)) break;
+      for (size_t i = 0; i < result.count; i++) {
+        circle_t c;
+        circleResultGet(&result, i, &c);
+        sink = sink + c.x + c.y + c.radius + c.filled;
+      }
+    }
+    double binary_ns = (nowNs() - start) / rounds;
+
+    /* a document large enough for this response, allocated per response like on the device */
+    size_t capacity = 1024;
+    while (capacity < 16 * BENCH_JSON_MAX) {
+      DynamicJsonDocument probe(capacity);
+      if (!deserializeJson(probe, json, json_len) && probe["circles"].size() == n) break;
+      capacity *= 2;
+    }
+    start = nowNs();
+    for (int r = 0; r < rounds; r++) {
+      DynamicJsonDocument doc(capacity);
+      deserializeJson(doc, json, json_len);
+      for (size_t i = 0; i < n; i++) {
+        int x = doc["circles"][i]["x"];
+        int y = doc["circles"][i]["y"];
+        int radius = doc["circles"][i]["radius"];
+        const char *status = doc["circles"][i]["status"];
+        sink = sink + x + y + radius + (status ? status[0] : 0);
+      }
+    }
+    double json_ns = (nowNs() - start) / rounds;
+
+    printf("%7u %9u %9u %12.0f %12.0f %13u\n", (unsigned)n, (unsigned)len, (unsigned)json_len,
+           binary_ns, json_ns, (unsigned)capacity);
+  }
+}
+
+/* prints a body saved from the backend */
+static int printBody(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+  size_t len = fread(body, 1, sizeof(body), f);
+  fclose(f);
+
+  circle_result_t result;
+  if (!circleResultParse(body, len, &result)) {
+    fprintf(stderr, "%s: not a binary detection result (%u bytes)\n", path, (unsigned)len);
+    return 1;
+  }
+  printf("%u circles\n", result.count);
+  for (size_t i = 0; i < result.count; i++) {
+    circle_t c;
+    circleResultGet(&result, i, &c);
+    printf("  (%u, %u) radius %u %s\n", c.x, c.y, c.radius, c.filled ? "filled" : "unfilled");
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    return printBody(argv[1]);
+  }
+
+  srand(1);
+  runChecks();
+  runBenchmark();
+  printf(failures ? "%d checks failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}
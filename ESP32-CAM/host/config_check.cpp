@@ -0,0 +1,413 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Checks for the config loader (config.cpp), host only.
+
+    ./config-check                 exit code 1 on failure
+    ./config-check 1000000         with that many mutated files instead of 200000
+
+  1. Table: defaults, a full config through save and load unchanged, values of the
+     wrong type or out of range (a CAPTURE_INTERVAL_IN_MS of 0 used to become a busy
+     loop) keep the default, strings are decoded and refused when they do not fit.
+  2. Malformed files: every prefix of a valid file, hand-written broken ones and
+     random mutations must be refused or parsed, never read past the buffer (build
+     with -fsanitize=address) and never leave a half-loaded config behind. What
+     ArduinoJson reads beyond strict JSON only has to load whole or not at all.
+  3. Size limits: nesting beyond CONFIG_JSON_DEPTH, a file one byte over
+     CONFIG_FILE_MAX, and that the largest possible config still fits the file and
+     the /settings answer of the portal.
+  4. Portal form: fields out of range are refused, fields the form does not carry
+     are kept.
+
+  The filesystem is hal_host.cpp on a temporary directory.
+*/
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+#define CHECK_SETTINGS_MAX 1280   /* PORTAL_SETTINGS_MAX in portal_handler.cpp */
+
+static const char FULL_CONFIG[] =
+  "{\"NETWORK\":{\"SSID\":\"hive\",\"PASSWORD\":\"s3cret\",\"UPLOAD_URL\":\"https://example.com/upload\",\"CHUNKED\":1},"
+  "\"CAMERA\":{\"RESOLUTION\":\"sxga\",\"CAPTURE_INTERVAL_IN_MS\":5000,\"VERTICAL_FLIP\":0,\"GAIN\":12,"
+  "\"QUEUE_DEPTH\":3,\"QUEUE_POLICY\":\"block\",\"MAX_FRAME_BYTES\":60000,\"BATCH_SIZE\":4},"
+  "\"STORE\":{\"RAM_KB\":512,\"SPILL\":1},\"MOTION\":{\"THRESHOLD\":12,\"KEEPALIVE_S\":60},"
+  "\"CONTROL\":{\"TOKEN\":\"t0ken\"},\"POWER\":{\"MODE\":\"deep_sleep\"}}";
+
+/* parses a copy of text, the parser writes into its buffer */
+static config_load_t parse(esp_config_t *config, const char *text, size_t len) {
+  static char buf[CONFIG_FILE_MAX * 2];
+  memcpy(buf, text, len);
+  memset(config, 0, sizeof(*config));
+  return configParse(config, buf, len);
+}
+
+static config_load_t parseText(esp_config_t *config, const char *text) {
+  return parse(config, text, strlen(text));
+}
+
+/* field by field, through the table */
+static bool sameConfig(const esp_config_t *a, const esp_config_t *b) {
+  static char json_a[CONFIG_FILE_MAX], json_b[CONFIG_FILE_MAX];
+  return configWriteJson(a, json_a, sizeof(json_a)) > 0 && configWriteJson(b, json_b, sizeof(json_b)) > 0 &&
+         strcmp(json_a, json_b) == 0;
+}
+
+static bool isDefault(const esp_config_t *config) {
+  esp_config_t defaults;
+  configDefaults(&defaults);
+  return sameConfig(config, &defaults);
+}
+
+/*
+  -----------------------------
+  ----------- TABLE -----------
+  -----------------------------
+*/
+static void checkDefaults() {
+  esp_config_t config;
+  check(parseText(&config, "{}") == CONFIG_LOAD_OK && isDefault(&config), "an empty object is all defaults");
+  check(config.CAMERA.value[CAMERA_SET_INTERVAL] == 300 && config.QUEUE_DEPTH == 1 &&
+        config.QUEUE_POLICY == FRAME_QUEUE_DROP_OLDEST && config.BATCH_SIZE == 1 && config.BATCH_TIMEOUT_MS == 5000 &&
+        config.STORE_RAM_KB == 1024 && config.MOTION_KEEPALIVE_S == 300 && config.POWER_MODE == POWER_AUTO &&
+        config.CAMERA.value[CAMERA_SET_FRAMESIZE] == FRAMESIZE_VGA, "the defaults loadConfig() always had");
+  check(!configComplete(&config), "SSID and UPLOAD_URL are required");
+
+  check(parseText(&config, "{\"NETWORK\":{\"SSID\":\"hive\",\"UPLOAD_URL\":\"http://h/u\"}}") == CONFIG_LOAD_OK &&
+        configComplete(&config), "no PASSWORD is an open network");
+
+  for (size_t i = 0; i < configFieldCount(); i++) {
+    const config_field_t *field = configField(i);
+    check(!field->form || configFormField(field->form) == field, "form names lead back to their field");
+  }
+  check(configFormField("nope") == NULL && configField(configFieldCount()) == NULL, "lookups past the table");
+}
+
+static void checkRoundTrip() {
+  esp_config_t config, again;
+  check(parseText(&config, FULL_CONFIG) == CONFIG_LOAD_OK && configComplete(&config), "full config parsed");
+  check(strcmp(config.wifi_config.PASSWORD, "s3cret") == 0 && config.CHUNKED_UPLOAD == 1 &&
+        config.CAMERA.value[CAMERA_SET_FRAMESIZE] == FRAMESIZE_SXGA && config.CAMERA.value[CAMERA_SET_GAIN] == 12 &&
+        config.CAMERA.value[CAMERA_SET_VFLIP] == 0 && config.QUEUE_DEPTH == 3 && config.QUEUE_POLICY == FRAME_QUEUE_BLOCK &&
+        config.STORE_SPILL == 1 && config.MOTION_THRESHOLD == 12 && strcmp(config.CONTROL_TOKEN, "t0ken") == 0 &&
+        config.POWER_MODE == POWER_DEEP_SLEEP, "every section read");
+
+  static char out[CONFIG_FILE_MAX];
+  size_t len = configWriteJson(&config, out, sizeof(out));
+  check(len > 0 && parse(&again, out, len) == CONFIG_LOAD_OK && sameConfig(&config, &again), "written and read back unchanged");
+  check(strstr(out, "\"CAMERA\":{\"RESOLUTION\":\"sxga\"") && strstr(out, "\"QUEUE_POLICY\":\"block\"") &&
+        strstr(out, "\"POWER\":{\"MODE\":\"deep_sleep\"}"), "choices and the frame size by name");
+
+  check(parseText(&config, "{\"EXTRA\":{\"A\":[1,{\"B\":null}]},\"NETWORK\":{\"SSID\":\"x\",\"NEW\":true},\"V\":2}") ==
+        CONFIG_LOAD_OK && strcmp(config.wifi_config.SSID, "x") == 0, "unknown sections and keys skipped");
+  len = configWriteJson(&config, out, sizeof(out));
+  check(len > 0 && !strstr(out, "EXTRA") && !strstr(out, "NEW"), "unknown keys are not written back");
+
+  check(parseText(&config, "\xEF\xBB\xBF {\"NETWORK\" : {\"SSID\" : \"bom\"} }\r\n") == CONFIG_LOAD_OK &&
+        strcmp(config.wifi_config.SSID, "bom") == 0, "byte order mark and white space");
+  check(parseText(&config, "{\"NETWORK\":{\"SSID\":\"a\"},\"NETWORK\":{\"SSID\":\"b\"}}") == CONFIG_LOAD_OK &&
+        strcmp(config.wifi_config.SSID, "b") == 0, "the last of a key twice wins");
+}
+
+static void checkValues() {
+  esp_config_t config;
+
+  /* wrong values keep the default, the rest of the file still counts */
+  check(parseText(&config, "{\"CAMERA\":{\"CAPTURE_INTERVAL_IN_MS\":0,\"QUEUE_DEPTH\":9,\"BATCH_SIZE\":-1,"
+                           "\"MAX_FRAME_BYTES\":1.5,\"GAIN\":31,\"RESOLUTION\":\"huge\",\"QUEUE_POLICY\":\"lifo\"},"
+                           "\"STORE\":{\"RAM_KB\":\"512\",\"SPILL\":1}}") == CONFIG_LOAD_OK, "bad values are no parse error");
+  check(config.CAMERA.value[CAMERA_SET_INTERVAL] == 300, "an interval of 0 is refused, not a busy loop");
+  check(config.QUEUE_DEPTH == 1 && config.BATCH_SIZE == 1 && config.MAX_FRAME_BYTES == 0 &&
+        config.CAMERA.value[CAMERA_SET_GAIN] == 0 && config.CAMERA.value[CAMERA_SET_FRAMESIZE] == FRAMESIZE_VGA &&
+        config.QUEUE_POLICY == FRAME_QUEUE_DROP_OLDEST, "out of range, fractions and unknown names keep the default");
+  check(config.STORE_RAM_KB == 1024 && config.STORE_SPILL == 1, "a number as string keeps the default");
+
+  check(parseText(&config, "{\"NETWORK\":{\"SSID\":5,\"CHUNKED\":true},\"CAMERA\":{\"VERTICAL_FLIP\":false,"
+                           "\"RESOLUTION\":5,\"QUEUE_DEPTH\":null,\"BATCH_SIZE\":{\"n\":2}}}") == CONFIG_LOAD_OK &&
+        config.wifi_config.SSID[0] == '\0' && config.CHUNKED_UPLOAD == 1 && config.CAMERA.value[CAMERA_SET_VFLIP] == 0 &&
+        config.CAMERA.value[CAMERA_SET_FRAMESIZE] == FRAMESIZE_VGA && config.QUEUE_DEPTH == 1 && config.BATCH_SIZE == 1,
+        "booleans count as numbers, other type mismatches keep the default");
+
+  check(parseText(&config, "{\"CAMERA\":{\"CAPTURE_INTERVAL_IN_MS\":99999999999999999999,\"BATCH_TIMEOUT_MS\":-0}}") ==
+        CONFIG_LOAD_OK && config.CAMERA.value[CAMERA_SET_INTERVAL] == 300 && config.BATCH_TIMEOUT_MS == 0,
+        "numbers beyond long are out of range");
+
+  /* SSID is char[64]: 63 characters fit, 64 are refused instead of cut */
+  char text[256];
+  char ssid[80];
+  memset(ssid, 'a', sizeof(ssid));
+  ssid[63] = '\0';
+  snprintf(text, sizeof(text), "{\"NETWORK\":{\"SSID\":\"%s\"}}", ssid);
+  check(parseText(&config, text) == CONFIG_LOAD_OK && strlen(config.wifi_config.SSID) == 63, "63 characters fit");
+  ssid[63] = 'a';
+  ssid[64] = '\0';
+  snprintf(text, sizeof(text), "{\"NETWORK\":{\"SSID\":\"%s\"}}", ssid);
+  check(parseText(&config, text) == CONFIG_LOAD_OK && config.wifi_config.SSID[0] == '\0', "64 characters are refused");
+
+  check(parseText(&config, "{\"NETWORK\":{\"SSID\":\"a\\\"b\\\\c\\/d\\n\\u00e9\\u20ac\\ud83d\\udc1d\"}}") == CONFIG_LOAD_OK &&
+        strcmp(config.wifi_config.SSID, "a\"b\\c/d\n\xC3\xA9\xE2\x82\xAC\xF0\x9F\x90\x9D") == 0, "escapes decoded in place");
+  check(parseText(&config, "{\"NET\\u0057ORK\":{\"SS\\u0049D\":\"k\"}}") == CONFIG_LOAD_OK &&
+        strcmp(config.wifi_config.SSID, "k") == 0, "escaped keys");
+
+  /* what is saved with characters that need escapes is what is loaded */
+  esp_config_t again;
+  snprintf(config.wifi_config.PASSWORD, sizeof(config.wifi_config.PASSWORD), "q\"\\\x01\t");
+  static char out[CONFIG_FILE_MAX];
+  size_t len = configWriteJson(&config, out, sizeof(out));
+  check(len > 0 && parse(&again, out, len) == CONFIG_LOAD_OK && sameConfig(&config, &again), "escaped on save");
+}
+
+/*
+  -----------------------------
+  --------- MALFORMED ---------
+  -----------------------------
+*/
+static void checkBroken(const char *text, config_load_t expected) {
+  esp_config_t config;
+  char what[160];
+  config_load_t result = parseText(&config, text);
+  snprintf(what, sizeof(what), "'%.60s' refused as %s, got %s", text, configLoadError(expected), configLoadError(result));
+  check(result == expected && isDefault(&config), what);
+}
+
+static void checkMalformed() {
+  static const char *const BROKEN[] = {
+    "", " ", "[]", "null", "\"NETWORK\"", "{", "}", "{\"NETWORK\"}", "{\"NETWORK\":}", "{\"NETWORK\":{}",
+    "{\"NETWORK\":{},}", "{,\"NETWORK\":{}}", "{\"NETWORK\":{\"SSID\":\"a}}",
+    "{\"NETWORK\":{\"SSID\":\"\\x\"}}", "{\"NETWORK\":{\"SSID\":\"\\u00\"}}",
+    "{\"CAMERA\":{\"GAIN\":-}}", "{\"CAMERA\":{\"GAIN\":tru}}", "{\"CAMERA\":{\"GAIN\":nul}}",
+    "{\"CAMERA\":{\"GAIN\":1 2}}", "{\"CAMERA\":[1,]}", "{\"CAMERA\":[1 2]}", "/* c */{}",
+  };
+  for (size_t i = 0; i < sizeof(BROKEN) / sizeof(BROKEN[0]); i++) {
+    checkBroken(BROKEN[i], CONFIG_LOAD_SYNTAX);
+  }
+
+  /* ArduinoJson reads these (it stops after the object, takes bare and single-quoted keys, loose numbers): whole or not at all */
+  static const char *const LAX[] = {
+    "{\"NETWORK\":{}}}", "{\"NETWORK\":{}} x", "{NETWORK:{}}", "{'NETWORK':{}}", "{}//",
+    "{\"NETWORK\":{\"SSID\":\"a\nb\"}}", "{\"NETWORK\":{\"SSID\":\"\\u0000\"}}", "{\"NETWORK\":{\"SSID\":\"\\ud83d\"}}",
+    "{\"NETWORK\":{\"SSID\":\"\\udc1d\"}}", "{\"NETWORK\":{\"SSID\":\"\\ud83d\\u0041\"}}",
+    "{\"CAMERA\":{\"GAIN\":01}}", "{\"CAMERA\":{\"GAIN\":1.}}", "{\"CAMERA\":{\"GAIN\":+1}}",
+    "{\"CAMERA\":{\"GAIN\":1e}}", "{\"CAMERA\":{\"GAIN\":.5}}",
+  };
+  for (size_t i = 0; i < sizeof(LAX) / sizeof(LAX[0]); i++) {
+    esp_config_t config;
+    char what[160];
+    config_load_t result = parseText(&config, LAX[i]);
+    snprintf(what, sizeof(what), "'%.60s' read or refused whole, got %s", LAX[i], configLoadError(result));
+    check(result == CONFIG_LOAD_OK || (result == CONFIG_LOAD_SYNTAX && isDefault(&config)), what);
+  }
+
+  /* every prefix of a valid file is broken */
+  esp_config_t config;
+  size_t full = strlen(FULL_CONFIG);
+  bool all_refused = true;
+  for (size_t len = 0; len < full; len++) {
+    all_refused = all_refused && parse(&config, FULL_CONFIG, len) != CONFIG_LOAD_OK && isDefault(&config);
+  }
+  check(all_refused, "every cut-off file refused, defaults left");
+}
+
+static uint32_t rng = 0x12345678;
+
+static uint32_t nextRandom() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+/* bytes replaced, inserted, removed; the result is parsed and either refused cleanly or written back and read unchanged */
+static void checkMutations(long rounds) {
+  static const char NASTY[] = "{}[]\",:\\u0123456789-+.eEtrufalsn \x01\xff";
+  static char text[CONFIG_FILE_MAX];
+  static char out[CONFIG_FILE_MAX];
+  long parsed = 0, refused = 0;
+  bool consistent = true;
+
+  for (long round = 0; round < rounds; round++) {
+    size_t len = strlen(FULL_CONFIG);
+    memcpy(text, FULL_CONFIG, len);
+
+    int edits = 1 + nextRandom() % 4;
+    for (int e = 0; e < edits; e++) {
+      size_t at = nextRandom() % (len + 1);
+      char c = (nextRandom() & 1) ? NASTY[nextRandom() % (sizeof(NASTY) - 1)] : (char)nextRandom();
+      switch (nextRandom() % 3) {
+        case 0:
+          if (at < len) text[at] = c;
+          break;
+        case 1:
+          if (len + 1 < sizeof(text)) {
+            memmove(text + at + 1, text + at, len - at);
+            text[at] = c;
+            len++;
+          }
+          break;
+        default:
+          if (at < len) {
+            memmove(text + at, text + at + 1, len - at - 1);
+            len--;
+          }
+          break;
+      }
+    }
+
+    esp_config_t config, again;
+    if (parse(&config, text, len) != CONFIG_LOAD_OK) {
+      consistent = consistent && isDefault(&config);
+      refused++;
+      continue;
+    }
+    parsed++;
+    size_t out_len = configWriteJson(&config, out, sizeof(out));
+    consistent = consistent && out_len > 0 && parse(&again, out, out_len) == CONFIG_LOAD_OK && sameConfig(&config, &again);
+  }
+
+  printf("%ld mutated files: %ld parsed, %ld refused\n", rounds, parsed, refused);
+  check(consistent, "mutated files refused with defaults, or parsed into a config that saves and loads unchanged");
+}
+
+/*
+  -----------------------------
+  ------- SIZE LIMITS ---------
+  -----------------------------
+*/
+/* a section with an unknown key holding arrays nested that deep; the whole file is then 2 + arrays deep */
+static config_load_t parseNested(int arrays) {
+  static char text[CONFIG_FILE_MAX * 2];
+  int len = snprintf(text, sizeof(text), "{\"CAMERA\":{\"X\":");
+  for (int i = 0; i < arrays; i++) text[len++] = '[';
+  for (int i = 0; i < arrays; i++) text[len++] = ']';
+  len += snprintf(text + len, sizeof(text) - len, "}}");
+  esp_config_t config;
+  return parse(&config, text, (size_t)len);
+}
+
+static void checkLimits() {
+  check(parseNested(CONFIG_JSON_DEPTH - 2) == CONFIG_LOAD_OK, "nested up to CONFIG_JSON_DEPTH");
+  check(parseNested(CONFIG_JSON_DEPTH - 1) == CONFIG_LOAD_TOO_DEEP, "one level deeper refused");
+  check(parseNested(CONFIG_FILE_MAX / 2 - 20) == CONFIG_LOAD_TOO_DEEP, "a file of brackets does not recurse");
+
+  /* the largest config: every string full, every number at its longest */
+  esp_config_t config;
+  memset(&config, 0, sizeof(config));
+  configDefaults(&config);
+  for (size_t i = 0; i < configFieldCount(); i++) {
+    const config_field_t *field = configField(i);
+    if (field->type == CONFIG_TEXT) {
+      char *text = (char *)&config + field->offset;
+      memset(text, 'x', field->size - 1);
+      text[field->size - 1] = '\0';
+    } else if (field->type == CONFIG_INT) {
+      *(int *)((char *)&config + field->offset) = field->min < 0 ? field->min : field->max;
+    } else if (field->type == CONFIG_CAMERA) {
+      const camera_setting_desc_t *desc = cameraSettingDesc((camera_setting_t)field->offset);
+      if (field->offset != CAMERA_SET_FRAMESIZE) config.CAMERA.value[field->offset] = desc->min < 0 ? desc->min : desc->max;
+    }
+  }
+
+  static char out[CONFIG_FILE_MAX];
+  size_t len = configWriteJson(&config, out, sizeof(out));
+  printf("largest config: %u of %u bytes\n", (unsigned)len, (unsigned)CONFIG_FILE_MAX);
+  check(len > 0, "the largest config fits into CONFIG_FILE_MAX");
+
+  char settings[CHECK_SETTINGS_MAX];
+  portal_json_t json;
+  portalJsonBegin(&json, settings, sizeof(settings));
+  portalJsonString(&json, "session", "ffffffff");
+  configFormJson(&json, &config);
+  len = portalJsonEnd(&json);
+  printf("largest /settings answer: %u of %u bytes\n", (unsigned)len, (unsigned)sizeof(settings));
+  check(len > 0, "the largest /settings answer fits");
+
+  /* files through hal_host.cpp: missing, exactly the buffer, one byte more */
+  static char buf[CONFIG_FILE_MAX];
+  check(configLoadFile("/missing.json", &config, buf, sizeof(buf)) == CONFIG_LOAD_MISSING && isDefault(&config),
+        "a missing file is all defaults");
+
+  static uint8_t file[CONFIG_FILE_MAX + 1];
+  memset(file, ' ', sizeof(file));
+  memcpy(file, FULL_CONFIG, strlen(FULL_CONFIG));
+  check(halFsWriteFile("/config.json", file, CONFIG_FILE_MAX) &&
+        configLoadFile("/config.json", &config, buf, sizeof(buf)) == CONFIG_LOAD_OK && configComplete(&config),
+        "a file of exactly CONFIG_FILE_MAX bytes");
+  check(halFsWriteFile("/config.json", file, CONFIG_FILE_MAX + 1) &&
+        configLoadFile("/config.json", &config, buf, sizeof(buf)) == CONFIG_LOAD_TOO_LARGE && isDefault(&config),
+        "one byte more is refused, not cut");
+
+  snprintf(config.CONFIG_FILE, sizeof(config.CONFIG_FILE), "/config.json");
+  check(!loadConfig(&config) && strcmp(config.CONFIG_FILE, "/config.json") == 0, "loadConfig() refuses it too");
+  check(halFsWriteFile("/config.json", (const uint8_t *)FULL_CONFIG, strlen(FULL_CONFIG)) && loadConfig(&config) &&
+        config.BATCH_SIZE == 4, "loadConfig() of the full config");
+  check(halFsWriteFile("/config.json", (const uint8_t *)"{\"NETWORK\":{\"SSID\":\"hive\"}}", 27) && !loadConfig(&config),
+        "loadConfig() without UPLOAD_URL");
+}
+
+/*
+  -----------------------------
+  ----------- FORM ------------
+  -----------------------------
+*/
+static void checkForm() {
+  esp_config_t config;
+  parseText(&config, FULL_CONFIG);
+
+  int refused = configApplyForm(&config, "session=1&ssid=new+hive&interval=0&qdepth=2&qpolicy=drop_oldest&"
+                                         "res=svga&bright=9&pmode=always_on&sram=&upload_base=http%3A%2F%2Fh");
+  check(refused == 3, "interval 0, brightness 9 and an empty number refused");
+  check(strcmp(config.wifi_config.SSID, "new hive") == 0 && config.QUEUE_DEPTH == 2 &&
+        config.QUEUE_POLICY == FRAME_QUEUE_DROP_OLDEST && config.CAMERA.value[CAMERA_SET_FRAMESIZE] == FRAMESIZE_SVGA &&
+        config.POWER_MODE == POWER_ALWAYS_ON, "form values applied");
+  check(config.CAMERA.value[CAMERA_SET_INTERVAL] == 5000 && config.STORE_RAM_KB == 512 &&
+        config.CAMERA.value[CAMERA_SET_GAIN] == 12 && strcmp(config.CONTROL_TOKEN, "t0ken") == 0 &&
+        strcmp(config.UPLOAD_URL, "https://example.com/upload") == 0, "refused and missing fields kept");
+
+  char settings[CHECK_SETTINGS_MAX];
+  portal_json_t json;
+  portalJsonBegin(&json, settings, sizeof(settings));
+  configFormJson(&json, &config);
+  check(portalJsonEnd(&json) > 0 && strstr(settings, "\"ssid\":\"new hive\"") && strstr(settings, "\"res\":\"svga\"") &&
+        strstr(settings, "\"min\":{\"chunked\":0,\"interval\":10,") && strstr(settings, "\"qdepth\":4") &&
+        !strstr(settings, "t0ken"), "/settings: values by form name, ranges from the table, no token");
+}
+
+int main(int argc, char **argv) {
+  long rounds = argc > 1 ? atol(argv[1]) : 200000;
+
+  char root[] = "/tmp/config-check-XXXXXX";
+  if (!mkdtemp(root)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  setenv("HIVEHIVE_FS_ROOT", root, 1);
+
+  checkDefaults();
+  checkRoundTrip();
+  checkValues();
+  checkMalformed();
+  checkMutations(rounds);
+  checkLimits();
+  checkForm();
+
+  char cleanup[128];
+  snprintf(cleanup, sizeof(cleanup), "rm -rf %s", root);
+  if (system(cleanup) != 0) {
+    printf("could not remove %s\n", root);
+  }
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,315 @@
+#include "duty_cycle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Checks and simulation of the deep-sleep duty cycle (duty_cycle.cpp), host only.
+
+    ./duty-cycle-sim            everything, exit code 1 if a check fails
+
+  1. RTC state: a sealed state survives the copy into and out of a byte buffer (the
+     RTC memory stand-in) unchanged, every single bit flip, a random power-on content,
+     another config or another layout version is rejected.
+  2. Timing model: average current of both modes and the choice of POWER_AUTO for a
+     range of intervals, the break-even interval, and that a wake cost jittering
+     around the break-even does not make the mode flap.
+  3. Wake cycles: a virtual device boots, captures, connects, uploads and sleeps on a
+     virtual clock, with the state carried over in the RTC stand-in. The captures must
+     stay on the interval, Retry-After and backoffs must carry over the sleep, and a
+     warm wake (cached access point, resumed TLS session) must be cheaper than a cold one.
+*/
+#define SIM_LEAD_MS 900            /* setup() to capture: camera init and settle frames */
+#define SIM_LEAD_JITTER_MS 100
+#define SIM_FAST_CONNECT_MS 400    /* cached BSSID and channel */
+#define SIM_SCAN_CONNECT_MS 2500
+#define SIM_FULL_HANDSHAKE_MS 1200
+#define SIM_RESUMED_HANDSHAKE_MS 150
+#define SIM_UPLOAD_MS 450
+#define SIM_SHUTDOWN_MS 20         /* Wi-Fi off, camera powered down */
+#define SIM_SESSION_BYTES 1500
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static uint32_t rng = 12345;
+
+static uint32_t nextRandom() {
+  rng = rng * 1103515245u + 12345u;
+  return rng >> 8;
+}
+
+static uint32_t jitter(uint32_t base, uint32_t spread) {
+  return base - spread + nextRandom() % (2 * spread + 1);
+}
+
+/* -------------------------------- */
+/* ----------- RTC STATE ---------- */
+/* -------------------------------- */
+static uint8_t rtc_memory[sizeof(duty_state_t)];
+
+static void checkState() {
+  const uint32_t config = dutyConfigCrc("hive-net", "https://example.com/upload");
+
+  duty_state_t state;
+  dutyStateInit(&state, config, 10000);
+  state.sequence = 4711;
+  state.clock_ms = 123456;
+  state.channel = 11;
+  memcpy(state.bssid, "\x01\x02\x03\x04\x05\x06", 6);
+  state.session_len = SIM_SESSION_BYTES;
+  for (uint32_t i = 0; i < state.session_len; i++) state.session[i] = (uint8_t)nextRandom();
+  schedulerOnResult(&state.scheduler, 503, 0, 30, 100000);
+  dutyStateSeal(&state);
+  check(dutyStateValid(&state, config), "sealed state is valid");
+
+  /* deep sleep: only the bytes in RTC memory are left */
+  memcpy(rtc_memory, &state, sizeof(state));
+  duty_state_t woken;
+  memcpy(&woken, rtc_memory, sizeof(woken));
+  check(dutyStateValid(&woken, config), "state valid after the sleep");
+  check(woken.sequence == 4711 && woken.clock_ms == 123456 && woken.channel == 11 &&
+        memcmp(woken.bssid, state.bssid, 6) == 0, "frame number, clock and access point kept");
+  check(woken.session_len == state.session_len && memcmp(woken.session, state.session, state.session_len) == 0,
+        "TLS session kept");
+  check(woken.scheduler.interval_ms == state.scheduler.interval_ms && woken.scheduler.holding &&
+        woken.scheduler.hold_until == state.scheduler.hold_until, "scheduler backoff and Retry-After kept");
+
+  check(!dutyStateValid(&woken, dutyConfigCrc("other-net", "https://example.com/upload")), "other network rejected");
+  check(!dutyStateValid(&woken, dutyConfigCrc("hive-net", "https://example.org/upload")), "other server rejected");
+
+  size_t flips = 0, missed = 0;
+  for (size_t byte = 0; byte < sizeof(state); byte++) {
+    for (int bit = 0; bit < 8; bit++) {
+      memcpy(&woken, rtc_memory, sizeof(woken));
+      ((uint8_t *)&woken)[byte] ^= (uint8_t)(1u << bit);
+      flips++;
+      if (dutyStateValid(&woken, config)) missed++;
+    }
+  }
+  check(missed == 0, "every single bit flip rejected");
+
+  size_t garbage_accepted = 0;
+  for (int i = 0; i < 10000; i++) {
+    for (size_t j = 0; j < sizeof(woken); j++) ((uint8_t *)&woken)[j] = (uint8_t)nextRandom();
+    if (dutyStateValid(&woken, config)) garbage_accepted++;
+  }
+  check(garbage_accepted == 0, "power-on RTC content rejected");
+
+  memcpy(&woken, rtc_memory, sizeof(woken));
+  woken.version = DUTY_STATE_VERSION + 1;
+  woken.crc = 0;
+  dutyStateSeal(&woken);   /* seals with this firmware's version again */
+  woken.version = DUTY_STATE_VERSION + 1;
+  check(!dutyStateValid(&woken, config), "other layout version rejected");
+
+  printf("RTC state: %u bytes, %u bit flips and 10000 random contents rejected\n",
+         (unsigned)sizeof(state), (unsigned)flips);
+}
+
+/* -------------------------------- */
+/* ---------- POWER MODEL --------- */
+/* -------------------------------- */
+static const duty_power_t POWER = DUTY_POWER_DEFAULT;
+#define SIM_BATTERY_MAH 3000
+
+static void checkModel() {
+  const uint32_t wake_ms = DUTY_WAKE_MS;
+  uint32_t break_even = dutyBreakEvenMs(&POWER, wake_ms, DUTY_BUSY_MS);
+
+  printf("\n%-10s %12s %12s %-11s %9s\n", "interval", "always on", "deep sleep", "auto", "battery");
+  static const uint32_t INTERVALS[] = { 300, 1000, 3000, 4000, 5000, 10000, 30000, 60000, 300000, 900000, 3600000 };
+  for (size_t i = 0; i < sizeof(INTERVALS) / sizeof(INTERVALS[0]); i++) {
+    uint32_t interval = INTERVALS[i];
+    uint32_t on = dutyAverageUa(&POWER, POWER_ALWAYS_ON, interval, wake_ms, DUTY_BUSY_MS);
+    uint32_t asleep = dutyAverageUa(&POWER, POWER_DEEP_SLEEP, interval, wake_ms, DUTY_BUSY_MS);
+    power_mode_t mode = dutyChooseMode(POWER_AUTO, false, &POWER, interval, wake_ms, DUTY_BUSY_MS);
+    uint32_t chosen = mode == POWER_DEEP_SLEEP ? asleep : on;
+    bool can_sleep = interval >= wake_ms + DUTY_MIN_SLEEP_MS;
+
+    printf("%8.1f s %9.1f mA ", interval / 1000.0, on / 1000.0);
+    if (can_sleep) {
+      printf("%9.1f mA ", asleep / 1000.0);
+    } else {
+      printf("%12s ", "-");
+    }
+    printf("%-11s %7.1f d\n", powerModeName(mode), SIM_BATTERY_MAH * 1000.0 / chosen / 24);
+
+    /* never the more expensive mode by more than the hysteresis */
+    uint32_t other = mode == POWER_DEEP_SLEEP ? on : asleep;
+    check(!can_sleep || (uint64_t)chosen * (100 - DUTY_HYSTERESIS_PCT) <= (uint64_t)other * 100,
+          "auto picks the cheaper mode");
+    check(can_sleep || mode == POWER_ALWAYS_ON, "no deep sleep below the wake cost");
+  }
+  printf("break-even at %.1f s (wake %u ms, busy %u ms)\n", break_even / 1000.0, (unsigned)wake_ms, DUTY_BUSY_MS);
+
+  check(dutyChooseMode(POWER_AUTO, false, &POWER, break_even * 13 / 10, wake_ms, DUTY_BUSY_MS) == POWER_DEEP_SLEEP,
+        "deep sleep well above the break-even");
+  check(dutyChooseMode(POWER_AUTO, false, &POWER, break_even * 8 / 10, wake_ms, DUTY_BUSY_MS) == POWER_ALWAYS_ON,
+        "always on below the break-even");
+  check(dutyChooseMode(POWER_ALWAYS_ON, true, &POWER, 3600000, wake_ms, DUTY_BUSY_MS) == POWER_ALWAYS_ON &&
+        dutyChooseMode(POWER_DEEP_SLEEP, false, &POWER, 300, wake_ms, DUTY_BUSY_MS) == POWER_DEEP_SLEEP,
+        "a configured mode is kept");
+
+  /*
+    Wakes jitter by +-10 % around the wake cost that makes the interval break even;
+    the decision sees their average, as on the device.
+  */
+  duty_state_t state;
+  dutyStateInit(&state, 0, 1000);
+  bool sleeping = true;
+  int switches = 0;
+  uint32_t interval = break_even;
+  for (int i = 0; i < 1000; i++) {
+    uint32_t awake = jitter(wake_ms, wake_ms / 10) - DUTY_BOOT_MS;
+    dutyEndWake(&state, awake / 2, awake, interval);
+    power_mode_t mode = dutyChooseMode(POWER_AUTO, sleeping, &POWER, interval, dutyWakeCost(&state), DUTY_BUSY_MS);
+    if ((mode == POWER_DEEP_SLEEP) != sleeping) switches++;
+    sleeping = mode == POWER_DEEP_SLEEP;
+  }
+  printf("mode switches at the break-even with +-10 %% wake jitter: %d of 1000 wakes\n", switches);
+  check(switches <= 2, "the mode does not flap at the break-even");
+}
+
+/* -------------------------------- */
+/* ---------- WAKE CYCLES --------- */
+/* -------------------------------- */
+typedef struct {
+  const char *name;
+  uint32_t interval_ms;
+  uint32_t wakes;
+  bool keep_cache;          /* false: AP and TLS session are not kept (a wake as without RTC state) */
+  uint32_t retry_after_at;  /* wake that gets 503 + Retry-After, 0 = none */
+  uint32_t retry_after_s;
+  uint32_t down_from;       /* wakes [down_from, down_to) get 503 */
+  uint32_t down_to;
+} cycle_t;
+
+static const cycle_t CYCLES[] = {
+  { "10 s, warm wakes",   10000,  360, true,  0,  0,   0,  0 },
+  { "10 s, cold wakes",   10000,  360, false, 0,  0,   0,  0 },
+  { "60 s, warm wakes",   60000,  120, true,  0,  0,   0,  0 },
+  { "10 s, Retry-After",  10000,  120, true,  20, 120, 0,  0 },
+  { "10 s, server down",  10000,  200, true,  0,  0,   50, 60 },
+};
+#define CYCLE_COUNT (sizeof(CYCLES) / sizeof(CYCLES[0]))
+
+/* returns the average time awake per wake */
+static uint32_t runCycle(const cycle_t *cycle) {
+  const uint32_t config = dutyConfigCrc("hive-net", "https://example.com/upload");
+  duty_state_t state;
+  dutyStateInit(&state, config, cycle->interval_ms);
+  dutyStateSeal(&state);
+  memcpy(rtc_memory, &state, sizeof(state));
+
+  uint64_t now_true = 0;          /* real time in ms, the device never sees it */
+  uint64_t last_capture = 0;
+  uint64_t awake_total = 0;
+  uint32_t worst_error = 0;
+  uint32_t max_gap = 0;
+  uint64_t retry_after_until = 0;
+  bool retry_after_kept = true;
+  uint32_t expected_sequence = 0;
+  bool sequence_ok = true;
+
+  for (uint32_t wake = 0; wake < cycle->wakes; wake++) {
+    memcpy(&state, rtc_memory, sizeof(state));
+    if (!dutyStateValid(&state, config)) {
+      check(false, "state lost over the sleep");
+      dutyStateInit(&state, config, cycle->interval_ms);
+    }
+    uint64_t wake_true = now_true + DUTY_BOOT_MS;   /* millis() == 0 */
+
+    uint32_t capture_ms = jitter(SIM_LEAD_MS, SIM_LEAD_JITTER_MS);
+    uint32_t online_ms = state.channel ? SIM_FAST_CONNECT_MS : SIM_SCAN_CONNECT_MS;
+    uint32_t start_ms = capture_ms > online_ms ? capture_ms : online_ms;
+    uint32_t handshake_ms = state.session_len ? SIM_RESUMED_HANDSHAKE_MS : SIM_FULL_HANDSHAKE_MS;
+    uint32_t done_ms = start_ms + handshake_ms + SIM_UPLOAD_MS;
+
+    uint64_t capture_true = wake_true + capture_ms;
+    if (wake > 0) {
+      uint32_t gap = (uint32_t)(capture_true - last_capture);
+      if (gap > max_gap) max_gap = gap;
+      /* after the first few wakes the averages have settled */
+      uint32_t error = gap > state.scheduler.interval_ms ? gap - state.scheduler.interval_ms
+                                                         : state.scheduler.interval_ms - gap;
+      if (wake > 5 && !state.scheduler.holding && error > worst_error) worst_error = error;
+    }
+    /* the request goes out after the handshake */
+    if (retry_after_until && wake_true + start_ms + handshake_ms < retry_after_until) retry_after_kept = false;
+    last_capture = capture_true;
+
+    if (state.sequence != expected_sequence) sequence_ok = false;
+    expected_sequence = state.sequence + 1;
+    state.sequence++;
+
+    int code = 200;
+    uint32_t retry_after_s = 0;
+    if (wake >= cycle->down_from && wake < cycle->down_to) code = 503;
+    if (cycle->retry_after_at && wake == cycle->retry_after_at) {
+      code = 503;
+      retry_after_s = cycle->retry_after_s;
+      /* the scheduler holds at most its longest interval */
+      uint64_t hold_ms = retry_after_s * 1000ULL;
+      retry_after_until = wake_true + done_ms + (hold_ms < state.scheduler.max_ms ? hold_ms : state.scheduler.max_ms);
+    }
+    schedulerOnResult(&state.scheduler, code, SIM_UPLOAD_MS / 2, retry_after_s, dutyNow(&state, done_ms));
+
+    if (cycle->keep_cache) {
+      state.channel = 6;
+      state.session_len = SIM_SESSION_BYTES;
+    }
+
+    uint32_t awake_ms = done_ms + SIM_SHUTDOWN_MS;
+    uint32_t delay_ms = schedulerNextDelay(&state.scheduler, dutyNow(&state, capture_ms), dutyNow(&state, awake_ms));
+    uint32_t sleep_ms = dutyEndWake(&state, capture_ms, awake_ms, delay_ms);
+    dutyStateSeal(&state);
+    memcpy(rtc_memory, &state, sizeof(state));
+
+    awake_total += awake_ms + DUTY_BOOT_MS;
+    now_true = wake_true + awake_ms + sleep_ms;
+  }
+
+  uint32_t wake_cost = (uint32_t)(awake_total / cycle->wakes);
+  uint32_t current = dutyAverageUa(&POWER, POWER_DEEP_SLEEP, cycle->interval_ms, wake_cost, DUTY_BUSY_MS);
+  printf("%-20s %8u %10u %10u %10.1f %9.1f mA\n", cycle->name, (unsigned)cycle->wakes, (unsigned)wake_cost,
+         (unsigned)worst_error, max_gap / 1000.0, current / 1000.0);
+
+  check(sequence_ok, "frame numbers continue over the sleep");
+  check(retry_after_kept, "no capture before Retry-After expired");
+  check(worst_error <= 2 * SIM_LEAD_JITTER_MS + 50, "captures stay on the interval");
+  if (cycle->down_to > cycle->down_from) {
+    check(max_gap > 2 * cycle->interval_ms, "a server that is down is backed off over the sleep");
+    check(state.scheduler.interval_ms == cycle->interval_ms, "back at the interval after the server recovered");
+  }
+  return wake_cost;
+}
+
+static void checkCycles() {
+  printf("\n%-20s %8s %10s %10s %10s %12s\n", "cycle", "wakes", "awake ms", "error ms", "max gap s", "average");
+  uint32_t costs[CYCLE_COUNT];
+  for (size_t i = 0; i < CYCLE_COUNT; i++) {
+    costs[i] = runCycle(&CYCLES[i]);
+  }
+  /* the first two differ only in the access point and TLS session kept in RTC memory */
+  check(costs[0] < costs[1], "RTC state makes a wake cheaper");
+}
+
+int main() {
+  checkState();
+  checkModel();
+  checkCycles();
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,334 @@
+#include "frame_queue.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Capture/upload pipeline with a fake camera and a fake socket, host only.
+
+    ./frame-queue-bench [frames] [capture_ms] [upload_ms]
+
+  A capture thread and an upload thread share the frame queue (frame_queue.cpp)
+  under one mutex, with the waits of pipeline.cpp: a full queue with the block
+  policy waits for the uploader to take a frame, an empty one for the next frame.
+
+  The fake camera has a fixed number of frame buffers like the esp32-camera driver.
+  Getting a frame waits until one of them is free, then takes capture_ms (readout).
+  The fake socket takes upload_ms per frame, +-50 % at random (the Wi-Fi round trip).
+
+  "sequential" is the loop before the pipeline: capture, upload, repeat. The pipeline
+  rows run every depth and policy with the fb_count of initEspCamera(), the last
+  row without its spare buffer. Per row: uploaded and captured frames/s, dropped
+  frames, mean queue occupancy over time, high-water mark and the longest wait of
+  the camera for a free buffer.
+
+  Exit code 1 if the pipeline does not beat the sequential loop, drops frames
+  with the block policy, loses a frame, or stalls the camera with drop_oldest.
+*/
+#define BENCH_FRAMES_DEFAULT 40
+#define BENCH_CAPTURE_MS_DEFAULT 6
+#define BENCH_UPLOAD_MS_DEFAULT 10
+#define BENCH_FB_MAX (FRAME_QUEUE_MAX_DEPTH + 2)
+
+static double nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void sleepMs(double ms) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)(ms / 1000);
+  ts.tv_nsec = (long)((ms - ts.tv_sec * 1000.0) * 1e6);
+  nanosleep(&ts, NULL);
+}
+
+/*
+  -----------------------------
+  --------- FAKE CAMERA -------
+  -----------------------------
+*/
+typedef struct {
+  int sequence;
+} fake_fb_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t returned;
+  fake_fb_t buffers[BENCH_FB_MAX];
+  bool out[BENCH_FB_MAX];
+  int count;
+  double capture_ms;
+  double longest_wait;
+} fake_camera_t;
+
+static void cameraInit(fake_camera_t *camera, int fb_count, double capture_ms) {
+  memset(camera, 0, sizeof(*camera));
+  pthread_mutex_init(&camera->lock, NULL);
+  pthread_cond_init(&camera->returned, NULL);
+  camera->count = fb_count;
+  camera->capture_ms = capture_ms;
+}
+
+/* esp_camera_fb_get(): waits for a free buffer, then reads the frame out into it */
+static fake_fb_t *cameraFbGet(fake_camera_t *camera, int sequence) {
+  double start = nowMs();
+  pthread_mutex_lock(&camera->lock);
+  fake_fb_t *fb = NULL;
+  while (!fb) {
+    for (int i = 0; i < camera->count && !fb; i++) {
+      if (!camera->out[i]) {
+        camera->out[i] = true;
+        fb = &camera->buffers[i];
+      }
+    }
+    if (!fb) pthread_cond_wait(&camera->returned, &camera->lock);
+  }
+  double waited = nowMs() - start;
+  if (waited > camera->longest_wait) camera->longest_wait = waited;
+  pthread_mutex_unlock(&camera->lock);
+
+  sleepMs(camera->capture_ms);
+  fb->sequence = sequence;
+  return fb;
+}
+
+static void cameraFbReturn(fake_camera_t *camera, fake_fb_t *fb) {
+  pthread_mutex_lock(&camera->lock);
+  camera->out[fb - camera->buffers] = false;
+  pthread_cond_signal(&camera->returned);
+  pthread_mutex_unlock(&camera->lock);
+}
+
+/*
+  -----------------------------
+  --------- FAKE SOCKET -------
+  -----------------------------
+*/
+static unsigned rng_state = 1;
+
+static void fakeUpload(const fake_fb_t *fb, double upload_ms) {
+  (void)fb;
+  double jitter = 0.5 + (rand_r(&rng_state) % 1000) / 1000.0;
+  sleepMs(upload_ms * jitter);
+}
+
+/*
+  -----------------------------
+  ---------- PIPELINE ---------
+  -----------------------------
+*/
+typedef struct {
+  frame_queue_t queue;
+  pthread_mutex_t lock;            /* around every frame queue call, like queue_mutex */
+  pthread_cond_t frame_ready;
+  pthread_cond_t slot_free;
+  bool capture_done;
+
+  fake_camera_t camera;
+  int frames;
+  double upload_ms;
+
+  /* queue occupancy integrated over time */
+  double occupancy_area;
+  double occupancy_since;
+
+  int captured;
+  int uploaded;
+  double first_capture;
+  double last_upload;
+} bench_pipeline_t;
+
+/* call with the lock held, before the queue count changes */
+static void trackOccupancy(bench_pipeline_t *p) {
+  double now = nowMs();
+  p->occupancy_area += frameQueueCount(&p->queue) * (now - p->occupancy_since);
+  p->occupancy_since = now;
+}
+
+static void *captureThread(void *arg) {
+  bench_pipeline_t *p = (bench_pipeline_t *)arg;
+  for (int i = 0; i < p->frames; i++) {
+    fake_fb_t *fb = cameraFbGet(&p->camera, i);
+    void *evicted = NULL;
+
+    pthread_mutex_lock(&p->lock);
+    p->captured++;
+    trackOccupancy(p);
+    while (!frameQueuePush(&p->queue, fb, &evicted)) {
+      /* FRAME_QUEUE_BLOCK: wait until the upload thread takes a frame */
+      pthread_cond_wait(&p->slot_free, &p->lock);
+      trackOccupancy(p);
+    }
+    pthread_cond_signal(&p->frame_ready);
+    pthread_mutex_unlock(&p->lock);
+
+    if (evicted) cameraFbReturn(&p->camera, (fake_fb_t *)evicted);
+  }
+
+  pthread_mutex_lock(&p->lock);
+  p->capture_done = true;
+  pthread_cond_signal(&p->frame_ready);
+  pthread_mutex_unlock(&p->lock);
+  return NULL;
+}
+
+static void *uploadThread(void *arg) {
+  bench_pipeline_t *p = (bench_pipeline_t *)arg;
+  for (;;) {
+    void *frame = NULL;
+    pthread_mutex_lock(&p->lock);
+    trackOccupancy(p);
+    while (!frameQueuePop(&p->queue, &frame)) {
+      if (p->capture_done) {
+        pthread_mutex_unlock(&p->lock);
+        return NULL;
+      }
+      pthread_cond_wait(&p->frame_ready, &p->lock);
+      trackOccupancy(p);
+    }
+    pthread_cond_signal(&p->slot_free);
+    pthread_mutex_unlock(&p->lock);
+
+    fakeUpload((fake_fb_t *)frame, p->upload_ms);
+    cameraFbReturn(&p->camera, (fake_fb_t *)frame);
+
+    pthread_mutex_lock(&p->lock);
+    p->uploaded++;
+    p->last_upload = nowMs();
+    pthread_mutex_unlock(&p->lock);
+  }
+}
+
+typedef struct {
+  double upload_fps;
+  double capture_fps;
+  uint32_t dropped;
+  double occupancy;
+  size_t high_water;
+  double longest_wait;
+  bool accounted;         /* every captured frame was uploaded or dropped */
+} bench_result_t;
+
+static void printResult(const char *label, const bench_result_t *r) {
+  printf("%-26s %9.1f %9.1f %8u %10.2f %6zu %10.1f\n", label, r->upload_fps, r->capture_fps,
+         (unsigned)r->dropped, r->occupancy, r->high_water, r->longest_wait);
+}
+
+static bench_result_t runPipeline(size_t depth, frame_queue_policy_t policy, int fb_count,
+                                  int frames, double capture_ms, double upload_ms) {
+  static bench_pipeline_t p;
+  memset(&p, 0, sizeof(p));
+  frameQueueInit(&p.queue, depth, policy);
+  pthread_mutex_init(&p.lock, NULL);
+  pthread_cond_init(&p.frame_ready, NULL);
+  pthread_cond_init(&p.slot_free, NULL);
+  cameraInit(&p.camera, fb_count, capture_ms);
+  p.frames = frames;
+  p.upload_ms = upload_ms;
+
+  double start = nowMs();
+  p.occupancy_since = start;
+  pthread_t capture, upload;
+  pthread_create(&capture, NULL, captureThread, &p);
+  pthread_create(&upload, NULL, uploadThread, &p);
+  pthread_join(capture, NULL);
+  double capture_end = nowMs();
+  pthread_join(upload, NULL);
+  trackOccupancy(&p);
+
+  bench_result_t r;
+  double elapsed = p.last_upload - start;
+  r.upload_fps = elapsed > 0 ? p.uploaded * 1000.0 / elapsed : 0;
+  r.capture_fps = p.captured * 1000.0 / (capture_end - start);
+  r.dropped = p.queue.dropped;
+  r.occupancy = p.occupancy_area / (nowMs() - start);
+  r.high_water = p.queue.high_water;
+  r.longest_wait = p.camera.longest_wait;
+  r.accounted = p.captured == frames && (uint32_t)p.uploaded + p.queue.dropped == (uint32_t)frames;
+  return r;
+}
+
+/* the loop before the pipeline: capture, upload, return the buffer, repeat */
+static bench_result_t runSequential(int frames, double capture_ms, double upload_ms) {
+  static fake_camera_t camera;
+  cameraInit(&camera, 2, capture_ms);
+
+  double start = nowMs();
+  for (int i = 0; i < frames; i++) {
+    fake_fb_t *fb = cameraFbGet(&camera, i);
+    fakeUpload(fb, upload_ms);
+    cameraFbReturn(&camera, fb);
+  }
+  double elapsed = nowMs() - start;
+
+  bench_result_t r = {};
+  r.upload_fps = frames * 1000.0 / elapsed;
+  r.capture_fps = r.upload_fps;
+  r.longest_wait = camera.longest_wait;
+  r.accounted = true;
+  return r;
+}
+
+/*
+  -----------------------------
+  ----------- CHECKS ----------
+  -----------------------------
+*/
+static int failures = 0;
+
+static void check(bool ok, const char *label, const char *what) {
+  if (!ok) {
+    failures++;
+    printf("  FAIL %s: %s\n", label, what);
+  }
+}
+
+int main(int argc, char **argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : BENCH_FRAMES_DEFAULT;
+  double capture_ms = argc > 2 ? atof(argv[2]) : BENCH_CAPTURE_MS_DEFAULT;
+  double upload_ms = argc > 3 ? atof(argv[3]) : BENCH_UPLOAD_MS_DEFAULT;
+  if (frames < 1) frames = 1;
+
+  printf("%d frames, capture %.1f ms, upload %.1f ms +-50 %%, one frame per upload\n\n",
+         frames, capture_ms, upload_ms);
+  printf("%-26s %9s %9s %8s %10s %6s %10s\n", "", "upload/s", "capture/s", "dropped", "occupancy",
+         "high", "stall ms");
+
+  bench_result_t sequential = runSequential(frames, capture_ms, upload_ms);
+  printResult("sequential", &sequential);
+
+  const frame_queue_policy_t policies[] = { FRAME_QUEUE_DROP_OLDEST, FRAME_QUEUE_BLOCK };
+  for (size_t depth = 1; depth <= FRAME_QUEUE_MAX_DEPTH; depth++) {
+    for (size_t i = 0; i < 2; i++) {
+      char label[64];
+      int fb_count = (int)depth + 1 + 1;   /* initEspCamera(): queue + upload + spare */
+      snprintf(label, sizeof(label), "depth %zu %s, fb %d", depth,
+               policies[i] == FRAME_QUEUE_BLOCK ? "block" : "drop_oldest", fb_count);
+
+      bench_result_t r = runPipeline(depth, policies[i], fb_count, frames, capture_ms, upload_ms);
+      printResult(label, &r);
+
+      check(r.accounted, label, "every frame uploaded or dropped");
+      check(r.high_water <= depth, label, "occupancy within the depth");
+      if (policies[i] == FRAME_QUEUE_BLOCK) {
+        check(r.dropped == 0, label, "block never drops");
+      } else {
+        /* the spare buffer: a full queue never makes the camera wait for an upload */
+        check(r.longest_wait < upload_ms / 2, label, "camera does not wait for a buffer");
+      }
+      if (depth == 2) {
+        check(r.upload_fps > sequential.upload_fps * 1.2, label, "faster than the sequential loop");
+      }
+    }
+  }
+
+  /* the same without the spare buffer: drop_oldest ends up waiting like block */
+  bench_result_t no_spare = runPipeline(2, FRAME_QUEUE_DROP_OLDEST, 3, frames, capture_ms, upload_ms);
+  printResult("depth 2 drop_oldest, fb 3", &no_spare);
+
+  printf("\n%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,352 @@
+#include "frame_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Checks for the flash tier of the offline store (frame_store.cpp), host only.
+
+    ./frame-store-check            exit code 1 on failure
+
+  The segment files live in hal_host.cpp's filesystem, a temporary HIVEHIVE_FS_ROOT;
+  every check starts with an empty one. A "restart" is a new frame_store_t over
+  the same files, as after a reboot.
+
+  1. Segment format: header and records byte for byte, as documented below.
+  2. Restart: the frames come back newest first with their metadata, and acked
+     frames stay gone.
+  3. Torn append: a record written past pending_end without the header update
+     does not exist after a restart and is overwritten by the next frame; a header
+     whose pending_end runs into garbage is cut back to the last good record.
+  4. Corrupted record: a JPEG whose CRC does not match is skipped and counted.
+  5. Segment wrap: more frames than the segments hold recycle the oldest segment,
+     before and after a restart; RAM frames flushed to flash keep their order.
+*/
+#define CHECK_FRAME_MAX (8 * 1024)
+
+/* same layout as frame_store.cpp, little endian */
+#define SEGMENT_MAGIC 0x47534848   /* "HHSG" */
+#define RECORD_MAGIC 0x32464848    /* "HHF2" */
+#define SEGMENT_HEADER_SIZE 16     /* magic, generation, pending_end, crc of those three */
+#define RECORD_HEADER_SIZE 24      /* magic, sequence, timestamp, len, roi_x:16, roi_y:16, crc of the JPEG */
+
+static int failures = 0;
+static char root[] = "/tmp/frame-store-check-XXXXXX";
+static int run = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+/* an empty filesystem for the next check */
+static void freshFs() {
+  char dir[64];
+  snprintf(dir, sizeof(dir), "%s/%d", root, run++);
+  setenv("HIVEHIVE_FS_ROOT", dir, 1);
+  halFsBegin();
+}
+
+static void segPath(int index, char *path, size_t len) {
+  snprintf(path, len, FRAME_STORE_DIR "/seg%d.bin", index);
+}
+
+static uint32_t readU32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void writeU32(uint8_t *p, uint32_t value) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(value >> (8 * i));
+}
+
+/* the segment header on disk; false if it is not valid */
+static bool readSegmentHeader(int index, uint32_t *generation, uint32_t *pending_end) {
+  char path[32];
+  uint8_t header[SEGMENT_HEADER_SIZE];
+  segPath(index, path, sizeof(path));
+  if (halFsReadAt(path, 0, header, sizeof(header)) != (long)sizeof(header)) return false;
+  *generation = readU32(header + 4);
+  *pending_end = readU32(header + 8);
+  return readU32(header) == SEGMENT_MAGIC && readU32(header + 12) == crc32Update(0, header, 12);
+}
+
+/*
+  -----------------------------
+  ----------- FRAMES ----------
+  -----------------------------
+*/
+static uint8_t frame_buf[FRAME_STORE_SEGMENT_SIZE];   /* also the frame too big for a segment */
+static uint8_t scratch[CHECK_FRAME_MAX];
+
+/* the JPEG of frame seq, len bytes that differ from every other frame */
+static const uint8_t *frameData(uint32_t seq, size_t len) {
+  for (size_t i = 0; i < len; i++) frame_buf[i] = (uint8_t)(seq * 7 + i * 13 + (i >> 8));
+  return frame_buf;
+}
+
+static frame_info_t frameInfo(uint32_t seq) {
+  frame_info_t info = {};
+  info.sequence = seq;
+  info.timestamp = 1760000000 + seq;
+  info.roi_x = (uint16_t)(seq * 3);
+  info.roi_y = (uint16_t)(seq * 5);
+  return info;
+}
+
+static size_t frameLen(uint32_t seq) {
+  return 100 + (seq * 37) % 900;
+}
+
+/* a store with no RAM tier: every frame goes to flash right away */
+static void openFlashOnly(frame_store_t *store) {
+  frameStoreInit(store, NULL, 0, scratch, sizeof(scratch), true);
+}
+
+static bool putFrame(frame_store_t *store, uint32_t seq, size_t len) {
+  frame_info_t info = frameInfo(seq);
+  return frameStorePut(store, frameData(seq, len), len, &info);
+}
+
+/* the frame handed out matches what was put in */
+static bool sameFrame(const stored_frame_t *frame, uint32_t seq, size_t len) {
+  frame_info_t info = frameInfo(seq);
+  return frame->len == len && memcmp(frame->data, frameData(seq, len), len) == 0 &&
+         frame->info.sequence == seq && frame->info.timestamp == info.timestamp &&
+         frame->info.roi_x == info.roi_x && frame->info.roi_y == info.roi_y && frame->info.uptime_ms == 0;
+}
+
+/* takes every frame out; true if they are sequences from..to, counting down, with their lengths */
+static bool drainDown(frame_store_t *store, uint32_t from, uint32_t to, size_t (*len)(uint32_t)) {
+  stored_frame_t frame;
+  for (uint32_t seq = from + 1; seq-- > to;) {
+    if (!frameStorePeekNewest(store, &frame) || !sameFrame(&frame, seq, len(seq))) {
+      printf("  expected frame %lu, got %s%lu\n", (unsigned long)seq,
+             frameStoreCount(store) ? "" : "none after ", (unsigned long)frame.info.sequence);
+      return false;
+    }
+    frameStoreAck(store, &frame);
+  }
+  return !frameStorePeekNewest(store, &frame);
+}
+
+/*
+  -----------------------------
+  ---------- CHECKS -----------
+  -----------------------------
+*/
+static void checkFormat() {
+  freshFs();
+  frame_store_t store;
+  openFlashOnly(&store);
+  const size_t lens[] = { 100, 101, 1003 };
+  for (uint32_t seq = 1; seq <= 3; seq++) putFrame(&store, seq, lens[seq - 1]);
+  check(store.spilled == 3 && store.active == 0, "three frames go to the first segment");
+
+  uint32_t generation, pending_end;
+  check(readSegmentHeader(0, &generation, &pending_end), "segment header: magic and CRC");
+  check(generation == 1, "segment header: first generation is 1");
+
+  char path[32];
+  segPath(0, path, sizeof(path));
+  uint32_t offset = SEGMENT_HEADER_SIZE;
+  bool records = true;
+  for (uint32_t seq = 1; seq <= 3; seq++) {
+    uint8_t header[RECORD_HEADER_SIZE];
+    static uint8_t data[CHECK_FRAME_MAX];
+    size_t len = lens[seq - 1];
+    frame_info_t info = frameInfo(seq);
+    records = records && halFsReadAt(path, offset, header, sizeof(header)) == (long)sizeof(header) &&
+              halFsReadAt(path, offset + RECORD_HEADER_SIZE, data, len) == (long)len &&
+              readU32(header) == RECORD_MAGIC && readU32(header + 4) == seq &&
+              readU32(header + 8) == info.timestamp && readU32(header + 12) == len &&
+              (header[16] | header[17] << 8) == info.roi_x && (header[18] | header[19] << 8) == info.roi_y &&
+              readU32(header + 20) == crc32Update(0, data, len) && memcmp(data, frameData(seq, len), len) == 0;
+    offset += RECORD_HEADER_SIZE + ((len + 3) & ~3u);
+  }
+  check(records, "records: header fields, CRC and JPEG at 4-byte aligned offsets");
+  check(pending_end == offset, "segment header: pending_end right after the last record");
+
+  check(crc32Update(0, (const uint8_t *)"123456789", 9) == 0xCBF43926, "CRC-32 check value");
+}
+
+static void checkRestart() {
+  freshFs();
+  frame_store_t store;
+  openFlashOnly(&store);
+  for (uint32_t seq = 1; seq <= 5; seq++) putFrame(&store, seq, frameLen(seq));
+
+  frame_store_t after;
+  openFlashOnly(&after);
+  check(frameStoreCount(&after) == 5 && after.corrupt == 0, "restart: all five frames recovered");
+
+  stored_frame_t frame;
+  check(frameStorePeekNewest(&after, &frame) && frame.source == STORED_FLASH && sameFrame(&frame, 5, frameLen(5)),
+        "restart: newest frame first, data and metadata intact");
+  frameStoreAck(&after, &frame);
+  frameStorePeekNewest(&after, &frame);
+  frameStoreAck(&after, &frame);
+
+  /* acked frames move pending_end back on disk */
+  frame_store_t again;
+  openFlashOnly(&again);
+  check(frameStoreCount(&again) == 3, "restart after two acks: three frames left");
+  check(drainDown(&again, 3, 1, frameLen), "restart after two acks: frames 3, 2, 1");
+
+  /* new frames after a restart go on top */
+  putFrame(&again, 6, frameLen(6));
+  frame_store_t last;
+  openFlashOnly(&last);
+  check(drainDown(&last, 6, 6, frameLen), "frame stored after a restart is recovered");
+}
+
+static void checkTornAppend() {
+  freshFs();
+  frame_store_t store;
+  openFlashOnly(&store);
+  for (uint32_t seq = 1; seq <= 2; seq++) putFrame(&store, seq, frameLen(seq));
+
+  uint32_t generation, pending_end;
+  readSegmentHeader(0, &generation, &pending_end);
+
+  /* power loss in the middle of frame 3: record header and half the JPEG, header not updated */
+  char path[32];
+  segPath(0, path, sizeof(path));
+  uint8_t header[RECORD_HEADER_SIZE] = {};
+  writeU32(header, RECORD_MAGIC);
+  writeU32(header + 4, 3);
+  writeU32(header + 12, 800);
+  halFsWriteAt(path, pending_end, header, sizeof(header));
+  halFsWriteAt(path, pending_end + RECORD_HEADER_SIZE, frameData(3, 400), 400);
+
+  frame_store_t after;
+  openFlashOnly(&after);
+  check(frameStoreCount(&after) == 2 && after.corrupt == 0, "torn append: the half record does not exist");
+  putFrame(&after, 3, frameLen(3));
+
+  frame_store_t again;
+  openFlashOnly(&again);
+  check(drainDown(&again, 3, 1, frameLen), "torn append: the next frame overwrites it");
+
+  /* pending_end already moved, but the last record is garbage: cut back to the good ones */
+  freshFs();
+  openFlashOnly(&store);
+  for (uint32_t seq = 1; seq <= 3; seq++) putFrame(&store, seq, frameLen(seq));
+  segPath(0, path, sizeof(path));
+  uint32_t third = SEGMENT_HEADER_SIZE;
+  for (uint32_t seq = 1; seq <= 2; seq++) third += RECORD_HEADER_SIZE + ((frameLen(seq) + 3) & ~3u);
+  static const uint8_t garbage[RECORD_HEADER_SIZE] = { 0xff, 0xff, 0xff, 0xff };
+  halFsWriteAt(path, third, garbage, sizeof(garbage));
+
+  openFlashOnly(&after);
+  check(frameStoreCount(&after) == 2 && after.corrupt == 1, "garbage record: cut off and counted");
+  check(readSegmentHeader(0, &generation, &pending_end) && pending_end == third,
+        "garbage record: pending_end written back");
+  check(drainDown(&after, 2, 1, frameLen), "garbage record: the frames before it are intact");
+
+  /* a torn segment header: the segment is empty, the others are not touched */
+  freshFs();
+  openFlashOnly(&store);
+  putFrame(&store, 1, frameLen(1));
+  segPath(0, path, sizeof(path));
+  uint8_t torn[4] = { 0x12, 0x34, 0x56, 0x78 };
+  halFsWriteAt(path, 8, torn, sizeof(torn));
+  openFlashOnly(&after);
+  check(frameStoreCount(&after) == 0, "torn segment header: segment ignored");
+}
+
+static void checkCorruptCrc() {
+  freshFs();
+  frame_store_t store;
+  openFlashOnly(&store);
+  for (uint32_t seq = 1; seq <= 3; seq++) putFrame(&store, seq, frameLen(seq));
+
+  /* one flipped bit in the JPEG of frame 2 */
+  char path[32];
+  segPath(0, path, sizeof(path));
+  uint32_t second = SEGMENT_HEADER_SIZE + RECORD_HEADER_SIZE + ((frameLen(1) + 3) & ~3u);
+  uint8_t byte;
+  halFsReadAt(path, second + RECORD_HEADER_SIZE + 10, &byte, 1);
+  byte ^= 0x04;
+  halFsWriteAt(path, second + RECORD_HEADER_SIZE + 10, &byte, 1);
+
+  frame_store_t after;
+  openFlashOnly(&after);
+  check(frameStoreCount(&after) == 3, "corrupt CRC: recovery only walks the headers");
+
+  stored_frame_t frame;
+  check(frameStorePeekNewest(&after, &frame) && sameFrame(&frame, 3, frameLen(3)), "corrupt CRC: frame 3 first");
+  frameStoreAck(&after, &frame);
+  check(frameStorePeekNewest(&after, &frame) && sameFrame(&frame, 1, frameLen(1)),
+        "corrupt CRC: frame 2 skipped, frame 1 next");
+  check(after.corrupt == 1 && frameStoreCount(&after) == 1, "corrupt CRC: counted and removed");
+}
+
+/* frames that fill a segment in FRAME_STORE_SEGMENT_RECORDS records */
+static size_t wrapLen(uint32_t seq) {
+  return 3000 + seq % 7;
+}
+
+static void checkWrap() {
+  freshFs();
+  frame_store_t store;
+  openFlashOnly(&store);
+  const uint32_t per_segment = FRAME_STORE_SEGMENT_RECORDS;
+  const uint32_t total = FRAME_STORE_SEGMENTS * per_segment + 10;
+  for (uint32_t seq = 1; seq <= total; seq++) putFrame(&store, seq, wrapLen(seq));
+
+  check(store.dropped == per_segment, "wrap: the oldest segment is recycled whole");
+  check(frameStoreCount(&store) == total - per_segment, "wrap: the rest is kept");
+
+  uint32_t generation, pending_end;
+  check(readSegmentHeader(0, &generation, &pending_end) && generation == FRAME_STORE_SEGMENTS + 1,
+        "wrap: the recycled segment has the newest generation");
+
+  frame_store_t after;
+  openFlashOnly(&after);
+  check(frameStoreCount(&after) == total - per_segment && after.next_generation == FRAME_STORE_SEGMENTS + 2,
+        "wrap: everything recovered after a restart");
+  check(drainDown(&after, total, per_segment + 1, wrapLen), "wrap: newest first across segments");
+
+  /* too big for a segment: refused */
+  check(!putFrame(&after, 1, FRAME_STORE_SEGMENT_SIZE) && after.dropped == 1, "frame larger than a segment dropped");
+}
+
+static void checkRamFlush() {
+  freshFs();
+  static uint8_t arena[2 * 1024];
+  frame_store_t store;
+  frameStoreInit(&store, arena, sizeof(arena), scratch, sizeof(scratch), true);
+  for (uint32_t seq = 1; seq <= 10; seq++) putFrame(&store, seq, frameLen(seq));
+  check(store.spilled > 0 && store.ram_count > 0, "RAM tier full: the oldest frames spill");
+
+  frameStoreFlush(&store);
+  frame_store_t after;
+  frameStoreInit(&after, arena, sizeof(arena), scratch, sizeof(scratch), true);
+  check(frameStoreCount(&after) == 10 && after.dropped == 0, "flush: all RAM frames on flash");
+  check(drainDown(&after, 10, 1, frameLen), "flush: newest first after a restart");
+}
+
+int main() {
+  if (!mkdtemp(root)) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  checkFormat();
+  checkRestart();
+  checkTornAppend();
+  checkCorruptCrc();
+  checkWrap();
+  checkRamFlush();
+
+  char cleanup[128];
+  snprintf(cleanup, sizeof(cleanup), "rm -rf %s", root);
+  if (system(cleanup) != 0) {
+    printf("could not remove %s\n", root);
+  }
+
+  printf("%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+#include "http_request.h"
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+
+/*
+  Transport writes and allocations per upload request, host only.
+
+    ./http-request-bench [rounds]
+
+  "String + print" is postImage() as it used to send a frame: the file name, the
+  multipart head and tail built as concatenated Strings, five print() calls for the
+  request line and headers, one for the part header, the JPEG in 16 KB writes and a
+  last print() for the closing boundary. std::string stands in for the Arduino
+  String, both keep short strings inline.
+
+  "gather" is what postImage() does now: buildImageRequest() renders everything
+  but the JPEG into http_request_t and httpWriteGather() sends it, with the 16 KB
+  staging buffer from PSRAM and with the 1 KB fallback of a board without PSRAM.
+
+  Every request is also checked on the wire: its Content-Length has to match the
+  body, and a transport that takes at most 1000 bytes per call has to receive the
+  same bytes. Exit code 1 if a check fails, or if gather allocates or needs more
+  than HTTP_BENCH_WRITES_MAX writes for a 50 KB frame.
+*/
+#define BENCH_ROUNDS_DEFAULT 1000
+#define BENCH_FRAME_MAX (110 * 1024)
+#define BENCH_WIRE_MAX (BENCH_FRAME_MAX + 1024)
+#define HTTP_BENCH_WRITES_MAX 4   /* 50 KB frame, 16 KB staging: 3 full records + the rest */
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static double nowUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/*
+  -----------------------------
+  ----------- SINKS -----------
+  -----------------------------
+*/
+typedef struct {
+  unsigned long writes;
+  unsigned long bytes;
+  uint8_t *wire;       /* keeps what was sent if set */
+  size_t wire_len;
+  size_t accept_max;   /* 0: everything offered */
+} sink_t;
+
+static size_t sinkWrite(void *ctx, const uint8_t *data, size_t len) {
+  sink_t *sink = (sink_t *)ctx;
+  if (sink->accept_max && len > sink->accept_max) len = sink->accept_max;
+  sink->writes++;
+  sink->bytes += len;
+  if (sink->wire && sink->wire_len + len <= BENCH_WIRE_MAX) {
+    memcpy(sink->wire + sink->wire_len, data, len);
+    sink->wire_len += len;
+  }
+  return len;
+}
+
+/* Print::print() of a String: one write of its bytes */
+static void print(sink_t *sink, const std::string &text) {
+  sinkWrite(sink, (const uint8_t *)text.data(), text.size());
+}
+
+static const char *HOST = "hivehive.example.com";
+static const char *PATH = "/api/v1/upload";
+static const char *DEVICE = "a0b1c2d3e4f5";
+static uint8_t *jpeg;
+
+/*
+  -----------------------------
+  ------- STRING + PRINT ------
+  -----------------------------
+*/
+static std::string legacyFileName() {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "esp_capture_%04d%02d%02d_%02d%02d%02d.jpg", 2026, 10, 17, 10, 0, 0);
+  return std::string(buf);
+}
+
+static void legacyPost(sink_t *sink, size_t len) {
+  std::string filename = legacyFileName();
+  const std::string boundary = "----esp32_boundary";
+
+  const std::string head =
+    std::string("--") + boundary + "\r\n" +
+    "Content-Disposition: form-data; name=\"image\"; filename=\"" + filename + "\"\r\n" +
+    "Content-Type: image/jpeg\r\n\r\n";
+  const std::string tail = "\r\n--" + boundary + "--\r\n";
+  size_t contentLength = head.length() + len + tail.length();
+
+  print(sink, std::string("POST ") + PATH + " HTTP/1.1\r\n");
+  print(sink, std::string("Host: ") + HOST + "\r\n");
+  print(sink, "Connection: keep-alive\r\n");
+  print(sink, std::string("Content-Type: multipart/form-data; boundary=") + boundary + "\r\n");
+  print(sink, std::string("Content-Length: ") + std::to_string(contentLength) + "\r\n\r\n");
+
+  print(sink, head);
+  size_t sent = 0;
+  while (sent < len) {
+    size_t chunk = len - sent < 16384 ? len - sent : 16384;
+    sent += sinkWrite(sink, jpeg + sent, chunk);
+  }
+  print(sink, tail);
+}
+
+/*
+  -----------------------------
+  ----------- GATHER ----------
+  -----------------------------
+*/
+static uint8_t psram_staging[HTTP_WRITE_MAX];
+static uint8_t fallback_staging[1024];
+
+static bool gatherPost(sink_t *sink, size_t len, uint8_t *staging, size_t staging_cap) {
+  char filename[64];
+  snprintf(filename, sizeof(filename), "esp_capture_%04d%02d%02d_%02d%02d%02d.jpg", 2026, 10, 17, 10, 0, 0);
+
+  static http_request_t req;
+  http_image_part_t image = { filename, jpeg, len, 0, 0 };
+  if (!buildImageRequest(&req, HOST, PATH, DEVICE, &image)) return false;
+  return httpWriteGather(req.segments, req.segment_count, staging, staging_cap, sinkWrite, sink, NULL);
+}
+
+static void gatherPsram(sink_t *sink, size_t len) {
+  gatherPost(sink, len, psram_staging, sizeof(psram_staging));
+}
+
+static void gatherFallback(sink_t *sink, size_t len) {
+  gatherPost(sink, len, fallback_staging, sizeof(fallback_staging));
+}
+
+/*
+  -----------------------------
+  ------------ RUN ------------
+  -----------------------------
+*/
+static uint8_t wire[BENCH_WIRE_MAX], short_wire[BENCH_WIRE_MAX];
+
+/* Content-Length against the bytes after the blank line */
+static bool framedRight(const uint8_t *data, size_t len) {
+  const char *end = (const char *)memmem(data, len, "\r\n\r\n", 4);
+  const char *header = (const char *)memmem(data, len, "Content-Length: ", 16);
+  if (!end || !header || header > end) return false;
+  size_t body = len - ((const uint8_t *)end + 4 - data);
+  return strtoul(header + 16, NULL, 10) == body;
+}
+
+/* one request on the wire, in full writes and in writes of at most 1000 bytes */
+static void checkWire(const char *label, void (*post)(sink_t *, size_t), size_t len) {
+  char what[96];
+  sink_t full = {}, partial = {};
+  full.wire = wire;
+  partial.wire = short_wire;
+  partial.accept_max = 1000;
+  post(&full, len);
+  post(&partial, len);
+
+  snprintf(what, sizeof(what), "%s, %zu KB: Content-Length matches the body", label, len / 1024);
+  check(framedRight(wire, full.wire_len), what);
+  snprintf(what, sizeof(what), "%s, %zu KB: same bytes through short writes", label, len / 1024);
+  check(full.wire_len == partial.wire_len && memcmp(wire, short_wire, full.wire_len) == 0, what);
+}
+
+/* prints one row; returns the writes and allocations per request */
+static void run(const char *label, void (*post)(sink_t *, size_t), size_t len, int rounds,
+                unsigned long *writes, unsigned long *allocs) {
+  checkWire(label, post, len);
+
+  sink_t sink = {};
+  unsigned long before = allocations;
+  double start = nowUs();
+  for (int i = 0; i < rounds; i++) post(&sink, len);
+  double us = (nowUs() - start) / rounds;
+
+  *writes = sink.writes / rounds;
+  *allocs = (allocations - before) / rounds;
+  printf("%-22s %6zu KB %8lu %10lu %8lu %8.2f\n", label, len / 1024, *writes, sink.bytes / rounds, *allocs, us);
+}
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : BENCH_ROUNDS_DEFAULT;
+  if (rounds < 1) rounds = 1;
+
+  jpeg = (uint8_t *)malloc(BENCH_FRAME_MAX);
+  for (size_t i = 0; i < BENCH_FRAME_MAX; i++) jpeg[i] = (uint8_t)(i * 31 + (i >> 8));
+
+  printf("%d rounds\n\n", rounds);
+  printf("%-22s %9s %8s %10s %8s %8s\n", "per request", "frame", "writes", "bytes", "allocs", "us");
+
+  const size_t sizes[] = { 20 * 1024, 50 * 1024, BENCH_FRAME_MAX };
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    unsigned long writes, allocs;
+    run("String + print", legacyPost, sizes[i], rounds, &writes, &allocs);
+    run("gather, 16 KB staging", gatherPsram, sizes[i], rounds, &writes, &allocs);
+    check(allocs == 0, "gather with 16 KB staging allocates nothing");
+    if (sizes[i] == 50 * 1024) {
+      check(writes <= HTTP_BENCH_WRITES_MAX, "a 50 KB frame goes out in at most 4 writes");
+    }
+    run("gather, 1 KB staging", gatherFallback, sizes[i], rounds, &writes, &allocs);
+    check(allocs == 0, "gather with 1 KB staging allocates nothing");
+    printf("\n");
+  }
+
+  printf("%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
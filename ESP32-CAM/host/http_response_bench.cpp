@@ -0,0 +1,173 @@
+#include "http_response.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Throughput of the response parser (http_response.cpp) on recorded responses, host only.
+
+    ./http-response-bench                          built-in responses, 20000 rounds
+    ./http-response-bench 1000                     fewer rounds
+    ./http-response-bench 1000 1460 resp/a.bin resp/b.bin  recorded responses in 1460 byte reads
+
+  A recorded response is the raw bytes of one answer of the server, e.g.
+      curl -s --raw -i -F image=@frame.jpg http://host:4444/upload -o resp/json.bin
+  (--raw keeps the chunked framing, -i the status line, headers and any 100 Continue).
+
+  Each response is fed in reads of at most read_size bytes (default 256, the
+  receive buffer of readResponse() in client.cpp) into a parser with the
+  firmware's 1024 byte body buffer. Prints the time per response and the bytes
+  per second; exit code 1 if a response does not parse.
+*/
+#define BENCH_ROUNDS_DEFAULT 20000
+#define BENCH_READ_DEFAULT 256
+#define BENCH_BODY_MAX 1024        /* RESPONSE_BODY_MAX in client.cpp */
+#define BENCH_RESPONSE_MAX (256 * 1024)
+
+static int failures = 0;
+
+static double nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+  -----------------------------
+  ---------- SAMPLES ----------
+  -----------------------------
+*/
+typedef struct {
+  const char *name;
+  uint8_t *data;
+  size_t len;
+} recorded_t;
+
+static char json_body[BENCH_BODY_MAX];
+
+/* the answers the upload endpoint gives, as the firmware sees them on the wire */
+static size_t builtInSamples(recorded_t *out) {
+  static char json_response[2048], chunked_response[2048], binary_response[512];
+  static const char RETRY[] =
+    "HTTP/1.1 503 Service Unavailable\r\nServer: gunicorn\r\nDate: Sat, 17 Oct 2026 10:00:00 GMT\r\n"
+    "Connection: keep-alive\r\nRetry-After: 30\r\nContent-Length: 0\r\n\r\n";
+  static char continue_response[2048];
+
+  /* JSON result with 12 circles, about what a busy frame gets */
+  int pos = snprintf(json_body, sizeof(json_body), "{\"circles\":[");
+  for (int i = 0; i < 12; i++) {
+    pos += snprintf(json_body + pos, sizeof(json_body) - pos, "%s{\"x\":%d,\"y\":%d,\"r\":%d,\"filled\":%s}",
+                    i ? "," : "", 100 + 97 * i, 80 + 53 * i, 20 + i, i % 3 ? "true" : "false");
+  }
+  pos += snprintf(json_body + pos, sizeof(json_body) - pos, "],\"timings\":{\"decode\":12.5,\"detect\":48.1}}");
+
+  snprintf(json_response, sizeof(json_response),
+           "HTTP/1.1 200 OK\r\nServer: gunicorn\r\nDate: Sat, 17 Oct 2026 10:00:00 GMT\r\n"
+           "Connection: keep-alive\r\nContent-Type: application/json\r\nContent-Length: %d\r\n\r\n%s",
+           pos, json_body);
+
+  /* the same body chunked the way a streaming server sends it */
+  int chunked = snprintf(chunked_response, sizeof(chunked_response),
+                         "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n");
+  for (int sent = 0; sent < pos; sent += 128) {
+    int n = pos - sent < 128 ? pos - sent : 128;
+    chunked += snprintf(chunked_response + chunked, sizeof(chunked_response) - chunked, "%x\r\n%.*s\r\n",
+                        n, n, json_body + sent);
+  }
+  chunked += snprintf(chunked_response + chunked, sizeof(chunked_response) - chunked, "0\r\n\r\n");
+
+  /* binary result (circle_result.h) with 12 circles */
+  int binary = snprintf(binary_response, sizeof(binary_response),
+                        "HTTP/1.1 200 OK\r\nContent-Type: application/vnd.hivehive.circles\r\nContent-Length: %d\r\n\r\n",
+                        4 + 6 * 12);
+  uint8_t *record = (uint8_t *)binary_response + binary;
+  *record++ = 1;
+  *record++ = 0;
+  *record++ = 12;
+  *record++ = 0;
+  for (int i = 0; i < 6 * 12; i++) *record++ = (uint8_t)(i * 37);
+  binary = (char *)record - binary_response;
+
+  int cont = snprintf(continue_response, sizeof(continue_response), "HTTP/1.1 100 Continue\r\n\r\n%s", json_response);
+
+  out[0] = { "json, Content-Length", (uint8_t *)json_response, strlen(json_response) };
+  out[1] = { "json, chunked", (uint8_t *)chunked_response, (size_t)chunked };
+  out[2] = { "binary result", (uint8_t *)binary_response, (size_t)binary };
+  out[3] = { "503 Retry-After", (uint8_t *)RETRY, sizeof(RETRY) - 1 };
+  out[4] = { "100 Continue + json", (uint8_t *)continue_response, (size_t)cont };
+  return 5;
+}
+
+static bool loadFile(const char *path, recorded_t *out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t *data = (uint8_t *)malloc(BENCH_RESPONSE_MAX);
+  size_t len = fread(data, 1, BENCH_RESPONSE_MAX, f);
+  fclose(f);
+  *out = { path, data, len };
+  return len > 0;
+}
+
+/*
+  -----------------------------
+  ---------- MEASURE ----------
+  -----------------------------
+*/
+
+/* one response in reads of read_size bytes, like readResponse() */
+static bool parse(const recorded_t *r, size_t read_size, http_response_t *res, uint8_t *body) {
+  httpResponseInit(res, body, BENCH_BODY_MAX);
+  for (size_t pos = 0; pos < r->len && !httpResponseDone(res); pos += read_size) {
+    size_t n = r->len - pos < read_size ? r->len - pos : read_size;
+    httpResponseFeed(res, r->data + pos, n);
+  }
+  if (!httpResponseDone(res)) httpResponseFinish(res);   /* recorded until the server closed */
+  return !httpResponseFailed(res);
+}
+
+static void measure(const recorded_t *r, int rounds, size_t read_size) {
+  static uint8_t body[BENCH_BODY_MAX];
+  http_response_t res;
+
+  if (!parse(r, read_size, &res, body)) {
+    printf("%-28s does not parse\n", r->name);
+    failures++;
+    return;
+  }
+
+  double start = nowNs();
+  for (int i = 0; i < rounds; i++) parse(r, read_size, &res, body);
+  double ns = (nowNs() - start) / rounds;
+
+  printf("%-28s %6zu %6d %7zu %10.0f %9.1f\n", r->name, r->len, res.status_code, res.body_len, ns,
+         r->len / ns * 1e3);
+}
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : BENCH_ROUNDS_DEFAULT;
+  size_t read_size = argc > 2 ? (size_t)atoi(argv[2]) : BENCH_READ_DEFAULT;
+  if (rounds < 1) rounds = 1;
+  if (read_size < 1) read_size = 1;
+
+  static recorded_t samples[64];
+  size_t count = 0;
+  if (argc > 3) {
+    for (int i = 3; i < argc && count < sizeof(samples) / sizeof(samples[0]); i++) {
+      if (!loadFile(argv[i], &samples[count])) {
+        printf("cannot read %s\n", argv[i]);
+        return 1;
+      }
+      count++;
+    }
+  } else {
+    count = builtInSamples(samples);
+  }
+
+  printf("%d rounds, reads of %zu bytes\n\n", rounds, read_size);
+  printf("%-28s %6s %6s %7s %10s %9s\n", "", "bytes", "status", "body", "ns/resp", "MB/s");
+  for (size_t i = 0; i < count; i++) measure(&samples[i], rounds, read_size);
+
+  printf("\n%s\n", failures ? "FAILED" : "all responses parsed");
+  return failures ? 1 : 0;
+}
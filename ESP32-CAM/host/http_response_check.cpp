@@ -0,0 +1,385 @@
+#include "http_response.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Checks for the response parser (http_response.cpp), host only.
+
+    ./http-response-check          exit code 1 on failure
+
+  Every case of the table is fed the way readResponse() in client.cpp might see
+  it: in one read, in two reads split at every byte boundary, and one byte at a
+  time. Each way has to end with the same status, headers and body, and consume
+  exactly the response (bytes after it belong to the next one on the connection).
+
+  The table covers Content-Length, chunked bodies with chunk extensions and
+  trailers, bodies that end with the connection, 100 Continue and other interim
+  responses before the real status, and broken responses (among them a
+  Content-Length that is not a number, sent twice with two values, or next to
+  chunked). Generated cases add
+  bodies around the body buffer of the firmware and an overlong header line.
+*/
+#define CHECK_BODY_MAX 1024   /* RESPONSE_BODY_MAX in client.cpp */
+
+static int failures = 0;
+static int cases = 0;
+
+static void check(bool ok, const char *name, const char *what, size_t split) {
+  if (!ok) {
+    printf("FAIL %s: %s (split %zu)\n", name, what, split);
+    failures++;
+  }
+}
+
+typedef struct {
+  const char *name;
+  const char *raw;             /* what the server sends */
+  size_t len;                  /* 0: strlen(raw) */
+  size_t tail;                 /* bytes at the end that belong to the next response */
+  bool closed;                 /* the server closes the connection after raw */
+
+  /* expected */
+  bool failed;
+  int status;
+  bool keep_alive;
+  uint32_t retry_after_s;
+  const char *content_type;
+  const char *body;
+  size_t body_len;             /* 0: strlen(body) */
+  bool truncated;
+} response_case_t;
+
+/*
+  -----------------------------
+  ----------- TABLE -----------
+  -----------------------------
+*/
+static const response_case_t CASES[] = {
+  { "content-length",
+    "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: 11\r\n\r\n{\"ok\":true}",
+    0, 0, false,
+    false, 200, true, 0, "application/json", "{\"ok\":true}", 0, false },
+
+  { "header names in any case, LF only",
+    "HTTP/1.1 201 Created\ncontent-length: 3\nCONTENT-TYPE:text/plain\n\nabc",
+    0, 0, false,
+    false, 201, true, 0, "text/plain", "abc", 0, false },
+
+  { "HTTP/1.0 closes",
+    "HTTP/1.0 200 OK\r\nContent-Length: 2\r\n\r\nok",
+    0, 0, false,
+    false, 200, false, 0, "", "ok", 0, false },
+
+  { "HTTP/1.0 keep-alive",
+    "HTTP/1.0 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 2\r\n\r\nok",
+    0, 0, false,
+    false, 200, true, 0, "", "ok", 0, false },
+
+  { "Connection: close",
+    "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok",
+    0, 0, false,
+    false, 200, false, 0, "", "ok", 0, false },
+
+  { "Content-Length twice, same, trailing white space",
+    "HTTP/1.1 200 OK\r\nContent-Length: 2 \t\r\nContent-Length: 2\r\n\r\nok",
+    0, 0, false,
+    false, 200, true, 0, "", "ok", 0, false },
+
+  { "pipelined next response",
+    "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nfirstHTTP/1.1 200 OK\r\n",
+    0, 18, false,
+    false, 200, true, 0, "", "firs", 0, false },
+
+  { "chunked",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n",
+    0, 0, false,
+    false, 200, true, 0, "", "hello world", 0, false },
+
+  { "chunk sizes in upper case hex with padding",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n00A\r\n0123456789\r\n0000\r\n\r\n",
+    0, 0, false,
+    false, 200, true, 0, "", "0123456789", 0, false },
+
+  { "chunk extensions",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+    "5;name=value\r\nhello\r\n6;a;b=\"q;x\"\r\n world\r\n0;last\r\n\r\n",
+    0, 0, false,
+    false, 200, true, 0, "", "hello world", 0, false },
+
+  { "chunked with trailers",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, chunked\r\nTrailer: X-Checksum\r\n\r\n"
+    "3\r\nabc\r\n0\r\nX-Checksum: 900150983cd24fb0\r\nContent-Length: 99\r\n\r\nHTTP",
+    0, 4, false,
+    false, 200, true, 0, "", "abc", 0, false },
+
+  { "chunk data with CR and LF in it",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n4\r\n\r\n\r\n\r\n0\r\n\r\n",
+    0, 0, false,
+    false, 200, true, 0, "", "\r\n\r\n", 0, false },
+
+  { "binary body with NUL bytes",
+    "HTTP/1.1 200 OK\r\nContent-Type: application/vnd.hivehive.circles\r\nContent-Length: 4\r\n\r\n\x01\x00\x00\x00",
+    sizeof("HTTP/1.1 200 OK\r\nContent-Type: application/vnd.hivehive.circles\r\nContent-Length: 4\r\n\r\n\x01\x00\x00\x00") - 1,
+    0, false,
+    false, 200, true, 0, "application/vnd.hivehive.circles", "\x01\x00\x00\x00", 4, false },
+
+  { "body until close",
+    "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\nuntil the end",
+    0, 0, true,
+    false, 200, false, 0, "text/plain", "until the end", 0, false },
+
+  { "204 without body",
+    "HTTP/1.1 204 No Content\r\n\r\nHTTP/1.1 200 OK\r\n",
+    0, 17, false,
+    false, 204, true, 0, "", "", 0, false },
+
+  { "304 ignores Content-Length",
+    "HTTP/1.1 304 Not Modified\r\nContent-Length: 500\r\n\r\n",
+    0, 0, false,
+    false, 304, true, 0, "", "", 0, false },
+
+  { "503 with Retry-After",
+    "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 120\r\nContent-Length: 0\r\n\r\n",
+    0, 0, false,
+    false, 503, true, 120, "", "", 0, false },
+
+  { "Retry-After as HTTP-date",
+    "HTTP/1.1 429 Too Many Requests\r\nRetry-After: Fri, 31 Dec 1999 23:59:59 GMT\r\nContent-Length: 0\r\n\r\n",
+    0, 0, false,
+    false, 429, true, 0, "", "", 0, false },
+
+  /* interim responses: the fields are those of the final response */
+  { "100 Continue, then the status",
+    "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok",
+    0, 0, false,
+    false, 200, true, 0, "", "ok", 0, false },
+
+  { "100 Continue, then a chunked status",
+    "HTTP/1.1 100 Continue\r\n\r\n"
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nok\r\n0\r\n\r\n",
+    0, 0, false,
+    false, 200, true, 0, "", "ok", 0, false },
+
+  { "103 headers do not leak into the final response",
+    "HTTP/1.1 103 Early Hints\r\nLink: </style.css>; rel=preload\r\nRetry-After: 30\r\n"
+    "Content-Type: text/css\r\nTransfer-Encoding: chunked\r\n\r\n"
+    "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok",
+    0, 0, false,
+    false, 200, true, 0, "", "ok", 0, false },
+
+  { "two interim responses, then 503",
+    "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 102 Processing\r\n\r\n"
+    "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 5\r\nConnection: close\r\n\r\n",
+    0, 0, true,
+    false, 503, false, 5, "", "", 0, false },
+
+  { "100 Continue, then HTTP/1.0",
+    "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.0 200 OK\r\nContent-Length: 2\r\n\r\nok",
+    0, 0, false,
+    false, 200, false, 0, "", "ok", 0, false },
+
+  /* broken */
+  { "100 Continue, then closed",
+    "HTTP/1.1 100 Continue\r\n\r\n",
+    0, 0, true,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "not HTTP",
+    "SSH-2.0-OpenSSH_9.6\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "status code missing",
+    "HTTP/1.1 OK\r\n\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "negative Content-Length",
+    "HTTP/1.1 200 OK\r\nContent-Length: -1\r\n\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "Content-Length not a number",
+    "HTTP/1.1 200 OK\r\nContent-Length: 12abc\r\n\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "Content-Length beyond long",
+    "HTTP/1.1 200 OK\r\nContent-Length: 99999999999999999999999\r\n\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "Content-Length twice, different",
+    "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nContent-Length: 20\r\n\r\nok",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "Content-Length and chunked",
+    "HTTP/1.1 200 OK\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "chunk size not hex",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "chunk longer than its size",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcd\r\n0\r\n\r\n",
+    0, 0, false,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "chunked body cut off",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel",
+    0, 0, true,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "Content-Length body cut off",
+    "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort",
+    0, 0, true,
+    true, 0, false, 0, "", "", 0, false },
+
+  { "headers cut off",
+    "HTTP/1.1 200 OK\r\nContent-Len",
+    0, 0, true,
+    true, 0, false, 0, "", "", 0, false },
+};
+
+/*
+  -----------------------------
+  ----------- RUNNER ----------
+  -----------------------------
+*/
+
+/*
+  Feeds c->raw up to split in reads of step bytes (0: all at once), the rest the
+  same way, like readResponse() with whatever the socket has. Returns the bytes used.
+*/
+static size_t feed(http_response_t *res, const response_case_t *c, size_t len, size_t split, size_t step) {
+  const uint8_t *data = (const uint8_t *)c->raw;
+  size_t pos = 0;
+  while (pos < len && !httpResponseDone(res)) {
+    size_t end = pos < split ? split : len;
+    if (step > 0 && pos + step < end) end = pos + step;
+    size_t used = httpResponseFeed(res, data + pos, end - pos);
+    if (used < end - pos) return pos + used;   /* complete; the rest is the next response */
+    pos += used;
+  }
+  if (!httpResponseDone(res) && c->closed) httpResponseFinish(res);
+  return pos;
+}
+
+static void runCase(const response_case_t *c, size_t split, size_t step) {
+  static uint8_t body[CHECK_BODY_MAX];
+  size_t len = c->len ? c->len : strlen(c->raw);
+  size_t body_len = c->body_len ? c->body_len : strlen(c->body);
+
+  memset(body, 0xa5, sizeof(body));
+  http_response_t res;
+  httpResponseInit(&res, body, sizeof(body));
+  size_t used = feed(&res, c, len, split, step);
+
+  check(httpResponseDone(&res), c->name, "complete", split);
+  check(httpResponseFailed(&res) == c->failed, c->name, c->failed ? "refused" : "accepted", split);
+  if (c->failed) return;
+
+  check(used == len - c->tail, c->name, "consumes exactly the response", split);
+  check(res.status_code == c->status, c->name, "status", split);
+  check(res.keep_alive == c->keep_alive, c->name, "keep-alive", split);
+  check(res.retry_after_s == c->retry_after_s, c->name, "Retry-After", split);
+  check(strcmp(res.content_type, c->content_type) == 0, c->name, "Content-Type", split);
+  check(res.body_len == body_len && memcmp(body, c->body, body_len) == 0, c->name, "body", split);
+  check(body[res.body_len] == '\0', c->name, "body NUL-terminated", split);
+  check(res.body_truncated == c->truncated, c->name, c->truncated ? "truncated" : "not truncated", split);
+}
+
+/* one read, two reads split at every byte, one byte per read */
+static void runSplits(const response_case_t *c) {
+  size_t len = c->len ? c->len : strlen(c->raw);
+  int before = failures;
+  cases++;
+  for (size_t split = 0; split <= len && failures == before; split++) {
+    runCase(c, split, 0);
+  }
+  if (failures == before) runCase(c, 0, 1);
+}
+
+/*
+  -----------------------------
+  -------- GENERATED ----------
+  -----------------------------
+*/
+static char generated[4 * CHECK_BODY_MAX];
+static char expected[4 * CHECK_BODY_MAX];
+
+static void fillBody(char *out, size_t len) {
+  for (size_t i = 0; i < len; i++) out[i] = 'a' + i % 26;
+}
+
+/* Content-Length body of body_len bytes; the parser keeps CHECK_BODY_MAX - 1 of them */
+static void checkContentLength(size_t body_len) {
+  char name[64];
+  snprintf(name, sizeof(name), "Content-Length body of %zu bytes", body_len);
+  int head = snprintf(generated, sizeof(generated), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n", body_len);
+  fillBody(generated + head, body_len);
+  size_t kept = body_len < CHECK_BODY_MAX - 1 ? body_len : CHECK_BODY_MAX - 1;
+  fillBody(expected, kept);
+
+  response_case_t c = { name, generated, head + body_len, 0, false,
+                        false, 200, true, 0, "", expected, kept, kept < body_len };
+  if (kept == 0) c.body = "";
+  runSplits(&c);
+}
+
+/* the same body in chunks of chunk bytes, with a trailer */
+static void checkChunked(size_t body_len, size_t chunk) {
+  char name[64];
+  snprintf(name, sizeof(name), "chunked body of %zu bytes in %zu byte chunks", body_len, chunk);
+  int pos = snprintf(generated, sizeof(generated), "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+  fillBody(expected, body_len);
+  for (size_t sent = 0; sent < body_len; sent += chunk) {
+    size_t n = body_len - sent < chunk ? body_len - sent : chunk;
+    pos += snprintf(generated + pos, sizeof(generated) - pos, "%zx;i=%zu\r\n", n, sent / chunk);
+    memcpy(generated + pos, expected + sent, n);
+    pos += n;
+    pos += snprintf(generated + pos, sizeof(generated) - pos, "\r\n");
+  }
+  pos += snprintf(generated + pos, sizeof(generated) - pos, "0\r\nX-Done: 1\r\n\r\n");
+
+  size_t kept = body_len < CHECK_BODY_MAX - 1 ? body_len : CHECK_BODY_MAX - 1;
+  response_case_t c = { name, generated, (size_t)pos, 0, false,
+                        false, 200, true, 0, "", expected, kept, kept < body_len };
+  runSplits(&c);
+}
+
+/* a header line longer than HTTP_LINE_MAX is cut off, the next one still counts */
+static void checkLongHeader() {
+  int pos = snprintf(generated, sizeof(generated), "HTTP/1.1 200 OK\r\nSet-Cookie: ");
+  memset(generated + pos, 'c', 3 * HTTP_LINE_MAX);
+  pos += 3 * HTTP_LINE_MAX;
+  pos += snprintf(generated + pos, sizeof(generated) - pos,
+                  "\r\nContent-Type: application/json\r\nContent-Length: 2\r\n\r\n{}");
+
+  response_case_t c = { "overlong header line", generated, (size_t)pos, 0, false,
+                        false, 200, true, 0, "application/json", "{}", 0, false };
+  runSplits(&c);
+}
+
+int main() {
+  for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+    runSplits(&CASES[i]);
+  }
+
+  const size_t sizes[] = { 0, 1, CHECK_BODY_MAX - 2, CHECK_BODY_MAX - 1, CHECK_BODY_MAX, CHECK_BODY_MAX + 1,
+                           3 * CHECK_BODY_MAX };
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    checkContentLength(sizes[i]);
+    if (sizes[i] > 0) checkChunked(sizes[i], 600);
+  }
+  checkChunked(CHECK_BODY_MAX + 10, 7);
+  checkLongHeader();
+
+  printf("%d cases, %s\n", cases, failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+#include "client.h"
+#include "config.h"
+#include "http_request.h"
+#include "metrics.h"
+#include "portal_handler.h"
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*
+  Linux entry point: runs the firmware's real loadConfig() + postImage() path
+  against the stand-ins in hal_host.cpp and prints the metrics snapshot at the end.
+
+    ./hivehive-host [frames] [upload_url] [batch_size]
+    ./hivehive-host portal [port]
+
+  Without an upload_url the one from $HIVEHIVE_FS_ROOT/config.json is used.
+  batch_size > 1 posts that many frames per request (postBatch()); running it once
+  with 1 and once with e.g. 8 compares frames/s and bytes_sent/bytes_received.
+  Exit code 1 if an upload failed.
+
+  "portal" serves the configuration portal (portal_handler.cpp) on port (default 8080)
+  instead of the access point, one connection at a time, until the form was saved
+  to $HIVEHIVE_FS_ROOT/config.json.
+*/
+#define HOST_PORTAL_PORT 8080
+#define HOST_PORTAL_SESSION "host"
+
+static size_t writeToSocket(void *ctx, const uint8_t *data, size_t len) {
+  ssize_t n = send(*(int *)ctx, data, len, MSG_NOSIGNAL);
+  return n > 0 ? (size_t)n : 0;
+}
+
+static int servePortal(uint16_t port) {
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (server < 0 || bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 4) != 0) {
+    perror("portal");
+    return 1;
+  }
+
+  halFsBegin();
+  portalBegin(HOST_PORTAL_SESSION);
+  halLog("---- portal on http://localhost:%u/\n", (unsigned)port);
+
+  bool saved = false;
+  while (!saved) {
+    int client = accept(server, NULL, NULL);
+    if (client < 0) continue;
+
+    static portal_request_t req;
+    portalRequestInit(&req);
+    uint8_t buf[256];
+    while (!portalRequestDone(&req)) {
+      ssize_t n = recv(client, buf, sizeof(buf), 0);
+      if (n <= 0) break;
+      portalRequestFeed(&req, buf, (size_t)n);
+    }
+    if (portalRequestDone(&req)) {
+      saved = portalHandleRequest(&req, writeToSocket, &client);
+    }
+    close(client);
+  }
+  close(server);
+  halLog("---- configuration saved\n");
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "portal") == 0) {
+    return servePortal(argc > 2 ? (uint16_t)atoi(argv[2]) : HOST_PORTAL_PORT);
+  }
+
+  int frames = argc > 1 ? atoi(argv[1]) : 20;
+
+  esp_config_t esp_config;
+  memset(&esp_config, 0, sizeof(esp_config));
+  snprintf(esp_config.CONFIG_FILE, sizeof(esp_config.CONFIG_FILE), "/config.json");
+
+  if (!loadConfig(&esp_config) && argc <= 2) {
+    halLog("-- Failed to configure host run: no config.json and no upload_url given\n");
+    return 1;
+  }
+  if (argc > 2) {
+    snprintf(esp_config.UPLOAD_URL, sizeof(esp_config.UPLOAD_URL), "%s", argv[2]);
+  }
+
+  loadUploadTrust();
+  if (getenv("HIVEHIVE_CHUNKED")) {
+    esp_config.CHUNKED_UPLOAD = atoi(getenv("HIVEHIVE_CHUNKED"));
+  }
+  setChunkedUpload(esp_config.CHUNKED_UPLOAD);
+
+  /* grayscale capture: the stand-in crops the files like the ESP32 does (-DHIVEHIVE_HOST_JPEG) */
+  roi_t roi;
+  configRoi(&esp_config, &roi);
+  halCameraCrop(esp_config.CAPTURE_FORMAT == CAPTURE_GRAYSCALE ? &roi : NULL);
+
+  int batch_size = argc > 3 ? atoi(argv[3]) : esp_config.BATCH_SIZE;
+  if (batch_size < 1) batch_size = 1;
+  if (batch_size > HTTP_BATCH_MAX) batch_size = HTTP_BATCH_MAX;
+
+  int failed = 0;
+  uint32_t start = halMillis();
+  for (int i = 0; i < frames; i += batch_size) {
+    camera_fb_t *fbs[HTTP_BATCH_MAX];
+    frame_info_t infos[HTTP_BATCH_MAX];
+    size_t count = 0;
+
+    for (int j = i; j < frames && j < i + batch_size; j++) {
+      uint32_t t_capture_start = halMillis();
+      camera_fb_t *fb = halCameraFbGet();
+      if (!fb) {
+        metricsRecordResult(-1);
+        failed++;
+        continue;
+      }
+      metricsRecordStage(STAGE_CAPTURE, halMillis() - t_capture_start);
+      fbs[count] = fb;
+      infos[count].sequence = (uint32_t)j;
+      infos[count].timestamp = halFrameTimestamp(fb);
+      infos[count].uptime_ms = halFrameUptime(fb);
+      halFrameOffset(fb, &infos[count].roi_x, &infos[count].roi_y);
+      count++;
+    }
+    if (count == 0) continue;
+
+    int httpCode = count == 1 && batch_size == 1
+                   ? postImage(esp_config.UPLOAD_URL, fbs[0], &infos[0])
+                   : postBatch(esp_config.UPLOAD_URL, fbs, infos, count);
+    for (size_t j = 0; j < count; j++) {
+      halCameraFbReturn(fbs[j]);
+    }
+
+    metricsCount(COUNTER_UPLOADS);
+    metricsCount(COUNTER_FRAMES, count);
+    metricsRecordResult(httpCode);
+    if (httpCode < 200 || httpCode > 299) failed++;
+    halLog("-- images %d..%d: %d\n", i, i + (int)count - 1, httpCode);
+  }
+
+  uint32_t elapsed = halMillis() - start;
+  static char snapshot[METRICS_SNAPSHOT_MAX];
+  metricsSnapshotJson(snapshot, sizeof(snapshot), elapsed);
+  printf("%s\n", snapshot);
+  printf("%.2f frames/s\n", elapsed ? frames * 1000.0 / elapsed : 0.0);
+  return failed ? 1 : 0;
+}
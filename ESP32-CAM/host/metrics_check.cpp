@@ -0,0 +1,245 @@
+#include "metrics.h"
+#include <algorithm>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Checks for the latency histograms and metrics (metrics.cpp), host only.
+
+    ./metrics-check               exit code 1 on failure
+
+  1. Bucket boundaries: 0..3 exact, then four buckets per power of two; every
+     lower bound maps to its own bucket and the value before it to the previous
+     one, and everything beyond ~131 s lands in the last bucket.
+  2. Percentiles of known inputs, worked out by hand below, and on random inputs
+     never below the exact percentile nor more than a bucket (25 %) above it.
+  3. Two threads record stages and counters, as the capture and upload tasks do,
+     while a third takes snapshots: nothing is lost, and no snapshot is torn (the
+     count of a histogram is the sum of its buckets).
+*/
+#define CHECK_THREAD_RECORDS 1000000
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static void checkValue(uint32_t got, uint32_t expected, const char *what) {
+  if (got != expected) {
+    printf("FAIL: %s: %lu, expected %lu\n", what, (unsigned long)got, (unsigned long)expected);
+    failures++;
+  }
+}
+
+/*
+  -----------------------------
+  ---------- BUCKETS ----------
+  -----------------------------
+*/
+static void checkBuckets() {
+  /* value -> bucket, lower bound of that bucket */
+  static const struct { uint32_t value; size_t index; uint32_t lower; } KNOWN[] = {
+    { 0, 0, 0 },   { 3, 3, 3 },   { 4, 4, 4 },   { 7, 7, 7 },
+    { 8, 8, 8 },   { 9, 8, 8 },   { 10, 9, 10 }, { 15, 11, 14 }, { 16, 12, 16 },
+    { 100, 22, 96 }, { 1000, 35, 896 }, { 1023, 35, 896 }, { 1024, 36, 1024 },
+    { 114687, 62, 98304 }, { 114688, 63, 114688 },
+    { 131071, 63, 114688 }, { 131072, 63, 114688 }, { 0xffffffff, 63, 114688 },
+  };
+  for (size_t i = 0; i < sizeof(KNOWN) / sizeof(KNOWN[0]); i++) {
+    char what[64];
+    snprintf(what, sizeof(what), "bucket of %lu", (unsigned long)KNOWN[i].value);
+    checkValue(histogramBucketIndex(KNOWN[i].value), KNOWN[i].index, what);
+    snprintf(what, sizeof(what), "lower bound of the bucket of %lu", (unsigned long)KNOWN[i].value);
+    checkValue(histogramBucketLowerBound(histogramBucketIndex(KNOWN[i].value)), KNOWN[i].lower, what);
+  }
+
+  bool exact = true, ordered = true, fine = true;
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    uint32_t lower = histogramBucketLowerBound(i);
+    exact = exact && histogramBucketIndex(lower) == i;
+    if (i > 0) {
+      uint32_t previous = histogramBucketLowerBound(i - 1);
+      ordered = ordered && previous < lower && histogramBucketIndex(lower - 1) == i - 1;
+      /* a bucket is at most a quarter of its lower bound wide */
+      fine = fine && (i <= HISTOGRAM_SUB_BUCKETS || (lower - previous) * 4 <= previous);
+    }
+  }
+  check(exact, "every lower bound maps to its own bucket");
+  check(ordered, "the value below a lower bound maps to the bucket before");
+  check(fine, "buckets are at most 25 % wide");
+}
+
+/*
+  -----------------------------
+  -------- PERCENTILES --------
+  -----------------------------
+*/
+static void checkPercentiles() {
+  histogram_t hist;
+
+  histogramReset(&hist);
+  checkValue(histogramPercentile(&hist, 50), 0, "p50 of nothing");
+
+  /*
+    1..100 once each. p50 is the 50th value, in bucket 48..55; p90 the 90th, in
+    80..95; p99 the 99th, in 96..111, which is capped at the largest value seen.
+  */
+  for (uint32_t v = 1; v <= 100; v++) histogramRecord(&hist, v);
+  checkValue(histogramPercentile(&hist, 50), 55, "p50 of 1..100");
+  checkValue(histogramPercentile(&hist, 90), 95, "p90 of 1..100");
+  checkValue(histogramPercentile(&hist, 99), 100, "p99 of 1..100");
+  checkValue(histogramPercentile(&hist, 0), 1, "p0 of 1..100");
+  checkValue(histogramPercentile(&hist, 100), 100, "p100 of 1..100");
+  check(hist.count == 100 && hist.min == 1 && hist.max == 100 && hist.sum == 5050, "count, min, max, sum of 1..100");
+
+  /* the exact buckets: 0 1 2 3, p50 is the second value */
+  histogramReset(&hist);
+  for (uint32_t v = 0; v < 4; v++) histogramRecord(&hist, v);
+  checkValue(histogramPercentile(&hist, 50), 1, "p50 of 0..3");
+  checkValue(histogramPercentile(&hist, 99), 3, "p99 of 0..3");
+
+  /* one value ten times: every percentile is that value, not its bucket's 1023 */
+  histogramReset(&hist);
+  for (int i = 0; i < 10; i++) histogramRecord(&hist, 1000);
+  checkValue(histogramPercentile(&hist, 50), 1000, "p50 of 1000 x 10");
+  checkValue(histogramPercentile(&hist, 99), 1000, "p99 of 1000 x 10");
+
+  /* 90 fast uploads of 10 ms and 10 slow ones of 5 s: p50, p90 in 10..11, p99 in 4096..5119 */
+  histogramReset(&hist);
+  for (int i = 0; i < 90; i++) histogramRecord(&hist, 10);
+  for (int i = 0; i < 10; i++) histogramRecord(&hist, 5000);
+  checkValue(histogramPercentile(&hist, 50), 11, "p50 of 90 x 10 + 10 x 5000");
+  checkValue(histogramPercentile(&hist, 90), 11, "p90 of 90 x 10 + 10 x 5000");
+  checkValue(histogramPercentile(&hist, 91), 5000, "p91 of 90 x 10 + 10 x 5000");
+  checkValue(histogramPercentile(&hist, 99), 5000, "p99 of 90 x 10 + 10 x 5000");
+
+  /* beyond the last bucket: clamped there, the percentile is still the max */
+  histogramReset(&hist);
+  histogramRecord(&hist, 500000);
+  checkValue(histogramPercentile(&hist, 50), 500000, "p50 of one value beyond the last bucket");
+
+  /* random latencies against the exact percentile of the sorted values */
+  srand(7);
+  static uint32_t values[5000];
+  bool bounded = true;
+  for (int round = 0; round < 50; round++) {
+    size_t n = 1 + rand() % 5000;
+    histogramReset(&hist);
+    for (size_t i = 0; i < n; i++) {
+      values[i] = (uint32_t)(rand() % 2 ? rand() % 200 : rand() % 20000);
+      histogramRecord(&hist, values[i]);
+    }
+    std::sort(values, values + n);
+
+    const float PS[] = { 50, 90, 99 };
+    for (float p : PS) {
+      uint32_t rank = (uint32_t)((p / 100.0f) * n + 0.5f);
+      if (rank < 1) rank = 1;
+      if (rank > n) rank = n;
+      uint32_t exact = values[rank - 1];
+      uint32_t got = histogramPercentile(&hist, p);
+      if (got < exact || (exact >= HISTOGRAM_SUB_BUCKETS && got > exact + exact / 4 + 1)) {
+        printf("  p%.0f of %zu random values: %lu, exact %lu\n", p, n, (unsigned long)got, (unsigned long)exact);
+        bounded = false;
+      }
+    }
+  }
+  check(bounded, "random percentiles within one bucket above the exact value");
+}
+
+/*
+  -----------------------------
+  ------ CONCURRENT USE -------
+  -----------------------------
+*/
+static volatile bool recording = true;
+static pthread_barrier_t start;   /* all three at once, or the first is done before the second starts */
+
+static void *recordThread(void *arg) {
+  metrics_stage_t stage = *(metrics_stage_t *)arg;
+  pthread_barrier_wait(&start);
+  for (uint32_t i = 0; i < CHECK_THREAD_RECORDS; i++) {
+    metricsRecordStage(stage, i % 3000);
+    metricsRecordStage(STAGE_UPLOAD, i % 700);
+    metricsCount(COUNTER_UPLOADS);
+    metricsCount(COUNTER_BYTES_SENT, 3);
+    metricsRecordResult(200);
+  }
+  return NULL;
+}
+
+static bool consistent(const histogram_t *hist) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) sum += hist->buckets[i];
+  return sum == hist->count;
+}
+
+static void *snapshotThread(void *arg) {
+  bool *torn = (bool *)arg;
+  static char json[METRICS_SNAPSHOT_MAX];
+  pthread_barrier_wait(&start);
+  while (recording) {
+    histogram_t hist;
+    metricsStage(STAGE_UPLOAD, &hist);
+    if (!consistent(&hist)) *torn = true;
+    if (metricsSnapshotJson(json, sizeof(json), 0) == 0) *torn = true;
+  }
+  return NULL;
+}
+
+/* the JSON counter after "name": */
+static unsigned long jsonCounter(const char *json, const char *name) {
+  char key[48];
+  snprintf(key, sizeof(key), "\"%s\":", name);
+  const char *p = strstr(json, key);
+  return p ? strtoul(p + strlen(key), NULL, 10) : 0;
+}
+
+static void checkConcurrent() {
+  metricsReset();
+
+  metrics_stage_t capture = STAGE_CAPTURE, header = STAGE_HEADER;
+  bool torn = false;
+  pthread_t a, b, reader;
+  pthread_barrier_init(&start, NULL, 3);
+  pthread_create(&reader, NULL, snapshotThread, &torn);
+  pthread_create(&a, NULL, recordThread, &capture);
+  pthread_create(&b, NULL, recordThread, &header);
+  pthread_join(a, NULL);
+  pthread_join(b, NULL);
+  recording = false;
+  pthread_join(reader, NULL);
+
+  histogram_t hist;
+  metricsStage(STAGE_UPLOAD, &hist);
+  checkValue(hist.count, 2 * CHECK_THREAD_RECORDS, "upload records from two threads");
+  check(consistent(&hist), "upload histogram count is the sum of its buckets");
+  metricsStage(STAGE_CAPTURE, &hist);
+  checkValue(hist.count, CHECK_THREAD_RECORDS, "capture records");
+  check(!torn, "no snapshot torn while recording");
+
+  static char json[METRICS_SNAPSHOT_MAX];
+  check(metricsSnapshotJson(json, sizeof(json), 0) > 0, "snapshot fits METRICS_SNAPSHOT_MAX");
+  checkValue(jsonCounter(json, "uploads"), 2 * CHECK_THREAD_RECORDS, "uploads counter");
+  checkValue(jsonCounter(json, "bytes_sent"), 6 * CHECK_THREAD_RECORDS, "bytes_sent counter");
+  checkValue(jsonCounter(json, "http_2xx"), 2 * CHECK_THREAD_RECORDS, "http_2xx counter");
+
+  metricsReset();
+  metricsStage(STAGE_UPLOAD, &hist);
+  checkValue(hist.count, 0, "upload records after reset");
+}
+
+int main() {
+  checkBuckets();
+  checkPercentiles();
+  checkConcurrent();
+
+  printf("%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
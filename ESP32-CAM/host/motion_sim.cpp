@@ -0,0 +1,234 @@
+#include "hal.h"
+#include "motion.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/*
+  Checks and benchmark for the change detection (motion.cpp) on recorded JPEGs, host only.
+  Needs the libjpeg decoder of hal_host.cpp (-DHIVEHIVE_HOST_JPEG -ljpeg).
+
+    ./motion-sim [dir]                    scenario checks on every JPEG in dir + timings
+    ./motion-sim <dir> <threshold>        replays the JPEGs of dir (sorted by name) as one
+                                          capture sequence and prints score and decision
+
+  dir defaults to ../circle_evaluation/input. The scenarios derive the frame sequences
+  from each recorded image: sensor noise, an exposure change, a small object moving
+  through the scene, a different scene, and a static scene with keepalive uploads.
+  They only change the thumbnail, which is what the gate sees on the device too.
+  Exit code 1 if a check fails.
+*/
+#define SIM_MAX_FILES 64
+#define SIM_THRESHOLD 20      /* per mille, as suggested in the README */
+#define SIM_INTERVAL_MS 300
+
+typedef struct {
+  char path[512];
+  camera_fb_t fb;
+} recorded_t;
+
+static recorded_t recorded[SIM_MAX_FILES];
+static size_t recorded_count = 0;
+
+static uint8_t thumbnail[MOTION_THUMB_MAX_W * MOTION_THUMB_MAX_H];
+static uint8_t scratch[MOTION_THUMB_MAX_W * MOTION_THUMB_MAX_H];
+static motion_t motion;
+
+static int comparePaths(const void *a, const void *b) {
+  return strcmp(((const recorded_t *)a)->path, ((const recorded_t *)b)->path);
+}
+
+static bool loadDirectory(const char *dir_path) {
+  DIR *dir = opendir(dir_path);
+  if (!dir) {
+    fprintf(stderr, "cannot open %s\n", dir_path);
+    return false;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL && recorded_count < SIM_MAX_FILES) {
+    const char *ext = strrchr(entry->d_name, '.');
+    if (!ext || (strcasecmp(ext, ".jpg") != 0 && strcasecmp(ext, ".jpeg") != 0)) continue;
+
+    recorded_t *rec = &recorded[recorded_count];
+    snprintf(rec->path, sizeof(rec->path), "%s/%s", dir_path, entry->d_name);
+    FILE *file = fopen(rec->path, "rb");
+    if (!file) continue;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    rec->fb.buf = (uint8_t *)malloc(size > 0 ? size : 1);
+    rec->fb.len = size > 0 ? fread(rec->fb.buf, 1, size, file) : 0;
+    fclose(file);
+    recorded_count++;
+  }
+  closedir(dir);
+  qsort(recorded, recorded_count, sizeof(recorded[0]), comparePaths);
+  return recorded_count > 0;
+}
+
+static double nowUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t rng = 4711;
+
+static int noise(int amplitude) {
+  rng = rng * 1103515245 + 12345;
+  return (int)((rng >> 8) % (2 * amplitude + 1)) - amplitude;
+}
+
+static uint8_t clampLuma(int value) {
+  return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+/* scratch = thumbnail + brightness + noise, with a dark square of side `square` at x0/y0 */
+static void derive(uint16_t w, uint16_t h, int brightness, int noise_amplitude, int square, int x0, int y0) {
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x++) {
+      size_t i = (size_t)y * MOTION_THUMB_MAX_W + x;
+      int value = thumbnail[i] + brightness + (noise_amplitude ? noise(noise_amplitude) : 0);
+      if (square && x >= x0 && x < x0 + square && y >= y0 && y < y0 + square) value = 20;
+      scratch[i] = clampLuma(value);
+    }
+  }
+}
+
+static int failures = 0;
+
+static void expect(const char *image, const char *scenario, uint32_t uploads, uint32_t min, uint32_t max) {
+  bool ok = uploads >= min && uploads <= max;
+  if (!ok) failures++;
+  printf("  %-4s %-44s uploads %3u (expected %u..%u)  %s\n", ok ? "ok" : "FAIL", scenario,
+         (unsigned)uploads, (unsigned)min, (unsigned)max, image);
+}
+
+/* runs frames derived from the thumbnail through the gate, returns the uploads */
+static uint32_t runFrames(uint16_t w, uint16_t h, int frames, int brightness, int noise_amplitude,
+                          bool moving_square, uint32_t *clock_ms) {
+  uint32_t uploads = 0;
+  int square = h / 4;  /* ~1/16 of a 4:3 image */
+  for (int i = 0; i < frames; i++) {
+    int x0 = moving_square ? (i * square / 2) % (w - square) : 0;
+    derive(w, h, brightness, noise_amplitude, moving_square ? square : 0, x0, h / 3);
+    if (motionCheck(&motion, scratch, w, h, MOTION_THUMB_MAX_W, *clock_ms)) uploads++;
+    *clock_ms += SIM_INTERVAL_MS;
+  }
+  return uploads;
+}
+
+/* -------------------------------- */
+/* ---------- SCENARIOS ---------- */
+/* -------------------------------- */
+static void checkImage(const recorded_t *rec, const recorded_t *other) {
+  const char *name = strrchr(rec->path, '/') ? strrchr(rec->path, '/') + 1 : rec->path;
+  uint16_t w, h;
+  if (!halJpegLuma(&rec->fb, thumbnail, MOTION_THUMB_MAX_W, MOTION_THUMB_MAX_H, &w, &h)) {
+    printf("  FAIL cannot decode %s\n", rec->path);
+    failures++;
+    return;
+  }
+  printf("%s: %ux%u thumbnail\n", name, (unsigned)w, (unsigned)h);
+
+  uint32_t clock_ms = 0;
+  motionInit(&motion, SIM_THRESHOLD, 0);
+
+  /* the first frame primes the background and is always uploaded */
+  expect(name, "static scene with sensor noise (+-6)", runFrames(w, h, 30, 0, 6, false, &clock_ms), 1, 1);
+
+  /* auto exposure moves in small steps; on a high-key scene a hard step clips and may count once */
+  uint32_t uploads = 0;
+  for (int b = 5; b <= 25; b += 5) uploads += runFrames(w, h, 2, b, 6, false, &clock_ms);
+  for (int b = 20; b >= 0; b -= 5) uploads += runFrames(w, h, 2, b, 6, false, &clock_ms);
+  expect(name, "exposure ramp +25 and back over 20 frames", uploads, 0, 0);
+  expect(name, "exposure step +25", runFrames(w, h, 10, 25, 6, false, &clock_ms), 0, 1);
+  expect(name, "exposure step back", runFrames(w, h, 10, 0, 6, false, &clock_ms), 0, 1);
+  expect(name, "object moving through the scene", runFrames(w, h, 20, 0, 6, true, &clock_ms), 20, 20);
+  /* the background takes over the final position within a few frames */
+  expect(name, "object stops", runFrames(w, h, 30, 0, 6, false, &clock_ms), 1, 10);
+
+  if (other) {
+    uint16_t ow, oh;
+    halJpegLuma(&other->fb, scratch, MOTION_THUMB_MAX_W, MOTION_THUMB_MAX_H, &ow, &oh);
+    motionInit(&motion, SIM_THRESHOLD, 0);
+    motionCheck(&motion, thumbnail, w, h, MOTION_THUMB_MAX_W, clock_ms);
+    bool changed = motionCheck(&motion, scratch, ow, oh, MOTION_THUMB_MAX_W, clock_ms + SIM_INTERVAL_MS);
+    expect(name, "switch to another recorded scene", changed ? 1 : 0, 1, 1);
+  }
+
+  /* keepalive every 3 s at one frame per 300 ms: every 10th frame */
+  motionInit(&motion, SIM_THRESHOLD, 3000);
+  clock_ms = 0;
+  expect(name, "static scene, keepalive 3 s, 100 frames", runFrames(w, h, 100, 0, 6, false, &clock_ms), 10, 10);
+}
+
+/* -------------------------------- */
+/* ---------- BENCHMARK ---------- */
+/* -------------------------------- */
+static void benchmark(const recorded_t *rec) {
+  const char *name = strrchr(rec->path, '/') ? strrchr(rec->path, '/') + 1 : rec->path;
+  const int rounds = 200;
+  uint16_t w = 0, h = 0;
+
+  double start = nowUs();
+  for (int i = 0; i < rounds; i++) {
+    halJpegLuma(&rec->fb, thumbnail, MOTION_THUMB_MAX_W, MOTION_THUMB_MAX_H, &w, &h);
+  }
+  double decode_us = (nowUs() - start) / rounds;
+
+  motionInit(&motion, SIM_THRESHOLD, 0);
+  derive(w, h, 0, 6, 0, 0, 0);
+  motionCheck(&motion, thumbnail, w, h, MOTION_THUMB_MAX_W, 0);
+  start = nowUs();
+  for (int i = 0; i < rounds * 10; i++) {
+    motionCheck(&motion, (i & 1) ? thumbnail : scratch, w, h, MOTION_THUMB_MAX_W, i);
+  }
+  double kernel_us = (nowUs() - start) / (rounds * 10);
+
+  printf("%-48s %7u B  %3ux%-3u  decode %8.1f us  gate %6.2f us\n", name, (unsigned)rec->fb.len,
+         (unsigned)w, (unsigned)h, decode_us, kernel_us);
+}
+
+/* -------------------------------- */
+/* ---------- REPLAY ---------- */
+/* -------------------------------- */
+static int replay(int threshold) {
+  motionInit(&motion, threshold, 0);
+  uint32_t uploads = 0;
+  for (size_t i = 0; i < recorded_count; i++) {
+    uint16_t w, h;
+    bool decoded = halJpegLuma(&recorded[i].fb, thumbnail, MOTION_THUMB_MAX_W, MOTION_THUMB_MAX_H, &w, &h);
+    bool upload = !decoded || motionCheck(&motion, thumbnail, w, h, MOTION_THUMB_MAX_W, i * SIM_INTERVAL_MS);
+    if (upload) uploads++;
+    printf("%4u  score %4u/1000  %-6s  %s\n", (unsigned)i, decoded ? (unsigned)motion.score : 1000,
+           upload ? "upload" : "skip", recorded[i].path);
+  }
+  printf("%u of %u frames uploaded at threshold %d\n", (unsigned)uploads, (unsigned)recorded_count, threshold);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const char *dir = argc > 1 ? argv[1] : "../circle_evaluation/input";
+  if (!loadDirectory(dir)) {
+    fprintf(stderr, "no JPEGs in %s\n", dir);
+    return 1;
+  }
+  if (argc > 2) {
+    return replay(atoi(argv[2]));
+  }
+
+  for (size_t i = 0; i < recorded_count; i++) {
+    checkImage(&recorded[i], recorded_count > 1 ? &recorded[(i + 1) % recorded_count] : NULL);
+  }
+  printf("\n");
+  for (size_t i = 0; i < recorded_count; i++) {
+    benchmark(&recorded[i]);
+  }
+
+  printf("\n%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,320 @@
+#include "config.h"
+#include "portal_handler.h"
+#include "portal_page.h"
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+
+/*
+  Writes, bytes and allocations per load of the configuration page, host only.
+
+    ./portal-bench [rounds]
+
+  "println" is the page as it used to be built: one client.println() per line, each a
+  String concatenated with the current values, and each println two transport writes
+  (the text, then "\r\n"), as Print::println() does. std::string stands in for the
+  Arduino String, both keep short strings inline.
+
+  "gzip + /settings" is what a browser fetches now: the compressed page from flash and
+  the JSON with the live values, both answered by the portal's request handler
+  (portal_handler.cpp) from a config.json in a temporary HIVEHIVE_FS_ROOT.
+  Exit code 1 if a load takes more than PORTAL_BENCH_WRITES_MAX writes or allocates.
+*/
+#define BENCH_ROUNDS_DEFAULT 1000
+#define PORTAL_BENCH_WRITES_MAX 4   /* page head + page, /settings */
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static double nowUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+typedef struct {
+  unsigned long writes;
+  unsigned long bytes;
+  size_t largest;
+} sink_t;
+
+static size_t countWrite(void *ctx, const uint8_t *data, size_t len) {
+  sink_t *sink = (sink_t *)ctx;
+  (void)data;
+  sink->writes++;
+  sink->bytes += len;
+  if (len > sink->largest) sink->largest = len;
+  return len;
+}
+
+/* a configured device, so every field has a value */
+static const std::string session = "5f3a9c21";
+static const std::string ssid = "hive-garden", password = "correct horse", upload_url = "http://192.168.4.20:5000/upload";
+static const std::string resolution = "UXGA", queue_policy = "drop_oldest";
+static const int interval = 300, vflip = 1, brightness = 0, saturation = 0, queue_depth = 2, frame_bytes = 0,
+                 upload_ms = 0, batch_size = 1, batch_timeout = 5000, ram_kb = 1024, spill = 0, motion = 0,
+                 keepalive = 300, chunked = 0;
+
+/*
+  -----------------------------
+  ---------- PRINTLN ----------
+  -----------------------------
+*/
+struct PrintClient {
+  sink_t *sink;
+  void println(const std::string &line) {
+    countWrite(sink, (const uint8_t *)line.data(), line.size());
+    countWrite(sink, (const uint8_t *)"\r\n", 2);
+  }
+  void println() { countWrite(sink, (const uint8_t *)"\r\n", 2); }
+};
+
+static std::string str(int value) { return std::to_string(value); }
+
+static std::string selected(const std::string &value, const char *option) {
+  return strcasecmp(value.c_str(), option) == 0 ? " selected" : "";
+}
+
+static void legacyPage(sink_t *sink) {
+  PrintClient client = { sink };
+
+  std::string uploadBase = upload_url, uploadEndpoint = "";
+  size_t lastSlash = uploadBase.rfind('/');
+  if (lastSlash != std::string::npos && lastSlash > 7) {
+    uploadEndpoint = uploadBase.substr(lastSlash + 1);
+    uploadBase = uploadBase.substr(0, lastSlash);
+  }
+
+  client.println("HTTP/1.1 200 OK");
+  client.println("Content-type:text/html");
+  client.println("Connection: close");
+  client.println();
+  client.println("<!DOCTYPE html><html><head>");
+  client.println("<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">");
+  client.println("<title>ESP32 Config</title>");
+  client.println(
+    "<style>"
+    "body{margin:0;padding:20px;font-family:Helvetica,Arial,sans-serif;background:#f5f5f5;}"
+    ".card{max-width:520px;margin:40px auto;background:#fff;border-radius:10px;"
+      "box-shadow:0 2px 8px rgba(0,0,0,0.12);padding:24px 26px;box-sizing:border-box;}"
+    "h1{margin-top:0;font-size:24px;text-align:center;}"
+    "h2{margin-top:24px;font-size:18px;border-bottom:1px solid #eee;padding-bottom:4px;}"
+    "label{display:block;margin-top:14px;font-weight:bold;font-size:14px;}"
+    "input,select{width:100%;padding:8px 10px;margin-top:6px;border-radius:6px;"
+      "border:1px solid #ccc;box-sizing:border-box;font-size:14px;}"
+    "input:focus,select:focus{outline:none;border-color:#1976d2;box-shadow:0 0 0 2px rgba(25,118,210,0.18);}"
+    "button{margin-top:22px;width:100%;padding:10px 0;font-size:16px;border:none;"
+      "border-radius:999px;background:#1976d2;color:#fff;cursor:pointer;font-weight:bold;}"
+    "button:hover{background:#1458a3;}"
+    ".message{padding:10px 12px;border-radius:6px;background:#e8f5e9;color:#1b5e20;"
+      "border:1px solid #c8e6c9;margin-top:10px;margin-bottom:10px;font-size:14px;}"
+    ".hint{font-size:12px;color:#777;margin-top:4px;}"
+    ".inline{display:flex;gap:8px;}"
+    ".inline > div{flex:1;}"
+    "</style>"
+  );
+  client.println("</head><body>");
+  client.println("<div class=\"card\">");
+  client.println("<h1>ESP32 Configuration</h1>");
+  client.println("<form action=\"/save\" method=\"POST\" autocomplete=\"off\">");
+  client.println("<input type=\"hidden\" name=\"session\" value=\"" + session + "\">");
+  client.println("<h2>Network</h2>");
+  client.println("<label for=\"ssid\">SSID</label>");
+  client.println("<input id=\"ssid\" type=\"text\" name=\"ssid\" value=\"" + ssid + "\">");
+  client.println("<label for=\"password\">Password</label>");
+  client.println("<input id=\"password\" type=\"password\" name=\"password\" value=\"" + password + "\">");
+  client.println("<div class=\"hint\">Password will be sent in the request body (not visible in the address bar).</div>");
+  client.println("<label for=\"upload_base\">Upload URL</label>");
+  client.println("<div class=\"inline\">");
+  client.println("<div>");
+  client.println("<input id=\"upload_base\" type=\"text\" name=\"upload_base\" "
+                 "placeholder=\"http://example.com\" value=\"" + uploadBase + "\">");
+  client.println("<div class=\"hint\">Base URL</div>");
+  client.println("</div>");
+  client.println("<div>");
+  client.println("<input id=\"upload_endpoint\" type=\"text\" name=\"upload_endpoint\" "
+                 "placeholder=\"upload\" value=\"" + uploadEndpoint + "\">");
+  client.println("<div class=\"hint\">Endpoint (path)</div>");
+  client.println("</div>");
+  client.println("</div>");
+  client.println("<div class=\"hint\">Server can combine these as "
+                 "<code>http://example.com/upload</code>.</div>");
+  client.println("<label for=\"chunked\">Chunked upload</label>");
+  client.println("<input id=\"chunked\" type=\"number\" name=\"chunked\" min=\"0\" max=\"1\" "
+                 "value=\"" + str(chunked) + "\">");
+  client.println("<div class=\"hint\">1 = send uploads with Transfer-Encoding: chunked instead of a Content-Length.</div>");
+  client.println("<h2>Camera</h2>");
+  client.println("<label for=\"interval\">Capture interval (ms)</label>");
+  client.println("<input id=\"interval\" type=\"number\" name=\"interval\" min=\"10\" "
+                 "value=\"" + str(interval) + "\">");
+  client.println("<label for=\"res\">Resolution</label>");
+  client.println("<select id=\"res\" name=\"res\">");
+  client.println("<option value=\"qvga\"" + selected(resolution, "qvga") + ">QVGA - 320 x 240</option>");
+  client.println("<option value=\"vga\""  + selected(resolution, "vga")  + ">VGA - 640 x 480</option>");
+  client.println("<option value=\"qxga\"" + selected(resolution, "qxga") + ">QXGA - 800 x 600</option>");
+  client.println("<option value=\"sxga\"" + selected(resolution, "sxga") + ">SXGA - 1280 x 1024</option>");
+  client.println("<option value=\"uxga\"" + selected(resolution, "uxga") + ">UXGA - 1600 x 1200</option>");
+  client.println("</select>");
+  client.println("<div class=\"hint\">Form will submit values like <code>qvga</code>, "
+                 "<code>vga</code>, <code>sxga</code>, etc.</div>");
+  client.println("<label for=\"vflip\">Vertical flip (0/1)</label>");
+  client.println("<input id=\"vflip\" type=\"number\" name=\"vflip\" min=\"0\" max=\"1\" "
+                 "value=\"" + str(vflip) + "\">");
+  client.println("<label for=\"bright\">Brightness</label>");
+  client.println("<input id=\"bright\" type=\"number\" name=\"bright\" "
+                 "value=\"" + str(brightness) + "\">");
+  client.println("<label for=\"sat\">Saturation</label>");
+  client.println("<input id=\"sat\" type=\"number\" name=\"sat\" "
+                 "value=\"" + str(saturation) + "\">");
+  client.println("<label for=\"qdepth\">Upload queue depth</label>");
+  client.println("<input id=\"qdepth\" type=\"number\" name=\"qdepth\" min=\"1\" max=\"4\" "
+                 "value=\"" + str(queue_depth) + "\">");
+  client.println("<div class=\"hint\">Frames buffered while an upload is in flight.</div>");
+  client.println("<label for=\"qpolicy\">When the queue is full</label>");
+  client.println("<select id=\"qpolicy\" name=\"qpolicy\">");
+  client.println("<option value=\"drop_oldest\"" + selected(queue_policy, "drop_oldest") + ">Drop oldest frame</option>");
+  client.println("<option value=\"block\""       + selected(queue_policy, "block")       + ">Wait for upload</option>");
+  client.println("</select>");
+  client.println("<label for=\"fbytes\">Max. bytes per frame</label>");
+  client.println("<input id=\"fbytes\" type=\"number\" name=\"fbytes\" min=\"0\" "
+                 "value=\"" + str(frame_bytes) + "\">");
+  client.println("<label for=\"fms\">Max. upload time per frame (ms)</label>");
+  client.println("<input id=\"fms\" type=\"number\" name=\"fms\" min=\"0\" "
+                 "value=\"" + str(upload_ms) + "\">");
+  client.println("<div class=\"hint\">0 = no limit. With a limit the JPEG quality, and if needed the resolution, is lowered on slow links.</div>");
+  client.println("<label for=\"bsize\">Frames per upload</label>");
+  client.println("<input id=\"bsize\" type=\"number\" name=\"bsize\" min=\"1\" max=\"8\" "
+                 "value=\"" + str(batch_size) + "\">");
+  client.println("<div class=\"hint\">More than 1 sends several frames in one request (time-lapse). Each frame needs its own camera buffer in PSRAM.</div>");
+  client.println("<label for=\"btime\">Max. wait for a full batch (ms)</label>");
+  client.println("<input id=\"btime\" type=\"number\" name=\"btime\" min=\"0\" "
+                 "value=\"" + str(batch_timeout) + "\">");
+  client.println("<label for=\"sram\">Offline buffer (KB of PSRAM)</label>");
+  client.println("<input id=\"sram\" type=\"number\" name=\"sram\" min=\"0\" "
+                 "value=\"" + str(ram_kb) + "\">");
+  client.println("<div class=\"hint\">Frames that could not be uploaded are kept here and sent newest first once the server is reachable again.</div>");
+  client.println("<label for=\"sspill\">Spill offline buffer to flash</label>");
+  client.println("<input id=\"sspill\" type=\"number\" name=\"sspill\" min=\"0\" max=\"1\" "
+                 "value=\"" + str(spill) + "\">");
+  client.println("<label for=\"mthr\">Motion threshold (per mille of the image)</label>");
+  client.println("<input id=\"mthr\" type=\"number\" name=\"mthr\" min=\"0\" max=\"1000\" "
+                 "value=\"" + str(motion) + "\">");
+  client.println("<div class=\"hint\">0 = upload every frame. Otherwise frames are only uploaded when at least this much of the image changed.</div>");
+  client.println("<label for=\"mkeep\">Upload an unchanged frame every (s)</label>");
+  client.println("<input id=\"mkeep\" type=\"number\" name=\"mkeep\" min=\"0\" "
+                 "value=\"" + str(keepalive) + "\">");
+  client.println("<button type=\"submit\">Save configuration</button>");
+  client.println("</form>");
+  client.println("</div>");
+  client.println("</body></html>");
+  client.println();
+}
+
+/*
+  -----------------------------
+  ------ GZIP + SETTINGS ------
+  -----------------------------
+*/
+static portal_request_t page_request, settings_request;
+
+static void parseRequest(portal_request_t *req, const char *text) {
+  portalRequestInit(req);
+  portalRequestFeed(req, (const uint8_t *)text, strlen(text));
+}
+
+static char root[] = "/tmp/portal-bench-XXXXXX";
+static bool root_made = false;
+
+/* stores the same configuration the println page shows */
+static bool storeConfig() {
+  if (!mkdtemp(root)) {
+    perror("mkdtemp");
+    return false;
+  }
+  root_made = true;
+  setenv("HIVEHIVE_FS_ROOT", root, 1);
+
+  static esp_config_t config;
+  static char file[CONFIG_FILE_MAX];
+  configDefaults(&config);
+  configFieldSet(&config, configFormField("ssid"), ssid.c_str());
+  configFieldSet(&config, configFormField("password"), password.c_str());
+  configFieldSet(&config, configFormField("upload_url"), upload_url.c_str());
+  configFieldSet(&config, configFormField("interval"), str(interval).c_str());
+  configFieldSet(&config, configFormField("vflip"), str(vflip).c_str());
+  configFieldSet(&config, configFormField("mkeep"), str(keepalive).c_str());
+  return configSaveFile(PORTAL_CONFIG_PATH, &config, file, sizeof(file));
+}
+
+/* config.json and the directory it was stored in */
+static void removeConfig() {
+  if (!root_made) return;
+  char path[sizeof(root) + sizeof(PORTAL_CONFIG_PATH)];
+  snprintf(path, sizeof(path), "%s%s", root, PORTAL_CONFIG_PATH);
+  unlink(path);
+  if (rmdir(root) != 0) {
+    printf("could not remove %s\n", root);
+  }
+}
+
+static void currentPage(sink_t *sink) {
+  portalHandleRequest(&page_request, countWrite, sink);
+  portalHandleRequest(&settings_request, countWrite, sink);
+}
+
+/* prints one row; returns the writes and allocations per load */
+static void run(const char *label, void (*page)(sink_t *), int rounds,
+                unsigned long *writes, unsigned long *allocs) {
+  sink_t sink = {};
+  unsigned long before = allocations;
+  double start = nowUs();
+  for (int i = 0; i < rounds; i++) page(&sink);
+  double us = (nowUs() - start) / rounds;
+
+  *writes = sink.writes / rounds;
+  *allocs = (allocations - before) / rounds;
+  printf("%-18s %8lu %10lu %10zu %8lu %10.2f\n", label, *writes, sink.bytes / rounds,
+         sink.largest, *allocs, us);
+}
+
+int main(int argc, char **argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : BENCH_ROUNDS_DEFAULT;
+  if (rounds < 1) rounds = 1;
+
+  size_t html_len;
+  size_t gz_len = portalPageSize(&html_len);
+  printf("page: %zu bytes HTML, %zu bytes gzip in flash; %d rounds\n\n", html_len, gz_len, rounds);
+
+  if (!storeConfig()) {
+    fprintf(stderr, "cannot store config.json\n");
+    removeConfig();
+    return 1;
+  }
+  portalBegin(session.c_str());
+  parseRequest(&page_request, "GET / HTTP/1.1\r\nHost: 192.168.4.1\r\nAccept-Encoding: gzip\r\n\r\n");
+  parseRequest(&settings_request, "GET /settings HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n");
+
+  unsigned long writes, allocs;
+  printf("%-18s %8s %10s %10s %8s %10s\n", "per page load", "writes", "bytes", "largest", "allocs", "us");
+  run("println", legacyPage, rounds, &writes, &allocs);
+  run("gzip + /settings", currentPage, rounds, &writes, &allocs);
+  removeConfig();
+
+  bool ok = writes <= PORTAL_BENCH_WRITES_MAX && allocs == 0;
+  if (!ok) {
+    printf("FAILED: expected at most %d writes and no allocations per load\n", PORTAL_BENCH_WRITES_MAX);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,343 @@
+#include "portal_request.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Checks and fuzzer for the configuration portal's request parser (portal_request.cpp), host only.
+
+    ./portal-fuzz [iterations] [seed]     fixed checks, then random requests, exit code 1 on failure
+
+  The checks cover the requests a browser sends (page, form POST, legacy GET /save?...),
+  every error status and the form decoding, each one fed in one piece, byte by byte and
+  split at every position. The fuzzer then mutates valid requests (flipped, inserted and
+  dropped bytes, cut off, oversized fields) and feeds them in random pieces, checking that
+  the result does not depend on the split and that every buffer stays NUL-terminated
+  within its bounds. Best built with -fsanitize=address,undefined.
+
+  With -DHIVEHIVE_LIBFUZZER (clang -fsanitize=fuzzer) the same invariants run as a
+  libFuzzer target instead of main().
+*/
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static bool sameResult(const portal_request_t *a, const portal_request_t *b) {
+  return a->state == b->state && a->error == b->error && strcmp(a->method, b->method) == 0 &&
+         strcmp(a->path, b->path) == 0 && a->form_len == b->form_len &&
+         memcmp(a->form, b->form, a->form_len) == 0 && a->content_length == b->content_length &&
+         strcmp(a->authorization, b->authorization) == 0;
+}
+
+/* bounds and consistency every parser state has to keep */
+static bool invariantsHold(const portal_request_t *req) {
+  if (req->form_len >= PORTAL_FORM_MAX || req->form[req->form_len] != '\0') return false;
+  if (strnlen(req->method, PORTAL_METHOD_MAX) >= PORTAL_METHOD_MAX) return false;
+  if (strnlen(req->path, PORTAL_PATH_MAX) >= PORTAL_PATH_MAX) return false;
+  if (strnlen(req->authorization, PORTAL_AUTH_MAX) >= PORTAL_AUTH_MAX) return false;
+  if (req->line_len >= PORTAL_LINE_MAX) return false;
+  bool known_error = req->error == 400 || req->error == 413 || req->error == 414 ||
+                     req->error == 431 || req->error == 501;
+  return req->state == PORTAL_PARSE_ERROR ? known_error : req->error == 0;
+}
+
+/*
+  Feeds data in pieces of the given sizes (cycled, 0 = rest). Returns the bytes consumed;
+  false in ok if the parser broke a rule on the way.
+*/
+static size_t feedSplit(portal_request_t *req, const uint8_t *data, size_t len, const size_t *pieces,
+                        size_t piece_count, bool *ok) {
+  portalRequestInit(req);
+  size_t pos = 0;
+  for (size_t i = 0; pos < len; i++) {
+    size_t piece = piece_count ? pieces[i % piece_count] : 0;
+    if (piece == 0 || piece > len - pos) piece = len - pos;
+
+    bool done_before = portalRequestDone(req);
+    size_t used = portalRequestFeed(req, data + pos, piece);
+    if (used > piece || (done_before && used > 0) || (used < piece && !portalRequestDone(req)) ||
+        !invariantsHold(req)) {
+      *ok = false;
+      return pos + used;
+    }
+    pos += used;
+    if (used < piece) break;
+  }
+  return pos;
+}
+
+static size_t feedAll(portal_request_t *req, const char *text) {
+  bool ok = true;
+  size_t used = feedSplit(req, (const uint8_t *)text, strlen(text), NULL, 0, &ok);
+  check(ok, "invariants while feeding");
+  return used;
+}
+
+/* one piece, byte by byte and split in two at every position give the same result */
+static void checkSplits(const char *text, const char *what) {
+  static portal_request_t whole, split;
+  size_t len = strlen(text);
+  bool ok = true;
+  size_t used = feedSplit(&whole, (const uint8_t *)text, len, NULL, 0, &ok);
+
+  size_t one = 1;
+  ok = feedSplit(&split, (const uint8_t *)text, len, &one, 1, &ok) == used && ok && sameResult(&whole, &split);
+  for (size_t at = 1; at < len && ok; at++) {
+    size_t pieces[2] = { at, 0 };
+    ok = feedSplit(&split, (const uint8_t *)text, len, pieces, 2, &ok) == used && ok && sameResult(&whole, &split);
+  }
+  if (!ok) printf("split: %s\n", what);
+  check(ok, "result independent of the split");
+}
+
+static void expectError(const char *text, int status, const char *what) {
+  static portal_request_t req;
+  feedAll(&req, text);
+  if (!portalRequestFailed(&req) || req.error != status) {
+    printf("%s: state %d, error %d, expected %d\n", what, req.state, req.error, status);
+    failures++;
+  }
+  checkSplits(text, what);
+}
+
+/*
+  -----------------------------
+  ---------- CHECKS -----------
+  -----------------------------
+*/
+static char big[8192];
+
+static const char *repeat(const char *prefix, char c, size_t count, const char *suffix) {
+  size_t len = snprintf(big, sizeof(big), "%s", prefix);
+  while (count-- > 0 && len < sizeof(big) - 1) big[len++] = c;
+  snprintf(big + len, sizeof(big) - len, "%s", suffix);
+  return big;
+}
+
+static void runChecks() {
+  static portal_request_t req;
+  char value[64];
+
+  /* the page */
+  const char *page = "GET / HTTP/1.1\r\nHost: 192.168.4.1\r\nUser-Agent: test\r\nAccept: */*\r\n\r\n";
+  check(feedAll(&req, page) == strlen(page) && req.state == PORTAL_PARSE_DONE, "GET / parsed");
+  check(strcmp(req.method, "GET") == 0 && strcmp(req.path, "/") == 0 && req.form_len == 0, "GET / fields");
+  checkSplits(page, "GET /");
+
+  /* the form */
+  const char *post = "POST /save HTTP/1.1\r\nHost: 192.168.4.1\r\n"
+                     "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: 47\r\n\r\n"
+                     "session=1a2b&ssid=My+Net&password=p%40ss%26word";
+  check(feedAll(&req, post) == strlen(post) && req.state == PORTAL_PARSE_DONE, "POST /save parsed");
+  check(strcmp(req.path, "/save") == 0 && req.form_len == 47, "POST /save fields");
+  check(portalFormValue(req.form, "ssid", value, sizeof(value)) && strcmp(value, "My Net") == 0, "form: + is a space");
+  check(portalFormValue(req.form, "password", value, sizeof(value)) && strcmp(value, "p@ss&word") == 0, "form: %xx decoded");
+  checkSplits(post, "POST /save");
+
+  /* a control endpoint request */
+  const char *control = "POST /camera HTTP/1.1\r\nauthorization:  Bearer s3cret\r\nContent-Length: 16\r\n\r\n"
+                        "{\"brightness\":2}";
+  check(feedAll(&req, control) == strlen(control) && req.state == PORTAL_PARSE_DONE, "POST /camera parsed");
+  check(strcmp(req.authorization, "Bearer s3cret") == 0 && strcmp(req.form, "{\"brightness\":2}") == 0,
+        "Authorization header and JSON body");
+  check(feedAll(&req, repeat("GET / HTTP/1.1\r\nAuthorization: ", 'a', PORTAL_AUTH_MAX * 2, "\r\n\r\n")) > 0 &&
+        req.state == PORTAL_PARSE_DONE && strlen(req.authorization) == PORTAL_AUTH_MAX - 1, "long Authorization cut off");
+  checkSplits(control, "POST /camera");
+
+  /* a second request on the same connection is left alone */
+  static char pipelined[512];
+  snprintf(pipelined, sizeof(pipelined), "%sGET / HTTP/1.1\r\n\r\n", post);
+  check(feedAll(&req, pipelined) == strlen(post), "bytes after the body are not consumed");
+
+  /* body still on its way */
+  const char *partial = "POST /save HTTP/1.1\r\nContent-Length: 10\r\n\r\nssid=";
+  check(feedAll(&req, partial) == strlen(partial) && req.state == PORTAL_PARSE_BODY, "incomplete body is pending");
+
+  /* legacy GET form and POST with a query */
+  check(feedAll(&req, "GET /save?ssid=a&session=b HTTP/1.0\r\n\r\n") > 0 && req.state == PORTAL_PARSE_DONE &&
+        strcmp(req.path, "/save") == 0 && strcmp(req.form, "ssid=a&session=b") == 0, "GET query is the form");
+  check(feedAll(&req, "POST /save?ssid=a HTTP/1.1\r\nContent-Length: 6\r\n\r\nssid=b") > 0 &&
+        strcmp(req.form, "ssid=b") == 0, "POST body replaces the query");
+  check(feedAll(&req, "\r\nGET / HTTP/1.1\r\n\r\n") > 0 && req.state == PORTAL_PARSE_DONE, "empty line before the request");
+  check(feedAll(&req, "POST /save HTTP/1.1\r\n\r\n") > 0 && req.state == PORTAL_PARSE_DONE && req.form_len == 0,
+        "POST without body");
+  const char *get_body = "GET / HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello";
+  check(feedAll(&req, get_body) == strlen(get_body) - 5 && req.state == PORTAL_PARSE_DONE, "GET body is not read");
+
+  /* errors */
+  expectError("BREW / HTTP/1.1\r\n\r\n", 501, "unknown method");
+  expectError("PROPFIND / HTTP/1.1\r\n\r\n", 501, "method longer than any known one");
+  expectError("get / HTTP/1.1\r\n\r\n", 400, "lower case method");
+  expectError(" / HTTP/1.1\r\n\r\n", 400, "no method");
+  expectError("GET http://x/ HTTP/1.1\r\n\r\n", 400, "absolute URI");
+  expectError("GET /\r\n\r\n", 400, "HTTP/0.9 request line");
+  expectError("GET / HTTP/2.0\r\n\r\n", 400, "HTTP/2 version");
+  expectError("GET / HTTP/1.1 x\r\n\r\n", 400, "trailing garbage after the version");
+  expectError(repeat("GET /", 'a', PORTAL_PATH_MAX, " HTTP/1.1\r\n\r\n"), 414, "long path");
+  expectError(repeat("GET /save?", 'a', PORTAL_FORM_MAX, " HTTP/1.1\r\n\r\n"), 414, "long query");
+  expectError("POST /save HTTP/1.1\r\nContent-Length: 1536\r\n\r\n", 413, "body one byte too large");
+  expectError("POST /save HTTP/1.1\r\nContent-Length: 99999999999\r\n\r\n", 400, "huge Content-Length");
+  expectError("POST /save HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n", 400, "Content-Length with garbage");
+  expectError("POST /save HTTP/1.1\r\nContent-Length: -1\r\n\r\n", 400, "negative Content-Length");
+  expectError("POST /save HTTP/1.1\r\nContent-Length: 4\r\nContent-Length: 5\r\n\r\n", 400, "conflicting Content-Length");
+  expectError("POST /save HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n4\r\nssid\r\n0\r\n\r\n", 501, "chunked body");
+  expectError(repeat("GET / HTTP/1.1\r\nX: ", 'a', PORTAL_HEADER_BYTES_MAX, "\r\n\r\n"), 431, "long header");
+  static char many[4096];
+  size_t len = snprintf(many, sizeof(many), "GET / HTTP/1.1\r\n");
+  for (int i = 0; i <= PORTAL_HEADERS_MAX; i++) len += snprintf(many + len, sizeof(many) - len, "X-%d: 1\r\n", i);
+  snprintf(many + len, sizeof(many) - len, "\r\n");
+  expectError(many, 431, "too many headers");
+
+  /* exactly at the limits */
+  check(feedAll(&req, repeat("GET /", 'a', PORTAL_PATH_MAX - 2, " HTTP/1.1\r\n\r\n")) > 0 &&
+        req.state == PORTAL_PARSE_DONE, "longest path");
+  check(feedAll(&req, repeat("GET /?", 'a', PORTAL_FORM_MAX - 1, " HTTP/1.1\r\n\r\n")) > 0 &&
+        req.state == PORTAL_PARSE_DONE && req.form_len == PORTAL_FORM_MAX - 1, "longest query");
+  check(feedAll(&req, repeat("POST / HTTP/1.1\r\nContent-Length: 1535\r\n\r\n", 'a', PORTAL_FORM_MAX - 1, "")) > 0 &&
+        req.state == PORTAL_PARSE_DONE && req.form_len == PORTAL_FORM_MAX - 1, "largest body");
+
+  /* form values */
+  check(portalFormValue("ssid=x&sid=y", "sid", value, sizeof(value)) && strcmp(value, "y") == 0, "form: whole names only");
+  check(portalFormValue("ssid=x&sid=y", "ssid", value, sizeof(value)) && strcmp(value, "x") == 0, "form: first field");
+  check(!portalFormValue("ssid=x", "password", value, sizeof(value)) && value[0] == '\0', "form: missing field");
+  check(portalFormValue("a=1&flag&b=2", "flag", value, sizeof(value)) && value[0] == '\0', "form: field without =");
+  check(portalFormValue("a=%zz%4", "a", value, sizeof(value)) && strcmp(value, "%zz%4") == 0, "form: broken escapes kept");
+  check(portalFormValue("a=x%00y", "a", value, sizeof(value)) && strcmp(value, "xy") == 0, "form: %00 dropped");
+  check(portalFormValue("a=abcdef", "a", value, 4) && strcmp(value, "abc") == 0, "form: cut off at cap");
+  check(!portalFormValue("", "a", value, sizeof(value)), "form: empty form");
+}
+
+/*
+  -----------------------------
+  ---------- FUZZER -----------
+  -----------------------------
+*/
+static const char *NAMES[] = { "session", "ssid", "password", "upload_base", "interval", "res", "a", "" };
+
+/* bounds that hold for any input, split any way; false on a violation */
+static bool fuzzOne(const uint8_t *data, size_t len, const size_t *pieces, size_t piece_count) {
+  static portal_request_t whole, split;
+  bool ok = true;
+  size_t used = feedSplit(&whole, data, len, NULL, 0, &ok);
+  if (feedSplit(&split, data, len, pieces, piece_count, &ok) != used || !sameResult(&whole, &split)) {
+    ok = false;
+  }
+
+  char value[64];
+  for (size_t n = 0; n < sizeof(NAMES) / sizeof(NAMES[0]); n++) {
+    size_t cap = 1 + (len + n) % sizeof(value);
+    portalFormValue(whole.form, NAMES[n], value, cap);
+    if (strnlen(value, cap) >= cap) ok = false;
+  }
+  return ok;
+}
+
+#ifdef HIVEHIVE_LIBFUZZER
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  runChecks();
+  if (failures) abort();
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  /* the first byte picks the piece size of the split feed */
+  if (size == 0) return 0;
+  size_t piece = data[0] % 64;
+  if (!fuzzOne(data + 1, size - 1, &piece, 1)) abort();
+  return 0;
+}
+#else
+static const char *SEEDS[] = {
+  "GET / HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n",
+  "GET /save?session=1a2b&ssid=My+Net&password=p%40ss HTTP/1.0\r\n\r\n",
+  "POST /save HTTP/1.1\r\nHost: 192.168.4.1\r\nContent-Length: 37\r\n\r\nsession=1a2b&ssid=net&password=secret",
+  "HEAD /favicon.ico HTTP/1.1\r\nConnection: keep-alive\r\n\r\n",
+  "POST /save HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+};
+
+static uint8_t input[PORTAL_FORM_MAX * 3];
+
+static size_t mutate(uint8_t *data, size_t len, size_t cap) {
+  int edits = 1 + rand() % 8;
+  for (int e = 0; e < edits; e++) {
+    size_t at = len ? rand() % len : 0;
+    switch (rand() % 6) {
+      case 0:   /* flip a byte */
+        if (len) data[at] ^= (uint8_t)(1 << (rand() % 8));
+        break;
+      case 1:   /* random byte */
+        if (len) data[at] = (uint8_t)rand();
+        break;
+      case 2:   /* insert structure */
+        if (len + 2 < cap) {
+          const char *tokens[] = { "\r\n", " ", "?", "&", "=", "%", ":" };
+          const char *token = tokens[rand() % 7];
+          size_t n = strlen(token);
+          memmove(data + at + n, data + at, len - at);
+          memcpy(data + at, token, n);
+          len += n;
+        }
+        break;
+      case 3:   /* drop bytes */
+        if (len) {
+          size_t n = 1 + rand() % 4;
+          if (n > len - at) n = len - at;
+          memmove(data + at, data + at + n, len - at - n);
+          len -= n;
+        }
+        break;
+      case 4:   /* cut off */
+        len = at;
+        break;
+      case 5: { /* blow a field up past its limit */
+        size_t n = 1 + rand() % (PORTAL_FORM_MAX + 64);
+        if (len + n > cap) n = cap - len;
+        memmove(data + at + n, data + at, len - at);
+        memset(data + at, "a%= \r\n"[rand() % 6], n);
+        len += n;
+        break;
+      }
+    }
+  }
+  return len;
+}
+
+static void runFuzzer(long iterations) {
+  long bad = 0;
+  for (long i = 0; i < iterations; i++) {
+    const char *seed = SEEDS[rand() % (sizeof(SEEDS) / sizeof(SEEDS[0]))];
+    size_t len = strlen(seed);
+    memcpy(input, seed, len);
+    len = mutate(input, len, sizeof(input));
+
+    size_t pieces[4];
+    for (int p = 0; p < 4; p++) pieces[p] = rand() % 40;
+    if (!fuzzOne(input, len, pieces, 1 + rand() % 4)) {
+      if (bad++ < 5) {
+        printf("fuzz: invariant broken by %u byte input: ", (unsigned)len);
+        for (size_t b = 0; b < len && b < 120; b++) {
+          putchar(input[b] >= ' ' && input[b] < 0x7f ? input[b] : '.');
+        }
+        putchar('\n');
+      }
+    }
+  }
+  printf("fuzz: %ld inputs, %ld broke an invariant\n", iterations, bad);
+  failures += bad > 0;
+}
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : 200000;
+  srand(argc > 2 ? atoi(argv[2]) : 1);
+
+  runChecks();
+  runFuzzer(iterations);
+  printf(failures ? "%d checks failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}
+#endif
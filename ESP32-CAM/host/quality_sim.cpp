@@ -0,0 +1,172 @@
+#include "quality_control.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+  Simulation harness for the JPEG quality controller (quality_control.cpp), host only.
+
+    ./quality-sim                                        synthetic scene + link, see simulate()
+    ./quality-sim <trace.csv> <max_bytes> [max_upload_ms] [best_quality] [framesize]
+
+  Trace lines are "len[,upload_ms]": the frame sizes (and upload times) recorded at
+  best_quality (default 10) and the given framesize (default UXGA = 13, the framesize_t value).
+  When the controller picks another setting, the recorded size is scaled with
+  sizeModel(); the recorded upload time is scaled along with it.
+  The synthetic run checks the share of frames over budget, the number of changes
+  and the return to the configured setting; exit code 1 if one fails.
+*/
+
+/*
+  Rough OV2640 behaviour: bytes ~ pixels, and ~ 1 / (quality + 8) over the useful range
+  (q 10 -> 40 shrinks a frame to about a third).
+*/
+static double sizeModel(const quality_setting_t *setting, int quality0, framesize_t framesize0) {
+  double by_quality = (quality0 + 8.0) / (setting->quality + 8.0);
+  double by_pixels = (double)framesizePixels(setting->framesize) / framesizePixels(framesize0);
+  return by_quality * by_pixels;
+}
+
+typedef struct {
+  uint32_t frames;
+  uint32_t over_budget;
+  uint32_t changes;
+  double bytes;
+} sim_stats_t;
+
+static int failures = 0;
+
+static void check(bool ok, const char *phase, const char *what) {
+  if (!ok) {
+    failures++;
+    printf("  FAIL %s: %s\n", phase, what);
+  }
+}
+
+static void report(const char *name, const sim_stats_t *stats, const quality_control_t *ctl) {
+  printf("%-18s frames %5u  avg %7.0f B  over budget %5.1f%%  changes %4u  -> quality %2d framesize %2d  budget %u B\n",
+         name, (unsigned)stats->frames, stats->frames ? stats->bytes / stats->frames : 0.0,
+         stats->frames ? stats->over_budget * 100.0 / stats->frames : 0.0, (unsigned)stats->changes,
+         ctl->current.quality, (int)ctl->current.framesize, (unsigned)qualityBudget(ctl));
+}
+
+/*
+  One frame through the controller. The setting only applies to frames captured after
+  the change; the pipeline still holds QUALITY_SETTLE_FRAMES - 1 frames with the old one.
+*/
+static quality_setting_t pipeline[QUALITY_SETTLE_FRAMES];
+
+static void step(quality_control_t *ctl, sim_stats_t *stats, double base_len, double link_bps,
+                 int quality0, framesize_t framesize0) {
+  quality_setting_t used = pipeline[0];
+  for (int i = 0; i < QUALITY_SETTLE_FRAMES - 1; i++) pipeline[i] = pipeline[i + 1];
+  pipeline[QUALITY_SETTLE_FRAMES - 1] = ctl->current;
+
+  size_t len = (size_t)(base_len * sizeModel(&used, quality0, framesize0));
+  uint32_t upload_ms = link_bps > 0 ? (uint32_t)(len * 1000.0 / link_bps) : 0;
+
+  uint32_t budget = qualityBudget(ctl);
+  stats->frames++;
+  stats->bytes += len;
+  if (budget && len > budget) stats->over_budget++;
+
+  if (qualityOnFrame(ctl, len)) stats->changes++;
+  qualityOnUpload(ctl, len, upload_ms);
+}
+
+static void resetPipeline(const quality_control_t *ctl) {
+  for (int i = 0; i < QUALITY_SETTLE_FRAMES; i++) pipeline[i] = ctl->current;
+}
+
+/* -------------------------------- */
+/* ---------- TRACE REPLAY ---------- */
+/* -------------------------------- */
+static int replayTrace(int argc, char **argv) {
+  FILE *file = fopen(argv[1], "r");
+  if (!file) {
+    fprintf(stderr, "cannot open %s\n", argv[1]);
+    return 1;
+  }
+  uint32_t max_bytes = argc > 2 ? atoi(argv[2]) : 0;
+  uint32_t max_upload_ms = argc > 3 ? atoi(argv[3]) : 0;
+  int quality0 = argc > 4 ? atoi(argv[4]) : 10;
+  framesize_t framesize0 = argc > 5 ? (framesize_t)atoi(argv[5]) : FRAMESIZE_UXGA;
+
+  quality_control_t ctl;
+  qualityInit(&ctl, quality0, framesize0, max_bytes, max_upload_ms);
+  resetPipeline(&ctl);
+
+  sim_stats_t stats = {};
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    unsigned len = 0, upload_ms = 0;
+    if (line[0] == '#' || sscanf(line, "%u,%u", &len, &upload_ms) < 1) continue;
+    double link_bps = upload_ms ? len * 1000.0 / upload_ms : 0;
+    step(&ctl, &stats, len, link_bps, quality0, framesize0);
+  }
+  fclose(file);
+
+  report(argv[1], &stats, &ctl);
+  printf("downgrades %u, upgrades %u\n", (unsigned)ctl.downgrades, (unsigned)ctl.upgrades);
+  return 0;
+}
+
+/* -------------------------------- */
+/* -------- SYNTHETIC RUN -------- */
+/* -------------------------------- */
+static uint32_t rng = 4711;
+
+static double random01() {
+  rng = rng * 1103515245 + 12345;
+  return ((rng >> 8) & 0xFFFF) / 65536.0;
+}
+
+/*
+  UXGA at quality 10, ~200 KB frames with slow scene changes and +-10% noise,
+  1 s upload budget over a link that degrades and recovers.
+*/
+static int simulate() {
+  typedef struct {
+    const char *name;
+    uint32_t frames;
+    double link_bps;
+  } phase_t;
+
+  const phase_t phases[] = {
+    { "good link",  300, 400000 },
+    { "weak link",  300,  60000 },
+    { "very weak",  300,  15000 },
+    { "recovered",  300, 400000 },
+  };
+
+  quality_control_t ctl;
+  qualityInit(&ctl, 10, FRAMESIZE_UXGA, 0, 1000);
+  resetPipeline(&ctl);
+
+  uint32_t frame = 0;
+  for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+    sim_stats_t stats = {};
+    for (uint32_t i = 0; i < phases[p].frames; i++, frame++) {
+      double scene = 1.0 + 0.25 * sin(frame / 50.0);
+      double noise = 0.9 + 0.2 * random01();
+      step(&ctl, &stats, 200000 * scene * noise, phases[p].link_bps, 10, FRAMESIZE_UXGA);
+    }
+    report(phases[p].name, &stats, &ctl);
+
+    check(stats.over_budget * 10 <= stats.frames, phases[p].name, "at most 10% of the frames over budget");
+    check(stats.changes * 10 <= stats.frames, phases[p].name, "no more than one change per 10 frames");
+  }
+  printf("downgrades %u, upgrades %u\n", (unsigned)ctl.downgrades, (unsigned)ctl.upgrades);
+
+  /* back on a good link the controller returns to the configured setting */
+  check(ctl.current.quality == 10 && ctl.current.framesize == FRAMESIZE_UXGA, "recovered", "back at quality 10, UXGA");
+  printf("%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    return replayTrace(argc, argv);
+  }
+  return simulate();
+}
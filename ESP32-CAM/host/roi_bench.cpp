@@ -0,0 +1,424 @@
+#include "hal.h"
+#include "roi.h"
+#include <dirent.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <jpeglib.h>
+
+/*
+  Checks and benchmark for grayscale capture with a region of interest (roi.cpp), host only.
+  Needs libjpeg, for the encoder of hal_host.cpp (-DHIVEHIVE_HOST_JPEG -ljpeg) and to
+  turn the recorded JPEGs back into raw frames.
+
+    ./roi-bench [dir] [x y w h]
+
+  dir defaults to ../circle_evaluation/input; x y w h is an extra region in UXGA
+  pixels (CAMERA.ROI_LEFT/TOP/WIDTH/HEIGHT) next to the built-in ones.
+
+  Checks: roiFit() on the frame sizes of the camera and of the recorded images,
+  roiCrop() in place against a plain copy for random regions, and the grayscale
+  capture of hal_host.cpp end to end (size and offset of the frames it returns).
+
+  Benchmark: every image is decoded to gray twice, at its own size and resampled to
+  SVGA (the largest grayscale frame of the ESP32, esp_init.cpp). For each region the
+  in-place crop and the JPEG encode are timed, and the encoded size is compared with
+  the whole frame as color JPEG at the same quality, which is roughly what the
+  sensor sends today. libjpeg stands in for the ESP32's fmt2jpg(); its times are
+  not the ESP32's, but the bytes are close and both scale with the encoded pixels.
+  Exit code 1 if a check fails.
+*/
+#define BENCH_MAX_FILES 16
+#define BENCH_ROUNDS 20
+#define BENCH_SENSOR_QUALITY 10    /* the sensor's PSRAM default, esp_init.cpp */
+#define SVGA_W 800
+#define SVGA_H 600
+
+typedef struct {
+  char path[512];
+  uint8_t *jpeg;
+  size_t len;
+} recorded_t;
+
+static recorded_t recorded[BENCH_MAX_FILES];
+static size_t recorded_count = 0;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static double nowUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t rng = 4711;
+
+static uint32_t nextRandom() {
+  rng = rng * 1103515245u + 12345u;
+  return rng >> 8;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static double median(double *values, int count) {
+  qsort(values, count, sizeof(values[0]), compareDoubles);
+  return values[count / 2];
+}
+
+static int comparePaths(const void *a, const void *b) {
+  return strcmp(((const recorded_t *)a)->path, ((const recorded_t *)b)->path);
+}
+
+static bool loadDirectory(const char *dir_path) {
+  DIR *dir = opendir(dir_path);
+  if (!dir) {
+    fprintf(stderr, "cannot open %s\n", dir_path);
+    return false;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL && recorded_count < BENCH_MAX_FILES) {
+    const char *ext = strrchr(entry->d_name, '.');
+    if (!ext || (strcasecmp(ext, ".jpg") != 0 && strcasecmp(ext, ".jpeg") != 0)) continue;
+
+    recorded_t *rec = &recorded[recorded_count];
+    snprintf(rec->path, sizeof(rec->path), "%s/%s", dir_path, entry->d_name);
+    FILE *file = fopen(rec->path, "rb");
+    if (!file) continue;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    rec->jpeg = (uint8_t *)malloc(size > 0 ? size : 1);
+    rec->len = size > 0 ? fread(rec->jpeg, 1, size, file) : 0;
+    fclose(file);
+    recorded_count++;
+  }
+  closedir(dir);
+  qsort(recorded, recorded_count, sizeof(recorded[0]), comparePaths);
+  return recorded_count > 0;
+}
+
+/* -------------------------------- */
+/* ------------ LIBJPEG ----------- */
+/* -------------------------------- */
+typedef struct {
+  struct jpeg_error_mgr mgr;
+  jmp_buf escape;
+} bench_error_t;
+
+static void benchError(j_common_ptr cinfo) {
+  longjmp(((bench_error_t *)cinfo->err)->escape, 1);
+}
+
+/* 1 (gray) or 3 (RGB) bytes per pixel, malloc'd; NULL if the file cannot be decoded */
+static uint8_t *decode(const recorded_t *rec, int components, uint16_t *w, uint16_t *h) {
+  struct jpeg_decompress_struct cinfo;
+  bench_error_t error;
+  uint8_t *pixels = NULL;
+  cinfo.err = jpeg_std_error(&error.mgr);
+  error.mgr.error_exit = benchError;
+  if (setjmp(error.escape)) {
+    jpeg_destroy_decompress(&cinfo);
+    free(pixels);
+    return NULL;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, rec->jpeg, rec->len);
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+  *w = cinfo.output_width;
+  *h = cinfo.output_height;
+  size_t stride = (size_t)*w * components;
+  pixels = (uint8_t *)malloc(stride * *h);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW rows[1] = { pixels + (size_t)cinfo.output_scanline * stride };
+    jpeg_read_scanlines(&cinfo, rows, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return pixels;
+}
+
+/* the whole frame in color at quality, what the sensor would send; returns the bytes */
+static size_t encodedColorSize(const uint8_t *rgb, uint16_t w, uint16_t h, int quality) {
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr mgr;
+  unsigned char *out = NULL;
+  unsigned long out_len = 0;
+  cinfo.err = jpeg_std_error(&mgr);
+  jpeg_create_compress(&cinfo);
+  jpeg_mem_dest(&cinfo, &out, &out_len);
+  cinfo.image_width = w;
+  cinfo.image_height = h;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW rows[1] = { (JSAMPROW)rgb + (size_t)cinfo.next_scanline * w * 3 };
+    jpeg_write_scanlines(&cinfo, rows, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  free(out);
+  return out_len;
+}
+
+/* box filter to dst_w x dst_h; components bytes per pixel */
+static uint8_t *resample(const uint8_t *src, uint16_t src_w, uint16_t src_h, int components,
+                         uint16_t dst_w, uint16_t dst_h) {
+  uint8_t *dst = (uint8_t *)malloc((size_t)dst_w * dst_h * components);
+  for (uint32_t dy = 0; dy < dst_h; dy++) {
+    uint32_t y0 = dy * src_h / dst_h, y1 = (dy + 1) * src_h / dst_h;
+    if (y1 <= y0) y1 = y0 + 1;
+    for (uint32_t dx = 0; dx < dst_w; dx++) {
+      uint32_t x0 = dx * src_w / dst_w, x1 = (dx + 1) * src_w / dst_w;
+      if (x1 <= x0) x1 = x0 + 1;
+      for (int c = 0; c < components; c++) {
+        uint32_t sum = 0;
+        for (uint32_t y = y0; y < y1; y++) {
+          for (uint32_t x = x0; x < x1; x++) sum += src[((size_t)y * src_w + x) * components + c];
+        }
+        dst[((size_t)dy * dst_w + dx) * components + c] = sum / ((y1 - y0) * (x1 - x0));
+      }
+    }
+  }
+  return dst;
+}
+
+/* -------------------------------- */
+/* ------------ CHECKS ------------ */
+/* -------------------------------- */
+static bool sameRoi(const roi_t *a, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  return a->x == x && a->y == y && a->w == w && a->h == h;
+}
+
+static void checkFit() {
+  roi_t fit;
+  roi_t whole = { 0, 0, 0, 0 };
+  check(roiFit(&whole, SVGA_W, SVGA_H, &fit) && sameRoi(&fit, 0, 0, SVGA_W, SVGA_H), "no region is the whole frame");
+
+  roi_t full = { 0, 0, ROI_REFERENCE_WIDTH, ROI_REFERENCE_HEIGHT };
+  check(roiFit(&full, SVGA_W, SVGA_H, &fit) && sameRoi(&fit, 0, 0, SVGA_W, SVGA_H), "the reference frame is the whole frame");
+
+  /* UXGA -> SVGA halves everything; 400/2 = 200 and 600/2 = 300 are on the 8 pixel grid */
+  roi_t entrance = { 400, 600, 800, 400 };
+  check(roiFit(&entrance, SVGA_W, SVGA_H, &fit) && sameRoi(&fit, 200, 296, 400, 208), "UXGA region scaled to SVGA");
+  check(roiFit(&entrance, ROI_REFERENCE_WIDTH, ROI_REFERENCE_HEIGHT, &fit) && sameRoi(&fit, 400, 600, 800, 400),
+        "aligned region at UXGA is kept as it is");
+
+  /* widened, never narrowed: the configured pixels stay inside */
+  roi_t odd = { 13, 7, 101, 55 };
+  check(roiFit(&odd, ROI_REFERENCE_WIDTH, ROI_REFERENCE_HEIGHT, &fit) && sameRoi(&fit, 8, 0, 112, 64),
+        "region widened to whole 8x8 blocks");
+
+  roi_t edge = { 1500, 1100, 100, 100 };
+  check(roiFit(&edge, 1300, 1151, &fit) && fit.x % ROI_ALIGN == 0 && fit.y % ROI_ALIGN == 0 &&
+        fit.x + fit.w == 1300 && fit.y + fit.h == 1151, "region at the edge of an odd-sized frame ends at the frame");
+
+  roi_t tiny = { 1599, 1199, 1, 1 };
+  check(roiFit(&tiny, 320, 240, &fit) && fit.w > 0 && fit.h > 0 && fit.x + fit.w <= 320 && fit.y + fit.h <= 240,
+        "one pixel region keeps at least one block");
+  check(!roiFit(&entrance, 0, 0, &fit), "no frame, no region");
+
+  /* every region that fits the reference stays inside every frame size */
+  static const uint16_t sizes[][2] = { { 320, 240 }, { 640, 480 }, { 800, 600 }, { 1300, 1151 }, { 1500, 1500 } };
+  for (int i = 0; i < 20000; i++) {
+    roi_t roi;
+    roi.x = nextRandom() % ROI_REFERENCE_WIDTH;
+    roi.y = nextRandom() % ROI_REFERENCE_HEIGHT;
+    roi.w = 1 + nextRandom() % (ROI_REFERENCE_WIDTH - roi.x);
+    roi.h = 1 + nextRandom() % (ROI_REFERENCE_HEIGHT - roi.y);
+    const uint16_t *size = sizes[i % 5];
+    bool ok = roiFit(&roi, size[0], size[1], &fit) && fit.w > 0 && fit.h > 0 &&
+              fit.x + fit.w <= size[0] && fit.y + fit.h <= size[1] &&
+              fit.x % ROI_ALIGN == 0 && fit.y % ROI_ALIGN == 0 &&
+              (uint32_t)fit.x * ROI_REFERENCE_WIDTH <= (uint32_t)roi.x * size[0] &&
+              (uint32_t)(fit.x + fit.w) * ROI_REFERENCE_WIDTH >= (uint32_t)(roi.x + roi.w) * size[0] - ROI_REFERENCE_WIDTH;
+    if (!ok) {
+      printf("FAIL: region %u,%u %ux%u at %ux%u -> %u,%u %ux%u\n", roi.x, roi.y, roi.w, roi.h, size[0], size[1],
+             fit.x, fit.y, fit.w, fit.h);
+      failures++;
+      break;
+    }
+  }
+}
+
+static void checkCrop() {
+  const uint16_t w = 200, h = 150;
+  static uint8_t frame[200 * 150], work[200 * 150], expected[200 * 150];
+  for (size_t i = 0; i < sizeof(frame); i++) frame[i] = nextRandom();
+
+  for (int i = 0; i < 2000; i++) {
+    roi_t roi;
+    roi.x = nextRandom() % w;
+    roi.y = nextRandom() % h;
+    roi.w = 1 + nextRandom() % (w - roi.x);
+    roi.h = 1 + nextRandom() % (h - roi.y);
+    if (i == 0) roi = { 0, 40, w, 50 };   /* whole rows */
+
+    for (uint16_t row = 0; row < roi.h; row++) {
+      memcpy(expected + (size_t)row * roi.w, frame + (size_t)(roi.y + row) * w + roi.x, roi.w);
+    }
+    memcpy(work, frame, sizeof(work));
+    size_t len = roiCrop(work, w, &roi);
+    if (len != (size_t)roi.w * roi.h || memcmp(work, expected, len) != 0) {
+      printf("FAIL: in-place crop %u,%u %ux%u\n", roi.x, roi.y, roi.w, roi.h);
+      failures++;
+      return;
+    }
+  }
+}
+
+/* hal_host.cpp's grayscale capture returns the region, encoded, with its offset */
+static void checkCapture(const char *dir) {
+  setenv("HIVEHIVE_FRAMES", dir, 1);
+  roi_t roi = { 400, 600, 800, 400 };
+  halCameraCrop(&roi);
+  for (size_t i = 0; i < recorded_count; i++) {
+    camera_fb_t *fb = halCameraFbGet();
+    uint16_t w, h, x, y;
+    uint8_t *gray = decode(&recorded[i], 1, &w, &h);
+    roi_t fit;
+    check(fb && gray && roiFit(&roi, w, h, &fit), "grayscale capture returns a frame");
+    if (fb && gray) {
+      recorded_t sent = { "", fb->buf, fb->len };
+      uint16_t sent_w, sent_h;
+      uint8_t *decoded = decode(&sent, 1, &sent_w, &sent_h);
+      halFrameOffset(fb, &x, &y);
+      check(decoded && sent_w == fit.w && sent_h == fit.h && fb->width == fit.w && fb->height == fit.h,
+            "captured frame is the region");
+      check(x == fit.x && y == fit.y, "captured frame carries the offset of the region");
+      free(decoded);
+    }
+    free(gray);
+    halCameraFbReturn(fb);
+  }
+  halCameraCrop(NULL);
+}
+
+/* -------------------------------- */
+/* ---------- BENCHMARK ---------- */
+/* -------------------------------- */
+typedef struct {
+  const char *name;
+  roi_t roi;
+} bench_region_t;
+
+/* centered regions of about 100, 50, 25 and 10 % of the frame */
+static bench_region_t regions[5] = {
+  { "whole frame", { 0, 0, 0, 0 } },
+  { "center 50%",  { 234, 176, 1132, 848 } },
+  { "center 25%",  { 400, 300, 800, 600 } },
+  { "center 10%",  { 548, 412, 504, 376 } },
+  { "argv", { 0, 0, 0, 0 } },
+};
+static int region_count = 4;
+
+static void benchFrame(const char *name, const uint8_t *gray, const uint8_t *rgb, uint16_t w, uint16_t h,
+                       size_t file_len) {
+  int quality = roiEncodeQuality(BENCH_SENSOR_QUALITY);
+  size_t color = encodedColorSize(rgb, w, h, quality);
+  printf("%s at %ux%u: file %u B, whole frame in color at quality %d %u B\n", name, w, h, (unsigned)file_len,
+         quality, (unsigned)color);
+  printf("  %-12s %-17s %9s %10s %9s %8s %8s\n", "region", "cropped", "crop us", "encode ms", "bytes",
+         "vs color", "vs file");
+
+  uint8_t *work = (uint8_t *)malloc((size_t)w * h);
+  for (int r = 0; r < region_count; r++) {
+    roi_t fit;
+    if (!roiFit(&regions[r].roi, w, h, &fit)) {
+      printf("  %-12s outside the frame\n", regions[r].name);
+      continue;
+    }
+
+    double crop_us[BENCH_ROUNDS], encode_ms[BENCH_ROUNDS];
+    size_t bytes = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+      /* the sensor writes a fresh frame every time; the copy is not part of the kernel */
+      memcpy(work, gray, (size_t)w * h);
+      double start = nowUs();
+      roiCrop(work, w, &fit);
+      double cropped = nowUs();
+      uint8_t *jpeg = NULL;
+      bool ok = halJpegEncodeGray(work, fit.w, fit.h, quality, &jpeg, &bytes);
+      double done = nowUs();
+      free(jpeg);
+      if (!ok) {
+        check(false, "grayscale encode");
+        free(work);
+        return;
+      }
+      crop_us[i] = cropped - start;
+      encode_ms[i] = (done - cropped) / 1000;
+    }
+
+    char size[24];
+    snprintf(size, sizeof(size), "%ux%u+%u+%u", fit.w, fit.h, fit.x, fit.y);
+    printf("  %-12s %-17s %9.1f %10.2f %9u %7.1f%% %7.1f%%\n", regions[r].name, size, median(crop_us, BENCH_ROUNDS),
+           median(encode_ms, BENCH_ROUNDS), (unsigned)bytes, 100.0 * bytes / color, 100.0 * bytes / file_len);
+  }
+  free(work);
+}
+
+static void benchmark(const recorded_t *rec) {
+  const char *name = strrchr(rec->path, '/') ? strrchr(rec->path, '/') + 1 : rec->path;
+  uint16_t w, h, cw, ch;
+  uint8_t *gray = decode(rec, 1, &w, &h);
+  uint8_t *rgb = decode(rec, 3, &cw, &ch);
+  if (!gray || !rgb) {
+    check(false, "recorded image decodes");
+    free(gray);
+    free(rgb);
+    return;
+  }
+  benchFrame(name, gray, rgb, w, h, rec->len);
+
+  uint8_t *svga_gray = resample(gray, w, h, 1, SVGA_W, SVGA_H);
+  uint8_t *svga_rgb = resample(rgb, w, h, 3, SVGA_W, SVGA_H);
+  benchFrame(name, svga_gray, svga_rgb, SVGA_W, SVGA_H, rec->len);
+  printf("\n");
+
+  free(svga_gray);
+  free(svga_rgb);
+  free(gray);
+  free(rgb);
+}
+
+int main(int argc, char **argv) {
+  const char *dir = argc > 1 ? argv[1] : "../circle_evaluation/input";
+  if (!loadDirectory(dir)) {
+    fprintf(stderr, "no JPEGs in %s\n", dir);
+    return 1;
+  }
+  if (argc > 5) {
+    regions[region_count++].roi = { (uint16_t)atoi(argv[2]), (uint16_t)atoi(argv[3]),
+                                     (uint16_t)atoi(argv[4]), (uint16_t)atoi(argv[5]) };
+  }
+
+  checkFit();
+  checkCrop();
+  checkCapture(dir);
+
+  for (size_t i = 0; i < recorded_count; i++) {
+    benchmark(&recorded[i]);
+  }
+
+  printf("%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
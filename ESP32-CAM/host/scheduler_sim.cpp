@@ -0,0 +1,217 @@
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Simulation harness for the capture scheduler (scheduler.cpp), host only.
+
+    ./scheduler-sim [target_ms]                 synthetic server, see simulateServer()
+    ./scheduler-sim <trace.csv> [target_ms]     replays a latency trace
+
+  Trace lines are "ttfb_ms,code[,retry_after_s]", one per upload, '#' starts a comment.
+  Each line is answered in a virtual clock, so a trace of a few thousand uploads runs
+  in milliseconds. The summary shows whether the interval settles (spread over the
+  last half of every phase) and how often it changes direction (oscillation).
+  The synthetic run also checks that the interval stays within [target, max], holds
+  the target on an idle server, backs off when overloaded and comes back after it.
+  Both check that no wait is longer than max and that a Retry-After is kept (up to
+  max); exit code 1 if one of these fails. host/scheduler_trace.csv is a short trace
+  with a server asking for a day and a Retry-After that overflows in milliseconds.
+*/
+
+#define SIM_MAX_RESULTS 100000
+
+typedef struct {
+  uint32_t intervals[SIM_MAX_RESULTS];
+  size_t count;
+  uint32_t clock_ms;
+} sim_run_t;
+
+static sim_run_t run;
+static int failures = 0;
+
+static void check(bool ok, const char *phase, const char *what) {
+  if (!ok) {
+    failures++;
+    printf("  FAIL %s: %s\n", phase, what);
+  }
+}
+
+/*
+  One upload: result at clock + ttfb, then the scheduler decides when the next capture
+  starts. The wait is never longer than max, and keeps a Retry-After up to max.
+*/
+static void step(scheduler_t *sched, int code, uint32_t ttfb_ms, uint32_t retry_after_s) {
+  uint32_t cycle_start = run.clock_ms;
+  run.clock_ms += ttfb_ms;
+  schedulerOnResult(sched, code, ttfb_ms, retry_after_s, run.clock_ms);
+  uint32_t delay = schedulerNextDelay(sched, cycle_start, run.clock_ms);
+  run.clock_ms += delay;
+
+  uint64_t retry_ms = (uint64_t)retry_after_s * 1000;
+  char what[96];
+  snprintf(what, sizeof(what), "wait %u ms after %d with Retry-After %u s", (unsigned)delay, code,
+           (unsigned)retry_after_s);
+  check(delay <= sched->max_ms, "wait at most max", what);
+  check(delay >= (retry_ms < sched->max_ms ? retry_ms : sched->max_ms), "Retry-After kept", what);
+
+  if (run.count < SIM_MAX_RESULTS) {
+    run.intervals[run.count++] = sched->interval_ms;
+  }
+}
+
+/* prints the phase and returns its steady interval average */
+static double summarize(const char *name, size_t from, size_t to) {
+  if (to <= from) return 0;
+
+  /* steady state = second half of the phase */
+  size_t half = from + (to - from) / 2;
+  uint32_t lo = UINT32_MAX, hi = 0;
+  double sum = 0;
+  for (size_t i = half; i < to; i++) {
+    uint32_t v = run.intervals[i];
+    if (v < lo) lo = v;
+    if (v > hi) hi = v;
+    sum += v;
+  }
+
+  size_t reversals = 0;
+  int last_dir = 0;
+  for (size_t i = from + 1; i < to; i++) {
+    int dir = run.intervals[i] > run.intervals[i - 1] ? 1 : run.intervals[i] < run.intervals[i - 1] ? -1 : 0;
+    if (dir != 0 && last_dir != 0 && dir != last_dir) reversals++;
+    if (dir != 0) last_dir = dir;
+  }
+
+  printf("%-22s results %5zu  steady interval avg %7.1f ms  min %6u  max %6u  reversals/100 %5.1f\n",
+         name, to - from, sum / (to - half), (unsigned)lo, (unsigned)hi, reversals * 100.0 / (to - from));
+  return sum / (to - half);
+}
+
+/* -------------------------------- */
+/* ---------- TRACE REPLAY ---------- */
+/* -------------------------------- */
+static int replayTrace(const char *path, uint32_t target_ms) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+
+  scheduler_t sched;
+  schedulerInit(&sched, target_ms);
+
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#' || line[0] == '\n') continue;
+    unsigned ttfb = 0, retry_after = 0;
+    int code = 0;
+    if (sscanf(line, "%u,%d,%u", &ttfb, &code, &retry_after) < 2) continue;
+    step(&sched, code, ttfb, retry_after);
+  }
+  fclose(file);
+
+  summarize(path, 0, run.count);
+  printf("backoffs %u, latency backoffs %u, retry-after %u, simulated %.1f s\n",
+         (unsigned)sched.backoffs, (unsigned)sched.latency_backoffs, (unsigned)sched.retry_afters,
+         run.clock_ms / 1000.0);
+  printf("%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
+
+/* -------------------------------- */
+/* -------- SYNTHETIC SERVER -------- */
+/* -------------------------------- */
+static uint32_t rng = 12345;
+
+static double random01() {
+  rng = rng * 1103515245 + 12345;
+  return ((rng >> 8) & 0xFFFF) / 65536.0;
+}
+
+/*
+  Server shared with other cameras: capacity_fps in total, background_fps of it
+  taken by the others. Latency follows an M/M/1-like curve in the utilization;
+  past saturation requests start failing with 503 + Retry-After.
+*/
+typedef enum {
+  EXPECT_ANY = 0,      /* somewhere between target and max */
+  EXPECT_TARGET,       /* steady interval at the target */
+  EXPECT_BACKOFF       /* steady interval at least twice the target */
+} sim_expect_t;
+
+typedef struct {
+  const char *name;
+  size_t results;
+  double capacity_fps;
+  double background_fps;
+  sim_expect_t expect;
+} sim_phase_t;
+
+static void serverRespond(const sim_phase_t *phase, uint32_t interval_ms,
+                          int *code, uint32_t *ttfb_ms, uint32_t *retry_after_s) {
+  const double base_ms = 80;
+  double rate = 1000.0 / interval_ms;
+  double utilization = (rate + phase->background_fps) / phase->capacity_fps;
+
+  *retry_after_s = 0;
+  if (utilization >= 0.95 && random01() < (utilization - 0.9) * 2) {
+    *code = 503;
+    *ttfb_ms = (uint32_t)base_ms;
+    *retry_after_s = utilization > 1.5 ? 2 : 0;
+    return;
+  }
+
+  double u = utilization < 0.95 ? utilization : 0.95;
+  double jitter = 0.8 + 0.4 * random01();
+  *code = 200;
+  *ttfb_ms = (uint32_t)(base_ms / (1 - u) * jitter);
+}
+
+static int simulateServer(uint32_t target_ms) {
+  const sim_phase_t phases[] = {
+    { "idle server",          400, 20.0,  2.0, EXPECT_TARGET },
+    { "busy (others 14 fps)", 400, 20.0, 14.0, EXPECT_ANY },
+    { "overloaded",           400, 20.0, 25.0, EXPECT_BACKOFF },
+    { "recovered",            400, 20.0,  2.0, EXPECT_TARGET },
+  };
+
+  scheduler_t sched;
+  schedulerInit(&sched, target_ms);
+
+  printf("target interval %u ms (%.2f fps)\n", (unsigned)target_ms, 1000.0 / target_ms);
+  for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+    size_t from = run.count;
+    for (size_t i = 0; i < phases[p].results; i++) {
+      int code;
+      uint32_t ttfb, retry_after;
+      serverRespond(&phases[p], sched.interval_ms, &code, &ttfb, &retry_after);
+      step(&sched, code, ttfb, retry_after);
+    }
+    double steady = summarize(phases[p].name, from, run.count);
+
+    bool in_range = true;
+    for (size_t i = from; i < run.count; i++) {
+      in_range = in_range && run.intervals[i] >= target_ms && run.intervals[i] <= sched.max_ms;
+    }
+    check(in_range, phases[p].name, "interval within [target, max]");
+    if (phases[p].expect == EXPECT_TARGET) {
+      check(steady <= target_ms * 1.1, phases[p].name, "settles at the target interval");
+    } else if (phases[p].expect == EXPECT_BACKOFF) {
+      check(steady >= target_ms * 2.0, phases[p].name, "backs off");
+    }
+  }
+  printf("backoffs %u, latency backoffs %u, retry-after %u, simulated %.1f s\n",
+         (unsigned)sched.backoffs, (unsigned)sched.latency_backoffs, (unsigned)sched.retry_afters,
+         run.clock_ms / 1000.0);
+  printf("%s\n", failures ? "FAILED" : "all checks passed");
+  return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && atoi(argv[1]) == 0) {
+    return replayTrace(argv[1], argc > 2 ? atoi(argv[2]) : 300);
+  }
+  return simulateServer(argc > 1 ? atoi(argv[1]) : 300);
+}
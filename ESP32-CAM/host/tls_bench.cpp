@@ -0,0 +1,111 @@
+#include "client.h"
+#include "hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  TLS handshake benchmark for the upload transport, host only (needs HIVEHIVE_HOST_TLS).
+
+    ./tls-bench <host> <port> [rounds]
+
+  Runs `rounds` connects with a full handshake each, then `rounds` connects that resume
+  the cached session, and prints the connect time (TCP + TLS) of both. Trust anchors are
+  read like on the device: ./spiffs/ca.pem and ./spiffs/tls_pin.txt.
+
+  Every connect sends a small request and reads the answer, so that TLS 1.3 session
+  tickets (sent by the server after the handshake) actually arrive.
+  Exit code 1 if a connect failed or no resumed connect resumed the session.
+*/
+
+static bool exchange(HalTransport *client, const char *host) {
+  char request[128];
+  int len = snprintf(request, sizeof(request), "GET / HTTP/1.0\r\nHost: %s\r\n\r\n", host);
+  if (client->write((const uint8_t *)request, len) != (size_t)len) {
+    return false;
+  }
+
+  uint8_t buf[1024];
+  uint32_t start = halMillis();
+  bool got = false;
+  while (halMillis() - start < 2000) {
+    int n = client->read(buf, sizeof(buf));
+    if (n > 0) {
+      got = true;
+      continue;
+    }
+    if (!client->connected()) break;
+    if (got && client->available() <= 0) {
+      halDelay(5);
+      if (client->available() <= 0) break;
+    }
+    halDelay(1);
+  }
+  return got;
+}
+
+static int compare(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void report(const char *name, uint32_t *times, int count, int resumed) {
+  if (count == 0) {
+    printf("%-8s no successful connects\n", name);
+    return;
+  }
+  qsort(times, count, sizeof(times[0]), compare);
+  printf("%-8s n %3d  min %4u ms  median %4u ms  p90 %4u ms  max %4u ms  resumed %d/%d\n", name, count,
+         (unsigned)times[0], (unsigned)times[count / 2], (unsigned)times[count * 9 / 10],
+         (unsigned)times[count - 1], resumed, count);
+}
+
+/* returns true if every connect succeeded and, with resume, at least one resumed */
+static bool run(HalTransport *client, const char *host, uint16_t port, int rounds, bool resume) {
+  uint32_t *times = (uint32_t *)malloc(rounds * sizeof(uint32_t));
+  int count = 0, resumed = 0;
+
+  if (resume) {
+    /* prime the session cache */
+    client->forgetSession();
+    if (client->connect(host, port)) exchange(client, host);
+    client->stop();
+  }
+
+  for (int i = 0; i < rounds; i++) {
+    if (!resume) client->forgetSession();
+
+    uint32_t start = halMillis();
+    bool ok = client->connect(host, port);
+    uint32_t elapsed = halMillis() - start;
+    if (ok) {
+      times[count++] = elapsed;
+      if (client->sessionResumed()) resumed++;
+      exchange(client, host);
+    }
+    client->stop();
+  }
+
+  report(resume ? "resumed" : "full", times, count, resumed);
+  free(times);
+  return count == rounds && (!resume || resumed > 0);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <host> <port> [rounds]\n", argv[0]);
+    return 1;
+  }
+  const char *host = argv[1];
+  uint16_t port = (uint16_t)atoi(argv[2]);
+  int rounds = argc > 3 ? atoi(argv[3]) : 20;
+  if (rounds < 1) rounds = 1;
+
+  halFsBegin();
+  loadUploadTrust();
+
+  HalTransport *client = halUploadTransport();
+  bool ok = run(client, host, port, rounds, false);
+  ok = run(client, host, port, rounds, true) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+#include "http_request.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+  -----------------------------
+  -------- RENDERING ----------
+  -----------------------------
+*/
+static const char *PART_HEADER_FORMAT =
+  "--" MULTIPART_BOUNDARY "\r\n"
+  "Content-Disposition: form-data; name=\"image\"; filename=\"%s\"\r\n"
+  "%s"
+  "Content-Type: image/jpeg\r\n\r\n";
+
+/* every part after the first one closes the previous image first */
+static const char *NEXT_PART_HEADER_FORMAT =
+  "\r\n--" MULTIPART_BOUNDARY "\r\n"
+  "Content-Disposition: form-data; name=\"image\"; filename=\"%s\"\r\n"
+  "%s"
+  "Content-Type: image/jpeg\r\n\r\n";
+
+/* longest HTTP_ROI_HEADER line: "X-ROI-Offset: 65535,65535\r\n" */
+#define ROI_LINE_MAX 32
+
+/* the HTTP_ROI_HEADER line of a cropped frame, empty for a whole one */
+static const char *roiLine(char *line, uint16_t roi_x, uint16_t roi_y) {
+  line[0] = '\0';
+  if (roi_x || roi_y) {
+    snprintf(line, ROI_LINE_MAX, HTTP_ROI_HEADER ": %u,%u\r\n", (unsigned)roi_x, (unsigned)roi_y);
+  }
+  return line;
+}
+
+static const char *CLOSING_BOUNDARY = "\r\n--" MULTIPART_BOUNDARY "--\r\n";
+
+/* "Content-Length: " and the 20 digits of the largest unsigned long */
+#define LENGTH_HEADER_MAX 40
+
+/*
+  Request line and headers up to the blank line. content_length < 0 -> chunked body.
+  Returns the length, -1 if it does not fit.
+*/
+static int renderHead(char *buf, size_t cap, const char *host, const char *path, const char *device,
+                      long content_length) {
+  char length_header[LENGTH_HEADER_MAX];
+  if (content_length >= 0) {
+    snprintf(length_header, sizeof(length_header), "Content-Length: %lu", (unsigned long)content_length);
+  } else {
+    snprintf(length_header, sizeof(length_header), "Transfer-Encoding: chunked");
+  }
+
+  bool has_device = device && *device;
+  int len = snprintf(buf, cap,
+    "POST %s HTTP/1.1\r\n"
+    "Host: %s\r\n"
+    "Connection: keep-alive\r\n"
+    "Accept: " HTTP_ACCEPT "\r\n"
+    "%s%s%s"
+    "Content-Type: multipart/form-data; boundary=" MULTIPART_BOUNDARY "\r\n"
+    "%s\r\n\r\n",
+    path, host,
+    has_device ? HTTP_DEVICE_HEADER ": " : "", has_device ? device : "", has_device ? "\r\n" : "",
+    length_header);
+  return len < 0 || len >= (int)cap ? -1 : len;
+}
+
+bool buildImageRequest(http_request_t *req, const char *host, const char *path, const char *device,
+                       const http_image_part_t *image) {
+  return buildBatchRequest(req, host, path, device, image, 1);
+}
+
+bool buildBatchRequest(http_request_t *req, const char *host, const char *path, const char *device,
+                       const http_image_part_t *images, size_t count) {
+  if (count == 0 || count > HTTP_BATCH_MAX) {
+    return false;
+  }
+
+  /* part headers 1..n-1 go into their own buffers right away */
+  size_t content_length = 0;
+  char roi[ROI_LINE_MAX];
+  for (size_t i = 1; i < count; i++) {
+    int len = snprintf(req->parts[i - 1], sizeof(req->parts[i - 1]), NEXT_PART_HEADER_FORMAT, images[i].filename,
+                       roiLine(roi, images[i].roi_x, images[i].roi_y));
+    if (len < 0 || len >= (int)sizeof(req->parts[i - 1])) {
+      return false;
+    }
+    content_length += len + images[i].len;
+  }
+
+  /* the first part header is needed twice: its length for Content-Length, then the text itself */
+  roiLine(roi, images[0].roi_x, images[0].roi_y);
+  int part_len = snprintf(NULL, 0, PART_HEADER_FORMAT, images[0].filename, roi);
+  int tail_len = snprintf(req->tail, sizeof(req->tail), "%s", CLOSING_BOUNDARY);
+  if (part_len < 0 || tail_len < 0 || tail_len >= (int)sizeof(req->tail)) {
+    return false;
+  }
+  req->tail_len = tail_len;
+  req->content_length = content_length + part_len + images[0].len + tail_len;
+
+  int head_len = renderHead(req->head, sizeof(req->head), host, path, device, (long)req->content_length);
+  if (head_len < 0 || head_len + part_len >= (int)sizeof(req->head)) {
+    return false;
+  }
+  snprintf(req->head + head_len, sizeof(req->head) - head_len, PART_HEADER_FORMAT, images[0].filename, roi);
+  req->head_len = head_len + part_len;
+
+  size_t n = 0;
+  req->segments[n].data = (const uint8_t *)req->head;
+  req->segments[n++].len = req->head_len;
+  for (size_t i = 0; i < count; i++) {
+    if (i > 0) {
+      req->segments[n].data = (const uint8_t *)req->parts[i - 1];
+      req->segments[n++].len = strlen(req->parts[i - 1]);
+    }
+    req->segments[n].data = images[i].jpeg;
+    req->segments[n++].len = images[i].len;
+  }
+  req->segments[n].data = (const uint8_t *)req->tail;
+  req->segments[n++].len = req->tail_len;
+  req->segment_count = n;
+  return true;
+}
+
+/*
+  -----------------------------
+  --------- WRITING -----------
+  -----------------------------
+*/
+static bool writeAll(const uint8_t *data, size_t len, http_write_fn write, void *ctx, http_write_stats_t *stats) {
+  while (len > 0) {
+    size_t accepted = write(ctx, data, len);
+    stats->writes++;
+    if (accepted == 0) {
+      return false;
+    }
+    if (accepted < len) {
+      stats->partial_writes++;
+    }
+    stats->bytes += accepted;
+    data += accepted;
+    len -= accepted;
+  }
+  return true;
+}
+
+bool httpWriteGather(const http_segment_t *segments, size_t count, uint8_t *staging, size_t staging_cap,
+                     http_write_fn write, void *ctx, http_write_stats_t *stats) {
+  http_write_stats_t local_stats;
+  if (!stats) stats = &local_stats;
+  memset(stats, 0, sizeof(*stats));
+
+  if (staging_cap > HTTP_WRITE_MAX) staging_cap = HTTP_WRITE_MAX;
+  size_t staged = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t *data = segments[i].data;
+    size_t left = segments[i].len;
+
+    while (left > 0) {
+      /* nothing pending and a big piece left: write straight from the source */
+      if (staged == 0 && left >= staging_cap) {
+        size_t chunk = left < HTTP_WRITE_MAX ? left : HTTP_WRITE_MAX;
+        if (!writeAll(data, chunk, write, ctx, stats)) return false;
+        data += chunk;
+        left -= chunk;
+        continue;
+      }
+
+      /* otherwise coalesce with whatever comes before/after */
+      size_t copy = left < staging_cap - staged ? left : staging_cap - staged;
+      memcpy(staging + staged, data, copy);
+      staged += copy;
+      data += copy;
+      left -= copy;
+
+      if (staged == staging_cap) {
+        if (!writeAll(staging, staged, write, ctx, stats)) return false;
+        staged = 0;
+      }
+    }
+  }
+
+  if (staged > 0) {
+    if (!writeAll(staging, staged, write, ctx, stats)) return false;
+  }
+  return true;
+}
+
+/*
+  -----------------------------
+  ------ CHUNKED STREAM -------
+  -----------------------------
+*/
+bool httpStreamBegin(http_stream_t *stream, const char *host, const char *path, const char *device,
+                     uint8_t *staging, size_t staging_cap, http_write_fn write, void *ctx) {
+  memset(stream, 0, sizeof(*stream));
+  stream->write = write;
+  stream->ctx = ctx;
+  stream->staging = staging;
+  stream->cap = staging_cap < HTTP_WRITE_MAX ? staging_cap : HTTP_WRITE_MAX;
+
+  int head_len = renderHead((char *)staging, stream->cap, host, path, device, -1);
+  if (head_len < 0 ||
+      (size_t)head_len + HTTP_CHUNK_SIZE_LINE + HTTP_PART_HEADER_MAX + HTTP_CHUNK_TRAILER > stream->cap) {
+    stream->failed = true;
+    return false;
+  }
+  stream->head_len = head_len;
+  stream->staged = head_len + HTTP_CHUNK_SIZE_LINE;
+  return true;
+}
+
+/*
+  Sends the head (if still pending) and the staged data as one chunk; with last
+  the terminating zero-length chunk goes out in the same write.
+*/
+static bool flushChunk(http_stream_t *stream, bool last) {
+  if (stream->failed) return false;
+
+  uint8_t *out = stream->staging;
+  size_t size_line = stream->head_len;
+  size_t data_len = stream->staged - size_line - HTTP_CHUNK_SIZE_LINE;
+  size_t end = size_line;
+
+  if (data_len > 0) {
+    char line[HTTP_CHUNK_SIZE_LINE + 1];
+    snprintf(line, sizeof(line), "%04x\r\n", (unsigned)data_len);
+    memcpy(out + size_line, line, HTTP_CHUNK_SIZE_LINE);
+    memcpy(out + stream->staged, "\r\n", 2);
+    end = stream->staged + 2;
+  }
+  if (last) {
+    memcpy(out + end, "0\r\n\r\n", 5);
+    end += 5;
+  }
+
+  if (end > 0 && !writeAll(out, end, stream->write, stream->ctx, &stream->stats)) {
+    stream->failed = true;
+    return false;
+  }
+  stream->head_len = 0;
+  stream->staged = HTTP_CHUNK_SIZE_LINE;
+  return true;
+}
+
+bool httpStreamWrite(http_stream_t *stream, const uint8_t *data, size_t len) {
+  while (len > 0) {
+    if (stream->failed) return false;
+
+    size_t room = stream->cap - HTTP_CHUNK_TRAILER - stream->staged;
+    if (room == 0) {
+      flushChunk(stream, false);
+      continue;
+    }
+    size_t copy = len < room ? len : room;
+    memcpy(stream->staging + stream->staged, data, copy);
+    stream->staged += copy;
+    data += copy;
+    len -= copy;
+  }
+  return !stream->failed;
+}
+
+bool httpStreamPart(http_stream_t *stream, const char *filename, uint16_t roi_x, uint16_t roi_y) {
+  char header[HTTP_PART_HEADER_MAX];
+  char roi[ROI_LINE_MAX];
+  int len = snprintf(header, sizeof(header), stream->parts ? NEXT_PART_HEADER_FORMAT : PART_HEADER_FORMAT, filename,
+                     roiLine(roi, roi_x, roi_y));
+  if (len < 0 || len >= (int)sizeof(header)) {
+    return false;
+  }
+  stream->parts++;
+  return httpStreamWrite(stream, (const uint8_t *)header, len);
+}
+
+bool httpStreamFlush(http_stream_t *stream) {
+  return flushChunk(stream, false);
+}
+
+bool httpStreamEnd(http_stream_t *stream) {
+  if (stream->parts > 0 &&
+      !httpStreamWrite(stream, (const uint8_t *)CLOSING_BOUNDARY, strlen(CLOSING_BOUNDARY))) {
+    return false;
+  }
+  return flushChunk(stream, true);
+}
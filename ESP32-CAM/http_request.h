@@ -0,0 +1,153 @@
+#ifndef HTTP_REQUEST_H
+#define HTTP_REQUEST_H
+
+#include "circle_result.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define MULTIPART_BOUNDARY "----esp32_boundary"
+
+/* request line + headers + multipart part header */
+#define HTTP_REQUEST_HEAD_MAX 512
+#define HTTP_REQUEST_TAIL_MAX 32
+
+/* frames per request in batch mode, and the room for the part headers between them */
+#define HTTP_BATCH_MAX 8
+#define HTTP_PART_HEADER_MAX 192
+#define HTTP_REQUEST_MAX_SEGMENTS (2 * HTTP_BATCH_MAX + 1)
+
+/* one TLS record carries at most 16 KB of payload */
+#define HTTP_WRITE_MAX 16384
+
+/*
+  One piece of memory that has to go out on the wire, without copying it first.
+*/
+typedef struct {
+  const uint8_t *data;
+  size_t len;
+} http_segment_t;
+
+/*
+  One image part of a multipart POST. A cropped frame (roi.h) carries its position
+  in the captured frame as a part header, HTTP_ROI_HEADER: x,y.
+*/
+typedef struct {
+  const char *filename;
+  const uint8_t *jpeg;
+  size_t len;
+  uint16_t roi_x;
+  uint16_t roi_y;
+} http_image_part_t;
+
+/*
+  A fully rendered multipart POST:
+
+    segments[0]    -> head  (request line, headers, first part header)
+    segments[1]    -> image (points into the camera frame buffer)
+    segments[2]    -> part  (boundary + header of the next image)      \  only in
+    segments[3]    -> image                                            /  batch mode
+    ...
+    segments[last] -> tail  (closing boundary)
+
+  Everything lives inside the struct; nothing is allocated and no image is copied.
+*/
+typedef struct {
+  char head[HTTP_REQUEST_HEAD_MAX];
+  size_t head_len;
+  char parts[HTTP_BATCH_MAX - 1][HTTP_PART_HEADER_MAX];
+  char tail[HTTP_REQUEST_TAIL_MAX];
+  size_t tail_len;
+  size_t content_length;
+
+  http_segment_t segments[HTTP_REQUEST_MAX_SEGMENTS];
+  size_t segment_count;
+} http_request_t;
+
+/*
+  The binary detection result (circle_result.h) if the backend has it, JSON otherwise.
+  Batch responses are always JSON.
+*/
+#define HTTP_ACCEPT CIRCLE_RESULT_MIME ", application/json;q=0.5"
+
+/* identifies the camera to the backend; results are kept per device */
+#define HTTP_DEVICE_HEADER "X-Device-ID"
+
+/* part header of a cropped frame; left out at 0,0 */
+#define HTTP_ROI_HEADER "X-ROI-Offset"
+
+/*
+  Renders the request for one JPEG. device (may be NULL) goes into the HTTP_DEVICE_HEADER.
+  Returns false if host/path/device/filename do not fit into head.
+*/
+bool buildImageRequest(http_request_t *req, const char *host, const char *path, const char *device,
+                       const http_image_part_t *image);
+
+/*
+  Renders one request carrying count (1..HTTP_BATCH_MAX) JPEGs as separate "image" parts.
+  Returns false if count is out of range or a header does not fit.
+*/
+bool buildBatchRequest(http_request_t *req, const char *host, const char *path, const char *device,
+                       const http_image_part_t *images, size_t count);
+
+/*
+  Transport hook: write up to len bytes, return how many were accepted (0 = error).
+*/
+typedef size_t (*http_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct {
+  uint32_t writes;          /* calls into the transport */
+  uint32_t partial_writes;  /* calls that accepted less than offered */
+  size_t bytes;
+} http_write_stats_t;
+
+/*
+  Chunked multipart POST (Transfer-Encoding: chunked) for bodies whose length is
+  not known up front: a JPEG that is still being produced in slices, or frames
+  appended one after the other.
+
+    httpStreamBegin()   request head, kept back until the first flush
+    httpStreamPart()    header of the next "image" part
+    httpStreamWrite()   image bytes, any number of times
+    httpStreamFlush()   sends what is staged as one chunk (e.g. after every slice)
+    httpStreamEnd()     closing boundary + last chunk
+
+  Everything goes through the staging buffer: each flush is one transport write
+  of [head, first time only][chunk size][data][CRLF], so no chunk header ever ends
+  up in a TLS record of its own. A full staging buffer is flushed automatically.
+*/
+#define HTTP_CHUNK_SIZE_LINE 6   /* "%04x\r\n": a chunk is at most HTTP_WRITE_MAX bytes */
+#define HTTP_CHUNK_TRAILER 7     /* "\r\n" after the data + "0\r\n\r\n" after the last chunk */
+
+typedef struct {
+  http_write_fn write;
+  void *ctx;
+  uint8_t *staging;
+  size_t cap;
+  size_t head_len;    /* unsent request head at the start of staging, 0 after the first flush */
+  size_t staged;      /* end of the staged data */
+  size_t parts;
+  bool failed;
+  http_write_stats_t stats;
+} http_stream_t;
+
+bool httpStreamBegin(http_stream_t *stream, const char *host, const char *path, const char *device,
+                     uint8_t *staging, size_t staging_cap, http_write_fn write, void *ctx);
+bool httpStreamPart(http_stream_t *stream, const char *filename, uint16_t roi_x, uint16_t roi_y);
+bool httpStreamWrite(http_stream_t *stream, const uint8_t *data, size_t len);
+bool httpStreamFlush(http_stream_t *stream);
+bool httpStreamEnd(http_stream_t *stream);
+
+/*
+  Sends a gather list with as few transport writes as possible.
+
+  Small segments (and the edges of large ones) are coalesced in the staging buffer,
+  so the headers go out in the same write as the first part of the image and the
+  closing boundary in the same write as the last part. The middle of large segments
+  is written straight from its source in HTTP_WRITE_MAX pieces.
+
+  Returns true if every byte was accepted by the transport.
+*/
+bool httpWriteGather(const http_segment_t *segments, size_t count, uint8_t *staging, size_t staging_cap,
+                     http_write_fn write, void *ctx, http_write_stats_t *stats);
+
+#endif
@@ -0,0 +1,235 @@
+#include "http_response.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+  -----------------------------
+  ---------- HELPERS ----------
+  -----------------------------
+*/
+
+/*
+  Returns the header value if line starts with "<name>:" (case-insensitive), otherwise NULL.
+  Leading whitespace of the value is skipped.
+*/
+static const char *headerValue(const char *line, const char *name) {
+  size_t name_len = strlen(name);
+  if (strncasecmp(line, name, name_len) != 0 || line[name_len] != ':') {
+    return NULL;
+  }
+  const char *value = line + name_len + 1;
+  while (*value == ' ' || *value == '\t') value++;
+  return value;
+}
+
+/* digits up to trailing whitespace, within long; -1 for anything else ("12abc", "-1", "5, 5") */
+static long contentLength(const char *value) {
+  if (!isdigit((unsigned char)*value)) return -1;
+  char *end;
+  errno = 0;
+  long length = strtol(value, &end, 10);
+  while (*end == ' ' || *end == '\t') end++;
+  return *end == '\0' && errno == 0 ? length : -1;
+}
+
+static bool containsToken(const char *value, const char *token) {
+  size_t token_len = strlen(token);
+  for (const char *p = value; *p; p++) {
+    if (strncasecmp(p, token, token_len) == 0) return true;
+  }
+  return false;
+}
+
+static void appendBody(http_response_t *res, const uint8_t *data, size_t len) {
+  size_t space = res->body_cap > res->body_len + 1 ? res->body_cap - res->body_len - 1 : 0;
+  size_t copy = len < space ? len : space;
+
+  if (copy > 0) {
+    memcpy(res->body + res->body_len, data, copy);
+    res->body_len += copy;
+    res->body[res->body_len] = '\0';
+  }
+  if (copy < len) {
+    res->body_truncated = true;
+  }
+}
+
+/*
+  Called after the blank line that ends the headers. Picks the body framing.
+*/
+static void startBody(http_response_t *res) {
+  /*
+    1xx (100 Continue, 103 Early Hints) are interim: the response to the request
+    follows on the same connection. Forget their headers and parse that one.
+  */
+  if (res->status_code >= 100 && res->status_code < 200) {
+    res->status_code = 0;
+    res->content_length = -1;
+    res->chunked = false;
+    res->retry_after_s = 0;
+    res->content_type[0] = '\0';
+    res->state = HTTP_PARSE_STATUS;
+  } else if (res->chunked && res->content_length >= 0) {
+    /* two framings that disagree on where the body ends (RFC 9112 section 6.3) */
+    res->state = HTTP_PARSE_ERROR;
+  } else if (res->status_code == 204 || res->status_code == 304) {
+    /* never carry a body */
+    res->state = HTTP_PARSE_DONE;
+  } else if (res->chunked) {
+    res->state = HTTP_PARSE_CHUNK_SIZE;
+  } else if (res->content_length >= 0) {
+    res->remaining = (size_t)res->content_length;
+    res->state = res->remaining > 0 ? HTTP_PARSE_BODY : HTTP_PARSE_DONE;
+  } else {
+    res->until_close = true;
+    res->keep_alive = false;
+    res->state = HTTP_PARSE_BODY;
+  }
+}
+
+/*
+  Handles one complete line (without CR/LF) for all line-based states.
+*/
+static void handleLine(http_response_t *res) {
+  char *line = res->line;
+
+  switch (res->state) {
+    case HTTP_PARSE_STATUS: {
+      /* "HTTP/1.1 200 OK" */
+      if (strncmp(line, "HTTP/1.", 7) != 0 || res->line_len < 12 || line[8] != ' ') {
+        res->state = HTTP_PARSE_ERROR;
+        return;
+      }
+      res->keep_alive = line[7] == '1';  /* HTTP/1.1 default, HTTP/1.0 closes */
+      res->status_code = atoi(line + 9);
+      res->state = res->status_code >= 100 ? HTTP_PARSE_HEADERS : HTTP_PARSE_ERROR;
+      break;
+    }
+
+    case HTTP_PARSE_HEADERS: {
+      if (res->line_len == 0) {
+        startBody(res);
+        return;
+      }
+
+      const char *value;
+      if ((value = headerValue(line, "Content-Length")) != NULL) {
+        long length = contentLength(value);
+        /* sent twice, it has to be the same length both times */
+        if (length < 0 || (res->content_length >= 0 && res->content_length != length)) {
+          res->state = HTTP_PARSE_ERROR;
+          return;
+        }
+        res->content_length = length;
+      } else if ((value = headerValue(line, "Transfer-Encoding")) != NULL) {
+        res->chunked = containsToken(value, "chunked");
+      } else if ((value = headerValue(line, "Connection")) != NULL) {
+        if (containsToken(value, "close")) res->keep_alive = false;
+        if (containsToken(value, "keep-alive")) res->keep_alive = true;
+      } else if ((value = headerValue(line, "Retry-After")) != NULL) {
+        /* delta-seconds only; an HTTP-date does not start with a digit and stays 0 */
+        res->retry_after_s = strtoul(value, NULL, 10);
+      } else if ((value = headerValue(line, "Content-Type")) != NULL) {
+        /* "application/json; charset=utf-8" -> "application/json" */
+        size_t len = strcspn(value, "; \t");
+        if (len >= sizeof(res->content_type)) len = sizeof(res->content_type) - 1;
+        memcpy(res->content_type, value, len);
+        res->content_type[len] = '\0';
+      }
+      break;
+    }
+
+    case HTTP_PARSE_CHUNK_SIZE: {
+      /* "1a2b" or "1a2b;extension" */
+      char *end;
+      unsigned long size = strtoul(line, &end, 16);
+      if (end == line) {
+        res->state = HTTP_PARSE_ERROR;
+        return;
+      }
+      res->remaining = size;
+      res->state = size > 0 ? HTTP_PARSE_CHUNK_DATA : HTTP_PARSE_TRAILERS;
+      break;
+    }
+
+    case HTTP_PARSE_CHUNK_DATA_END:
+      res->state = res->line_len == 0 ? HTTP_PARSE_CHUNK_SIZE : HTTP_PARSE_ERROR;
+      break;
+
+    case HTTP_PARSE_TRAILERS:
+      if (res->line_len == 0) res->state = HTTP_PARSE_DONE;
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*
+  -----------------------------
+  ----------- API -------------
+  -----------------------------
+*/
+void httpResponseInit(http_response_t *res, uint8_t *body_buf, size_t body_cap) {
+  memset(res, 0, sizeof(*res));
+  res->state = HTTP_PARSE_STATUS;
+  res->content_length = -1;
+  res->body = body_buf;
+  res->body_cap = body_cap;
+  if (body_buf && body_cap > 0) body_buf[0] = '\0';
+}
+
+size_t httpResponseFeed(http_response_t *res, const uint8_t *data, size_t len) {
+  size_t pos = 0;
+
+  while (pos < len && res->state != HTTP_PARSE_DONE && res->state != HTTP_PARSE_ERROR) {
+    if (res->state == HTTP_PARSE_BODY || res->state == HTTP_PARSE_CHUNK_DATA) {
+      /* raw body bytes: copy as much as belongs to this body/chunk in one go */
+      size_t take = len - pos;
+      if (!res->until_close && take > res->remaining) take = res->remaining;
+
+      appendBody(res, data + pos, take);
+      pos += take;
+
+      if (!res->until_close) {
+        res->remaining -= take;
+        if (res->remaining == 0) {
+          res->state = res->state == HTTP_PARSE_BODY ? HTTP_PARSE_DONE : HTTP_PARSE_CHUNK_DATA_END;
+        }
+      }
+      continue;
+    }
+
+    /* line-based states */
+    char c = (char)data[pos++];
+    if (c == '\n') {
+      res->line[res->line_len] = '\0';
+      handleLine(res);
+      res->line_len = 0;
+    } else if (c != '\r' && res->line_len < HTTP_LINE_MAX - 1) {
+      res->line[res->line_len++] = c;
+    }
+  }
+
+  return pos;
+}
+
+void httpResponseFinish(http_response_t *res) {
+  if (res->state == HTTP_PARSE_BODY && res->until_close) {
+    res->state = HTTP_PARSE_DONE;
+  } else if (res->state != HTTP_PARSE_DONE) {
+    res->state = HTTP_PARSE_ERROR;
+  }
+  res->keep_alive = false;
+}
+
+bool httpResponseDone(const http_response_t *res) {
+  return res->state == HTTP_PARSE_DONE || res->state == HTTP_PARSE_ERROR;
+}
+
+bool httpResponseFailed(const http_response_t *res) {
+  return res->state == HTTP_PARSE_ERROR;
+}
@@ -0,0 +1,77 @@
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Longest status/header/chunk-size line that is kept.
+  Longer lines are consumed but cut off (only the start of a header is ever needed).
+*/
+#define HTTP_LINE_MAX 128
+
+/* media type of the body, without parameters; longer ones are cut off */
+#define HTTP_CONTENT_TYPE_MAX 48
+
+typedef enum {
+  HTTP_PARSE_STATUS = 0,
+  HTTP_PARSE_HEADERS,
+  HTTP_PARSE_BODY,           /* Content-Length body or read-until-close body */
+  HTTP_PARSE_CHUNK_SIZE,
+  HTTP_PARSE_CHUNK_DATA,
+  HTTP_PARSE_CHUNK_DATA_END, /* CRLF after each chunk */
+  HTTP_PARSE_TRAILERS,
+  HTTP_PARSE_DONE,
+  HTTP_PARSE_ERROR
+} http_parse_state_t;
+
+/*
+  Incremental HTTP/1.x response parser.
+
+  Works on caller-provided memory only: the body is copied into body_buf
+  (always NUL-terminated, truncated if it does not fit) and nothing is allocated.
+  Feed it whatever the socket currently has; it reports when the response is complete
+  so a keep-alive connection does not have to wait for a timeout. Interim 1xx
+  responses are skipped; the fields describe the final response.
+*/
+typedef struct {
+  http_parse_state_t state;
+
+  int status_code;
+  long content_length;  /* -1 if the server did not send one */
+  bool chunked;
+  bool keep_alive;
+  uint32_t retry_after_s;  /* Retry-After in seconds, 0 if absent (HTTP-date form is ignored) */
+  char content_type[HTTP_CONTENT_TYPE_MAX];  /* "" if absent */
+
+  /* body */
+  uint8_t *body;
+  size_t body_cap;
+  size_t body_len;
+  bool body_truncated;
+
+  /* internal */
+  char line[HTTP_LINE_MAX];
+  size_t line_len;
+  size_t remaining;     /* bytes left in the current body or chunk */
+  bool until_close;     /* neither Content-Length nor chunked: body ends with the connection */
+} http_response_t;
+
+void httpResponseInit(http_response_t *res, uint8_t *body_buf, size_t body_cap);
+
+/*
+  Consumes up to len bytes and returns how many were used.
+  Stops early once the response is complete; left-over bytes belong to the next response.
+*/
+size_t httpResponseFeed(http_response_t *res, const uint8_t *data, size_t len);
+
+/*
+  Must be called when the peer closed the connection.
+  Completes read-until-close bodies, everything else still pending becomes an error.
+*/
+void httpResponseFinish(http_response_t *res);
+
+bool httpResponseDone(const http_response_t *res);
+bool httpResponseFailed(const http_response_t *res);
+
+#endif
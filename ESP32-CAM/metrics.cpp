@@ -0,0 +1,257 @@
+#include "metrics.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+  The capture and the upload task both record, the loop task snapshots and resets.
+  Every access to metrics and boot_marks holds this lock. It is only held for a few
+  increments or one copy of the struct, never while formatting, so a spinlock is
+  enough on the ESP32 (it also keeps the other core out).
+*/
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+static portMUX_TYPE metrics_lock = portMUX_INITIALIZER_UNLOCKED;
+#define METRICS_LOCK() portENTER_CRITICAL(&metrics_lock)
+#define METRICS_UNLOCK() portEXIT_CRITICAL(&metrics_lock)
+#else
+#include <pthread.h>
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+#define METRICS_LOCK() pthread_mutex_lock(&metrics_lock)
+#define METRICS_UNLOCK() pthread_mutex_unlock(&metrics_lock)
+#endif
+
+static const char *STAGE_NAMES[STAGE_COUNT] = {
+  "capture", "motion", "connect", "connect_resumed", "header", "upload", "first_byte", "body_read"
+};
+
+static const char *COUNTER_NAMES[COUNTER_COUNT] = {
+  "uploads", "frames", "reconnects", "partial_writes", "bytes_sent", "bytes_received", "frames_unchanged"
+};
+
+static const char *BOOT_MARK_NAMES[BOOT_MARK_COUNT] = {
+  "config_ms", "wifi_ms", "first_capture_ms", "first_upload_ms"
+};
+
+typedef struct {
+  histogram_t stages[STAGE_COUNT];
+  uint32_t counters[COUNTER_COUNT];
+  uint32_t errors[METRICS_ERROR_CODES];  /* index 0 -> -1, ..., 3 -> -4 */
+  uint32_t http_2xx;
+  uint32_t http_4xx;
+  uint32_t http_5xx;
+  uint32_t http_other;
+} metrics_t;
+
+static metrics_t metrics;
+
+/* outside of metrics_t: a measurement window does not restart the boot */
+static uint32_t boot_marks[BOOT_MARK_COUNT];
+
+/*
+  -----------------------------
+  -------- HISTOGRAM ----------
+  -----------------------------
+*/
+void histogramReset(histogram_t *hist) {
+  memset(hist, 0, sizeof(*hist));
+}
+
+size_t histogramBucketIndex(uint32_t value) {
+  if (value < HISTOGRAM_SUB_BUCKETS) {
+    return value;
+  }
+
+  /* position of the highest set bit selects the power of two, the next two bits the sub-bucket */
+  size_t msb = 31 - __builtin_clz(value);
+  size_t sub = (value >> (msb - 2)) & (HISTOGRAM_SUB_BUCKETS - 1);
+  size_t index = (msb - 1) * HISTOGRAM_SUB_BUCKETS + sub;
+
+  return index < HISTOGRAM_BUCKETS ? index : HISTOGRAM_BUCKETS - 1;
+}
+
+uint32_t histogramBucketLowerBound(size_t index) {
+  if (index < HISTOGRAM_SUB_BUCKETS) {
+    return index;
+  }
+  size_t msb = index / HISTOGRAM_SUB_BUCKETS + 1;
+  size_t sub = index % HISTOGRAM_SUB_BUCKETS;
+  return (uint32_t)(HISTOGRAM_SUB_BUCKETS + sub) << (msb - 2);
+}
+
+void histogramRecord(histogram_t *hist, uint32_t value) {
+  if (hist->count == 0 || value < hist->min) hist->min = value;
+  if (value > hist->max) hist->max = value;
+  hist->buckets[histogramBucketIndex(value)]++;
+  hist->count++;
+  hist->sum += value;
+}
+
+uint32_t histogramPercentile(const histogram_t *hist, float p) {
+  if (hist->count == 0) {
+    return 0;
+  }
+
+  uint32_t rank = (uint32_t)((p / 100.0f) * hist->count + 0.5f);
+  if (rank < 1) rank = 1;
+  if (rank > hist->count) rank = hist->count;
+
+  uint32_t seen = 0;
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    seen += hist->buckets[i];
+    if (seen >= rank) {
+      /* upper bound of the bucket, but never beyond what was actually recorded */
+      uint32_t upper = i + 1 < HISTOGRAM_BUCKETS ? histogramBucketLowerBound(i + 1) - 1 : hist->max;
+      return upper < hist->max ? upper : hist->max;
+    }
+  }
+  return hist->max;
+}
+
+/*
+  -----------------------------
+  --------- METRICS -----------
+  -----------------------------
+*/
+void metricsReset() {
+  METRICS_LOCK();
+  memset(&metrics, 0, sizeof(metrics));
+  METRICS_UNLOCK();
+}
+
+void metricsRecordStage(metrics_stage_t stage, uint32_t ms) {
+  METRICS_LOCK();
+  histogramRecord(&metrics.stages[stage], ms);
+  METRICS_UNLOCK();
+}
+
+void metricsCount(metrics_counter_t counter, uint32_t n) {
+  METRICS_LOCK();
+  metrics.counters[counter] += n;
+  METRICS_UNLOCK();
+}
+
+void metricsRecordResult(int code) {
+  METRICS_LOCK();
+  if (code < 0) {
+    if (code >= -METRICS_ERROR_CODES) metrics.errors[-code - 1]++;
+  } else if (code >= 200 && code < 300) {
+    metrics.http_2xx++;
+  } else if (code >= 400 && code < 500) {
+    metrics.http_4xx++;
+  } else if (code >= 500 && code < 600) {
+    metrics.http_5xx++;
+  } else {
+    metrics.http_other++;
+  }
+  METRICS_UNLOCK();
+}
+
+void metricsStage(metrics_stage_t stage, histogram_t *out) {
+  METRICS_LOCK();
+  *out = metrics.stages[stage];
+  METRICS_UNLOCK();
+}
+
+void metricsMarkBoot(metrics_boot_mark_t mark, uint32_t ms) {
+  METRICS_LOCK();
+  if (boot_marks[mark] == 0) {
+    boot_marks[mark] = ms ? ms : 1;
+  }
+  METRICS_UNLOCK();
+}
+
+uint32_t metricsBootMark(metrics_boot_mark_t mark) {
+  METRICS_LOCK();
+  uint32_t ms = boot_marks[mark];
+  METRICS_UNLOCK();
+  return ms;
+}
+
+/*
+  -----------------------------
+  --------- SNAPSHOT ----------
+  -----------------------------
+*/
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t pos;
+  bool overflow;
+} json_writer_t;
+
+static void append(json_writer_t *w, const char *format, ...) {
+  if (w->overflow) return;
+
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(w->buf + w->pos, w->len - w->pos, format, args);
+  va_end(args);
+
+  if (n < 0 || (size_t)n >= w->len - w->pos) {
+    w->overflow = true;
+  } else {
+    w->pos += n;
+  }
+}
+
+size_t metricsSnapshotJson(char *buf, size_t len, uint32_t uptime_ms) {
+  if (len == 0) return 0;
+  json_writer_t w = { buf, len, 0, false };
+
+  /* one consistent copy, formatted outside the lock (only the loop task snapshots) */
+  static metrics_t snap;
+  uint32_t marks[BOOT_MARK_COUNT];
+  METRICS_LOCK();
+  snap = metrics;
+  memcpy(marks, boot_marks, sizeof(marks));
+  METRICS_UNLOCK();
+
+  append(&w, "{\"uptime_ms\":%lu,\"counters\":{", (unsigned long)uptime_ms);
+  for (size_t i = 0; i < COUNTER_COUNT; i++) {
+    append(&w, "\"%s\":%lu,", COUNTER_NAMES[i], (unsigned long)snap.counters[i]);
+  }
+  append(&w, "\"http_2xx\":%lu,\"http_4xx\":%lu,\"http_5xx\":%lu,\"http_other\":%lu,\"errors\":[%lu,%lu,%lu,%lu]},",
+         (unsigned long)snap.http_2xx, (unsigned long)snap.http_4xx,
+         (unsigned long)snap.http_5xx, (unsigned long)snap.http_other,
+         (unsigned long)snap.errors[0], (unsigned long)snap.errors[1],
+         (unsigned long)snap.errors[2], (unsigned long)snap.errors[3]);
+
+  append(&w, "\"boot\":{");
+  for (size_t i = 0; i < BOOT_MARK_COUNT; i++) {
+    append(&w, "%s\"%s\":%lu", i ? "," : "", BOOT_MARK_NAMES[i], (unsigned long)marks[i]);
+  }
+  append(&w, "},");
+
+  append(&w, "\"stages\":{");
+  for (size_t i = 0; i < STAGE_COUNT; i++) {
+    const histogram_t *hist = &snap.stages[i];
+    append(&w, "%s\"%s\":{\"n\":%lu", i ? "," : "", STAGE_NAMES[i], (unsigned long)hist->count);
+
+    if (hist->count > 0) {
+      append(&w, ",\"min\":%lu,\"max\":%lu,\"mean\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"buckets\":[",
+             (unsigned long)hist->min, (unsigned long)hist->max,
+             (unsigned long)(hist->sum / hist->count),
+             (unsigned long)histogramPercentile(hist, 50),
+             (unsigned long)histogramPercentile(hist, 90),
+             (unsigned long)histogramPercentile(hist, 99));
+
+      bool first = true;
+      for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        if (hist->buckets[b] == 0) continue;
+        append(&w, "%s[%lu,%lu]", first ? "" : ",",
+               (unsigned long)histogramBucketLowerBound(b), (unsigned long)hist->buckets[b]);
+        first = false;
+      }
+      append(&w, "]");
+    }
+    append(&w, "}");
+  }
+  append(&w, "}}");
+
+  if (w.overflow) {
+    buf[0] = '\0';
+    return 0;
+  }
+  return w.pos;
+}
@@ -0,0 +1,100 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Log-linear histogram (HDR style): every power of two is split into
+  HISTOGRAM_SUB_BUCKETS linear buckets, i.e. ~25% resolution at any scale.
+  Values 0..3 get exact buckets; everything above the last bucket is clamped into it.
+*/
+#define HISTOGRAM_SUB_BUCKETS 4
+#define HISTOGRAM_BUCKETS 64  /* covers 0 .. ~131 s in milliseconds */
+
+typedef struct {
+  uint32_t buckets[HISTOGRAM_BUCKETS];
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} histogram_t;
+
+void histogramReset(histogram_t *hist);
+void histogramRecord(histogram_t *hist, uint32_t value);
+
+/* p in [0, 100]; returns the upper bound of the bucket that holds the percentile */
+uint32_t histogramPercentile(const histogram_t *hist, float p);
+
+size_t histogramBucketIndex(uint32_t value);
+uint32_t histogramBucketLowerBound(size_t index);
+
+/*
+  Stages of one capture -> upload -> response cycle
+*/
+typedef enum {
+  STAGE_CAPTURE = 0,
+  STAGE_MOTION,       /* thumbnail decode + change detection */
+  STAGE_CONNECT,      /* TCP connect + full TLS handshake (only when not reusing the connection) */
+  STAGE_CONNECT_RESUMED, /* TCP connect + TLS handshake resuming a cached session */
+  STAGE_HEADER,       /* first write, carrying the request headers */
+  STAGE_UPLOAD,       /* rest of the body */
+  STAGE_FIRST_BYTE,   /* end of upload until the first response byte */
+  STAGE_BODY_READ,    /* first response byte until the response is complete */
+  STAGE_COUNT
+} metrics_stage_t;
+
+typedef enum {
+  COUNTER_UPLOADS = 0,      /* HTTP requests */
+  COUNTER_FRAMES,           /* frames carried by them (more than uploads in batch mode) */
+  COUNTER_RECONNECTS,
+  COUNTER_PARTIAL_WRITES,
+  COUNTER_BYTES_SENT,
+  COUNTER_BYTES_RECEIVED,
+  COUNTER_FRAMES_UNCHANGED, /* frames the change detection kept from being uploaded */
+  COUNTER_COUNT
+} metrics_counter_t;
+
+/*
+  Milestones of the boot, in ms since boot. Each is recorded once per boot and
+  kept across metricsReset(); 0 = not reached yet.
+*/
+typedef enum {
+  BOOT_MARK_CONFIG = 0,     /* config loaded */
+  BOOT_MARK_WIFI,           /* first Wi-Fi connection */
+  BOOT_MARK_FIRST_CAPTURE,
+  BOOT_MARK_FIRST_UPLOAD,   /* first 2xx answer: time to first upload */
+  BOOT_MARK_COUNT
+} metrics_boot_mark_t;
+
+/* room for all stages with widely spread histograms */
+#define METRICS_SNAPSHOT_MAX 6144
+
+/* postImage() error codes -1 .. -4 */
+#define METRICS_ERROR_CODES 4
+
+/*
+  Every call below may come from any task; the snapshot is taken in one piece.
+*/
+void metricsReset();
+void metricsRecordStage(metrics_stage_t stage, uint32_t ms);
+void metricsCount(metrics_counter_t counter, uint32_t n = 1);
+
+/* HTTP status or negative postImage() error code */
+void metricsRecordResult(int code);
+
+/* copy of one stage's histogram */
+void metricsStage(metrics_stage_t stage, histogram_t *out);
+
+/* only the first call per mark counts */
+void metricsMarkBoot(metrics_boot_mark_t mark, uint32_t ms);
+uint32_t metricsBootMark(metrics_boot_mark_t mark);
+
+/*
+  Writes a compact JSON snapshot of all counters and histograms
+  (percentiles + non-empty buckets as [lower_bound, count] pairs).
+  Returns the number of characters written, 0 if buf was too small.
+*/
+size_t metricsSnapshotJson(char *buf, size_t len, uint32_t uptime_ms);
+
+#endif
@@ -0,0 +1,150 @@
+#include "motion.h"
+#include <string.h>
+
+/* luma values are kept as 8.8 fixed point */
+#define LUMA_SHIFT 8
+
+/* cells this close to black / white may be clipped: they only bound the true value */
+#define CLIP_LOW (8 << LUMA_SHIFT)
+#define CLIP_HIGH (247 << LUMA_SHIFT)
+
+static bool clipped(uint16_t value) {
+  return value <= CLIP_LOW || value >= CLIP_HIGH;
+}
+
+void motionInit(motion_t *motion, uint16_t threshold, uint32_t keepalive_ms) {
+  memset(motion, 0, sizeof(*motion));
+  motion->threshold = threshold > 1000 ? 1000 : threshold;
+  motion->keepalive_ms = keepalive_ms;
+}
+
+bool motionEnabled(const motion_t *motion) {
+  return motion->threshold > 0;
+}
+
+/*
+  Maps thumbnail columns to grid columns and precomputes 2^16 / pixels for every cell.
+  Only runs when the thumbnail size changes (first frame, new frame size).
+*/
+static void setGeometry(motion_t *motion, uint16_t w, uint16_t h) {
+  motion->width = w;
+  motion->height = h;
+  motion->primed = false;
+
+  uint8_t cols[MOTION_GRID_W] = {};
+  uint8_t rows[MOTION_GRID_H] = {};
+  for (uint16_t x = 0; x < w; x++) {
+    motion->col_cell[x] = (uint8_t)((uint32_t)x * MOTION_GRID_W / w);
+    cols[motion->col_cell[x]]++;
+  }
+  for (uint16_t y = 0; y < h; y++) {
+    rows[(uint32_t)y * MOTION_GRID_H / h]++;
+  }
+
+  motion->used_cells = 0;
+  for (int cy = 0; cy < MOTION_GRID_H; cy++) {
+    for (int cx = 0; cx < MOTION_GRID_W; cx++) {
+      uint32_t pixels = (uint32_t)cols[cx] * rows[cy];
+      motion->recip[cy * MOTION_GRID_W + cx] = pixels ? ((1UL << 16) + pixels / 2) / pixels : 0;
+      if (pixels) motion->used_cells++;
+    }
+  }
+}
+
+/* block means of the thumbnail, one pass over the rows */
+static void reduce(motion_t *motion, const uint8_t *luma, size_t stride) {
+  uint32_t sums[MOTION_GRID_W] = {};
+  const uint16_t w = motion->width, h = motion->height;
+  int cy = 0;
+
+  for (uint16_t y = 0; y <= h; y++) {
+    int row_cell = y < h ? (int)((uint32_t)y * MOTION_GRID_H / h) : MOTION_GRID_H;
+
+    if (row_cell != cy) {
+      /* cell row complete: sum * (2^16 / pixels) >> 8 = mean << 8 */
+      uint16_t *cells = &motion->cells[cy * MOTION_GRID_W];
+      const uint32_t *recip = &motion->recip[cy * MOTION_GRID_W];
+      for (int cx = 0; cx < MOTION_GRID_W; cx++) {
+        cells[cx] = (uint16_t)((sums[cx] * recip[cx]) >> (16 - LUMA_SHIFT));
+        sums[cx] = 0;
+      }
+      cy = row_cell;
+    }
+    if (y == h) break;
+
+    const uint8_t *row = luma + (size_t)y * stride;
+    for (uint16_t x = 0; x < w; x++) {
+      sums[motion->col_cell[x]] += row[x];
+    }
+  }
+}
+
+uint16_t motionScore(motion_t *motion, const uint8_t *luma, uint16_t w, uint16_t h, size_t stride) {
+  if (w > MOTION_THUMB_MAX_W) w = MOTION_THUMB_MAX_W;
+  if (w != motion->width || h != motion->height) {
+    setGeometry(motion, w, h);
+  }
+  if (motion->used_cells == 0) {
+    return 1000;
+  }
+  reduce(motion, luma, stride);
+
+  if (!motion->primed) {
+    memcpy(motion->background, motion->cells, sizeof(motion->cells));
+    motion->primed = true;
+    motion->score = 1000;
+    return motion->score;
+  }
+
+  /* global offset: mean difference over the cells that are not clipped (exposure, light) */
+  int32_t total = 0;
+  uint32_t counted = 0;
+  for (int i = 0; i < MOTION_CELLS; i++) {
+    if (motion->recip[i] && !clipped(motion->cells[i]) && !clipped(motion->background[i])) {
+      total += (int32_t)motion->cells[i] - motion->background[i];
+      counted++;
+    }
+  }
+  int32_t offset = counted ? total / (int32_t)counted : 0;
+
+  const int32_t delta = MOTION_CELL_DELTA << LUMA_SHIFT;
+  uint32_t changed = 0;
+  for (int i = 0; i < MOTION_CELLS; i++) {
+    if (!motion->recip[i]) continue;
+
+    int32_t diff = (int32_t)motion->cells[i] - motion->background[i];
+    int32_t residual = diff - offset;
+    /*
+      A clipped value only bounds the true one, so it cannot prove a change in the
+      direction it was clipped from (e.g. white now, or white before and brighter now).
+    */
+    bool changed_up = residual > delta && motion->cells[i] > CLIP_LOW && motion->background[i] < CLIP_HIGH;
+    bool changed_down = residual < -delta && motion->cells[i] < CLIP_HIGH && motion->background[i] > CLIP_LOW;
+    if (changed_up || changed_down) changed++;
+
+    motion->background[i] = (uint16_t)(motion->background[i] + diff / (1 << MOTION_BG_SHIFT));
+  }
+
+  motion->score = (uint16_t)(changed * 1000 / motion->used_cells);
+  return motion->score;
+}
+
+bool motionCheck(motion_t *motion, const uint8_t *luma, uint16_t w, uint16_t h, size_t stride, uint32_t now_ms) {
+  motion->frames++;
+  bool first = !motion->primed || w != motion->width || h != motion->height;
+  uint16_t score = motionScore(motion, luma, w, h, stride);
+
+  bool upload;
+  if (first || score >= motion->threshold) {
+    motion->changed++;
+    upload = true;
+  } else if (motion->keepalive_ms > 0 && now_ms - motion->last_upload_ms >= motion->keepalive_ms) {
+    motion->keepalives++;
+    upload = true;
+  } else {
+    upload = false;
+  }
+
+  if (upload) motion->last_upload_ms = now_ms;
+  return upload;
+}
@@ -0,0 +1,80 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Change detection gate
+
+  Works on the 1/8 scale luma thumbnail of a frame (halJpegLuma(): one value per
+  8x8 JPEG block, i.e. the DC coefficients), which is reduced to a fixed grid of
+  MOTION_GRID_W x MOTION_GRID_H cells and compared with a rolling background:
+
+    cell changed   -> |cell - background - global offset| > MOTION_CELL_DELTA
+    frame changed  -> changed cells >= threshold (per mille of all cells)
+
+  The global offset is the mean difference over all cells, so auto exposure and
+  clouds do not count as a change. The background follows every frame with weight
+  1 / 2^MOTION_BG_SHIFT: a new static scene is uploaded a few times and then
+  becomes the background, sensor noise averages out.
+
+  Unchanged frames are skipped, except one every keepalive_ms so the server
+  still sees the device (and the scene) from time to time.
+
+  All arithmetic is integer: cells and background are luma in 8.8 fixed point,
+  the cell means use precomputed reciprocals instead of divisions, and the
+  thumbnail is read once, row by row. Plain C++ without camera calls;
+  host/motion_sim.cpp runs the same code on recorded JPEGs.
+*/
+#define MOTION_GRID_W 32
+#define MOTION_GRID_H 24
+#define MOTION_CELLS (MOTION_GRID_W * MOTION_GRID_H)
+
+/* largest thumbnail: UXGA at 1/8 scale */
+#define MOTION_THUMB_MAX_W 200
+#define MOTION_THUMB_MAX_H 150
+
+#define MOTION_CELL_DELTA 10
+#define MOTION_BG_SHIFT 2
+
+typedef struct {
+  uint16_t threshold;                /* per mille of cells, 0 = gate off */
+  uint32_t keepalive_ms;             /* upload an unchanged frame this often, 0 = never */
+
+  /* thumbnail geometry the tables below belong to */
+  uint16_t width;
+  uint16_t height;
+  uint8_t col_cell[MOTION_THUMB_MAX_W];
+  uint32_t recip[MOTION_CELLS];      /* 2^16 / pixels of the cell, 0 = cell unused */
+  uint16_t used_cells;
+
+  uint16_t cells[MOTION_CELLS];      /* luma << 8 of the last frame */
+  uint16_t background[MOTION_CELLS]; /* luma << 8 */
+  bool primed;
+  uint32_t last_upload_ms;
+
+  uint16_t score;                    /* changed cells of the last frame, per mille */
+
+  /* statistics */
+  uint32_t frames;
+  uint32_t changed;
+  uint32_t keepalives;
+} motion_t;
+
+void motionInit(motion_t *motion, uint16_t threshold, uint32_t keepalive_ms);
+
+/* true if the gate has anything to do */
+bool motionEnabled(const motion_t *motion);
+
+/*
+  Scores a thumbnail (w x h luma, rows stride bytes apart) against the background
+  and updates the background. Returns the changed cells in per mille.
+  A new thumbnail size restarts the background.
+*/
+uint16_t motionScore(motion_t *motion, const uint8_t *luma, uint16_t w, uint16_t h, size_t stride);
+
+/* motionScore() plus the decision: true if the frame should be uploaded */
+bool motionCheck(motion_t *motion, const uint8_t *luma, uint16_t w, uint16_t h, size_t stride, uint32_t now_ms);
+
+#endif
@@ -0,0 +1,671 @@
+#include "esp_camera.h"
+#include "pipeline.h"
+#include "frame_queue.h"
+#include "frame_store.h"
+#include "client.h"
+#include "http_request.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "quality_control.h"
+#include "motion.h"
+#include "esp_init.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+/*
+  Producer/consumer pipeline
+
+    capture task --> [ frame_queue_t ] --> upload task
+
+  The queue itself is plain C++ (frame_queue.cpp). This file only adds the locking:
+  a mutex around the queue plus two binary semaphores used as "something changed" events.
+  Both sides re-check the queue under the mutex after waking up, so a missed or
+  doubled signal can never lose a frame.
+
+  Frames whose upload fails because the server is unreachable are copied into the
+  frame store (frame_store.cpp) and uploaded, newest first, whenever the live queue
+  runs empty again. The store is only touched by the upload task and needs no lock.
+
+  The capture interval comes from the scheduler (scheduler.cpp), the JPEG quality and
+  frame size from the quality controller (quality_control.cpp): the upload task reports
+  every result, the capture task asks how long to sleep and which setting to use.
+  Both controllers are only touched under control_mutex.
+
+  Frames that show no change against the background (motion.cpp) are returned to the
+  camera right after capturing and never reach the queue. The change detection is
+  only touched by the capture task.
+
+  Camera settings changed at runtime (control.cpp) are applied by the capture task
+  between two captures, so no frame is taken halfway through a change. A frame size
+  larger than the one the camera was initialized with needs a re-init, which waits
+  until the upload task has returned every frame buffer (frames_out).
+
+  In deep sleep (duty_cycle.h) there are no tasks: every wake captures and uploads
+  one frame with the same helpers, in the calling task. The scheduler then runs on
+  the device clock of the duty state (clock_offset), which goes on across sleeps.
+*/
+static frame_queue_t frame_queue;
+static SemaphoreHandle_t queue_mutex;
+static SemaphoreHandle_t frame_ready;
+static SemaphoreHandle_t slot_free;
+
+static frame_store_t frame_store;
+
+static scheduler_t scheduler;
+static quality_control_t quality_control;
+static SemaphoreHandle_t control_mutex;
+
+static motion_t motion;
+static uint8_t *motion_thumbnail;
+
+static esp_config_t *pipeline_config;
+static uint32_t frame_counter = 0;
+
+/* millis() + clock_offset is the clock of the scheduler; 0 unless woken from deep sleep */
+static uint32_t clock_offset = 0;
+
+/* camera buffers taken and not yet returned, under queue_mutex */
+static int frames_out = 0;
+
+/* live camera settings, written by the capture task, read and handed over under control_mutex */
+static camera_settings_t camera_settings;
+static camera_settings_t pending_settings;
+static bool settings_pending = false;
+static pipeline_update_t settings_result;
+static SemaphoreHandle_t settings_wake;   /* capture task: new settings are pending */
+static SemaphoreHandle_t settings_done;   /* caller of pipelineUpdateCamera(): they were applied */
+
+/* a re-init waits this long for frames still being uploaded, pipelineUpdateCamera() for the capture task */
+#define PIPELINE_REINIT_WAIT_MS 20000
+#define PIPELINE_UPDATE_WAIT_MS 30000
+
+/* stored frames uploaded in one go before the upload task looks at the live queue again */
+#define STORE_DRAIN_BATCH 5
+
+/* frames taken and dropped after a wake, until exposure and white balance settled */
+#define WAKE_SETTLE_FRAMES 3
+
+/* -------------------------------- */
+/* ---------- QUEUE ACCESS ---------- */
+/* -------------------------------- */
+static void countFrame(int delta) {
+  xSemaphoreTake(queue_mutex, portMAX_DELAY);
+  frames_out += delta;
+  xSemaphoreGive(queue_mutex);
+}
+
+/* every camera buffer goes back through here, so a re-init knows when all are back */
+static void returnFrame(camera_fb_t *fb) {
+  halCameraFbReturn(fb);
+  countFrame(-1);
+}
+
+static int framesOut() {
+  xSemaphoreTake(queue_mutex, portMAX_DELAY);
+  int count = frames_out;
+  xSemaphoreGive(queue_mutex);
+  return count;
+}
+
+static void enqueueFrame(camera_fb_t *fb) {
+  void *evicted = NULL;
+
+  while (true) {
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    bool pushed = frameQueuePush(&frame_queue, fb, &evicted);
+    xSemaphoreGive(queue_mutex);
+
+    if (pushed) break;
+
+    /* FRAME_QUEUE_BLOCK: wait until the upload task takes a frame */
+    xSemaphoreTake(slot_free, portMAX_DELAY);
+  }
+  xSemaphoreGive(frame_ready);
+
+  if (evicted) {
+    Serial.println("---- Queue full. Dropped oldest frame");
+    returnFrame((camera_fb_t *)evicted);
+  }
+}
+
+/* waits at most timeout ticks for a frame; NULL on timeout */
+static camera_fb_t *dequeueFrame(TickType_t timeout = portMAX_DELAY) {
+  void *frame = NULL;
+  TickType_t start = xTaskGetTickCount();
+
+  while (true) {
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    bool popped = frameQueuePop(&frame_queue, &frame);
+    xSemaphoreGive(queue_mutex);
+
+    if (popped) break;
+
+    TickType_t waited = xTaskGetTickCount() - start;
+    if (timeout != portMAX_DELAY && waited >= timeout) {
+      return NULL;
+    }
+    xSemaphoreTake(frame_ready, timeout == portMAX_DELAY ? portMAX_DELAY : timeout - waited);
+  }
+  xSemaphoreGive(slot_free);
+
+  return (camera_fb_t *)frame;
+}
+
+static size_t queuedFrames() {
+  xSemaphoreTake(queue_mutex, portMAX_DELAY);
+  size_t count = frameQueueCount(&frame_queue);
+  xSemaphoreGive(queue_mutex);
+  return count;
+}
+
+static bool queueEmpty() {
+  return queuedFrames() == 0;
+}
+
+/* -------------------------------- */
+/* ---------- SCHEDULING ---------- */
+/* -------------------------------- */
+static uint32_t schedulerClock() {
+  return clock_offset + millis();
+}
+
+static void reportResult(int httpCode) {
+  const upload_feedback_t *feedback = lastUploadFeedback();
+
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  uint32_t before = scheduler.interval_ms;
+  schedulerOnResult(&scheduler, httpCode, feedback->first_byte_ms, feedback->retry_after_s, schedulerClock());
+  qualityOnUpload(&quality_control, feedback->bytes_sent, feedback->upload_ms);
+  uint32_t after = scheduler.interval_ms;
+  xSemaphoreGive(control_mutex);
+
+  if (httpCode >= 200 && httpCode < 300 && metricsBootMark(BOOT_MARK_FIRST_UPLOAD) == 0) {
+    metricsMarkBoot(BOOT_MARK_FIRST_UPLOAD, millis());
+    Serial.printf("---- First upload %lu ms after boot\n", (unsigned long)millis());
+  }
+  if (feedback->retry_after_s > 0) {
+    Serial.printf("---- Server asked to retry after %u s\n", (unsigned)feedback->retry_after_s);
+  }
+  if (after != before) {
+    Serial.printf("---- Capture interval %u -> %u ms\n", (unsigned)before, (unsigned)after);
+  }
+}
+
+/* feeds the frame size to the quality controller and applies a new setting */
+static void adjustQuality(const camera_fb_t *fb) {
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  bool changed = qualityOnFrame(&quality_control, fb->len);
+  quality_setting_t setting = quality_control.current;
+  uint32_t budget = qualityBudget(&quality_control);
+  xSemaphoreGive(control_mutex);
+
+  if (changed) {
+    Serial.printf("---- Frame budget %u bytes: jpeg quality %d, frame size %d\n",
+                  (unsigned)budget, setting.quality, (int)setting.framesize);
+    setCameraSetting(setting.quality, setting.framesize);
+  }
+}
+
+/*
+  true if fb should be uploaded. Frames that cannot be decoded always pass,
+  the gate must never lose a frame it cannot judge.
+*/
+static bool frameChanged(const camera_fb_t *fb) {
+  if (!motion_thumbnail) {
+    return true;
+  }
+
+  unsigned long t_start = millis();
+  uint16_t w, h;
+  if (!halJpegLuma(fb, motion_thumbnail, MOTION_THUMB_MAX_W, MOTION_THUMB_MAX_H, &w, &h)) {
+    return true;
+  }
+  bool changed = motionCheck(&motion, motion_thumbnail, w, h, MOTION_THUMB_MAX_W, millis());
+  metricsRecordStage(STAGE_MOTION, millis() - t_start);
+
+  if (!changed) {
+    metricsCount(COUNTER_FRAMES_UNCHANGED);
+    Serial.printf("---- Scene unchanged (%u/1000 changed), frame skipped\n", motion.score);
+  }
+  return changed;
+}
+
+/* cycle_start in millis() */
+static uint32_t nextCaptureDelay(uint32_t cycle_start) {
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  uint32_t delay_ms = schedulerNextDelay(&scheduler, clock_offset + cycle_start, schedulerClock());
+  xSemaphoreGive(control_mutex);
+  return delay_ms;
+}
+
+/* -------------------------------- */
+/* ------- CAMERA SETTINGS -------- */
+/* -------------------------------- */
+/* waits until the upload task returned every frame; queued frames are still uploaded */
+static bool waitForFrames() {
+  uint32_t start = millis();
+  while (framesOut() > 0) {
+    if (millis() - start > PIPELINE_REINIT_WAIT_MS) {
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  return true;
+}
+
+/* capture task only: applies settings handed over by pipelineUpdateCamera() */
+static void applyPendingSettings() {
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  bool pending = settings_pending;
+  camera_settings_t next = pending_settings;
+  camera_settings_t current = camera_settings;
+  settings_pending = false;
+  xSemaphoreGive(control_mutex);
+  if (!pending) {
+    return;
+  }
+
+  uint32_t changes = cameraSettingsDiff(&current, &next);
+  uint32_t framesize_bit = 1u << CAMERA_SET_FRAMESIZE;
+  pipeline_update_t result = PIPELINE_UPDATE_APPLIED;
+
+  if (cameraSettingsNeedReinit(changes, &next, getInitFramesize())) {
+    Serial.println("---- Larger frame size, re-initializing the camera");
+    if (waitForFrames() && reinitEspCamera((framesize_t)next.value[CAMERA_SET_FRAMESIZE])) {
+      result = PIPELINE_UPDATE_REINIT;
+    } else {
+      Serial.println("---- Camera re-init failed, keeping the frame size");
+      next.value[CAMERA_SET_FRAMESIZE] = current.value[CAMERA_SET_FRAMESIZE];
+      result = PIPELINE_UPDATE_FAILED;
+    }
+    /* a fresh sensor starts from its defaults; set everything again */
+    changes = ((1u << CAMERA_SETTING_COUNT) - 1) & ~framesize_bit;
+  }
+  if (!applyCameraSettings(&next, changes) && result != PIPELINE_UPDATE_FAILED) {
+    result = PIPELINE_UPDATE_FAILED;
+  }
+
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  bool framesize_changed = next.value[CAMERA_SET_FRAMESIZE] != current.value[CAMERA_SET_FRAMESIZE];
+  camera_settings = next;
+  schedulerSetTarget(&scheduler, next.value[CAMERA_SET_INTERVAL]);
+  if (framesize_changed) {
+    /* the chosen frame size is the new upper bound of the quality controller */
+    qualityInit(&quality_control, quality_control.best_quality, (framesize_t)next.value[CAMERA_SET_FRAMESIZE],
+                quality_control.max_frame_bytes, quality_control.max_upload_ms);
+  }
+  quality_setting_t setting = quality_control.current;
+  settings_result = result;
+  xSemaphoreGive(control_mutex);
+
+  if (framesize_changed) {
+    setCameraSetting(setting.quality, setting.framesize);
+  }
+  Serial.printf("---- Camera settings applied (%s)\n",
+                result == PIPELINE_UPDATE_REINIT ? "camera re-initialized"
+                : result == PIPELINE_UPDATE_FAILED ? "not all of them" : "live");
+  xSemaphoreGive(settings_done);
+}
+
+pipeline_update_t pipelineUpdateCamera(const camera_settings_t *next) {
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  pending_settings = *next;
+  settings_pending = true;
+  xSemaphoreGive(control_mutex);
+
+  xSemaphoreTake(settings_done, 0);   /* left over from an update that timed out */
+  xSemaphoreGive(settings_wake);
+  if (xSemaphoreTake(settings_done, pdMS_TO_TICKS(PIPELINE_UPDATE_WAIT_MS)) != pdTRUE) {
+    return PIPELINE_UPDATE_PENDING;
+  }
+
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  pipeline_update_t result = settings_result;
+  xSemaphoreGive(control_mutex);
+  return result;
+}
+
+void pipelineCameraSettings(camera_settings_t *settings) {
+  xSemaphoreTake(control_mutex, portMAX_DELAY);
+  *settings = camera_settings;
+  xSemaphoreGive(control_mutex);
+}
+
+/* -------------------------------- */
+/* ---------- LOGGING ---------- */
+/* -------------------------------- */
+static void logHttpCode(int httpCode) {
+  if (httpCode == -1) {
+    Serial.println("---- Camera error. Could not capture image");
+    return;
+  } else if (httpCode == -2) {
+    Serial.println("---- Network error. Could not start the host connection");
+    return;
+  }  else if (httpCode == -3) {
+    Serial.println("---- Data error. Could not send the complete image");
+    return;
+  } else if (httpCode == -4) {
+    Serial.println("---- HTTP error. Invalid or missing HTTP response");
+    return;
+  }
+
+  Serial.printf("---- %s responded with status: %d\n", pipeline_config->UPLOAD_URL, httpCode);
+
+  switch (httpCode) {
+    case 200:
+    case 201:
+        Serial.println("------ Success");
+        break;
+
+    case 400:
+        Serial.println("------ Bad Request");
+        break;
+
+    case 401:
+    case 403:
+        Serial.println("------ Unauthorized or Forbidden");
+        break;
+
+    case 404:
+        Serial.println("------ URL Not Found");
+        break;
+
+    case 500:
+    case 502:
+    case 503:
+        Serial.println("------ Server-side error");
+        break;
+
+    default:
+        Serial.printf("------ Unexpected response code: %d\n", httpCode);
+        break;
+  }
+}
+
+/* -------------------------------- */
+/* ---------- TASKS ---------- */
+/* -------------------------------- */
+static void captureTask(void *arg) {
+  while (true) {
+    unsigned long t_capture_start = millis();
+    camera_fb_t *fb = captureImage();
+    if (!fb) {
+      metricsRecordResult(-1);
+      logHttpCode(-1);
+    } else {
+      countFrame(1);
+      metricsMarkBoot(BOOT_MARK_FIRST_CAPTURE, millis());
+      metricsRecordStage(STAGE_CAPTURE, millis() - t_capture_start);
+      adjustQuality(fb);
+      if (frameChanged(fb)) {
+        enqueueFrame(fb);
+      } else {
+        returnFrame(fb);
+      }
+    }
+
+    /* whatever the capture took is already part of the interval; new settings wake the task early */
+    while (xSemaphoreTake(settings_wake, pdMS_TO_TICKS(nextCaptureDelay(t_capture_start))) == pdTRUE) {
+      applyPendingSettings();
+    }
+  }
+}
+
+/* the frame never reached the server; a later attempt may succeed */
+static bool worthRetrying(int httpCode) {
+  return httpCode == -2 || httpCode == -3 || httpCode == -4 || httpCode >= 500;
+}
+
+/*
+  Uploads up to STORE_DRAIN_BATCH stored frames, newest first.
+  Stops at the first failure that means the server is still unreachable.
+*/
+static void drainStore() {
+  for (int i = 0; i < STORE_DRAIN_BATCH && frameStoreCount(&frame_store) > 0 && queueEmpty(); i++) {
+    stored_frame_t stored;
+    if (!frameStorePeekNewest(&frame_store, &stored)) {
+      return;
+    }
+
+    Serial.printf("-- Trying to post stored image number %u (%u stored)\n",
+                  stored.info.sequence, (unsigned)frameStoreCount(&frame_store));
+
+    camera_fb_t fb = {};
+    fb.buf = (uint8_t *)stored.data;
+    fb.len = stored.len;
+
+    int httpCode = postImage(pipeline_config->UPLOAD_URL, &fb, &stored.info);
+    reportResult(httpCode);
+    metricsCount(COUNTER_UPLOADS);
+    metricsCount(COUNTER_FRAMES);
+    metricsRecordResult(httpCode);
+    logHttpCode(httpCode);
+
+    if (worthRetrying(httpCode)) {
+      return;
+    }
+    /* 2xx, or a 4xx that will not get better by sending the frame again */
+    frameStoreAck(&frame_store, &stored);
+  }
+}
+
+/* numbers the frame and notes when it was captured and where it was cut from */
+static frame_info_t frameInfo(const camera_fb_t *fb) {
+  frame_info_t info = { frame_counter++, halFrameTimestamp(fb), halFrameUptime(fb), 0, 0 };
+  halFrameOffset(fb, &info.roi_x, &info.roi_y);
+  return info;
+}
+
+static void uploadSingle(camera_fb_t *fb) {
+  frame_info_t info = frameInfo(fb);
+
+  Serial.println("");
+  Serial.printf("-- Trying to post image number %u (%u queued)\n", info.sequence, (unsigned)queuedFrames());
+
+  int httpCode = postImage(pipeline_config->UPLOAD_URL, fb, &info);
+  reportResult(httpCode);
+
+  if (worthRetrying(httpCode) && frameStorePut(&frame_store, fb->buf, fb->len, &info)) {
+    Serial.printf("---- Kept image %u for later (%u stored)\n", info.sequence, (unsigned)frameStoreCount(&frame_store));
+  }
+
+  /*
+    ALWAYS free the image from memory otherwise the fun won't last for a long time...
+  */
+  returnFrame(fb);
+
+  metricsCount(COUNTER_UPLOADS);
+  metricsCount(COUNTER_FRAMES);
+  metricsRecordResult(httpCode);
+  logHttpCode(httpCode);
+  Serial.printf("-- Finished posting image %u\n", info.sequence);
+
+  if (httpCode >= 200 && httpCode < 300) {
+    drainStore();
+  }
+}
+
+/*
+  Batch mode: collects up to BATCH_SIZE frames, or whatever arrived within
+  BATCH_TIMEOUT_MS after the first one, and posts them in one request.
+  The frames stay in their camera buffers until the request is done.
+*/
+static void uploadBatch(camera_fb_t *first, size_t batch_size) {
+  camera_fb_t *fbs[HTTP_BATCH_MAX];
+  frame_info_t infos[HTTP_BATCH_MAX];
+  size_t count = 0;
+
+  TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(pipeline_config->BATCH_TIMEOUT_MS);
+  camera_fb_t *fb = first;
+  while (fb) {
+    fbs[count] = fb;
+    infos[count] = frameInfo(fb);
+    count++;
+    if (count == batch_size) break;
+
+    TickType_t now = xTaskGetTickCount();
+    fb = (int32_t)(deadline - now) > 0 ? dequeueFrame(deadline - now) : NULL;
+  }
+
+  Serial.println("");
+  Serial.printf("-- Trying to post images %u..%u (%u queued)\n",
+                infos[0].sequence, infos[count - 1].sequence, (unsigned)queuedFrames());
+
+  int httpCode = postBatch(pipeline_config->UPLOAD_URL, fbs, infos, count);
+  reportResult(httpCode);
+
+  for (size_t i = 0; i < count; i++) {
+    if (worthRetrying(httpCode)) {
+      frameStorePut(&frame_store, fbs[i]->buf, fbs[i]->len, &infos[i]);
+    }
+    returnFrame(fbs[i]);
+  }
+
+  metricsCount(COUNTER_UPLOADS);
+  metricsCount(COUNTER_FRAMES, count);
+  metricsRecordResult(httpCode);
+  logHttpCode(httpCode);
+  Serial.printf("-- Finished posting %u images\n", (unsigned)count);
+
+  if (httpCode >= 200 && httpCode < 300) {
+    drainStore();
+  }
+}
+
+static void uploadTask(void *arg) {
+  size_t batch_size = pipeline_config->BATCH_SIZE;
+  if (batch_size < 1) batch_size = 1;
+  if (batch_size > HTTP_BATCH_MAX) batch_size = HTTP_BATCH_MAX;
+
+  while (true) {
+    camera_fb_t *fb = dequeueFrame();
+    if (batch_size == 1) {
+      uploadSingle(fb);
+    } else {
+      uploadBatch(fb, batch_size);
+    }
+  }
+}
+
+static void initFrameStore(esp_config_t *esp_config) {
+  size_t arena_cap = (size_t)esp_config->STORE_RAM_KB * 1024;
+  uint8_t *arena = arena_cap ? (uint8_t *)halAllocLarge(arena_cap) : NULL;
+  uint8_t *scratch = esp_config->STORE_SPILL ? (uint8_t *)halAllocLarge(FRAME_STORE_SEGMENT_SIZE) : NULL;
+
+  if (arena_cap && !arena) {
+    Serial.println("---- Could not allocate the offline buffer");
+    arena_cap = 0;
+  }
+  frameStoreInit(&frame_store, arena, arena_cap, scratch, FRAME_STORE_SEGMENT_SIZE, esp_config->STORE_SPILL);
+
+  Serial.printf("-- offline store: %u KB RAM, spill %s, %u frames recovered\n",
+                (unsigned)(arena_cap / 1024), frame_store.spill ? "on" : "off",
+                (unsigned)frameStoreCount(&frame_store));
+}
+
+void startPipeline(esp_config_t *esp_config, uint32_t first_sequence) {
+  pipeline_config = esp_config;
+  frame_counter = first_sequence;
+
+  frameQueueInit(&frame_queue, esp_config->QUEUE_DEPTH, esp_config->QUEUE_POLICY);
+  queue_mutex = xSemaphoreCreateMutex();
+  frame_ready = xSemaphoreCreateBinary();
+  slot_free = xSemaphoreCreateBinary();
+  control_mutex = xSemaphoreCreateMutex();
+  settings_wake = xSemaphoreCreateBinary();
+  settings_done = xSemaphoreCreateBinary();
+  camera_settings = esp_config->CAMERA;
+  schedulerInit(&scheduler, camera_settings.value[CAMERA_SET_INTERVAL]);
+
+  int quality;
+  framesize_t framesize;
+  getCameraSetting(&quality, &framesize);
+  qualityInit(&quality_control, quality, framesize, esp_config->MAX_FRAME_BYTES, esp_config->MAX_UPLOAD_MS);
+
+  initFrameStore(esp_config);
+
+  motionInit(&motion, esp_config->MOTION_THRESHOLD, (uint32_t)esp_config->MOTION_KEEPALIVE_S * 1000);
+  if (motionEnabled(&motion)) {
+    motion_thumbnail = (uint8_t *)halAllocLarge(MOTION_THUMB_MAX_W * MOTION_THUMB_MAX_H);
+    Serial.printf("-- change detection: threshold %u/1000, keepalive %d s%s\n", motion.threshold,
+                  esp_config->MOTION_KEEPALIVE_S, motion_thumbnail ? "" : " (no memory, off)");
+  }
+
+  Serial.printf("-- starting pipeline (queue depth %u, policy %s, batch %d)\n",
+                (unsigned)frame_queue.depth,
+                frame_queue.policy == FRAME_QUEUE_BLOCK ? "block" : "drop_oldest",
+                esp_config->BATCH_SIZE);
+
+  /* upload task does TLS and needs the bigger stack; WiFi lives on core 0 */
+  xTaskCreatePinnedToCore(uploadTask, "upload", 12288, NULL, 2, NULL, 1);
+  xTaskCreatePinnedToCore(captureTask, "capture", 4096, NULL, 3, NULL, 0);
+}
+
+/* -------------------------------- */
+/* ---------- DEEP SLEEP ---------- */
+/* -------------------------------- */
+static unsigned long wake_capture_start;
+
+camera_fb_t *pipelineCaptureWake(esp_config_t *esp_config, const duty_state_t *state, uint32_t *capture_ms) {
+  pipeline_config = esp_config;
+  frame_counter = state->sequence;
+  clock_offset = state->clock_ms;
+
+  frameQueueInit(&frame_queue, 1, FRAME_QUEUE_DROP_OLDEST);
+  queue_mutex = xSemaphoreCreateMutex();
+  control_mutex = xSemaphoreCreateMutex();
+  camera_settings = esp_config->CAMERA;
+  scheduler = state->scheduler;
+  schedulerSetTarget(&scheduler, camera_settings.value[CAMERA_SET_INTERVAL]);
+
+  int quality;
+  framesize_t framesize;
+  getCameraSetting(&quality, &framesize);
+  qualityInit(&quality_control, quality, framesize, esp_config->MAX_FRAME_BYTES, esp_config->MAX_UPLOAD_MS);
+
+  /* the sensor starts from scratch after every sleep */
+  for (int i = 0; i < WAKE_SETTLE_FRAMES; i++) {
+    camera_fb_t *fb = halCameraFbGet();
+    if (fb) halCameraFbReturn(fb);
+  }
+
+  wake_capture_start = millis();
+  *capture_ms = wake_capture_start;
+  camera_fb_t *fb = captureImage();
+  if (!fb) {
+    metricsRecordResult(-1);
+    logHttpCode(-1);
+    return NULL;
+  }
+  countFrame(1);
+  metricsMarkBoot(BOOT_MARK_FIRST_CAPTURE, millis());
+  metricsRecordStage(STAGE_CAPTURE, millis() - wake_capture_start);
+  return fb;
+}
+
+uint32_t pipelineUploadWake(camera_fb_t *fb, bool online, duty_state_t *state) {
+  /* no RAM tier: the PSRAM does not keep its content over the sleep, frames go straight to flash */
+  uint8_t *scratch = pipeline_config->STORE_SPILL ? (uint8_t *)halAllocLarge(FRAME_STORE_SEGMENT_SIZE) : NULL;
+  frameStoreInit(&frame_store, NULL, 0, scratch, FRAME_STORE_SEGMENT_SIZE, pipeline_config->STORE_SPILL);
+
+  if (fb && online) {
+    /* stores the frame if the upload fails, sends stored ones after a success */
+    uploadSingle(fb);
+  } else if (fb) {
+    frame_info_t info = frameInfo(fb);
+    reportResult(-2);
+    logHttpCode(-2);
+    if (frameStorePut(&frame_store, fb->buf, fb->len, &info)) {
+      Serial.printf("---- Kept image %u for later (%u stored)\n", info.sequence, (unsigned)frameStoreCount(&frame_store));
+    }
+    returnFrame(fb);
+  } else if (online) {
+    drainStore();
+  }
+
+  state->sequence = frame_counter;
+  state->scheduler = scheduler;
+  return nextCaptureDelay(wake_capture_start);
+}
@@ -0,0 +1,42 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "esp_init.h"
+
+/*
+  Starts the capture task (producer) and the upload task (consumer).
+  Both tasks run forever; the bounded frame queue between them decouples
+  esp_camera_fb_get() from the HTTP round trip. Frames are numbered from
+  first_sequence on.
+*/
+void startPipeline(esp_config_t *esp_config, uint32_t first_sequence = 0);
+
+/*
+  Deep sleep (duty_cycle.h): one frame per wake, without the tasks.
+
+  pipelineCaptureWake() takes the frame number and the scheduler from state and
+  captures once the sensor settled (NULL if the camera failed); capture_ms is the
+  millis() the capture started at. It runs while Wi-Fi connects. pipelineUploadWake() uploads the frame, or keeps it in the flash store
+  if the device is offline or the upload failed, writes frame number and scheduler
+  back into state and returns the delay until the next capture.
+*/
+camera_fb_t *pipelineCaptureWake(esp_config_t *esp_config, const duty_state_t *state, uint32_t *capture_ms);
+uint32_t pipelineUploadWake(camera_fb_t *fb, bool online, duty_state_t *state);
+
+typedef enum {
+  PIPELINE_UPDATE_APPLIED = 0,   /* set on the running sensor */
+  PIPELINE_UPDATE_REINIT,        /* the camera was re-initialized for a larger frame size */
+  PIPELINE_UPDATE_FAILED,        /* the sensor refused a value or the re-init failed */
+  PIPELINE_UPDATE_PENDING        /* the capture task is busy, it applies them when it gets to it */
+} pipeline_update_t;
+
+/*
+  Hands new camera settings to the capture task and waits until it applied them
+  between two captures. One caller at a time.
+*/
+pipeline_update_t pipelineUpdateCamera(const camera_settings_t *next);
+
+/* the settings the camera currently runs with; esp_config->CAMERA stays what was loaded at boot */
+void pipelineCameraSettings(camera_settings_t *settings);
+
+#endif
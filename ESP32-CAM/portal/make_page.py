@@ -0,0 +1,53 @@
+"""
+Compresses portal/index.html into portal_page_gz.h (flash-resident, sent as it is
+with Content-Encoding: gzip). Run it after every change to the page:
+
+    python3 portal/make_page.py
+
+Lines are stripped of their indentation and HTML comments are dropped before
+compressing; the output is reproducible (no timestamp in the gzip header).
+"""
+
+import gzip
+import os
+import re
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SOURCE = os.path.join(HERE, "index.html")
+TARGET = os.path.join(HERE, "..", "portal_page_gz.h")
+
+
+def minify(html):
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    lines = (line.strip() for line in html.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+def main():
+    with open(SOURCE, encoding="utf-8") as file:
+        html = minify(file.read()).encode()
+    data = gzip.compress(html, compresslevel=9, mtime=0)
+
+    rows = []
+    for start in range(0, len(data), 16):
+        rows.append("  " + ", ".join(f"0x{b:02x}" for b in data[start : start + 16]) + ",")
+
+    with open(TARGET, "w", encoding="utf-8") as file:
+        file.write(
+            "/* generated by portal/make_page.py from portal/index.html, do not edit */\n"
+            "#ifndef PORTAL_PAGE_GZ_H\n"
+            "#define PORTAL_PAGE_GZ_H\n\n"
+            "#include <stdint.h>\n\n"
+            "#ifndef PROGMEM\n"
+            "#define PROGMEM\n"
+            "#endif\n\n"
+            f"#define PORTAL_PAGE_HTML_LEN {len(html)}\n\n"
+            "static const uint8_t PORTAL_PAGE_GZ[] PROGMEM = {\n"
+            + "\n".join(rows)
+            + "\n};\n\n#endif\n"
+        )
+    print(f"{len(html)} bytes of HTML -> {len(data)} bytes gzip in {os.path.relpath(TARGET)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+#include "portal_handler.h"
+#include "portal_page.h"
+#include "config.h"
+#include "hal.h"
+#include <stdio.h>
+#include <string.h>
+
+/* what the form shows; the fields and their ranges are the config table (config.h) */
+static esp_config_t portal_config;
+static char session_token[PORTAL_SESSION_MAX];
+
+
+/*
+  -----------------------------
+  ---------- HELPERS ----------
+  -----------------------------
+*/
+#define PORTAL_VALUE_MAX 256
+
+/* URL-decoded value of a form field with the blanks at both ends cut off, "" if it is missing */
+static char *formValue(const portal_request_t *req, const char *name, char *value, size_t cap) {
+  portalFormValue(req->form, name, value, cap);
+
+  char *start = value;
+  while (*start == ' ' || *start == '\t') start++;
+  size_t len = strlen(start);
+  while (len > 0 && (start[len - 1] == ' ' || start[len - 1] == '\t')) start[--len] = '\0';
+  return start;
+}
+
+/*
+  -------------------------------------
+  -- LOAD EXISTING CONFIG TO PREFILL --
+  -------------------------------------
+*/
+void portalBegin(const char *session) {
+  static char file[CONFIG_FILE_MAX];
+  config_load_t result = configLoadFile(PORTAL_CONFIG_PATH, &portal_config, file, sizeof(file));
+  if (result == CONFIG_LOAD_MISSING) {
+    halLog("config.json not found, using defaults\n");
+  }
+  snprintf(session_token, sizeof(session_token), "%s", session);
+}
+
+bool portalConfigured() {
+  return portal_config.wifi_config.SSID[0] && portal_config.UPLOAD_URL[0];
+}
+
+
+/*
+  ----------------------------------
+  ----- LIVE VALUES OF THE FORM ----
+  ----------------------------------
+
+  The page (portal/index.html) is static and fills its fields from GET /settings;
+  the keys are the form field names.
+*/
+#define PORTAL_SETTINGS_MAX 1280
+
+static void sendSettings(bool head_only, http_write_fn write, void *ctx) {
+  static char json[PORTAL_SETTINGS_MAX];
+  portal_json_t out;
+
+  portalJsonBegin(&out, json, sizeof(json));
+  portalJsonString(&out, "session", session_token);
+  configFormJson(&out, &portal_config);
+
+  size_t len = portalJsonEnd(&out);
+  if (len == 0) {
+    portalSendError(500, write, ctx);
+    return;
+  }
+  portalSendResponse(200, "application/json", "Cache-Control: no-store\r\n",
+                     (const uint8_t *)json, len, head_only, write, ctx, NULL);
+}
+
+
+/*
+  ----------------------------------
+  -- UPDATE JSON CONFIG ON DEVICE --
+  ----------------------------------
+
+  The form is applied to the stored file as it is now, so settings changed through
+  the control endpoint since the portal opened are kept. A refused form value keeps
+  the stored one.
+*/
+static void saveForm(const portal_request_t *req) {
+  static char file[CONFIG_FILE_MAX];
+  static esp_config_t next;
+
+  configLoadFile(PORTAL_CONFIG_PATH, &next, file, sizeof(file));
+  configApplyForm(&next, req->form);
+
+  // split URL fields, combined into the upload URL
+  char base_value[PORTAL_VALUE_MAX], endpoint_value[PORTAL_VALUE_MAX];
+  char *base = formValue(req, "upload_base", base_value, sizeof(base_value));
+  char *endpoint = formValue(req, "upload_endpoint", endpoint_value, sizeof(endpoint_value));
+
+  size_t base_len = strlen(base);
+  if (base_len > 0 && base[base_len - 1] == '/') {
+    base[base_len - 1] = '\0';
+  }
+  if (endpoint[0] == '/') {
+    endpoint++;
+  }
+
+  char url[2 * PORTAL_VALUE_MAX];
+  if (base[0] && endpoint[0]) {
+    snprintf(url, sizeof(url), "%s/%s", base, endpoint);
+  } else {
+    snprintf(url, sizeof(url), "%s", base);
+  }
+  if (!configFieldSet(&next, configFormField("upload_url"), url)) {
+    halLog("---- upload URL too long, kept the stored one\n");
+  }
+
+  /* a power loss while saving leaves the old file (config.h) */
+  if (!configSaveFile(PORTAL_CONFIG_PATH, &next, file, sizeof(file))) {
+    halLog("Failed to write config.json\n");
+    return;
+  }
+  portal_config = next;
+}
+
+
+/*
+  ----------------------------------
+  -------- ANSWER A REQUEST --------
+  ----------------------------------
+*/
+bool portalHandleRequest(const portal_request_t *req, http_write_fn write, void *ctx) {
+  if (portalRequestFailed(req)) {
+    portalSendError(req->error, write, ctx);
+    return false;
+  }
+  bool head_only = strcmp(req->method, "HEAD") == 0;
+
+  if (strcmp(req->path, "/settings") == 0) {
+    sendSettings(head_only, write, ctx);
+    return false;
+  }
+
+  // /save with parameters (POST body, or the query of the old GET form)
+  if (strncmp(req->path, "/save", 5) == 0 && req->form_len > 0) {
+    // Only treat as valid if session token matches
+    char session[PORTAL_SESSION_MAX];
+    portalFormValue(req->form, "session", session, sizeof(session));
+    if (session_token[0] && strcmp(session, session_token) == 0) {
+      saveForm(req);
+      portalSendRedirect("/?saved=1", write, ctx);
+      return true;
+    }
+    portalSendRedirect("/", write, ctx);
+    return false;
+  }
+
+  // anything else -> the form
+  portalSendPage(head_only, write, ctx, NULL);
+  return false;
+}
@@ -0,0 +1,32 @@
+#ifndef PORTAL_HANDLER_H
+#define PORTAL_HANDLER_H
+
+#include "http_request.h"
+#include "portal_request.h"
+
+/*
+  Request handling of the configuration portal, without the access point around it:
+  answers one parsed request (portal_request.h) through an http_write_fn and saves
+  the form to config.json through the HAL filesystem. host.cpp runs it on the
+  ESP32's access point, host/linux_main.cpp on a TCP socket of the host.
+
+    GET/HEAD /settings   current values of the form (JSON, see portal/index.html)
+    POST /save           new values; only with the session token of this boot
+    anything else        the page (also answers the OS captive portal probes)
+*/
+#define PORTAL_CONFIG_PATH "/config.json"
+#define PORTAL_SESSION_MAX 16
+
+/*
+  Loads config.json to prefill the form. session is the token the form has to send
+  back with a save, so only a page served since this call can change the config.
+*/
+void portalBegin(const char *session);
+
+/* answers req; returns true if it saved a new configuration */
+bool portalHandleRequest(const portal_request_t *req, http_write_fn write, void *ctx);
+
+/* a stored config to fall back to: only then the portal may close */
+bool portalConfigured();
+
+#endif
@@ -0,0 +1,151 @@
+#include "portal_page.h"
+#include "portal_page_gz.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PORTAL_HEAD_MAX 256
+
+/*
+  -----------------------------
+  --------- RESPONSES ---------
+  -----------------------------
+*/
+static const char *statusReason(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 303: return "See Other";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default:  return "Bad Request";
+  }
+}
+
+bool portalSendResponse(int status, const char *content_type, const char *extra_headers,
+                        const uint8_t *body, size_t len, bool head_only,
+                        http_write_fn write, void *ctx, http_write_stats_t *stats) {
+  char head[PORTAL_HEAD_MAX];
+  int head_len = snprintf(head, sizeof(head),
+                          "HTTP/1.1 %d %s\r\n"
+                          "Content-Type: %s\r\n"
+                          "Content-Length: %u\r\n"
+                          "%s"
+                          "Connection: close\r\n\r\n",
+                          status, statusReason(status), content_type, (unsigned)len,
+                          extra_headers ? extra_headers : "");
+  if (head_len < 0 || head_len >= (int)sizeof(head)) return false;
+
+  uint8_t staging[PORTAL_STAGING_MAX];
+  http_segment_t segments[2] = {
+    { (const uint8_t *)head, (size_t)head_len },
+    { body, head_only ? 0 : len },
+  };
+  return httpWriteGather(segments, 2, staging, sizeof(staging), write, ctx, stats);
+}
+
+bool portalSendPage(bool head_only, http_write_fn write, void *ctx, http_write_stats_t *stats) {
+  return portalSendResponse(200, "text/html", "Content-Encoding: gzip\r\nCache-Control: no-cache\r\n",
+                            PORTAL_PAGE_GZ, sizeof(PORTAL_PAGE_GZ), head_only, write, ctx, stats);
+}
+
+bool portalSendError(int status, http_write_fn write, void *ctx) {
+  char body[48];
+  int len = snprintf(body, sizeof(body), "%s\n", statusReason(status));
+  return portalSendResponse(status, "text/plain", NULL, (const uint8_t *)body, (size_t)len, false,
+                            write, ctx, NULL);
+}
+
+bool portalSendRedirect(const char *location, http_write_fn write, void *ctx) {
+  char header[PORTAL_HEAD_MAX / 2];
+  int len = snprintf(header, sizeof(header), "Location: %s\r\n", location);
+  if (len < 0 || len >= (int)sizeof(header)) return false;
+  return portalSendResponse(303, "text/plain", header, NULL, 0, false, write, ctx, NULL);
+}
+
+size_t portalPageSize(size_t *html_len) {
+  if (html_len) *html_len = PORTAL_PAGE_HTML_LEN;
+  return sizeof(PORTAL_PAGE_GZ);
+}
+
+/*
+  -----------------------------
+  ------------ JSON -----------
+  -----------------------------
+*/
+static void put(portal_json_t *json, const char *data, size_t len) {
+  if (json->failed) return;
+  if (json->len + len + 1 > json->cap) {   /* keep room for the NUL */
+    json->failed = true;
+    return;
+  }
+  memcpy(json->buf + json->len, data, len);
+  json->len += len;
+  json->buf[json->len] = '\0';
+}
+
+/* '"' and '\' are escaped, control characters become \u00XX */
+static void putString(portal_json_t *json, const char *value) {
+  put(json, "\"", 1);
+  for (const char *c = value; *c; c++) {
+    unsigned char ch = (unsigned char)*c;
+    if (ch == '"' || ch == '\\') {
+      char escaped[2] = { '\\', (char)ch };
+      put(json, escaped, 2);
+    } else if (ch < 0x20) {
+      char escaped[8];
+      int len = snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+      put(json, escaped, (size_t)len);
+    } else {
+      put(json, (const char *)c, 1);
+    }
+  }
+  put(json, "\"", 1);
+}
+
+static void putKey(portal_json_t *json, const char *key) {
+  if (json->len > 0 && json->buf[json->len - 1] != '{') put(json, ",", 1);
+  putString(json, key);
+  put(json, ":", 1);
+}
+
+void portalJsonBegin(portal_json_t *json, char *buf, size_t cap) {
+  json->buf = buf;
+  json->cap = cap;
+  json->len = 0;
+  json->failed = cap == 0;
+  put(json, "{", 1);
+}
+
+void portalJsonString(portal_json_t *json, const char *key, const char *value) {
+  putKey(json, key);
+  putString(json, value);
+}
+
+void portalJsonInt(portal_json_t *json, const char *key, long value) {
+  char number[24];
+  int len = snprintf(number, sizeof(number), "%ld", value);
+  putKey(json, key);
+  put(json, number, (size_t)len);
+}
+
+void portalJsonOpen(portal_json_t *json, const char *key) {
+  putKey(json, key);
+  put(json, "{", 1);
+}
+
+void portalJsonClose(portal_json_t *json) {
+  put(json, "}", 1);
+}
+
+size_t portalJsonEnd(portal_json_t *json) {
+  put(json, "}", 1);
+  return json->failed ? 0 : json->len;
+}
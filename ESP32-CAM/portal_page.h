@@ -0,0 +1,66 @@
+#ifndef PORTAL_PAGE_H
+#define PORTAL_PAGE_H
+
+#include "http_request.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Responses of the configuration portal. The page itself (portal/index.html) is
+  stored gzip-compressed in flash (portal_page_gz.h, made by portal/make_page.py)
+  and goes out as it is; the live values come from GET /settings as a small JSON
+  object, rendered without allocating (portal_json_t).
+
+  Like portal_request.cpp this is plain C over an http_write_fn, so the write
+  pattern can be measured on the host (host/portal_bench.cpp). The control endpoint
+  (control.cpp) answers through the same functions.
+*/
+
+/* room for the response head and the first bytes of the body; the rest of a body is written from its source */
+#define PORTAL_STAGING_MAX 512
+
+/*
+  Sends one complete response: status line, Content-Type, Content-Length,
+  extra_headers (each ending in "\r\n", may be NULL), "Connection: close" and the
+  body, coalesced by httpWriteGather() in a staging buffer on the stack.
+  head_only leaves the body out (HEAD). Returns true if every byte was accepted by the transport.
+*/
+bool portalSendResponse(int status, const char *content_type, const char *extra_headers,
+                        const uint8_t *body, size_t len, bool head_only,
+                        http_write_fn write, void *ctx, http_write_stats_t *stats);
+
+/* the configuration page, Content-Encoding: gzip */
+bool portalSendPage(bool head_only, http_write_fn write, void *ctx, http_write_stats_t *stats);
+
+/* text/plain answer with the reason phrase of status */
+bool portalSendError(int status, http_write_fn write, void *ctx);
+
+/* 303 See Other to location */
+bool portalSendRedirect(const char *location, http_write_fn write, void *ctx);
+
+/* bytes of the compressed page in flash, and of the HTML it expands to */
+size_t portalPageSize(size_t *html_len);
+
+/*
+  JSON object writer over a caller buffer. Once something does not fit the
+  writer stays failed and portalJsonEnd() returns 0.
+*/
+typedef struct {
+  char *buf;
+  size_t cap;
+  size_t len;
+  bool failed;
+} portal_json_t;
+
+void portalJsonBegin(portal_json_t *json, char *buf, size_t cap);
+void portalJsonString(portal_json_t *json, const char *key, const char *value);   /* value is escaped */
+void portalJsonInt(portal_json_t *json, const char *key, long value);
+
+/* a nested object under key, until portalJsonClose() */
+void portalJsonOpen(portal_json_t *json, const char *key);
+void portalJsonClose(portal_json_t *json);
+
+/* closes the object; returns its length (without the NUL), 0 on overflow */
+size_t portalJsonEnd(portal_json_t *json);
+
+#endif
@@ -0,0 +1,184 @@
+/* generated by portal/make_page.py from portal/index.html, do not edit */
+#ifndef PORTAL_PAGE_GZ_H
+#define PORTAL_PAGE_GZ_H
+
+#include <stdint.h>
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+#define PORTAL_PAGE_HTML_LEN 7076
+
+static const uint8_t PORTAL_PAGE_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x59, 0xff, 0x73, 0xdb, 0xb6,
+  0x15, 0xff, 0xdd, 0x7f, 0x05, 0xc6, 0xdc, 0xee, 0xa4, 0xab, 0x2c, 0x89, 0xaa, 0xe3, 0x38, 0xb2,
+  0xa4, 0x5d, 0x9a, 0x7a, 0x5d, 0xb6, 0xb4, 0xc9, 0xe2, 0x74, 0x5d, 0xaf, 0xb7, 0xcb, 0x41, 0x24,
+  0x28, 0xa2, 0x26, 0x09, 0x86, 0x00, 0x2d, 0x69, 0x6e, 0xfe, 0xf7, 0x7d, 0x1e, 0x00, 0x52, 0xa2,
+  0x4d, 0xf5, 0xba, 0xf3, 0xc5, 0x26, 0xc1, 0xf7, 0x3e, 0xef, 0xfb, 0x7b, 0x00, 0xb2, 0xf8, 0xd3,
+  0xb7, 0xef, 0x5e, 0x7f, 0xfc, 0xf9, 0xfd, 0x0d, 0x4b, 0x4d, 0x9e, 0xad, 0x16, 0xfe, 0xb7, 0xe0,
+  0xf1, 0xea, 0x6c, 0x91, 0x0b, 0xc3, 0x59, 0xc1, 0x73, 0xb1, 0x0c, 0xee, 0xa5, 0xd8, 0x96, 0xaa,
+  0x32, 0x01, 0x8b, 0x54, 0x61, 0x44, 0x61, 0x96, 0xc1, 0x56, 0xc6, 0x26, 0x5d, 0xc6, 0xe2, 0x5e,
+  0x46, 0xe2, 0xdc, 0xbe, 0x8c, 0x98, 0x2c, 0xa4, 0x91, 0x3c, 0x3b, 0xd7, 0x11, 0xcf, 0xc4, 0x32,
+  0x0c, 0x00, 0x62, 0xa4, 0xc9, 0xc4, 0xea, 0xe6, 0xf6, 0xfd, 0xd7, 0x33, 0xf6, 0x5a, 0x15, 0x89,
+  0xdc, 0x2c, 0x26, 0x6e, 0xed, 0x6c, 0xa1, 0xcd, 0x9e, 0xfe, 0xae, 0x55, 0xbc, 0x7f, 0xc8, 0x79,
+  0xb5, 0x91, 0xc5, 0x7c, 0x7a, 0x5d, 0xf2, 0x38, 0x96, 0xc5, 0x66, 0x3e, 0x9b, 0x96, 0xbb, 0xeb,
+  0x04, 0xd2, 0xce, 0x13, 0x9e, 0xcb, 0x6c, 0x3f, 0xff, 0x9b, 0xc8, 0xee, 0x85, 0x91, 0x11, 0x1f,
+  0xbd, 0xaa, 0x20, 0x64, 0xa4, 0x79, 0xa1, 0xcf, 0xb5, 0xa8, 0x64, 0x72, 0xbd, 0xe6, 0xd1, 0xdd,
+  0xa6, 0x52, 0x75, 0x11, 0xcf, 0x9f, 0x25, 0xcf, 0xe9, 0xe7, 0xfa, 0xcb, 0xd9, 0x38, 0xe2, 0x55,
+  0x0c, 0xdc, 0x9d, 0xd3, 0x6e, 0xfe, 0xdc, 0x22, 0x7a, 0x39, 0x17, 0x78, 0x66, 0xbc, 0x36, 0xaa,
+  0xcb, 0x9b, 0x00, 0x4b, 0x55, 0xb1, 0xa8, 0xce, 0x2b, 0x1e, 0xcb, 0x5a, 0xcf, 0x43, 0xe2, 0x59,
+  0xab, 0xdd, 0xb9, 0x4e, 0x79, 0xac, 0xb6, 0xf3, 0x29, 0x9b, 0x81, 0xf1, 0x0a, 0xff, 0xaa, 0xcd,
+  0x9a, 0x0f, 0xa6, 0x23, 0xfb, 0x33, 0x0e, 0x67, 0xc3, 0x83, 0xe2, 0x17, 0xf8, 0x3a, 0xbb, 0x6c,
+  0xf8, 0xe4, 0x7f, 0x69, 0xd1, 0xa3, 0x62, 0x05, 0x9a, 0xa5, 0xa1, 0x37, 0xf7, 0xdc, 0xa8, 0x12,
+  0x26, 0x5b, 0x2b, 0x41, 0x28, 0x2c, 0xef, 0xb5, 0x11, 0x3b, 0x73, 0xce, 0x33, 0xb9, 0x29, 0xe6,
+  0x11, 0x5c, 0x2d, 0x2a, 0x62, 0x99, 0x1d, 0xb3, 0x58, 0xb2, 0x03, 0x57, 0x78, 0x65, 0x85, 0x79,
+  0x09, 0xc6, 0xa8, 0x7c, 0x1e, 0x42, 0x07, 0xad, 0x32, 0x19, 0xb3, 0x67, 0x42, 0x88, 0x46, 0xb7,
+  0xe6, 0x2b, 0xb1, 0x7f, 0x39, 0xcb, 0xf8, 0x5a, 0x64, 0x0f, 0xb1, 0xd4, 0x65, 0xc6, 0xf7, 0xf3,
+  0x75, 0xa6, 0xa2, 0xbb, 0xeb, 0x23, 0x21, 0x61, 0x2b, 0x64, 0x2b, 0xe4, 0x26, 0x35, 0xb0, 0x21,
+  0x8b, 0x8f, 0xa5, 0x3a, 0x14, 0x59, 0x94, 0xb5, 0x19, 0x69, 0x91, 0x89, 0xc8, 0x3c, 0x38, 0x4f,
+  0x87, 0xd3, 0xe9, 0x9f, 0x5b, 0x77, 0x90, 0xaf, 0xc2, 0x83, 0xe7, 0x2d, 0xf4, 0xe5, 0x41, 0x5f,
+  0xef, 0xe7, 0xc3, 0xca, 0xb1, 0xea, 0x51, 0x14, 0x9d, 0x70, 0x62, 0xbf, 0x1a, 0xf3, 0x44, 0x45,
+  0xb5, 0xf6, 0xca, 0xb8, 0x97, 0x07, 0x55, 0x9b, 0x4c, 0x16, 0x62, 0x5e, 0xa8, 0x42, 0x34, 0x42,
+  0x23, 0x95, 0xa9, 0x6a, 0xfe, 0x2c, 0x7c, 0xf9, 0xe2, 0x32, 0x9e, 0x75, 0xc3, 0x4b, 0x3f, 0xb3,
+  0x26, 0xbc, 0xb3, 0xe7, 0xa3, 0x30, 0xbc, 0x1a, 0xcd, 0x42, 0x1b, 0xe3, 0xab, 0x21, 0xe4, 0xac,
+  0x6b, 0x78, 0xb0, 0xe8, 0x04, 0x03, 0xe4, 0xd7, 0x3d, 0x86, 0x93, 0xd1, 0xec, 0x38, 0xb8, 0xe1,
+  0x91, 0x91, 0xc7, 0xda, 0x78, 0x17, 0xbc, 0x7c, 0xf9, 0x92, 0xbe, 0x1f, 0xa5, 0xa3, 0xd7, 0xcf,
+  0x6b, 0x4b, 0xc9, 0x19, 0xd5, 0x95, 0xc6, 0x73, 0xa9, 0xa4, 0xcd, 0x8b, 0x27, 0xd1, 0x69, 0xf4,
+  0x9b, 0xa7, 0xea, 0x5e, 0x54, 0x0f, 0x1d, 0xb0, 0x8b, 0xe7, 0x57, 0xfc, 0x6b, 0xaa, 0x8b, 0x5c,
+  0x68, 0xcd, 0x37, 0xa2, 0x8d, 0xbc, 0xd5, 0xa5, 0xa3, 0x75, 0x38, 0xeb, 0x0f, 0xd0, 0x11, 0x9c,
+  0xb8, 0x4a, 0x9e, 0x8b, 0x97, 0x8d, 0x6e, 0xe1, 0xfa, 0xb9, 0x98, 0x4d, 0xfb, 0x22, 0x78, 0x25,
+  0x2e, 0xa3, 0x97, 0x9d, 0xb4, 0x3a, 0xca, 0x85, 0x26, 0x59, 0xa7, 0x65, 0x4f, 0x44, 0xc7, 0x29,
+  0x8c, 0x7c, 0x38, 0x5a, 0x26, 0xa5, 0xbc, 0xbc, 0x17, 0x2f, 0x5e, 0x1c, 0x63, 0x7a, 0x06, 0x59,
+  0x50, 0xa4, 0x5b, 0xbb, 0x92, 0x4c, 0xec, 0xae, 0x37, 0xbc, 0xa4, 0x14, 0x3c, 0x7c, 0x66, 0x2b,
+  0x16, 0xcb, 0xfb, 0x07, 0xfa, 0x38, 0x0f, 0xb1, 0xbc, 0x98, 0xf8, 0x36, 0xb4, 0x98, 0xd8, 0xbe,
+  0xb7, 0xa0, 0x76, 0x84, 0x37, 0x10, 0xb1, 0x28, 0xe3, 0x5a, 0x2f, 0x03, 0x6a, 0x24, 0xd4, 0xcb,
+  0xd2, 0xb0, 0xd3, 0xc8, 0xea, 0x8a, 0x1b, 0xa9, 0x0a, 0xf0, 0x85, 0x5d, 0x7a, 0xef, 0xe0, 0x80,
+  0xc9, 0x78, 0x19, 0x68, 0x7e, 0x2f, 0xc0, 0xbd, 0x58, 0xaf, 0x1c, 0x17, 0xb3, 0x0b, 0xe3, 0xc5,
+  0x64, 0xbd, 0x62, 0x3f, 0xab, 0x9a, 0x45, 0xbc, 0x00, 0x9f, 0xd2, 0x82, 0x99, 0x54, 0x6a, 0x56,
+  0x82, 0x11, 0x1f, 0x81, 0x06, 0xcc, 0x44, 0x55, 0x39, 0xe3, 0x11, 0x49, 0x59, 0x06, 0x13, 0x62,
+  0x0c, 0x18, 0xba, 0x72, 0xaa, 0x80, 0xfb, 0xfe, 0xdd, 0xed, 0xc7, 0xc0, 0xb6, 0xb0, 0x48, 0xe5,
+  0x65, 0x26, 0x0c, 0xda, 0xb4, 0x4a, 0x12, 0xd2, 0xd3, 0xd6, 0x02, 0x33, 0xfb, 0x12, 0x4b, 0xa9,
+  0x8c, 0x63, 0x51, 0x04, 0xbe, 0x8f, 0x6b, 0x68, 0x06, 0x30, 0x6b, 0xcc, 0x6c, 0xf5, 0x83, 0x30,
+  0x5b, 0x55, 0xdd, 0xc1, 0x80, 0x19, 0x16, 0x6c, 0x3b, 0x60, 0x10, 0x09, 0x32, 0x2d, 0xa1, 0xf2,
+  0xed, 0xed, 0x9b, 0x6f, 0x17, 0x13, 0xbb, 0xdc, 0x82, 0x5a, 0x8b, 0xe8, 0xab, 0x87, 0xa7, 0x5e,
+  0xd5, 0x82, 0x5b, 0xae, 0x0e, 0x50, 0x09, 0x7f, 0x40, 0x04, 0x96, 0xdf, 0xfb, 0xa7, 0x3e, 0xc0,
+  0x96, 0xca, 0x83, 0x1e, 0xde, 0x1d, 0xf0, 0x01, 0xa5, 0xe3, 0x66, 0xca, 0x8f, 0x03, 0x30, 0xdb,
+  0xca, 0x2c, 0x63, 0x6b, 0xc1, 0x34, 0x7a, 0x26, 0x26, 0x11, 0xdc, 0x29, 0x58, 0x25, 0x3e, 0xd7,
+  0x42, 0x1b, 0x46, 0x31, 0x65, 0x83, 0x42, 0x19, 0x76, 0x2f, 0xb5, 0x5c, 0x67, 0xa2, 0x21, 0x40,
+  0xd6, 0x57, 0xf0, 0x09, 0x5b, 0xf3, 0x6a, 0xd8, 0xba, 0xfd, 0xc8, 0x80, 0xba, 0xcc, 0x14, 0x8f,
+  0x3f, 0xad, 0xb9, 0x16, 0xc1, 0xea, 0x47, 0xfb, 0xc2, 0x7e, 0xfc, 0xf0, 0xf6, 0x60, 0xc5, 0x91,
+  0x3e, 0x2e, 0xbf, 0xbc, 0x92, 0x1d, 0x03, 0x8f, 0x51, 0x7a, 0x1c, 0xd7, 0xf9, 0x8c, 0xd4, 0x8d,
+  0x44, 0x8a, 0x62, 0x16, 0x10, 0x9f, 0x1a, 0x53, 0xce, 0x27, 0x13, 0xb1, 0xe3, 0x14, 0xe2, 0x31,
+  0x22, 0xdd, 0xeb, 0x83, 0x6f, 0xc0, 0xe9, 0xd4, 0x72, 0x92, 0xfd, 0x9f, 0x13, 0x6a, 0x88, 0x22,
+  0xb6, 0x0d, 0xe4, 0x77, 0x54, 0x39, 0x90, 0x74, 0xd4, 0x71, 0x5f, 0x7b, 0x55, 0xb8, 0xf1, 0x1c,
+  0x6c, 0x50, 0x72, 0x93, 0x0e, 0x1f, 0x69, 0x72, 0x50, 0xa8, 0xcb, 0x75, 0x2b, 0x2a, 0xf4, 0x29,
+  0x57, 0x03, 0x2a, 0x5f, 0x53, 0x79, 0x22, 0x2a, 0x30, 0x86, 0x6b, 0xb6, 0x88, 0x54, 0x2c, 0x56,
+  0x4f, 0x3d, 0x30, 0x71, 0x5a, 0x2c, 0x26, 0xf6, 0x7b, 0x5f, 0xd0, 0xa2, 0xb4, 0x2e, 0xee, 0xa8,
+  0xe8, 0x5e, 0xbb, 0x07, 0xd6, 0x70, 0x3c, 0x4d, 0xbd, 0x86, 0xd4, 0xbb, 0xa2, 0xa8, 0xf3, 0xb5,
+  0xa8, 0x1a, 0x67, 0xb4, 0x38, 0x3d, 0x9a, 0x87, 0x6c, 0x49, 0x99, 0xd6, 0x60, 0x6b, 0xa4, 0x9f,
+  0x49, 0xd9, 0xc7, 0x0a, 0x9b, 0x92, 0x04, 0x5d, 0xf3, 0xa6, 0x80, 0x76, 0xd4, 0x4f, 0x99, 0x07,
+  0x41, 0xc2, 0x69, 0x83, 0xfe, 0xc2, 0x54, 0xc2, 0x38, 0x35, 0x10, 0xda, 0x45, 0x9d, 0xbf, 0x15,
+  0xc5, 0xc6, 0xa4, 0xad, 0x0d, 0xa8, 0xc3, 0xd7, 0x90, 0x5c, 0xf1, 0xa7, 0x25, 0x69, 0x1b, 0xfe,
+  0x3d, 0xcf, 0x60, 0x14, 0x2f, 0x4d, 0x5d, 0x51, 0x06, 0xbb, 0x15, 0x36, 0xc8, 0xf5, 0xb0, 0xcf,
+  0xb6, 0x96, 0xa5, 0xd7, 0xb8, 0x03, 0x60, 0x47, 0x0e, 0xaa, 0x21, 0x58, 0x7d, 0x10, 0x68, 0xdf,
+  0xb5, 0x6b, 0x6e, 0x0d, 0xae, 0x1b, 0xaa, 0x16, 0x98, 0x68, 0x3c, 0x8a, 0x25, 0x3f, 0x5b, 0xa8,
+  0x92, 0x88, 0x19, 0xe0, 0x6a, 0x2c, 0x7e, 0xbe, 0xdf, 0xf0, 0x60, 0xf5, 0xcf, 0x7f, 0x7d, 0xf7,
+  0x8a, 0x9d, 0xb3, 0xaf, 0x67, 0x53, 0x86, 0xfd, 0xd0, 0xc5, 0x74, 0x31, 0x71, 0x54, 0x4f, 0xc8,
+  0x2d, 0xb5, 0x23, 0xbe, 0xbc, 0x20, 0xe2, 0x8b, 0xab, 0xd3, 0xc4, 0xda, 0x52, 0xdf, 0x3a, 0xf2,
+  0xab, 0x29, 0x91, 0x5f, 0x4e, 0x7f, 0x87, 0x7c, 0x67, 0xc9, 0xff, 0x6d, 0xc9, 0xc3, 0xd9, 0x15,
+  0xd1, 0x87, 0xd3, 0xd9, 0xc5, 0x49, 0x86, 0xda, 0x32, 0xfc, 0xe8, 0x19, 0x2e, 0xad, 0x80, 0x70,
+  0xd6, 0x91, 0x30, 0x71, 0xae, 0xe8, 0xcb, 0x8a, 0xbf, 0x52, 0xc3, 0xb6, 0x8d, 0x48, 0xd7, 0xeb,
+  0x5c, 0x1a, 0x87, 0xaa, 0x59, 0x26, 0xef, 0x84, 0x4f, 0x68, 0x72, 0x8e, 0xcf, 0xdd, 0x91, 0x5f,
+  0x7a, 0xba, 0x42, 0x6a, 0xb7, 0x4b, 0xc2, 0x44, 0x7d, 0x59, 0x7e, 0x9f, 0x64, 0xb2, 0x84, 0xe3,
+  0x44, 0x45, 0x9b, 0x62, 0x2c, 0xe2, 0x95, 0x0d, 0xa6, 0x93, 0xb0, 0x37, 0x19, 0x1c, 0x75, 0x6f,
+  0x26, 0x78, 0xa0, 0x0e, 0xf8, 0xba, 0xa2, 0x4d, 0x05, 0x3a, 0x8b, 0xfd, 0x5b, 0xa0, 0x45, 0xf6,
+  0x81, 0x7a, 0xaa, 0x5e, 0xd4, 0x06, 0xa1, 0x3b, 0x58, 0x38, 0x15, 0x3d, 0x37, 0xed, 0xe8, 0xec,
+  0x99, 0x2e, 0xfc, 0x04, 0xa0, 0xe5, 0xed, 0xa0, 0x7d, 0x8e, 0x45, 0x69, 0xd2, 0xb6, 0x2f, 0xa3,
+  0xd5, 0xd7, 0x82, 0xd9, 0xb5, 0x3e, 0x60, 0x4f, 0xdd, 0x8b, 0xdd, 0x20, 0xf5, 0x85, 0xb4, 0x02,
+  0x05, 0x06, 0x44, 0x9d, 0xa0, 0xae, 0x51, 0xc7, 0xdb, 0x54, 0x62, 0x7c, 0xa0, 0x61, 0xb9, 0xc2,
+  0x67, 0x98, 0xd9, 0x98, 0x25, 0x70, 0x21, 0xac, 0xed, 0x0b, 0xd3, 0xe7, 0x12, 0x3b, 0xa1, 0x68,
+  0x1f, 0xac, 0x7e, 0x4a, 0x85, 0x9b, 0x39, 0x4e, 0x4f, 0xf0, 0x25, 0x75, 0x96, 0xf5, 0x16, 0x58,
+  0xc3, 0xd3, 0x68, 0xd7, 0x40, 0x3c, 0x4e, 0xd6, 0xb8, 0x52, 0xe5, 0x27, 0xea, 0xcd, 0x1a, 0x8a,
+  0x7e, 0x8b, 0x17, 0xe6, 0x5e, 0x58, 0x42, 0x4a, 0x9f, 0xcc, 0x71, 0xbb, 0xd5, 0x87, 0x42, 0x1c,
+  0x09, 0x0a, 0x1d, 0xdb, 0xf6, 0xd8, 0x93, 0xe1, 0x47, 0x86, 0x24, 0xeb, 0xbd, 0xa1, 0x6a, 0xff,
+  0x9e, 0xef, 0xc6, 0xcc, 0x3e, 0xb3, 0x12, 0xbd, 0xdb, 0x8b, 0x7a, 0xea, 0x6f, 0x4f, 0xdf, 0xeb,
+  0xef, 0x06, 0xab, 0x2b, 0x20, 0x6f, 0xd0, 0xbd, 0x6b, 0x8d, 0xcc, 0xc5, 0x41, 0xc6, 0xc9, 0x3e,
+  0x47, 0x7c, 0xfd, 0x52, 0x72, 0xdd, 0x1b, 0xd2, 0x29, 0x7a, 0x77, 0xa1, 0x50, 0x94, 0xa8, 0xd0,
+  0x31, 0xfb, 0x89, 0x1a, 0x37, 0x77, 0x6f, 0x36, 0x3e, 0x7f, 0x7f, 0x7f, 0xf3, 0x1d, 0x82, 0x84,
+  0x13, 0x98, 0xd9, 0x8f, 0x10, 0x69, 0xc4, 0x38, 0x61, 0x85, 0x10, 0x31, 0xa2, 0xef, 0x36, 0x15,
+  0x4d, 0x77, 0x1c, 0x51, 0x14, 0x33, 0xb5, 0xb5, 0x89, 0x01, 0xff, 0x6a, 0x3c, 0x03, 0xa8, 0xb8,
+  0xd3, 0x7d, 0x99, 0xb0, 0xa6, 0x6d, 0x6c, 0x9b, 0x50, 0x64, 0xd7, 0xe9, 0xb9, 0xe4, 0x68, 0xfb,
+  0x0b, 0xcb, 0xc1, 0xf4, 0xd8, 0xf5, 0xbd, 0xaa, 0x68, 0x7e, 0x22, 0x37, 0x43, 0x3b, 0x9b, 0x34,
+  0x7e, 0x63, 0xbc, 0x52, 0x6f, 0x70, 0x32, 0x91, 0xa8, 0xd8, 0xeb, 0xb7, 0xbb, 0xa2, 0x01, 0x39,
+  0xf8, 0x3c, 0xe3, 0xa5, 0x16, 0xc3, 0x31, 0xbb, 0xe1, 0x51, 0xea, 0x3d, 0x4d, 0xc6, 0x82, 0xda,
+  0x68, 0xa6, 0xb6, 0x98, 0xcc, 0x76, 0x24, 0xf9, 0x0a, 0x20, 0x8c, 0xf7, 0xb7, 0x1f, 0x5e, 0x7d,
+  0xdf, 0x6b, 0x21, 0x01, 0xfa, 0x18, 0x6e, 0x9b, 0xec, 0xe2, 0x36, 0xcf, 0xb1, 0xc3, 0x32, 0xc0,
+  0x3f, 0x15, 0x43, 0xc7, 0xd9, 0x6f, 0xaf, 0x03, 0xed, 0xee, 0x2b, 0xe5, 0x2e, 0xc9, 0x4d, 0x3b,
+  0x0b, 0x7b, 0x8b, 0xc8, 0xd3, 0x34, 0x7b, 0x48, 0xcf, 0xf1, 0xb8, 0x16, 0x7e, 0x2d, 0xc5, 0x06,
+  0x38, 0x74, 0xac, 0x70, 0x81, 0x4f, 0x2a, 0x95, 0xdb, 0x30, 0x47, 0x7e, 0x12, 0x9f, 0x28, 0xa2,
+  0x4d, 0xc5, 0xf7, 0xf6, 0x9e, 0x23, 0x58, 0x7d, 0xd7, 0x3c, 0x8e, 0xe0, 0xda, 0x0d, 0xd1, 0x60,
+  0xc8, 0xdb, 0xf9, 0x4a, 0x5e, 0x56, 0x45, 0xb6, 0xff, 0x63, 0xd3, 0xa3, 0xc5, 0x61, 0x82, 0xb6,
+  0x0f, 0x08, 0x18, 0x25, 0x9f, 0x8b, 0x24, 0xa1, 0xf8, 0xec, 0xb3, 0x12, 0x60, 0x2e, 0x72, 0x6d,
+  0xc0, 0x0d, 0xcb, 0x15, 0x84, 0xd0, 0x40, 0x44, 0x0c, 0x3f, 0xa6, 0xb4, 0xff, 0xb5, 0x7b, 0xaa,
+  0x8d, 0x30, 0x2e, 0x84, 0xa5, 0xd2, 0xd2, 0x2a, 0x4e, 0x60, 0x95, 0xa0, 0x6b, 0x1c, 0xcd, 0x22,
+  0x59, 0x45, 0x99, 0xcb, 0x08, 0x8a, 0xce, 0xb9, 0x8b, 0x7b, 0xa4, 0xb0, 0x91, 0x96, 0x05, 0x47,
+  0x6d, 0xf6, 0x85, 0xb7, 0x52, 0x72, 0x47, 0x9b, 0x03, 0xab, 0x40, 0x26, 0x12, 0xc3, 0x26, 0x0c,
+  0xc7, 0x2f, 0x6c, 0xf9, 0x76, 0x64, 0xf1, 0xd1, 0xb4, 0xec, 0x8d, 0xb1, 0x65, 0xef, 0x0d, 0xb1,
+  0x03, 0x7e, 0x44, 0xbb, 0x3f, 0x49, 0xbb, 0x0f, 0x9e, 0xe8, 0xb5, 0x6d, 0xf5, 0xb2, 0x27, 0x71,
+  0x28, 0x96, 0xda, 0x63, 0x31, 0x06, 0x22, 0x8a, 0x7d, 0x8b, 0x0d, 0xac, 0x70, 0xb9, 0x7d, 0x4a,
+  0xb3, 0xed, 0x49, 0x69, 0xdb, 0x27, 0x9a, 0xa5, 0x27, 0x69, 0xd3, 0xc7, 0xf3, 0x0e, 0x22, 0x83,
+  0xd5, 0xbb, 0x24, 0xb1, 0x27, 0x4f, 0x5f, 0x41, 0x83, 0x7f, 0x7c, 0x43, 0xee, 0xb2, 0x55, 0xd4,
+  0xab, 0x8e, 0xe5, 0xea, 0x9f, 0x81, 0x16, 0xef, 0xf4, 0x94, 0x42, 0xf1, 0x1b, 0x44, 0xb1, 0xce,
+  0x62, 0x46, 0x87, 0x1d, 0x9c, 0x86, 0x5c, 0x8b, 0x41, 0x7b, 0xe2, 0xe8, 0x0d, 0x77, 0x98, 0x72,
+  0x70, 0x4c, 0x25, 0x9a, 0xc4, 0x32, 0x28, 0xf5, 0xad, 0x1d, 0x18, 0xb2, 0xb2, 0xa9, 0x1a, 0xd9,
+  0x0d, 0x78, 0x93, 0x43, 0xe8, 0x6e, 0x95, 0x40, 0x5b, 0xe0, 0x74, 0x62, 0xe2, 0x1b, 0x2e, 0x8b,
+  0xbe, 0xb4, 0xd0, 0xba, 0xc4, 0x8e, 0x07, 0x73, 0x9d, 0xfe, 0xc0, 0xb2, 0x8e, 0xb1, 0x46, 0x61,
+  0x36, 0x72, 0x9d, 0xf6, 0x1f, 0x24, 0x2d, 0x63, 0xbf, 0xa5, 0x1e, 0xb4, 0x23, 0x29, 0x37, 0x69,
+  0x45, 0x6d, 0xce, 0xa6, 0x33, 0x9e, 0x85, 0xa6, 0x93, 0x09, 0xf2, 0x0f, 0x82, 0x72, 0x90, 0x0b,
+  0xf2, 0x2b, 0xe9, 0x2f, 0x73, 0x1c, 0xa3, 0x7b, 0x7d, 0x6b, 0x21, 0x7a, 0x25, 0x3a, 0xf0, 0x13,
+  0xe3, 0xc2, 0x4f, 0x24, 0x6a, 0xa7, 0x7b, 0x97, 0x48, 0x63, 0xf6, 0x0e, 0x92, 0xaa, 0xad, 0xd4,
+  0xa2, 0x69, 0xaf, 0xe4, 0x62, 0x5b, 0xa7, 0xad, 0xd3, 0xb7, 0x34, 0xf3, 0x11, 0x92, 0x4c, 0x70,
+  0x6d, 0xdc, 0x01, 0x3f, 0xaf, 0xd1, 0x06, 0x8f, 0xd5, 0xc4, 0x09, 0x81, 0x17, 0x1b, 0x7b, 0x25,
+  0xf0, 0xc4, 0xb5, 0xf9, 0x9d, 0x10, 0x65, 0xbb, 0xc1, 0xa1, 0x4d, 0x47, 0xe1, 0xa9, 0x7d, 0xa7,
+  0x76, 0x0a, 0x0d, 0xfa, 0x9b, 0xaa, 0xe3, 0xee, 0x37, 0xd6, 0x01, 0x77, 0x9b, 0x6a, 0x8e, 0x9e,
+  0x83, 0x03, 0x35, 0xcd, 0xb3, 0xfe, 0x8e, 0x6a, 0x09, 0x9a, 0x86, 0xea, 0xa8, 0x1f, 0xb7, 0x45,
+  0xba, 0x90, 0xc0, 0x5e, 0x04, 0xe8, 0x98, 0x86, 0xf4, 0xdb, 0xba, 0x00, 0xa3, 0x80, 0x6e, 0x2f,
+  0xa8, 0x19, 0x59, 0xf0, 0x13, 0x3d, 0x95, 0x67, 0x5b, 0x74, 0xc0, 0x4f, 0x74, 0x41, 0xf1, 0xca,
+  0x3e, 0x32, 0xda, 0x23, 0x9e, 0x20, 0x8e, 0x81, 0xfe, 0xc9, 0xca, 0x68, 0xa9, 0xe3, 0x83, 0xd8,
+  0xb5, 0x30, 0x5b, 0x01, 0xc9, 0x2e, 0x34, 0x7f, 0xac, 0xff, 0x1e, 0x6b, 0xcd, 0xef, 0x6c, 0x39,
+  0x35, 0x63, 0xc0, 0x4e, 0xb2, 0x4e, 0xf4, 0xdf, 0x74, 0x4c, 0x72, 0x63, 0x03, 0x01, 0x6a, 0x4f,
+  0x65, 0xf6, 0x9c, 0x97, 0x88, 0x2d, 0x6a, 0x29, 0x52, 0xae, 0x83, 0x8f, 0x50, 0x14, 0x6e, 0x8b,
+  0x41, 0xb7, 0xe8, 0x95, 0xca, 0x58, 0x73, 0xce, 0xa6, 0x4a, 0xa3, 0x82, 0x3d, 0x54, 0x9b, 0x2c,
+  0x1a, 0x13, 0xda, 0xbc, 0x70, 0x57, 0x7b, 0x3e, 0x9c, 0xee, 0x7c, 0x41, 0x9b, 0xe9, 0x7b, 0x0b,
+  0x77, 0x7c, 0x1f, 0xe5, 0x08, 0xc9, 0x56, 0xba, 0x40, 0x3a, 0x1c, 0xbf, 0x75, 0x54, 0xc9, 0x12,
+  0x96, 0x4f, 0x26, 0xd8, 0xa4, 0x80, 0xcd, 0x1f, 0x4e, 0x70, 0xa6, 0x16, 0x4e, 0x7f, 0xf8, 0xc6,
+  0x18, 0x9c, 0x5a, 0xf5, 0xb5, 0xd5, 0xf2, 0x4e, 0xec, 0x5d, 0x52, 0xd3, 0x8b, 0xbd, 0x8b, 0x4a,
+  0xa4, 0xa0, 0xd6, 0x42, 0x2e, 0x3d, 0xc3, 0xa6, 0x68, 0x80, 0x8d, 0xa4, 0x95, 0x39, 0xd6, 0x82,
+  0x57, 0x51, 0x3a, 0x96, 0x45, 0x2c, 0x76, 0xef, 0x92, 0x81, 0xbb, 0xf5, 0x5a, 0x86, 0xc1, 0x90,
+  0xad, 0x96, 0x6c, 0x3a, 0x64, 0xb1, 0x8a, 0xea, 0x1c, 0xfd, 0x66, 0x8c, 0xb1, 0x74, 0x93, 0x09,
+  0x7a, 0xfc, 0x66, 0xff, 0x26, 0xf6, 0x84, 0xc1, 0x70, 0x6c, 0x2f, 0xe1, 0xc6, 0xfe, 0xea, 0x0e,
+  0x05, 0xe7, 0x37, 0xa9, 0xd7, 0x67, 0x09, 0x8e, 0x3f, 0xe9, 0x20, 0x68, 0x55, 0x03, 0x2d, 0xd4,
+  0x29, 0x06, 0x09, 0x4a, 0xc1, 0xa6, 0xc3, 0xa0, 0x1a, 0xb2, 0x07, 0x78, 0x0e, 0x1b, 0x81, 0x82,
+  0x55, 0xe3, 0x5f, 0xb5, 0x2a, 0x06, 0xc3, 0x6b, 0xf6, 0xe5, 0x09, 0x9d, 0x06, 0x1d, 0xd9, 0x0e,
+  0x11, 0xc8, 0x47, 0x7f, 0xd3, 0x51, 0x57, 0x19, 0xc5, 0x4c, 0x31, 0xba, 0x7d, 0x61, 0x5f, 0x1d,
+  0x22, 0x32, 0xe0, 0x09, 0x22, 0xc9, 0x9a, 0x2b, 0x98, 0x60, 0xe4, 0x1e, 0x35, 0x3d, 0x0f, 0xcf,
+  0xee, 0x39, 0x76, 0x6f, 0x60, 0x5d, 0x32, 0x3d, 0x3e, 0x42, 0xfa, 0xed, 0x37, 0x16, 0x80, 0x52,
+  0x53, 0xc7, 0xa3, 0xae, 0x51, 0x65, 0x63, 0x3c, 0x9a, 0x37, 0x8d, 0x5b, 0xc0, 0x7a, 0x7d, 0xd6,
+  0x72, 0x58, 0x91, 0x4b, 0x4f, 0xbd, 0x62, 0x2f, 0xd8, 0x5f, 0x2c, 0x87, 0xc6, 0x66, 0x5f, 0x0c,
+  0xa6, 0x1e, 0x66, 0xc8, 0xe6, 0xb4, 0x7a, 0xc4, 0xd6, 0xaa, 0x78, 0x8a, 0xd5, 0xad, 0x7e, 0xc5,
+  0x42, 0xe2, 0x0d, 0xe0, 0x43, 0xd2, 0xd6, 0xc6, 0x6f, 0x79, 0x08, 0x04, 0xbd, 0xeb, 0x5f, 0xa6,
+  0xff, 0x81, 0x87, 0x91, 0xda, 0x03, 0x22, 0xa1, 0xb8, 0x52, 0xe2, 0x59, 0x47, 0x59, 0x1e, 0x1b,
+  0xee, 0xa5, 0xe5, 0x1d, 0x0b, 0x17, 0x36, 0xfd, 0x0b, 0x91, 0x81, 0x8d, 0xe2, 0x6f, 0x09, 0x86,
+  0x8e, 0x6e, 0x6c, 0xd3, 0x89, 0xa8, 0xed, 0x9b, 0xe1, 0x9b, 0x1f, 0x08, 0x6f, 0x89, 0x58, 0xde,
+  0xde, 0xbc, 0xbd, 0x79, 0xfd, 0x31, 0x80, 0x92, 0xb7, 0xa6, 0x42, 0x10, 0x07, 0x1e, 0x04, 0x21,
+  0x52, 0x6f, 0xa9, 0x7c, 0x5e, 0xc3, 0x13, 0x03, 0xd2, 0xb6, 0x45, 0xff, 0x42, 0x91, 0xaa, 0xa8,
+  0xd5, 0xe9, 0xa6, 0x5b, 0xba, 0x0e, 0xe6, 0xe0, 0xf5, 0xe8, 0x68, 0xa3, 0xe6, 0xee, 0x55, 0x8d,
+  0xad, 0x1b, 0xe5, 0xce, 0x58, 0xee, 0xff, 0xa5, 0x9c, 0x69, 0xad, 0x59, 0xe3, 0x5c, 0x16, 0x43,
+  0x66, 0xf5, 0x7e, 0x6a, 0xd0, 0xb0, 0xcf, 0x4a, 0xe2, 0xb0, 0x31, 0xc6, 0xdf, 0x46, 0xb3, 0xc7,
+  0x98, 0x7c, 0xf7, 0xff, 0x62, 0xf2, 0x9d, 0xc3, 0xe4, 0xbb, 0xd6, 0x5a, 0xa4, 0x05, 0x3a, 0x93,
+  0xaf, 0x4f, 0x54, 0x30, 0xdd, 0x41, 0x2f, 0x26, 0xf6, 0xbf, 0xe3, 0xfe, 0x07, 0xb0, 0x78, 0x25,
+  0xf5, 0xa4, 0x1b, 0x00, 0x00,
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "portal_request.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+  -----------------------------
+  ---------- HELPERS ----------
+  -----------------------------
+*/
+
+static void fail(portal_request_t *req, int status) {
+  req->state = PORTAL_PARSE_ERROR;
+  req->error = status;
+}
+
+/*
+  Returns the header value if line starts with "<name>:" (case-insensitive), otherwise NULL.
+  Leading whitespace of the value is skipped.
+*/
+static const char *headerValue(const char *line, const char *name) {
+  size_t name_len = strlen(name);
+  if (strncasecmp(line, name, name_len) != 0 || line[name_len] != ':') {
+    return NULL;
+  }
+  const char *value = line + name_len + 1;
+  while (*value == ' ' || *value == '\t') value++;
+  return value;
+}
+
+/* digits only, at most 9 of them: anything else is not a length we accept */
+static long parseLength(const char *value) {
+  long length = 0;
+  size_t digits = 0;
+  for (; isdigit((unsigned char)*value); value++) {
+    if (++digits > 9) return -1;
+    length = length * 10 + (*value - '0');
+  }
+  while (*value == ' ' || *value == '\t') value++;
+  return digits > 0 && *value == '\0' ? length : -1;
+}
+
+static void appendForm(portal_request_t *req, char c) {
+  req->form[req->form_len++] = c;
+  req->form[req->form_len] = '\0';
+}
+
+/*
+  Called after the blank line that ends the headers. Only a POST keeps its body,
+  and it replaces a query string of the request line.
+*/
+static void startBody(portal_request_t *req) {
+  if (strcmp(req->method, "POST") != 0) {
+    req->state = PORTAL_PARSE_DONE;
+    return;
+  }
+  if (req->chunked) {
+    fail(req, 501);
+    return;
+  }
+  req->form_len = 0;
+  req->form[0] = '\0';
+  req->state = req->content_length > 0 ? PORTAL_PARSE_BODY : PORTAL_PARSE_DONE;
+}
+
+/*
+  Handles one complete line (without CR/LF) of the version and header states.
+*/
+static void handleLine(portal_request_t *req) {
+  const char *line = req->line;
+
+  if (req->state == PORTAL_PARSE_VERSION) {
+    /* "HTTP/1.0" or "HTTP/1.1" */
+    if (strncmp(line, "HTTP/1.", 7) != 0 || !isdigit((unsigned char)line[7]) || line[8] != '\0') {
+      fail(req, 400);
+      return;
+    }
+    req->state = PORTAL_PARSE_HEADERS;
+    return;
+  }
+
+  if (req->line_len == 0) {
+    startBody(req);
+    return;
+  }
+  if (++req->headers > PORTAL_HEADERS_MAX) {
+    fail(req, 431);
+    return;
+  }
+
+  const char *value;
+  if ((value = headerValue(line, "Content-Length")) != NULL) {
+    long length = parseLength(value);
+    if (length < 0 || (req->content_length >= 0 && length != req->content_length)) {
+      fail(req, 400);
+    } else if (length > PORTAL_FORM_MAX - 1) {
+      fail(req, 413);
+    } else {
+      req->content_length = length;
+    }
+  } else if (headerValue(line, "Transfer-Encoding") != NULL) {
+    req->chunked = true;
+  } else if ((value = headerValue(line, "Authorization")) != NULL) {
+    snprintf(req->authorization, sizeof(req->authorization), "%s", value);
+  }
+}
+
+/*
+  One byte of the request line up to the version. Method, path and query are
+  checked as they arrive, so an overlong one fails without being buffered.
+*/
+static void requestLineByte(portal_request_t *req, char c) {
+  switch (req->state) {
+    case PORTAL_PARSE_METHOD:
+      if (c == '\r' || c == '\n') {
+        /* empty lines before the request line are allowed */
+        if (req->field_len > 0) fail(req, 400);
+      } else if (c == ' ') {
+        if (strcmp(req->method, "GET") == 0 || strcmp(req->method, "HEAD") == 0 || strcmp(req->method, "POST") == 0) {
+          req->state = PORTAL_PARSE_PATH;
+          req->field_len = 0;
+        } else {
+          fail(req, req->field_len > 0 ? 501 : 400);
+        }
+      } else if (c < 'A' || c > 'Z') {
+        fail(req, 400);
+      } else if (req->field_len >= PORTAL_METHOD_MAX - 1) {
+        fail(req, 501);
+      } else {
+        req->method[req->field_len++] = c;
+        req->method[req->field_len] = '\0';
+      }
+      break;
+
+    case PORTAL_PARSE_PATH:
+      if (req->field_len == 0 && c != '/') {
+        fail(req, 400);
+      } else if (c == ' ' || c == '?') {
+        req->state = c == ' ' ? PORTAL_PARSE_VERSION : PORTAL_PARSE_QUERY;
+      } else if ((unsigned char)c <= ' ' || c == 0x7f) {
+        fail(req, 400);
+      } else if (req->field_len >= PORTAL_PATH_MAX - 1) {
+        fail(req, 414);
+      } else {
+        req->path[req->field_len++] = c;
+        req->path[req->field_len] = '\0';
+      }
+      break;
+
+    case PORTAL_PARSE_QUERY:
+      if (c == ' ') {
+        req->state = PORTAL_PARSE_VERSION;
+      } else if ((unsigned char)c <= ' ' || c == 0x7f) {
+        fail(req, 400);
+      } else if (req->form_len >= PORTAL_FORM_MAX - 1) {
+        fail(req, 414);
+      } else {
+        appendForm(req, c);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*
+  -----------------------------
+  ----------- API -------------
+  -----------------------------
+*/
+void portalRequestInit(portal_request_t *req) {
+  memset(req, 0, sizeof(*req));
+  req->state = PORTAL_PARSE_METHOD;
+  req->content_length = -1;
+}
+
+size_t portalRequestFeed(portal_request_t *req, const uint8_t *data, size_t len) {
+  size_t pos = 0;
+
+  while (pos < len && req->state != PORTAL_PARSE_DONE && req->state != PORTAL_PARSE_ERROR) {
+    if (req->state == PORTAL_PARSE_BODY) {
+      /* copy as much as belongs to the body in one go; it fits, Content-Length was checked */
+      size_t take = len - pos;
+      size_t remaining = (size_t)req->content_length - req->form_len;
+      if (take > remaining) take = remaining;
+
+      memcpy(req->form + req->form_len, data + pos, take);
+      req->form_len += take;
+      req->form[req->form_len] = '\0';
+      pos += take;
+
+      if (req->form_len == (size_t)req->content_length) req->state = PORTAL_PARSE_DONE;
+      continue;
+    }
+
+    char c = (char)data[pos++];
+    if (req->state < PORTAL_PARSE_VERSION) {
+      requestLineByte(req, c);
+      continue;
+    }
+
+    /* line-based states: version and headers */
+    if (++req->header_bytes > PORTAL_HEADER_BYTES_MAX) {
+      fail(req, 431);
+    } else if (c == '\n') {
+      req->line[req->line_len] = '\0';
+      handleLine(req);
+      req->line_len = 0;
+    } else if (c != '\r' && req->line_len < PORTAL_LINE_MAX - 1) {
+      req->line[req->line_len++] = c;
+    }
+  }
+
+  return pos;
+}
+
+bool portalRequestDone(const portal_request_t *req) {
+  return req->state == PORTAL_PARSE_DONE || req->state == PORTAL_PARSE_ERROR;
+}
+
+bool portalRequestFailed(const portal_request_t *req) {
+  return req->state == PORTAL_PARSE_ERROR;
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* "+" is a space, "%xx" a byte; a "%" without two hex digits stays as it is, %00 is dropped */
+static void urlDecode(const char *src, const char *end, char *out, size_t cap) {
+  size_t len = 0;
+  while (src < end && len + 1 < cap) {
+    char c = *src++;
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && end - src >= 2 && hexValue(src[0]) >= 0 && hexValue(src[1]) >= 0) {
+      c = (char)(hexValue(src[0]) * 16 + hexValue(src[1]));
+      src += 2;
+      if (c == '\0') continue;
+    }
+    out[len++] = c;
+  }
+  out[len] = '\0';
+}
+
+bool portalFormValue(const char *form, const char *name, char *out, size_t cap) {
+  if (cap == 0) return false;
+  out[0] = '\0';
+
+  size_t name_len = strlen(name);
+  const char *field = form;
+  while (*field) {
+    const char *end = strchr(field, '&');
+    if (!end) end = field + strlen(field);
+
+    if ((size_t)(end - field) >= name_len && strncmp(field, name, name_len) == 0 &&
+        (field + name_len == end || field[name_len] == '=')) {
+      const char *value = field + name_len;
+      if (value < end) value++;   /* skip '=' */
+      urlDecode(value, end, out, cap);
+      return true;
+    }
+    field = *end ? end + 1 : end;
+  }
+  return false;
+}
@@ -0,0 +1,81 @@
+#ifndef PORTAL_REQUEST_H
+#define PORTAL_REQUEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Limits of one configuration portal request. Nothing grows: a request that
+  does not fit is answered with the error status instead.
+*/
+#define PORTAL_METHOD_MAX 8
+#define PORTAL_PATH_MAX 64
+#define PORTAL_FORM_MAX 1536     /* POST body or query string of a GET, URL-encoded */
+#define PORTAL_LINE_MAX 128      /* header line; longer ones are consumed but cut off */
+#define PORTAL_HEADER_BYTES_MAX 4096
+#define PORTAL_HEADERS_MAX 48
+#define PORTAL_AUTH_MAX 96       /* Authorization header value; longer ones are cut off */
+
+typedef enum {
+  PORTAL_PARSE_METHOD = 0,
+  PORTAL_PARSE_PATH,
+  PORTAL_PARSE_QUERY,
+  PORTAL_PARSE_VERSION,
+  PORTAL_PARSE_HEADERS,
+  PORTAL_PARSE_BODY,
+  PORTAL_PARSE_DONE,
+  PORTAL_PARSE_ERROR
+} portal_parse_state_t;
+
+/*
+  Incremental parser for the requests a browser sends to the configuration portal
+  (GET of the page, POST of the form), also used by the control endpoint (control.cpp). Pure C, no allocation, no Arduino types, so it
+  can be checked and fuzzed on the host (host/portal_fuzz.cpp).
+
+  Feed it whatever the socket has; the state tells when the request is complete.
+  On PORTAL_PARSE_ERROR, error holds the status to answer with:
+    400 malformed request line, header or Content-Length
+    413 body larger than PORTAL_FORM_MAX
+    414 path or query too long
+    431 too many header bytes or lines
+    501 method other than GET/HEAD/POST, or a chunked body
+*/
+typedef struct {
+  portal_parse_state_t state;
+  int error;
+
+  char method[PORTAL_METHOD_MAX];
+  char path[PORTAL_PATH_MAX];   /* without the query */
+  char form[PORTAL_FORM_MAX];   /* always NUL-terminated */
+  size_t form_len;
+  long content_length;          /* -1 if absent */
+  char authorization[PORTAL_AUTH_MAX];   /* "" if absent */
+
+  /* internal */
+  char line[PORTAL_LINE_MAX];
+  size_t line_len;
+  size_t field_len;             /* of method/path/version while they are read */
+  size_t header_bytes;
+  size_t headers;
+  bool chunked;
+} portal_request_t;
+
+void portalRequestInit(portal_request_t *req);
+
+/*
+  Consumes up to len bytes and returns how many were used.
+  Stops early once the request is complete or failed.
+*/
+size_t portalRequestFeed(portal_request_t *req, const uint8_t *data, size_t len);
+
+bool portalRequestDone(const portal_request_t *req);
+bool portalRequestFailed(const portal_request_t *req);
+
+/*
+  URL-decodes the value of field name of an application/x-www-form-urlencoded form
+  into out (NUL-terminated, cut off if it does not fit). Only whole field names match,
+  "sid" does not match "ssid=". Returns false (and out = "") if the field is missing.
+*/
+bool portalFormValue(const char *form, const char *name, char *out, size_t cap);
+
+#endif
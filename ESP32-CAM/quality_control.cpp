@@ -0,0 +1,149 @@
+#include "quality_control.h"
+
+/*
+  Frame sizes the controller steps through, smallest first.
+  Only sizes up to the one the camera was initialized with are used,
+  the frame buffers are not big enough for anything larger.
+*/
+typedef struct {
+  framesize_t framesize;
+  uint32_t pixels;
+} ladder_step_t;
+
+static const ladder_step_t LADDER[] = {
+  { FRAMESIZE_QVGA,  320 * 240 },
+  { FRAMESIZE_VGA,   640 * 480 },
+  { FRAMESIZE_SVGA,  800 * 600 },
+  { FRAMESIZE_XGA,  1024 * 768 },
+  { FRAMESIZE_SXGA, 1280 * 1024 },
+  { FRAMESIZE_UXGA, 1600 * 1200 },
+};
+#define LADDER_STEPS (sizeof(LADDER) / sizeof(LADDER[0]))
+
+/* index of the largest ladder step not bigger than framesize */
+static int ladderIndex(framesize_t framesize) {
+  int index = 0;
+  for (size_t i = 0; i < LADDER_STEPS; i++) {
+    if (LADDER[i].framesize <= framesize) index = i;
+  }
+  return index;
+}
+
+uint32_t framesizePixels(framesize_t framesize) {
+  for (size_t i = 0; i < LADDER_STEPS; i++) {
+    if (LADDER[i].framesize == framesize) return LADDER[i].pixels;
+  }
+  return 0;
+}
+
+static void changed(quality_control_t *ctl) {
+  ctl->settle = QUALITY_SETTLE_FRAMES;
+  ctl->avg_len = 0;
+  ctl->samples = 0;
+}
+
+void qualityInit(quality_control_t *ctl, int best_quality, framesize_t max_framesize,
+                 uint32_t max_frame_bytes, uint32_t max_upload_ms) {
+  *ctl = quality_control_t();
+  ctl->best_quality = best_quality < QUALITY_WORST ? best_quality : QUALITY_WORST;
+  ctl->max_framesize = LADDER[ladderIndex(max_framesize)].framesize;
+  ctl->max_frame_bytes = max_frame_bytes;
+  ctl->max_upload_ms = max_upload_ms;
+  ctl->current.quality = ctl->best_quality;
+  ctl->current.framesize = ctl->max_framesize;
+}
+
+bool qualityEnabled(const quality_control_t *ctl) {
+  return ctl->max_frame_bytes > 0 || ctl->max_upload_ms > 0;
+}
+
+uint32_t qualityBudget(const quality_control_t *ctl) {
+  uint32_t budget = ctl->max_frame_bytes;
+  if (ctl->max_upload_ms > 0 && ctl->throughput > 0) {
+    uint64_t by_time = (uint64_t)ctl->throughput * ctl->max_upload_ms / 1000;
+    if (budget == 0 || by_time < budget) budget = (uint32_t)by_time;
+  }
+  return budget;
+}
+
+void qualityOnUpload(quality_control_t *ctl, size_t bytes, uint32_t upload_ms) {
+  if (upload_ms == 0 || bytes == 0) {
+    return;
+  }
+  uint32_t sample = (uint32_t)((uint64_t)bytes * 1000 / upload_ms);
+  ctl->throughput = ctl->throughput ? ctl->throughput - ctl->throughput / 4 + sample / 4 : sample;
+}
+
+bool qualityOnFrame(quality_control_t *ctl, size_t len) {
+  if (!qualityEnabled(ctl)) {
+    return false;
+  }
+  if (ctl->settle > 0) {
+    /* still old-setting frames in the pipeline */
+    ctl->settle--;
+    return false;
+  }
+
+  ctl->avg_len = ctl->samples ? ctl->avg_len - ctl->avg_len / 4 + (uint32_t)len / 4 : (uint32_t)len;
+  ctl->samples++;
+
+  uint32_t budget = qualityBudget(ctl);
+  if (budget == 0) {
+    return false;
+  }
+
+  /* decide on an average, except when a frame is way over budget */
+  bool far_over = ctl->avg_len > budget + budget / 2;
+  if (ctl->samples < QUALITY_SETTLE_FRAMES && !far_over) {
+    return false;
+  }
+
+  quality_setting_t *current = &ctl->current;
+  int index = ladderIndex(current->framesize);
+
+  if (ctl->avg_len > budget) {
+    /* aim for the middle of the band in one step, using the size model */
+    uint64_t target = (uint64_t)budget * (QUALITY_HIGH_WATER + 100) / 200;
+    int wanted = (int)(((uint64_t)(current->quality + QUALITY_MODEL_OFFSET) * ctl->avg_len + target - 1) / target)
+                 - QUALITY_MODEL_OFFSET;
+    if (wanted <= current->quality) wanted = current->quality + 1;
+
+    if (wanted <= QUALITY_WORST) {
+      current->quality = wanted;
+    } else if (index > 0) {
+      /* quality alone is not enough: fewer pixels, at half way between best and worst quality */
+      int quality = (ctl->best_quality + QUALITY_WORST) / 2;
+      uint64_t at_quality = (uint64_t)ctl->avg_len * (current->quality + QUALITY_MODEL_OFFSET) / (quality + QUALITY_MODEL_OFFSET);
+      int next = index - 1;
+      while (next > 0 && at_quality * LADDER[next].pixels / LADDER[index].pixels > target) next--;
+      current->framesize = LADDER[next].framesize;
+      current->quality = quality;
+    } else if (current->quality < QUALITY_WORST) {
+      current->quality = QUALITY_WORST;
+    } else {
+      return false;
+    }
+    ctl->downgrades++;
+    changed(ctl);
+    return true;
+  }
+
+  if (ctl->avg_len < (uint64_t)budget * QUALITY_HIGH_WATER / 100) {
+    if (current->quality > ctl->best_quality) {
+      current->quality--;
+    } else if (LADDER[index].framesize < ctl->max_framesize) {
+      uint64_t predicted = (uint64_t)ctl->avg_len * LADDER[index + 1].pixels / LADDER[index].pixels;
+      if (predicted >= (uint64_t)budget * QUALITY_UPSIZE_LIMIT / 100) {
+        return false;
+      }
+      current->framesize = LADDER[index + 1].framesize;
+    } else {
+      return false;
+    }
+    ctl->upgrades++;
+    changed(ctl);
+    return true;
+  }
+
+  return false;
+}
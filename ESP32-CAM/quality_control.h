@@ -0,0 +1,83 @@
+#ifndef QUALITY_CONTROL_H
+#define QUALITY_CONTROL_H
+
+#include "hal.h"
+
+/*
+  Closed-loop JPEG quality / frame size controller
+
+  Keeps the average frame below a byte budget. The budget is the smaller of
+    - max_frame_bytes                             (0 = no fixed limit)
+    - max_upload_ms * measured upload throughput  (0 = no time limit)
+
+  Frames too big   -> jump to the quality that is predicted to land in the middle of
+                      the band (frame bytes ~ 1 / (quality + QUALITY_MODEL_OFFSET));
+                      if even the worst quality would not do, the largest frame size
+                      predicted to fit at medium quality.
+  Frames too small -> quality number down by 1 until the configured quality;
+                      then one frame size up, if the bigger frame is predicted to fit.
+
+  Down fast, up slowly: a weak link is handled within a few frames, and the way back
+  probes one small step at a time.
+
+  Hysteresis: "too small" means below HIGH_WATER of the budget, so a setting that just
+  fits is kept. After every change the next QUALITY_SETTLE_FRAMES frames are ignored,
+  because frames already in the pipeline still carry the old setting, and the next
+  decision waits for as many new frames (unless a frame is far over budget).
+
+  Plain C++ without camera calls; the caller applies the returned setting through the
+  sensor API. host/quality_sim.cpp drives the same code with recorded frame-size traces.
+*/
+#define QUALITY_WORST 40
+#define QUALITY_MODEL_OFFSET 8
+#define QUALITY_SETTLE_FRAMES 3
+
+/* percent of the budget */
+#define QUALITY_HIGH_WATER 60
+#define QUALITY_UPSIZE_LIMIT 80
+
+typedef struct {
+  int quality;             /* esp32-camera jpeg_quality: lower is better */
+  framesize_t framesize;
+} quality_setting_t;
+
+typedef struct {
+  quality_setting_t current;
+  int best_quality;
+  framesize_t max_framesize;
+
+  uint32_t max_frame_bytes;
+  uint32_t max_upload_ms;
+
+  uint32_t avg_len;        /* average frame size since the last change */
+  uint32_t samples;
+  uint32_t throughput;     /* upload bytes per second, 0 = not measured yet */
+  uint32_t settle;         /* frames still to skip after a change */
+
+  /* statistics */
+  uint32_t downgrades;
+  uint32_t upgrades;
+} quality_control_t;
+
+void qualityInit(quality_control_t *ctl, int best_quality, framesize_t max_framesize,
+                 uint32_t max_frame_bytes, uint32_t max_upload_ms);
+
+/* true if the controller has anything to do (at least one budget configured) */
+bool qualityEnabled(const quality_control_t *ctl);
+
+/*
+  Feeds the size of a captured frame. Returns true if the setting changed;
+  the new one is in ctl->current.
+*/
+bool qualityOnFrame(quality_control_t *ctl, size_t len);
+
+/* feeds a finished upload (bytes on the wire, time the body took) */
+void qualityOnUpload(quality_control_t *ctl, size_t bytes, uint32_t upload_ms);
+
+/* current byte budget per frame, 0 if none */
+uint32_t qualityBudget(const quality_control_t *ctl);
+
+/* pixels of a frame size, 0 if unknown */
+uint32_t framesizePixels(framesize_t framesize);
+
+#endif
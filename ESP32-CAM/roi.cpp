@@ -0,0 +1,60 @@
+#include "roi.h"
+#include <string.h>
+
+/* sensor quality 10 (the PSRAM default) comes out at 80, QUALITY_WORST (40) at 20 */
+#define ENCODE_QUALITY_MIN 5
+#define ENCODE_QUALITY_MAX 95
+
+static uint32_t alignDown(uint32_t value) {
+  return value / ROI_ALIGN * ROI_ALIGN;
+}
+
+static uint32_t alignUp(uint32_t value, uint32_t limit) {
+  value = (value + ROI_ALIGN - 1) / ROI_ALIGN * ROI_ALIGN;
+  return value < limit ? value : limit;
+}
+
+bool roiFit(const roi_t *roi, uint16_t frame_w, uint16_t frame_h, roi_t *out) {
+  if (frame_w == 0 || frame_h == 0) {
+    return false;
+  }
+  if (roi->w == 0 || roi->h == 0) {
+    *out = { 0, 0, frame_w, frame_h };
+    return true;
+  }
+
+  /* start rounded down, end rounded up: the scaled region covers at least the configured one */
+  uint32_t x0 = alignDown((uint32_t)roi->x * frame_w / ROI_REFERENCE_WIDTH);
+  uint32_t y0 = alignDown((uint32_t)roi->y * frame_h / ROI_REFERENCE_HEIGHT);
+  uint32_t x1 = alignUp((((uint32_t)roi->x + roi->w) * frame_w + ROI_REFERENCE_WIDTH - 1) / ROI_REFERENCE_WIDTH, frame_w);
+  uint32_t y1 = alignUp((((uint32_t)roi->y + roi->h) * frame_h + ROI_REFERENCE_HEIGHT - 1) / ROI_REFERENCE_HEIGHT, frame_h);
+  if (x0 >= x1 || y0 >= y1) {
+    return false;
+  }
+  *out = { (uint16_t)x0, (uint16_t)y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0) };
+  return true;
+}
+
+size_t roiCrop(uint8_t *buf, size_t stride, const roi_t *roi) {
+  const uint8_t *src = buf + (size_t)roi->y * stride + roi->x;
+  uint8_t *dst = buf;
+
+  /* whole rows: nothing to move */
+  if (roi->x == 0 && roi->w == stride) {
+    if (roi->y > 0) memmove(dst, src, (size_t)roi->w * roi->h);
+    return (size_t)roi->w * roi->h;
+  }
+  for (uint16_t row = 0; row < roi->h; row++) {
+    memmove(dst, src, roi->w);
+    dst += roi->w;
+    src += stride;
+  }
+  return (size_t)roi->w * roi->h;
+}
+
+int roiEncodeQuality(int sensor_quality) {
+  int quality = 100 - 2 * sensor_quality;
+  if (quality < ENCODE_QUALITY_MIN) return ENCODE_QUALITY_MIN;
+  if (quality > ENCODE_QUALITY_MAX) return ENCODE_QUALITY_MAX;
+  return quality;
+}
@@ -0,0 +1,61 @@
+#ifndef ROI_H
+#define ROI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Region of interest
+
+  The backend only looks for circles around the hive entrance, which is a small
+  part of the picture. In grayscale capture the sensor delivers raw 8 bit luma
+  instead of JPEG; the firmware cuts the region of interest out of that frame and
+  JPEG-encodes only the region (halCameraFbGet(), hal.h), so the rest of the frame
+  is never encoded, stored or sent. The offset of the region goes along with
+  every upload (X-ROI-Offset part header) and the backend adds it to the circle
+  coordinates, so results are in the coordinates of the whole frame.
+
+  The region is configured in pixels of a UXGA frame (the sensor's full field of
+  view) and scaled to whatever size is captured, so it stays on the same spot when
+  the frame size changes (quality_control.h, control endpoint). The scaled region
+  is widened to whole 8x8 JPEG blocks: no block is padded by the encoder and the
+  offsets the backend gets are exact.
+
+  Plain C++ without camera calls; host/roi_bench.cpp runs the same crop on the
+  circle_evaluation images.
+*/
+#define ROI_REFERENCE_WIDTH 1600
+#define ROI_REFERENCE_HEIGHT 1200
+#define ROI_ALIGN 8
+
+typedef enum {
+  CAPTURE_JPEG = 0,        /* the sensor encodes the whole frame */
+  CAPTURE_GRAYSCALE        /* raw luma, cropped to the ROI and encoded on the ESP32 */
+} capture_format_t;
+
+typedef struct {
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;              /* w or h 0 = the whole frame */
+  uint16_t h;
+} roi_t;
+
+/*
+  Scales roi (reference coordinates) to a frame_w x frame_h frame, widens it to
+  ROI_ALIGN and clips it to the frame. False if nothing of it is inside the frame.
+*/
+bool roiFit(const roi_t *roi, uint16_t frame_w, uint16_t frame_h, roi_t *out);
+
+/*
+  Moves roi out of an 8 bit image with stride bytes per row to the start of buf,
+  rows packed. In place: every row only moves towards the start. Returns w * h.
+*/
+size_t roiCrop(uint8_t *buf, size_t stride, const roi_t *roi);
+
+/*
+  Encoder quality (1..100, higher is better) for a sensor JPEG quality (0..63,
+  lower is better), so the quality controller keeps working on encoded ROIs.
+*/
+int roiEncodeQuality(int sensor_quality);
+
+#endif
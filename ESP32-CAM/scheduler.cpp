@@ -0,0 +1,119 @@
+#include "scheduler.h"
+
+/*
+  The control variable is the capture rate in milli-frames per second, so that
+  "additive increase" means a constant step in frames/s (as in TCP's AIMD) and
+  recovering from a long backoff does not take thousands of cycles.
+*/
+#define RATE_SCALE 1000000UL  /* rate [mfps] = RATE_SCALE / interval [ms] */
+
+/* good uploads needed to climb from (almost) zero back to the target rate */
+#define INCREASE_STEPS 16
+
+/* averages are kept in ms * 16 */
+#define TTFB_SHIFT 4
+#define TTFB_SLACK_MS 20
+
+static uint32_t rateOf(uint32_t interval_ms) {
+  return interval_ms ? RATE_SCALE / interval_ms : RATE_SCALE;
+}
+
+static void setRate(scheduler_t *sched, uint32_t rate) {
+  uint32_t max_rate = rateOf(sched->target_ms);
+  uint32_t min_rate = rateOf(sched->max_ms);
+  if (rate > max_rate) rate = max_rate;
+  if (rate < min_rate) rate = min_rate;
+  if (rate == 0) rate = 1;
+
+  sched->interval_ms = RATE_SCALE / rate;
+  if (sched->interval_ms < sched->target_ms) sched->interval_ms = sched->target_ms;
+  if (sched->interval_ms > sched->max_ms) sched->interval_ms = sched->max_ms;
+}
+
+/*
+  Tracks a fast average and a baseline that follows drops quickly but rises slowly.
+  Returns true if the fast average is clearly above the baseline.
+*/
+static bool latencyRising(scheduler_t *sched, uint32_t ttfb_ms) {
+  uint32_t sample = ttfb_ms << TTFB_SHIFT;
+
+  if (sched->ttfb_baseline == 0) {
+    sched->ttfb_avg = sample;
+    sched->ttfb_baseline = sample;
+    return false;
+  }
+
+  sched->ttfb_avg = sched->ttfb_avg - (sched->ttfb_avg >> 2) + (sample >> 2);
+  if (sample < sched->ttfb_baseline) {
+    sched->ttfb_baseline = sched->ttfb_baseline - (sched->ttfb_baseline >> 2) + (sample >> 2);
+  } else {
+    sched->ttfb_baseline = sched->ttfb_baseline - (sched->ttfb_baseline >> 6) + (sample >> 6);
+  }
+
+  return sched->ttfb_avg > sched->ttfb_baseline + (sched->ttfb_baseline >> 1) + (TTFB_SLACK_MS << TTFB_SHIFT);
+}
+
+void schedulerInit(scheduler_t *sched, uint32_t target_ms, uint32_t max_ms) {
+  *sched = scheduler_t();
+  sched->target_ms = target_ms > 0 ? target_ms : 1;
+  sched->max_ms = max_ms > sched->target_ms ? max_ms : sched->target_ms;
+  sched->interval_ms = sched->target_ms;
+}
+
+void schedulerSetTarget(scheduler_t *sched, uint32_t target_ms) {
+  if (target_ms == 0) target_ms = 1;
+  /* a backed-off interval stays backed off by the same factor */
+  sched->interval_ms = (uint32_t)((uint64_t)sched->interval_ms * target_ms / sched->target_ms);
+  sched->target_ms = target_ms;
+  if (sched->max_ms < sched->target_ms) sched->max_ms = sched->target_ms;
+  if (sched->interval_ms < sched->target_ms) sched->interval_ms = sched->target_ms;
+  if (sched->interval_ms > sched->max_ms) sched->interval_ms = sched->max_ms;
+}
+
+void schedulerOnResult(scheduler_t *sched, int code, uint32_t ttfb_ms, uint32_t retry_after_s, uint32_t now_ms) {
+  uint32_t rate = rateOf(sched->interval_ms);
+
+  if (retry_after_s > 0) {
+    /* capped at the longest interval: a server asking for a day (or garbage) does not stop the camera */
+    uint64_t hold_ms = (uint64_t)retry_after_s * 1000;
+    sched->hold_until = now_ms + (hold_ms < sched->max_ms ? (uint32_t)hold_ms : sched->max_ms);
+    sched->holding = true;
+    sched->retry_afters++;
+  }
+
+  bool rising = ttfb_ms > 0 && latencyRising(sched, ttfb_ms);
+  if (sched->cooldown > 0) {
+    sched->cooldown--;
+    rising = false;
+  }
+
+  if (code == -2 || code == -3 || code == -4 || code >= 500) {
+    /* multiplicative decrease of the rate: the server or the link is overloaded */
+    setRate(sched, rate / 2);
+    sched->cooldown = SCHEDULER_COOLDOWN_RESULTS;
+    sched->backoffs++;
+  } else if (rising) {
+    /* queueing delay builds up before errors do; back off gently */
+    setRate(sched, rate - rate / 5);
+    sched->cooldown = SCHEDULER_COOLDOWN_RESULTS;
+    sched->latency_backoffs++;
+  } else if (code > 0) {
+    /* additive increase, a fixed fraction of the target rate per good upload */
+    setRate(sched, rate + rateOf(sched->target_ms) / INCREASE_STEPS);
+  }
+}
+
+uint32_t schedulerNextDelay(scheduler_t *sched, uint32_t cycle_start_ms, uint32_t now_ms) {
+  uint32_t elapsed = now_ms - cycle_start_ms;
+  uint32_t delay = elapsed < sched->interval_ms ? sched->interval_ms - elapsed : 0;
+
+  if (sched->holding) {
+    int32_t hold = (int32_t)(sched->hold_until - now_ms);
+    if (hold <= 0) {
+      sched->holding = false;
+    } else if ((uint32_t)hold > delay) {
+      delay = hold;
+    }
+  }
+  return delay;
+}
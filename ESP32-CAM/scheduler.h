@@ -0,0 +1,69 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Adaptive capture scheduler (AIMD)
+
+  Aims for one frame every target_ms. The capture rate drops when the server
+  signals overload and climbs back towards the target while uploads go well:
+
+    - 5xx, network/data/HTTP errors (incl. timeouts)  -> rate / 2
+    - time-to-first-byte well above its baseline       -> rate * 4/5
+    - any other response                               -> rate + target rate / 16
+    - Retry-After                                      -> no capture before it expired,
+                                                          but at most max_ms
+
+  After a backoff the latency signal is ignored for a few results, so the
+  effect of the previous backoff is seen before reacting again.
+
+  Plain C++ without clock or RTOS calls: time is passed in, so the pipeline and
+  host/scheduler_sim.cpp drive the exact same logic.
+*/
+#define SCHEDULER_MAX_INTERVAL_MS 60000
+#define SCHEDULER_COOLDOWN_RESULTS 4
+
+typedef struct {
+  uint32_t target_ms;
+  uint32_t max_ms;
+  uint32_t interval_ms;      /* current capture interval */
+
+  /* time-to-first-byte: fast average vs. slowly adapting baseline, both in ms * 16 */
+  uint32_t ttfb_avg;
+  uint32_t ttfb_baseline;
+
+  uint32_t cooldown;         /* results left before latency is looked at again */
+  uint32_t hold_until;       /* Retry-After, in the caller's millisecond clock */
+  bool holding;
+
+  /* statistics */
+  uint32_t backoffs;
+  uint32_t latency_backoffs;
+  uint32_t retry_afters;
+} scheduler_t;
+
+void schedulerInit(scheduler_t *sched, uint32_t target_ms, uint32_t max_ms = SCHEDULER_MAX_INTERVAL_MS);
+
+/*
+  New target interval at runtime. The current interval is scaled with it and
+  kept within [target, max]; Retry-After and the latency state stay as they are.
+*/
+void schedulerSetTarget(scheduler_t *sched, uint32_t target_ms);
+
+/*
+  Feeds the outcome of one upload.
+  code is the HTTP status or a negative postImage() error, ttfb_ms 0 if no response
+  byte arrived, retry_after_s the server's Retry-After (0 = none; longer than max_ms
+  waits max_ms), now_ms the current time.
+*/
+void schedulerOnResult(scheduler_t *sched, int code, uint32_t ttfb_ms, uint32_t retry_after_s, uint32_t now_ms);
+
+/*
+  How long to wait before the next capture, given that the current cycle
+  started at cycle_start_ms (the time already spent is subtracted).
+*/
+uint32_t schedulerNextDelay(scheduler_t *sched, uint32_t cycle_start_ms, uint32_t now_ms);
+
+#endif
@@ -1,17 +1,27 @@
 import os
-from concurrent.futures import ThreadPoolExecutor
 
-from flask import Flask, jsonify, request
+from flask import Flask, Response, jsonify, request
 
 from routes.preview import preview_route, push_frame
 from routes.dashboard import dashboard_route
 from services.aws import AWSClient
-from services.circle_detection.detect_circle import detect_circles
+from services.circle_detection.detect_circle import (
+    detect_circles_bytes,
+    detect_circles_bytes_batch,
+)
+from services.circle_detection.ingest import stage
+from services.circle_result import CIRCLES_MIME, encode_circles, wants_binary
+from services.devices import (
+    DEFAULT_DEVICE,
+    DEVICE_HEADER,
+    registry,
+    valid_device_id,
+)
+from services.upload_stream import UploadError, read_parts
+from services.uploader import FolderStore, S3Store, Uploader
 
 app = Flask(__name__)
-
-# Global variable to store detected circles
-circles_array = []
+app.config["MAX_CONTENT_LENGTH"] = 32 * 1024 * 1024
 
 # Register other routes
 app.register_blueprint(preview_route)
@@ -23,55 +33,222 @@ app.config["UPLOAD_FOLDER"] = os.path.abspath(
 )
 os.makedirs(app.config["UPLOAD_FOLDER"], exist_ok=True)
 
-# Init AWS client for image upload
+# Init AWS client for image upload; without S3 the images stay in the upload folder
 s3 = AWSClient()
-executor = ThreadPoolExecutor(max_workers=25)  # limit
+uploader = Uploader(
+    S3Store(s3, "validation")
+    if s3.configured
+    else FolderStore(app.config["UPLOAD_FOLDER"]),
+    max_queue=int(os.getenv("UPLOAD_QUEUE_MAX", "64")),
+    policy=os.getenv("UPLOAD_POLICY", "drop_oldest"),
+    workers=int(os.getenv("UPLOAD_WORKERS", "4")),
+    spill_dir=os.getenv("UPLOAD_SPILL_DIR")
+    or os.path.join(app.config["UPLOAD_FOLDER"], ".spill"),
+)
 
+# Seconds the cameras are asked to wait (Retry-After) while the upload queue is full
+UPLOAD_RETRY_AFTER_S = int(os.getenv("UPLOAD_RETRY_AFTER_S", "5"))
 
-# Upload route for ESP
-@app.post("/upload")
-def upload_image():
-    if "image" not in request.files:
-        return jsonify({"error": "No image file provided"}), 400
 
-    image = request.files["image"]
+def read_image(image):
+    """
+    Returns the bytes of one uploaded image, None if the part has no file name.
+    """
     if image.filename == "":
-        return jsonify({"error": "No selected file"}), 400
+        return None
+    return image.data
+
+
+def to_frame(circles, offset):
+    """
+    Moves circles found in a cropped part (X-ROI-Offset) to the coordinates of
+    the whole frame the camera captured.
+    """
+    dx, dy = offset
+    if not dx and not dy:
+        return circles
+    return [dict(circle, x=circle["x"] + dx, y=circle["y"] + dy) for circle in circles]
+
+
+def publish_result(slot, image, data, circles, result_img, timings):
+    """
+    Makes a detection result visible (result routes, preview) in the slot of
+    its device and queues the image for S3. Circles are reported in frame
+    coordinates, the preview shows the part as it was sent.
+    """
+    circles = to_frame(circles, image.offset)
+    with stage(timings, "publish"):
+        registry.publish(slot, circles)
+        push_frame(result_img, slot.device)
+
+        # Store and push image to S3 bucket asynchronously
+        uploader.submit(slot.device, data, image.filename)
+
+    return {"filename": image.filename, "circles": circles, "timings": timings}
+
+
+def process_image(slot, image, received):
+    """
+    Runs the circle detection on one uploaded image, straight from the request
+    bytes, and queues it for S3 afterwards. received holds the timings of
+    reading the body.
+    Returns the per-image result and whether the image was accepted.
+    """
+    data = read_image(image)
+    if data is None:
+        return {"error": "No selected file"}, False
+
+    timings = dict(received)
+    detection = detect_circles_bytes(data, timings=timings)
+    if detection is None:
+        return {"error": "Invalid image"}, False
+
+    circles, result_img = detection
+    return publish_result(slot, image, data, circles, result_img, timings), True
+
+
+def process_batch(slot, images, received):
+    """
+    process_image() for all parts of a batch upload; the detection runs for
+    all images at once (see detect_circles_bytes_batch).
+    """
+    blobs = [read_image(image) for image in images]
+    present = [data for data in blobs if data is not None]
+    timings = [dict(received) for _ in present]
+    detections = zip(
+        detect_circles_bytes_batch(present, timings=timings), timings, strict=True
+    )
+
+    results = []
+    accepted = 0
+    for image, data in zip(images, blobs, strict=True):
+        if data is None:
+            results.append({"error": "No selected file"})
+            continue
 
-    file_path = os.path.join(app.config["UPLOAD_FOLDER"], image.filename)
-    image.save(file_path)
+        detection, image_timings = next(detections)
+        if detection is None:
+            results.append({"filename": image.filename, "error": "Invalid image"})
+            continue
 
-    circles, result_img = detect_circles(file_path)
-    circles_array.clear()
-    circles_array.append(circles)
-    push_frame(result_img)
+        circles, result_img = detection
+        results.append(
+            publish_result(slot, image, data, circles, result_img, image_timings)
+        )
+        accepted += 1
+    return results, accepted
 
-    # Push image to S3 bucket asynchronously
-    executor.submit(s3.upload, "validation", file_path, delete=True)
 
+# Upload route for ESP
+# One "image" part -> single result, several "image" parts (batch mode) -> one result per part
+# The X-Device-ID header selects the camera's result / preview slot
+# Single results are binary if the Accept header prefers it (the firmware does), JSON otherwise
+@app.post("/upload")
+def upload_image():
+    response, status = handle_upload()
+    if status == 200 and uploader.saturated():
+        # the firmware pauses its captures for this long (see ESP32-CAM/scheduler.h)
+        response.headers["Retry-After"] = str(UPLOAD_RETRY_AFTER_S)
+    return response, status
+
+
+def handle_upload():
+    device = request.headers.get(DEVICE_HEADER, DEFAULT_DEVICE)
+    if not valid_device_id(device):
+        return jsonify({"error": "Invalid device ID"}), 400
+
+    # parsed while it arrives, also with Transfer-Encoding: chunked
+    received = {}
+    try:
+        images = read_parts(request, "image", received)
+    except UploadError as error:
+        return jsonify({"error": str(error)}), 400
+    if not images:
+        return jsonify({"error": "No image file provided"}), 400
+
+    slot = registry.slot(device)
+    if slot is None:
+        return jsonify({"error": "Too many devices"}), 503
+
+    if len(images) == 1:
+        result, ok = process_image(slot, images[0], received)
+        if not ok:
+            return jsonify(result), 400
+
+        # the firmware asks for the binary result (services/circle_result.py)
+        if wants_binary(request.accept_mimetypes):
+            return Response(
+                encode_circles(result["circles"]), mimetype=CIRCLES_MIME
+            ), 200
+
+        return (
+            jsonify(
+                {
+                    "message": f"Image {images[0].filename} uploaded successfully",
+                    "circles": result["circles"],
+                    "timings": result["timings"],
+                }
+            ),
+            200,
+        )
+
+    results, accepted = process_batch(slot, images, received)
     return (
         jsonify(
             {
-                "message": f"Image {image.filename} uploaded successfully",
-                "circles": circles,
+                "message": f"{accepted} of {len(images)} images uploaded successfully",
+                "results": results,
             }
         ),
-        200,
+        200 if accepted else 400,
     )
 
 
-# Results route for classification result
+# Results route for classification result, of the device that uploaded last
 @app.get("/result")
 def get_result():
+    slot = registry.latest_slot()
     return (
         jsonify(
             {
-                "circles": circles_array,
+                "device": slot.device if slot else None,
+                "circles": slot.circles if slot else [],
             }
         ),
         200,
     )
 
 
+# Results of one camera
+@app.get("/result/<device>")
+def get_device_result(device):
+    slot = registry.slot(device, create=False)
+    if slot is None:
+        return jsonify({"error": "Unknown device"}), 404
+
+    return (
+        jsonify(
+            {
+                "device": slot.device,
+                "circles": slot.circles,
+                "updated": slot.updated,
+            }
+        ),
+        200,
+    )
+
+
+# Cameras that uploaded since the start
+@app.get("/devices")
+def get_devices():
+    return jsonify({"devices": registry.devices()}), 200
+
+
+# Upload queue: depth, throughput, drops and failures
+@app.get("/metrics")
+def get_metrics():
+    return jsonify({"uploader": uploader.metrics()}), 200
+
+
 if __name__ == "__main__":
     app.run(host="0.0.0.0", port=4444, debug=True)
@@ -0,0 +1,167 @@
+"""
+Benchmark of the circle classification: NumPy masks vs. the native engine.
+
+    python benchmark_circles.py [input_dir] [--repeat N] [--threads N]
+
+For every image in input_dir (default: ../circle_evaluation/input) the Hough
+transform runs once, then the filled / unfilled statistics are timed with both
+implementations. Also checks that both give the same means and decisions,
+and times detect_circles() per image against detect_circles_batch().
+
+Memory: Python/NumPy allocations are traced with tracemalloc. The engine's mask
+buffers are C++ allocations; their peak is computed from the circle sizes.
+"""
+
+import argparse
+import contextlib
+import os
+import statistics
+import sys
+import time
+import tracemalloc
+
+import cv2
+
+from services.circle_detection import circle_engine
+from services.circle_detection.detect_circle import (
+    FILL_THRESHOLD,
+    circle_stats_numpy,
+    detect_circles,
+    detect_circles_batch,
+    find_circles,
+)
+
+DEFAULT_INPUT = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), "..", "circle_evaluation", "input"
+)
+
+
+def image_paths(path):
+    return sorted(
+        os.path.join(path, f)
+        for f in os.listdir(path)
+        if f.lower().endswith((".jpg", ".jpeg", ".png"))
+    )
+
+
+def timed(fn, repeat):
+    """Median wall time in ms and the tracemalloc peak in bytes of one extra run."""
+    times = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        fn()
+        times.append((time.perf_counter() - start) * 1000)
+
+    tracemalloc.start()
+    fn()
+    _, peak = tracemalloc.get_traced_memory()
+    tracemalloc.stop()
+    return statistics.median(times), peak
+
+
+def native_mask_bytes(circles, threads):
+    # inside mask (2r+1)^2 + edge mask (2r+9)^2 per worker, largest circles first
+    sizes = sorted(
+        ((2 * int(r) + 1) ** 2 + (2 * int(r) + 9) ** 2 for _, _, r in circles),
+        reverse=True,
+    )
+    return sum(sizes[: max(threads, 1)])
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("input", nargs="?", default=DEFAULT_INPUT)
+    parser.add_argument("--repeat", type=int, default=10)
+    parser.add_argument("--threads", type=int, default=0, help="0 = all cores")
+    args = parser.parse_args()
+
+    if not circle_engine.available():
+        print(f"native engine not built: {circle_engine.LIBRARY_PATH}")
+        return 1
+
+    paths = image_paths(args.input)
+    if not paths:
+        print(f"no images in {args.input}")
+        return 1
+
+    threads = args.threads or os.cpu_count() or 1
+    mismatches = 0
+
+    print(
+        f"{'image':<40} {'size':>10} {'circles':>7} {'hough ms':>9} "
+        f"{'numpy ms':>9} {'native ms':>9} {'speedup':>7} "
+        f"{'numpy peak':>11} {'native peak':>11}"
+    )
+    for path in paths:
+        img = cv2.imread(path)
+        start = time.perf_counter()
+        gray, circles = find_circles(img)
+        hough_ms = (time.perf_counter() - start) * 1000
+        if circles is None:
+            print(f"{os.path.basename(path):<40} no circles")
+            continue
+
+        numpy_ms, numpy_peak = timed(
+            lambda gray=gray, circles=circles: circle_stats_numpy(gray, circles),
+            args.repeat,
+        )
+        native_ms, native_peak = timed(
+            lambda gray=gray, circles=circles: circle_engine.circle_stats_batch(
+                [(gray, circles)], FILL_THRESHOLD, args.threads
+            ),
+            args.repeat,
+        )
+        native_peak += native_mask_bytes(circles, threads)
+
+        # same means, same decisions
+        ref_inside, ref_edge = circle_stats_numpy(gray, circles)
+        inside, edge, filled = circle_engine.circle_stats_batch(
+            [(gray, circles)], FILL_THRESHOLD, args.threads
+        )[0]
+        for i in range(len(circles)):
+            ref_filled = abs(ref_inside[i] - ref_edge[i]) < FILL_THRESHOLD
+            if (
+                ref_inside[i] != inside[i]
+                or ref_edge[i] != edge[i]
+                or ref_filled != filled[i]
+            ):
+                mismatches += 1
+                print(f"  mismatch {path} circle {circles[i]}")
+
+        print(
+            f"{os.path.basename(path)[:40]:<40} "
+            f"{gray.shape[1]:>4}x{gray.shape[0]:<5} {len(circles):>7} "
+            f"{hough_ms:>9.1f} {numpy_ms:>9.2f} {native_ms:>9.2f} "
+            f"{numpy_ms / native_ms:>6.0f}x "
+            f"{numpy_peak / 1024:>9.0f}KB {native_peak / 1024:>9.0f}KB"
+        )
+
+    # end to end, including decoding, Hough and annotation
+    batch = paths * args.repeat
+    with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+        start = time.perf_counter()
+        for path in batch:
+            detect_circles(path, native=False)
+        numpy_total = time.perf_counter() - start
+
+        start = time.perf_counter()
+        for path in batch:
+            detect_circles(path, native=True)
+        native_total = time.perf_counter() - start
+
+        start = time.perf_counter()
+        detect_circles_batch(batch, native=True)
+        batch_total = time.perf_counter() - start
+
+    print()
+    print(f"end to end over {len(batch)} images ({threads} threads):")
+    print(f"  detect_circles, numpy      {len(batch) / numpy_total:7.1f} images/s")
+    print(f"  detect_circles, native     {len(batch) / native_total:7.1f} images/s")
+    print(f"  detect_circles_batch       {len(batch) / batch_total:7.1f} images/s")
+    print()
+    print("decisions match" if mismatches == 0 else f"{mismatches} MISMATCHES")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
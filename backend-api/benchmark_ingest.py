@@ -0,0 +1,237 @@
+"""
+Benchmark of the /upload ingest: disk round trip vs. in-memory decode, and
+throughput of the running app with concurrent simulated ESP clients.
+
+    python benchmark_ingest.py [input_dir] [--clients N] [--duration S] [--scale S]
+
+1. Per image, single thread: the old path (write the upload to disk,
+   cv2.imread, BGR -> gray) against detect_circles_bytes() (luma straight from
+   the bytes), with the stage times and how many circles and decisions agree.
+2. The Flask app is served on a local port (threaded, like the dev server) and
+   N clients post the images of input_dir in a loop for S seconds, one
+   multipart request each, like the ESP. Prints requests/s, latency percentiles
+   and the mean server stage times from the responses.
+
+--scale overrides INGEST_SCALE (1, 2, 4, 8) to see what a reduced decode costs
+in accuracy. Uploads are written to a temporary folder; S3 stays off unless the
+AWS_* variables are set.
+"""
+
+import argparse
+import contextlib
+import http.client
+import json
+import os
+import statistics
+import sys
+import tempfile
+import threading
+import time
+
+from services.circle_detection import detect_circle
+from services.circle_detection.detect_circle import (
+    detect_circles,
+    detect_circles_bytes,
+)
+
+DEFAULT_INPUT = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), "..", "circle_evaluation", "input"
+)
+BOUNDARY = "----HiveHiveBenchmark"
+
+
+def image_paths(path):
+    return sorted(
+        os.path.join(path, f)
+        for f in os.listdir(path)
+        if f.lower().endswith((".jpg", ".jpeg"))
+    )
+
+
+def agreement(reference, results, tolerance):
+    """Circles of reference found again within tolerance px, and with the same decision."""
+    found = same = 0
+    for ref in reference:
+        best = min(
+            results,
+            key=lambda res: abs(res["x"] - ref["x"]) + abs(res["y"] - ref["y"]),
+            default=None,
+        )
+        if best and abs(best["x"] - ref["x"]) + abs(best["y"] - ref["y"]) <= tolerance:
+            found += 1
+            same += best["status"] == ref["status"]
+    return found, same
+
+
+def compare_paths(paths, repeat, scale):
+    print(f"single thread, median of {repeat}, decoder scale 1/{scale}:")
+    print(
+        f"{'image':<40} {'disk ms':>8} {'memory ms':>9} "
+        f"{'decode':>7} {'hough':>7} {'stats':>7} {'annotate':>8} "
+        f"{'circles':>9} {'same':>5}"
+    )
+    with tempfile.TemporaryDirectory() as folder:
+        for path in paths:
+            with open(path, "rb") as file:
+                data = file.read()
+            upload_path = os.path.join(folder, os.path.basename(path))
+
+            disk_times, memory_times, stage_times = [], [], []
+            with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+                for _ in range(repeat):
+                    start = time.perf_counter()
+                    with open(upload_path, "wb") as file:
+                        file.write(data)
+                    reference, _ = detect_circles(upload_path)
+                    disk_times.append((time.perf_counter() - start) * 1000)
+
+                    timings = {}
+                    start = time.perf_counter()
+                    results, _ = detect_circles_bytes(data, timings=timings)
+                    memory_times.append((time.perf_counter() - start) * 1000)
+                    stage_times.append(timings)
+
+            found, same = agreement(reference, results, 3 * scale)
+            stages = {
+                name: statistics.median(t[name] for t in stage_times)
+                for name in ("decode", "hough", "stats", "annotate")
+            }
+            print(
+                f"{os.path.basename(path)[:40]:<40} "
+                f"{statistics.median(disk_times):>8.1f} "
+                f"{statistics.median(memory_times):>9.1f} "
+                f"{stages['decode']:>7.1f} {stages['hough']:>7.1f} "
+                f"{stages['stats']:>7.1f} {stages['annotate']:>8.1f} "
+                f"{found:>4}/{len(reference):<4} {same:>5}"
+            )
+
+
+def multipart(filename, data):
+    head = (
+        f"--{BOUNDARY}\r\n"
+        f'Content-Disposition: form-data; name="image"; filename="{filename}"\r\n'
+        "Content-Type: image/jpeg\r\n\r\n"
+    ).encode()
+    return head + data + f"\r\n--{BOUNDARY}--\r\n".encode()
+
+
+def esp_client(port, client_id, images, deadline, samples):
+    """Posts the images round robin until deadline, like one camera."""
+    sent = 0
+    while time.perf_counter() < deadline:
+        data = images[sent % len(images)]
+        body = multipart(f"esp{client_id}-{sent}.jpg", data)
+        start = time.perf_counter()
+        conn = http.client.HTTPConnection("127.0.0.1", port, timeout=60)
+        conn.request(
+            "POST",
+            "/upload",
+            body,
+            {"Content-Type": f"multipart/form-data; boundary={BOUNDARY}"},
+        )
+        response = conn.getresponse()
+        payload = response.read()
+        conn.close()
+        latency = (time.perf_counter() - start) * 1000
+
+        timings = (
+            json.loads(payload).get("timings", {}) if response.status == 200 else {}
+        )
+        samples.append((response.status, latency, timings))
+        sent += 1
+
+
+def run_clients(paths, clients, duration):
+    from werkzeug.serving import WSGIRequestHandler, make_server
+
+    import app as backend
+    from services.uploader import FolderStore
+
+    class QuietHandler(WSGIRequestHandler):
+        def log_request(self, *args, **kwargs):
+            pass
+
+    images = []
+    for path in paths:
+        with open(path, "rb") as file:
+            images.append(file.read())
+
+    with tempfile.TemporaryDirectory() as folder:
+        backend.app.config["UPLOAD_FOLDER"] = folder
+        backend.uploader.store = FolderStore(folder)
+        server = make_server(
+            "127.0.0.1", 0, backend.app, threaded=True, request_handler=QuietHandler
+        )
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+
+        samples = []
+        deadline = time.perf_counter() + duration
+        workers = [
+            threading.Thread(
+                target=esp_client,
+                args=(server.server_port, i, images, deadline, samples),
+            )
+            for i in range(clients)
+        ]
+        with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+            start = time.perf_counter()
+            for worker in workers:
+                worker.start()
+            for worker in workers:
+                worker.join()
+            elapsed = time.perf_counter() - start
+            server.shutdown()
+            backend.uploader.close()
+
+    ok = [sample for sample in samples if sample[0] == 200]
+    latencies = sorted(latency for _, latency, _ in ok)
+    print()
+    print(f"{clients} simulated ESP clients for {elapsed:.1f} s:")
+    if not latencies:
+        print(f"  no successful requests ({len(samples)} sent)")
+        return 1
+
+    def percentile(p):
+        return latencies[min(int(len(latencies) * p), len(latencies) - 1)]
+
+    print(
+        f"  {len(ok)} of {len(samples)} requests ok, {len(ok) / elapsed:.1f} images/s"
+    )
+    print(
+        f"  latency p50 {percentile(0.5):.1f} ms  p95 {percentile(0.95):.1f} ms  "
+        f"max {latencies[-1]:.1f} ms"
+    )
+    stages = ("decode", "hough", "stats", "annotate", "publish")
+    means = {
+        name: statistics.mean(timings.get(name, 0.0) for _, _, timings in ok)
+        for name in stages
+    }
+    print(
+        "  server stages (mean ms): " + "  ".join(f"{n} {means[n]:.1f}" for n in stages)
+    )
+    return 0 if len(ok) == len(samples) else 1
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("input", nargs="?", default=DEFAULT_INPUT)
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--clients", type=int, default=8)
+    parser.add_argument("--duration", type=float, default=10.0)
+    parser.add_argument("--scale", type=int, choices=(1, 2, 4, 8))
+    args = parser.parse_args()
+
+    if args.scale:
+        detect_circle.INGEST_SCALE = args.scale
+
+    paths = image_paths(args.input)
+    if not paths:
+        print(f"no JPEGs in {args.input}")
+        return 1
+
+    compare_paths(paths, args.repeat, detect_circle.INGEST_SCALE)
+    return run_clients(paths, args.clients, args.duration)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
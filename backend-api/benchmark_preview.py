@@ -0,0 +1,138 @@
+"""
+CPU cost of the MJPEG preview as the number of dashboard viewers grows.
+
+    python benchmark_preview.py [image] [--viewers 1,10,50,100] [--rate R] [--duration S]
+
+One camera pushes the annotated detection result of image (default: the first
+sample of ../circle_evaluation/input) R times per second. N viewers consume the
+stream generator of routes/preview.py in their own threads, like the Flask
+response threads do. For comparison the same runs are made with the previous
+implementation (PIL encode per viewer and per tick, polling at FPS).
+
+Prints the process CPU time per second of wall time (100 % = one core), the
+frames delivered per viewer and the CPU time per delivered frame.
+"""
+
+import argparse
+import contextlib
+import os
+import sys
+import threading
+import time
+from io import BytesIO
+
+from PIL import Image
+
+from benchmark_ingest import DEFAULT_INPUT, image_paths
+from routes import preview
+from services.circle_detection.detect_circle import detect_circles_bytes
+from services.devices import registry
+
+DEVICE = "bench"
+
+
+class PerViewerPreview:
+    """The preview before the broadcast: every viewer encodes every tick."""
+
+    def __init__(self):
+        self.frame = None
+        self.lock = threading.Lock()
+
+    def push_frame(self, img_bgr):
+        img_rgb = Image.fromarray(img_bgr[:, :, ::-1])
+        with self.lock:
+            self.frame = img_rgb
+
+    def frames(self):
+        while True:
+            with self.lock:
+                frame = self.frame
+            if frame is None:
+                frame = Image.new("RGB", (640, 360), (10, 10, 10))
+            buf = BytesIO()
+            frame.save(buf, format="JPEG", quality=80, optimize=True)
+            yield buf.getvalue()
+            time.sleep(1.0 / preview.FPS)
+
+
+class BroadcastPreview:
+    """routes/preview.py"""
+
+    def push_frame(self, img_bgr):
+        preview.push_frame(img_bgr, DEVICE)
+
+    def frames(self):
+        return preview._frame_generator(DEVICE)
+
+
+def run(implementation, img, viewers, rate, duration):
+    stop = threading.Event()
+    delivered = [0] * viewers
+
+    def viewer(i):
+        for _ in implementation.frames():
+            delivered[i] += 1
+            if stop.is_set():
+                return
+
+    implementation.push_frame(img)
+    threads = [threading.Thread(target=viewer, args=(i,)) for i in range(viewers)]
+
+    cpu_start = time.process_time()
+    wall_start = time.perf_counter()
+    for thread in threads:
+        thread.start()
+    pushed = 0
+    while time.perf_counter() - wall_start < duration:
+        implementation.push_frame(img.copy())
+        pushed += 1
+        time.sleep(max(0.0, wall_start + pushed / rate - time.perf_counter()))
+    cpu = time.process_time() - cpu_start
+    wall = time.perf_counter() - wall_start
+
+    # wake the viewers blocked on the next frame
+    stop.set()
+    implementation.push_frame(img)
+    for thread in threads:
+        thread.join()
+
+    frames = sum(delivered)
+    return cpu / wall * 100, frames / viewers / wall, cpu * 1000 / max(frames, 1)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("image", nargs="?")
+    parser.add_argument("--viewers", default="1,10,50,100")
+    parser.add_argument("--rate", type=float, default=2.0, help="uploads per second")
+    parser.add_argument("--duration", type=float, default=5.0)
+    args = parser.parse_args()
+
+    path = args.image or image_paths(DEFAULT_INPUT)[0]
+    with open(path, "rb") as file:
+        data = file.read()
+    with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+        _, img = detect_circles_bytes(data)
+    registry.slot(DEVICE)
+
+    print(
+        f"{os.path.basename(path)} ({img.shape[1]}x{img.shape[0]}), "
+        f"{args.rate:g} uploads/s, {args.duration:g} s per run, "
+        f"{os.cpu_count()} cores"
+    )
+    print(
+        f"{'viewers':>7}  {'per-viewer CPU':>14} {'frames/s':>8} {'ms/frame':>8}  "
+        f"{'broadcast CPU':>13} {'frames/s':>8} {'ms/frame':>8}"
+    )
+    for viewers in (int(v) for v in args.viewers.split(",")):
+        old = run(PerViewerPreview(), img, viewers, args.rate, args.duration)
+        new = run(BroadcastPreview(), img, viewers, args.rate, args.duration)
+        print(
+            f"{viewers:>7}  {old[0]:>13.0f}% {old[1]:>8.1f} {old[2]:>8.2f}  "
+            f"{new[0]:>12.0f}% {new[1]:>8.1f} {new[2]:>8.2f}"
+        )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,229 @@
+"""
+Burst test of the S3 upload stage (services/uploader.py).
+
+    python benchmark_uploader.py [input_dir] [--endpoint URL] [--frames N] [--rate R]
+                                 [--latency MS] [--queue N] [--workers N]
+
+Uploads go to a real S3-compatible endpoint (MinIO, moto_server; credentials from
+AWS_ACCESS_KEY_ID / AWS_SECRET_ACCESS_KEY) or, without --endpoint, to moto's
+in-process mock (requirements-dev.txt). --latency adds a delay to every PUT, to
+stand in for a slow uplink.
+
+N frames of input_dir are submitted at R frames/s from 10 cameras, first to the
+previous stage (unbounded thread pool, second-resolution keys), then to the
+Uploader with each queue policy. Prints what arrived in the bucket, what was
+dropped or spilled, the peak backlog and the throughput, then checks that a
+large object goes out as a multipart upload. Exit code 1 if a key was
+overwritten or an upload is missing.
+"""
+
+import argparse
+import contextlib
+import io
+import os
+import shutil
+import sys
+import tempfile
+import time
+import uuid
+from concurrent.futures import ThreadPoolExecutor
+from datetime import datetime
+
+import boto3
+
+from benchmark_ingest import DEFAULT_INPUT, image_paths
+from services import aws
+from services.uploader import POLICIES, S3Store, Uploader
+
+CAMERAS = 10
+
+
+class SlowClient:
+    """AWSClient stand-in that adds a fixed latency to every PUT."""
+
+    def __init__(self, s3, latency):
+        self.s3 = s3
+        self.latency = latency
+        self.transfer = aws.AWSClient().transfer
+
+    def put(self, bucket, key, data):
+        time.sleep(self.latency)
+        self.s3.upload_fileobj(io.BytesIO(data), bucket, key, Config=self.transfer)
+
+
+def count_objects(s3, bucket):
+    paginator = s3.get_paginator("list_objects_v2")
+    return sum(page.get("KeyCount", 0) for page in paginator.paginate(Bucket=bucket))
+
+
+def burst(submit, frames, images, rate, backlog):
+    """Submits frames at rate; backlog() is sampled for its peak."""
+    peak = 0
+    start = time.perf_counter()
+    for n in range(frames):
+        submit(f"cam-{n % CAMERAS:02d}", images[n % len(images)])
+        peak = max(peak, backlog())
+        time.sleep(max(0.0, start + (n + 1) / rate - time.perf_counter()))
+    return peak
+
+
+def row(stage, frames, stored, dropped, spilled, overwritten, peak, elapsed):
+    return (
+        f"{stage:>12} {frames:>8} {stored:>8} {dropped:>8} {spilled:>8} "
+        f"{overwritten:>11} {peak:>9} {elapsed:>7.1f}s"
+    )
+
+
+def run_previous(s3, bucket, client, images, args):
+    """
+    The stage before the Uploader: one unbounded pool, keys per second.
+    Returns the table row.
+    """
+    executor = ThreadPoolExecutor(max_workers=25)
+
+    def upload(device, data):
+        key = f"{device}/{datetime.now():%Y-%m-%d_%H-%M-%S}.jpg"
+        client.put(bucket, key, data)
+
+    start = time.perf_counter()
+    peak = burst(
+        lambda device, data: executor.submit(upload, device, data),
+        args.frames,
+        images,
+        args.rate,
+        executor._work_queue.qsize,
+    )
+    executor.shutdown(wait=True)
+    elapsed = time.perf_counter() - start
+    stored = count_objects(s3, bucket)
+    return row(
+        "previous", args.frames, stored, "-", "-", args.frames - stored, peak, elapsed
+    )
+
+
+def run_uploader(s3, bucket, client, images, args, policy, spill_dir):
+    """Returns the table row and whether every upload is stored under its own key."""
+    uploader = Uploader(
+        S3Store(client, bucket),
+        max_queue=args.queue,
+        policy=policy,
+        workers=args.workers,
+        spill_dir=spill_dir,
+    )
+    accepted = []
+
+    def submit(device, data):
+        key = uploader.submit(device, data)
+        if key is not None:
+            accepted.append(key)
+
+    start = time.perf_counter()
+    peak = burst(submit, args.frames, images, args.rate, uploader._queue.qsize)
+    # spilled files are sent once the queue is empty
+    while uploader.metrics()["spill_bytes"] or uploader.metrics()["in_flight"]:
+        time.sleep(0.1)
+    uploader.close()
+    elapsed = time.perf_counter() - start
+
+    metrics = uploader.metrics()
+    stored = count_objects(s3, bucket)
+    text = row(
+        policy,
+        args.frames,
+        stored,
+        metrics["dropped"],
+        metrics["spilled"],
+        metrics["uploaded"] - stored,
+        peak,
+        elapsed,
+    )
+    # drop_oldest may still drop an accepted upload, but never lose an uploaded one
+    return text, (
+        stored == metrics["uploaded"]
+        and len(accepted) == len(set(accepted))
+        and not metrics["failed"]
+    )
+
+
+def check_multipart(s3, bucket, client):
+    size = aws.multipart_bytes * 2 + 1
+    client.put(bucket, "multipart-check.bin", os.urandom(size))
+    etag = s3.head_object(Bucket=bucket, Key="multipart-check.bin")["ETag"]
+    parts = etag.strip('"').partition("-")[2]
+    print(
+        f"{size / 1e6:.1f} MB object: "
+        + (f"multipart upload, {parts} parts" if parts else "single PUT")
+    )
+    return bool(parts)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("input", nargs="?", default=DEFAULT_INPUT)
+    parser.add_argument("--endpoint")
+    parser.add_argument("--frames", type=int, default=300)
+    parser.add_argument("--rate", type=float, default=100.0, help="frames per second")
+    parser.add_argument("--latency", type=float, default=50.0, help="ms per PUT")
+    parser.add_argument("--queue", type=int, default=64)
+    parser.add_argument("--workers", type=int, default=4)
+    args = parser.parse_args()
+
+    images = []
+    for path in image_paths(args.input):
+        with open(path, "rb") as file:
+            images.append(file.read())
+    if not images:
+        print(f"no JPEGs in {args.input}")
+        return 1
+
+    mock = contextlib.nullcontext()
+    if not args.endpoint:
+        from moto import mock_aws
+
+        os.environ.setdefault("AWS_ACCESS_KEY_ID", "testing")
+        os.environ.setdefault("AWS_SECRET_ACCESS_KEY", "testing")
+        mock = mock_aws()
+
+    ok = True
+    spill_dir = tempfile.mkdtemp()
+    with mock:
+        s3 = boto3.client(
+            "s3",
+            endpoint_url=args.endpoint,
+            region_name=os.getenv("AWS_DEFAULT_REGION", "us-east-1"),
+        )
+        client = SlowClient(s3, args.latency / 1000)
+
+        print(
+            f"{args.frames} frames from {CAMERAS} cameras at {args.rate:g}/s, "
+            f"{args.latency:g} ms per PUT, queue {args.queue}, {args.workers} workers "
+            f"({'moto' if not args.endpoint else args.endpoint})"
+        )
+        print(
+            f"{'stage':>12} {'frames':>8} {'stored':>8} {'dropped':>8} {'spilled':>8} "
+            f"{'overwritten':>11} {'peak q':>9} {'time':>8}"
+        )
+        for name in ("previous", *POLICIES):
+            bucket = f"bench-{uuid.uuid4().hex[:12]}"
+            s3.create_bucket(Bucket=bucket)
+            with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+                if name == "previous":
+                    text = run_previous(s3, bucket, client, images, args)
+                else:
+                    text, stored = run_uploader(
+                        s3, bucket, client, images, args, name, spill_dir
+                    )
+                    ok &= stored
+            print(text)
+
+        bucket = f"bench-{uuid.uuid4().hex[:12]}"
+        s3.create_bucket(Bucket=bucket)
+        ok &= check_multipart(s3, bucket, client)
+    shutil.rmtree(spill_dir, ignore_errors=True)
+
+    print("all uploads stored under their own key" if ok else "FAILED")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
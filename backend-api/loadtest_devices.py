@@ -0,0 +1,212 @@
+"""
+Load test of the per-device state with many cameras uploading at once.
+
+    python loadtest_devices.py [input_dir] [--devices N] [--interval S] [--duration S]
+
+The app is served on a local port (threaded, HTTP/1.1 keep-alive like the
+firmware). Every simulated camera sends its own X-Device-ID and always the same
+image of input_dir (camera i -> image i % count), one upload every S seconds
+(randomly phased), over one persistent connection.
+
+Prints upload latency percentiles overall and of the slowest camera, then
+checks that every camera's /result/<device> holds the circles of its own image
+and that /preview/<device>/stream serves a frame. Exit code 1 if an upload
+failed or a camera sees another camera's result.
+"""
+
+import argparse
+import contextlib
+import http.client
+import json
+import os
+import random
+import statistics
+import sys
+import tempfile
+import threading
+import time
+
+from benchmark_ingest import BOUNDARY, DEFAULT_INPUT, image_paths, multipart
+
+
+def device_name(i):
+    return f"sim-{i:03d}"
+
+
+def camera(port, i, data, interval, deadline, samples):
+    """One simulated ESP32-CAM."""
+    conn = http.client.HTTPConnection("127.0.0.1", port, timeout=120)
+    headers = {
+        "Content-Type": f"multipart/form-data; boundary={BOUNDARY}",
+        "X-Device-ID": device_name(i),
+    }
+    time.sleep(random.uniform(0, interval))
+    sent = 0
+    while time.perf_counter() < deadline:
+        started = time.perf_counter()
+        body = multipart(f"esp_capture_{i}_{sent}.jpg", data)
+        try:
+            conn.request("POST", "/upload", body, headers)
+            response = conn.getresponse()
+            response.read()
+            status = response.status
+        except (OSError, http.client.HTTPException):
+            conn.close()
+            status = 0
+        samples.append((i, status, (time.perf_counter() - started) * 1000))
+        sent += 1
+        time.sleep(max(0.0, interval - (time.perf_counter() - started)))
+    conn.close()
+
+
+def get_json(port, path):
+    conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+    conn.request("GET", path)
+    response = conn.getresponse()
+    payload = json.loads(response.read())
+    conn.close()
+    return response.status, payload
+
+
+def preview_frame(port, device):
+    """Reads the first part of a device's MJPEG stream, returns its size."""
+    conn = http.client.HTTPConnection("127.0.0.1", port, timeout=10)
+    conn.request("GET", f"/preview/{device}/stream")
+    response = conn.getresponse()
+    length = 0
+    while True:
+        line = response.fp.readline()
+        if line.lower().startswith(b"content-length:"):
+            length = int(line.split(b":")[1])
+        if line == b"\r\n" and length:
+            break
+    frame = response.fp.read(length)
+    conn.close()
+    return len(frame) if frame.startswith(b"\xff\xd8") else 0
+
+
+def percentile(values, p):
+    return values[min(int(len(values) * p), len(values) - 1)]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("input", nargs="?", default=DEFAULT_INPUT)
+    parser.add_argument("--devices", type=int, default=50)
+    parser.add_argument("--interval", type=float, default=10.0)
+    parser.add_argument("--duration", type=float, default=30.0)
+    args = parser.parse_args()
+
+    from werkzeug.serving import WSGIRequestHandler, make_server
+
+    import app as backend
+    from services.circle_detection.detect_circle import detect_circles_bytes
+    from services.uploader import FolderStore
+
+    class QuietHandler(WSGIRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def log_request(self, *args, **kwargs):
+            pass
+
+    paths = image_paths(args.input)
+    if not paths:
+        print(f"no JPEGs in {args.input}")
+        return 1
+    images = []
+    for path in paths:
+        with open(path, "rb") as file:
+            images.append(file.read())
+
+    # what each camera has to find in its own slot
+    with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+        expected = [detect_circles_bytes(data)[0] for data in images]
+
+    failures = 0
+    with tempfile.TemporaryDirectory() as folder:
+        backend.app.config["UPLOAD_FOLDER"] = folder
+        backend.uploader.store = FolderStore(folder)
+        server = make_server(
+            "127.0.0.1", 0, backend.app, threaded=True, request_handler=QuietHandler
+        )
+        port = server.server_port
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+
+        samples = []
+        deadline = time.perf_counter() + args.duration
+        cameras = [
+            threading.Thread(
+                target=camera,
+                args=(
+                    port,
+                    i,
+                    images[i % len(images)],
+                    args.interval,
+                    deadline,
+                    samples,
+                ),
+            )
+            for i in range(args.devices)
+        ]
+        with open(os.devnull, "w") as devnull, contextlib.redirect_stdout(devnull):
+            start = time.perf_counter()
+            for thread in cameras:
+                thread.start()
+            for thread in cameras:
+                thread.join()
+            elapsed = time.perf_counter() - start
+
+        # every camera sees its own result and preview
+        for i in range(args.devices):
+            device = device_name(i)
+            status, payload = get_json(port, f"/result/{device}")
+            own = [expected[i % len(images)]]
+            if status != 200 or payload["circles"] != own:
+                failures += 1
+                print(f"  {device}: wrong or missing result (HTTP {status})")
+            elif not preview_frame(port, device):
+                failures += 1
+                print(f"  {device}: no preview frame")
+        _, listed = get_json(port, "/devices")
+
+        server.shutdown()
+        backend.uploader.close()
+
+    ok = [(i, latency) for i, status, latency in samples if status == 200]
+    failed = len(samples) - len(ok)
+    latencies = sorted(latency for _, latency in ok)
+    print(
+        f"{args.devices} cameras, one upload every {args.interval:g} s each, "
+        f"{elapsed:.1f} s:"
+    )
+    if not latencies:
+        print(f"  no successful uploads ({len(samples)} sent)")
+        return 1
+
+    print(
+        f"  {len(ok)} of {len(samples)} uploads ok, {len(ok) / elapsed:.1f} uploads/s, "
+        f"{len(listed['devices'])} devices registered"
+    )
+    print(
+        f"  latency p50 {percentile(latencies, 0.5):.1f} ms  "
+        f"p90 {percentile(latencies, 0.9):.1f} ms  "
+        f"p99 {percentile(latencies, 0.99):.1f} ms  max {latencies[-1]:.1f} ms"
+    )
+    per_device = {}
+    for i, latency in ok:
+        per_device.setdefault(i, []).append(latency)
+    slowest = max(per_device, key=lambda i: statistics.median(per_device[i]))
+    print(
+        f"  slowest camera {device_name(slowest)}: "
+        f"median {statistics.median(per_device[slowest]):.1f} ms"
+    )
+    print(
+        "all cameras see their own result and preview"
+        if not failures
+        else f"{failures} cameras with a wrong result or preview"
+    )
+    return 1 if failures or failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
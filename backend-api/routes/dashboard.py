@@ -58,6 +58,10 @@ def dashboard():
   const tableWrap = document.getElementById('tableWrap');
   const lastUpdateEl = document.getElementById('lastUpdate');
   const toggleBtn = document.getElementById('toggleOverlay');
+  // ?device=<id> shows one camera, otherwise the one that uploaded last
+  const device = new URLSearchParams(location.search).get('device');
+  const resultUrl = device ? '/result/' + encodeURIComponent(device) : '/result';
+  if(device){ img.src = '/preview/' + encodeURIComponent(device) + '/stream'; }
   const snapshotBtn = document.getElementById('snapshot');
 
   let showOverlay = true;
@@ -162,7 +166,7 @@ def dashboard():
 
   async function fetchResult(){
     try{
-      const res = await fetch('/result', {cache:'no-store'});
+      const res = await fetch(resultUrl, {cache:'no-store'});
       if(!res.ok) throw new Error('Network');
       const data = await res.json();
       const raw = data.circles;
@@ -1,66 +1,141 @@
-import threading
 import time
-from io import BytesIO
 
-from flask import Blueprint, Response
-from PIL import Image
+import cv2
+import numpy as np
+from flask import Blueprint, Response, abort
+
+from services.devices import DEFAULT_DEVICE, registry, valid_device_id
 
 preview_route = Blueprint("preview", __name__, url_prefix="/preview")
 
-FPS = 5  # streaming framerate
+FPS = 5  # max. streaming framerate
+KEEPALIVE_S = 10  # resend the current frame this often, so idle streams stay open
+JPEG_PARAMS = [cv2.IMWRITE_JPEG_QUALITY, 80, cv2.IMWRITE_JPEG_OPTIMIZE, 1]
+
+
+def _encode(img_bgr):
+    ok, buf = cv2.imencode(".jpg", img_bgr, JPEG_PARAMS)
+    return buf.tobytes() if ok else b""
+
+
+# fallback grey/black placeholder
+_PLACEHOLDER = _encode(np.full((360, 640, 3), 10, dtype=np.uint8))
+
 
-# Shared global last frame
-_last_frame = None
-_lock = threading.Lock()
+def push_frame(img_bgr, device=DEFAULT_DEVICE):
+    """
+    New preview frame of device. Kept as it is (BGR, no copy) and only encoded
+    when a viewer needs it, once per frame however many viewers there are.
+    """
+    slot = registry.slot(device)
+    if slot is not None:
+        registry.push_frame(slot, img_bgr)
 
 
-def push_frame(img_bgr):
-    global _last_frame
-    # convert BGR → RGB
-    img_rgb = Image.fromarray(img_bgr[:, :, ::-1])
-    with _lock:
-        _last_frame = img_rgb
+def _jpeg_bytes(slot):
+    """
+    JPEG of the current frame of slot, encoded by the first viewer that asks.
+    """
+    if slot is None or slot.frame is None:
+        return _PLACEHOLDER
 
+    cached = slot.jpeg
+    if cached is not None and cached[0] == slot.frame_version():
+        return cached[1]
 
-def _jpeg_bytes(img: Image.Image) -> bytes:
-    buf = BytesIO()
-    img.save(buf, format="JPEG", quality=80, optimize=True)
-    return buf.getvalue()
+    with slot.encode_lock:
+        # the frame may have moved on while waiting: always encode the newest
+        version, frame = slot.frame
+        cached = slot.jpeg
+        if cached is None or cached[0] != version:
+            cached = (version, _encode(frame))
+            slot.jpeg = cached
+    return cached[1]
 
 
-def _frame_generator():
-    global _last_frame
-    w, h = 640, 360
+def _source(device):
+    """
+    What a viewer of device (None = the latest upload) waits on:
+    the condition, a function for the current (slot, version) and the slot.
+    """
+    if device is not None:
+        slot = registry.slot(device, create=False)
+        if slot is not None:
+            return slot.frame_cond, lambda: (slot, slot.frame_version()), slot
+
+    def current():
+        # latest device, or a device that has not uploaded yet: any new frame
+        latest = registry.latest_slot() if device is None else None
+        return latest, registry.frame_version
+
+    return registry.frame_cond, current, current()[0]
+
+
+def _frame_generator(device=None):
+    """
+    Frames of one device, of the device that uploaded last if device is None.
+    Sends each new frame once (at most FPS per second) and otherwise blocks
+    until the next one arrives, resending the current one every KEEPALIVE_S.
+    """
+    sent = None
+    next_frame = 0.0
 
     while True:
-        with _lock:
-            frame = _last_frame
+        cond, current, _ = _source(device)
+        with cond:
+            cond.wait_for(
+                lambda current=current, sent=sent: current() != sent,
+                timeout=KEEPALIVE_S,
+            )
 
-        if frame is None:
-            # fallback grey/black placeholder
-            frame = Image.new("RGB", (w, h), (10, 10, 10))
+        delay = next_frame - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        next_frame = time.monotonic() + 1.0 / FPS
 
-        yield _jpeg_bytes(frame)
-        time.sleep(1.0 / FPS)
+        _, current, slot = _source(device)
+        sent = current()
+        yield _jpeg_bytes(slot)
 
 
-@preview_route.get("/")
-def index():
+def _viewer(stream_url):
     return (
         "<!doctype html><meta charset='utf-8'>"
         "<body style='margin:0;display:flex;justify-content:center;"
         "align-items:center;height:100vh;background:#111;'>"
-        "<img src='/preview/stream' style='max-width:100%;max-height:100%;"
+        f"<img src='{stream_url}' style='max-width:100%;max-height:100%;"
         "object-fit:contain;border:3px solid #444;border-radius:8px;"
         "background:#000;'/>"
         "</body>"
     )
 
 
+@preview_route.get("/")
+def index():
+    return _viewer("/preview/stream")
+
+
+@preview_route.get("/<device>/")
+def device_index(device):
+    if not valid_device_id(device):
+        abort(404)
+    return _viewer(f"/preview/{device}/stream")
+
+
 @preview_route.get("/stream")
 def stream():
+    return _stream(_frame_generator())
+
+
+@preview_route.get("/<device>/stream")
+def device_stream(device):
+    if not valid_device_id(device):
+        abort(404)
+    return _stream(_frame_generator(device))
+
+
+def _stream(gen):
     boundary = "frame"
-    gen = _frame_generator()
 
     def multipart():
         for jpg in gen:
@@ -1,9 +1,9 @@
 import os
-from datetime import datetime
+from io import BytesIO
 
 import boto3
+from boto3.s3.transfer import TransferConfig
 from dotenv import load_dotenv
-from PIL import Image
 
 # Load .env file
 load_dotenv()
@@ -12,10 +12,21 @@ endpoint = os.getenv("AWS_ENDPOINT")
 access_key = os.getenv("AWS_ACCESS_KEY_ID")
 secret_key = os.getenv("AWS_SECRET_ACCESS_KEY")
 
+# Objects above this size are sent as multipart uploads, in parts of this size,
+# up to S3_MAX_CONCURRENCY parts at once
+multipart_bytes = int(os.getenv("S3_MULTIPART_MB", "8")) * 1024 * 1024
+max_concurrency = int(os.getenv("S3_MAX_CONCURRENCY", "4"))
+
 
 class AWSClient:
     def __init__(self):
-        if endpoint and access_key and secret_key:
+        self.configured = bool(endpoint and access_key and secret_key)
+        self.transfer = TransferConfig(
+            multipart_threshold=multipart_bytes,
+            multipart_chunksize=multipart_bytes,
+            max_concurrency=max_concurrency,
+        )
+        if self.configured:
             self.s3 = boto3.client(
                 "s3",
                 endpoint_url=endpoint,
@@ -24,44 +35,10 @@ class AWSClient:
             )
             print("[S3] Bucket upload initialized...")
 
-    def _convert_to_jpg(self, input_path, output_path=None):
-        ext = os.path.splitext(input_path)[1].lower()
-
-        # Skip if already JPG/JPEG
-        if ext in [".jpg", ".jpeg"]:
-            return input_path
-
-        if output_path is None:
-            base, _ = os.path.splitext(input_path)
-            output_path = base + ".jpg"
-
-        with Image.open(input_path) as img:
-            rgb = img.convert("RGB")
-            rgb.save(output_path, "JPEG")
-
-        return output_path
-
-    def upload(self, bucket, filename, delete=False):
-        if endpoint and access_key and secret_key:
-            timestamp = datetime.now().strftime("%Y-%m-%d_%H-%M-%S")
-
-            # Convert to JPG if needed
-            jpg_file = self._convert_to_jpg(filename)
-
-            key = f"{timestamp}.jpg"
-
-            # Upload to S3
-            self.s3.upload_file(Filename=jpg_file, Bucket=bucket, Key=key)
-
-            if delete:
-                # Delete original if different
-                if jpg_file != filename and os.path.exists(filename):
-                    os.remove(filename)
-
-                # Delete JPG file afterwards
-                if os.path.exists(jpg_file):
-                    os.remove(jpg_file)
-
-            print(f"[S3] Uploaded {key} to /{bucket}")
-        else:
-            return
+    def put(self, bucket, key, data):
+        """
+        Uploads data (bytes) as bucket/key. Called from the uploader threads
+        (services/uploader.py); boto3 clients are thread-safe.
+        """
+        self.s3.upload_fileobj(BytesIO(data), bucket, key, Config=self.transfer)
+        print(f"[S3] Uploaded {key} to /{bucket}")
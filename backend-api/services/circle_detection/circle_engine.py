@@ -0,0 +1,106 @@
+"""
+ctypes binding for the native circle statistics (native/circle_engine.cpp).
+
+The library is built by the Dockerfile; for local runs:
+
+    g++ -O3 -std=c++17 -shared -fPIC -pthread \
+        services/circle_detection/native/circle_engine.cpp \
+        -o services/circle_detection/native/libcircle_engine.so
+
+CIRCLE_ENGINE_LIB overrides the library path. Without the library available()
+is False and detect_circle.py keeps using the NumPy masks.
+"""
+
+import ctypes
+import os
+
+import numpy as np
+
+LIBRARY_PATH = os.environ.get(
+    "CIRCLE_ENGINE_LIB",
+    os.path.join(os.path.dirname(__file__), "native", "libcircle_engine.so"),
+)
+
+
+class _Frame(ctypes.Structure):
+    # mirrors hh_frame_t
+    _fields_ = [
+        ("gray", ctypes.c_void_p),
+        ("width", ctypes.c_int32),
+        ("height", ctypes.c_int32),
+        ("stride", ctypes.c_int32),
+        ("circles", ctypes.c_void_p),
+        ("count", ctypes.c_int32),
+        ("mean_inside", ctypes.c_void_p),
+        ("mean_edge", ctypes.c_void_p),
+        ("filled", ctypes.c_void_p),
+    ]
+
+
+def _load():
+    try:
+        lib = ctypes.CDLL(LIBRARY_PATH)
+    except OSError:
+        return None
+
+    lib.hh_circle_stats_batch.argtypes = [
+        ctypes.POINTER(_Frame),
+        ctypes.c_int32,
+        ctypes.c_double,
+        ctypes.c_int32,
+    ]
+    lib.hh_circle_stats_batch.restype = ctypes.c_int
+    return lib
+
+
+_lib = _load()
+
+
+def available():
+    return _lib is not None
+
+
+def circle_stats_batch(frames, threshold, threads=0):
+    """
+    frames: list of (gray, circles), gray a 2D uint8 array, circles an (N, 3) array of x, y, r.
+    Returns one (mean_inside, mean_edge, filled) tuple of arrays per frame.
+    The GIL is released during the call; threads=0 uses all cores.
+    """
+    if _lib is None:
+        raise RuntimeError(f"circle engine not built ({LIBRARY_PATH})")
+
+    structs = (_Frame * max(len(frames), 1))()
+    keep_alive = []
+    outputs = []
+
+    for i, (gray, circles) in enumerate(frames):
+        gray = np.ascontiguousarray(gray, dtype=np.uint8)
+        circles = np.ascontiguousarray(
+            np.zeros((0, 3)) if circles is None else circles, dtype=np.int32
+        ).reshape(-1, 3)
+        count = len(circles)
+        mean_inside = np.zeros(count, dtype=np.float64)
+        mean_edge = np.zeros(count, dtype=np.float64)
+        filled = np.zeros(count, dtype=np.uint8)
+
+        structs[i] = _Frame(
+            gray.ctypes.data,
+            gray.shape[1],
+            gray.shape[0],
+            gray.strides[0],
+            circles.ctypes.data,
+            count,
+            mean_inside.ctypes.data,
+            mean_edge.ctypes.data,
+            filled.ctypes.data,
+        )
+        keep_alive.append((gray, circles))
+        outputs.append((mean_inside, mean_edge, filled))
+
+    if _lib.hh_circle_stats_batch(structs, len(frames), threshold, threads) != 0:
+        raise ValueError("invalid frame passed to the circle engine")
+
+    return [
+        (mean_inside, mean_edge, filled.astype(bool))
+        for mean_inside, mean_edge, filled in outputs
+    ]
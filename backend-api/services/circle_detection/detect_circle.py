@@ -1,65 +1,247 @@
+import os
+from concurrent.futures import ThreadPoolExecutor
+
 import cv2
 import numpy as np
 
+from services.circle_detection import circle_engine
+from services.circle_detection.ingest import decode_luma, scale_for_dp, stage
+
+# |mean inside - mean edge| below this -> filled
+FILL_THRESHOLD = 20
+
+# Hough transform, distances in full resolution pixels
+HOUGH_DP = 1.2  # resolution ratio
+HOUGH_MIN_DIST = 50  # minimum distance between circles
+HOUGH_CANNY = 85  # Canny edge parameter
+HOUGH_VOTES = 85  # sensitivity: smaller -> more circles
+HOUGH_MIN_RADIUS = 5
+HOUGH_MAX_RADIUS = 500
+
+# Uploads are decoded at 1/INGEST_SCALE (1, 2, 4 or 8); by default the scale
+# that matches HOUGH_DP. INGEST_SCALE=2 or more trades accuracy for speed,
+# check with benchmark_ingest.py on real captures first.
+INGEST_SCALE = int(os.environ.get("INGEST_SCALE", 0)) or scale_for_dp(HOUGH_DP)
 
-def detect_circles(image_path):
+
+def find_circles(img):
     """
-    Detect circles in an image and determine whether each circle is filled or not.
-    Returns a list of results and the annotated image.
+    Grayscale + blur + Hough transform.
+    Returns the blurred gray image and an (N, 3) uint16 array of x, y, radius (or None).
     """
+    return find_circles_gray(cv2.cvtColor(img, cv2.COLOR_BGR2GRAY))
 
-    img = cv2.imread(image_path)
 
-    gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
+def find_circles_gray(gray, scale=1):
+    """
+    find_circles() for a luma image decoded at 1/scale of the full resolution.
+    The Hough parameters are scaled to match; the circles are in gray's coordinates.
+    """
     gray = cv2.medianBlur(gray, 5)
 
-    # Initialize results so function always returns a list
-    results = []
-
     # Detect circles (Hough Transform)
     circles = cv2.HoughCircles(
         gray,
         cv2.HOUGH_GRADIENT,
-        dp=1.2,  # resolution ratio
-        minDist=50,  # minimum distance between circles
-        param1=85,  # Canny edge parameter
-        param2=85,  # sensitivity: smaller -> more circles
-        minRadius=5,
-        maxRadius=500,
+        dp=max(HOUGH_DP / scale, 1.0),
+        minDist=HOUGH_MIN_DIST / scale,
+        param1=HOUGH_CANNY,
+        param2=HOUGH_VOTES / scale,  # votes grow with the circumference
+        minRadius=max(round(HOUGH_MIN_RADIUS / scale), 1),
+        maxRadius=round(HOUGH_MAX_RADIUS / scale),
     )
 
-    if circles is not None:
-        circles = np.uint16(np.around(circles[0, :]))
+    if circles is None:
+        return gray, None
+    return gray, np.uint16(np.around(circles[0, :]))
+
+
+def circle_stats_numpy(gray, circles):
+    """
+    Reference implementation: two full-image masks per circle.
+    Returns the mean gray value inside each circle and on its edge.
+    """
+    mean_inside = []
+    mean_edge = []
+    for x, y, r in circles:
+        # Extract circle region
+        mask = np.zeros_like(gray)
+        cv2.circle(mask, (x, y), r, 255, -1)
+        mean_inside.append(cv2.mean(gray, mask=mask)[0])
+
+        # Ring mask (edge)
+        ring = np.zeros_like(gray)
+        cv2.circle(ring, (x, y), r, 255, 2)
+        mean_edge.append(cv2.mean(gray, mask=ring)[0])
 
-        for x, y, r in circles:
-            # Extract circle region
-            mask = np.zeros_like(gray)
-            cv2.circle(mask, (x, y), r, 255, -1)
-            mean_inside = cv2.mean(gray, mask=mask)[0]
+    return mean_inside, mean_edge
 
-            # Ring mask (edge)
-            ring = np.zeros_like(gray)
-            cv2.circle(ring, (x, y), r, 255, 2)
-            mean_edge = cv2.mean(gray, mask=ring)[0]
 
-            # Decision: filled or not?
-            filled = abs(mean_inside - mean_edge) < 20  # threshold adjustable
-            fill_state = "filled" if filled else "unfilled"
+def classify(frames, native=None):
+    """
+    Filled / unfilled per circle for a list of (gray, circles).
+    Uses the native engine (bounding box only, all cores) when it is built,
+    native=False forces the NumPy reference.
+    """
+    if native is None:
+        native = circle_engine.available()
 
-            results.append(
-                {"x": int(x), "y": int(y), "radius": int(r), "status": fill_state}
-            )
+    if native:
+        stats = circle_engine.circle_stats_batch(frames, FILL_THRESHOLD)
+        return [filled.tolist() for _, _, filled in stats]
 
-            # Visualization
-            color = (0, 255, 0) if filled else (0, 0, 255)
-            cv2.circle(img, (x, y), r, color, 2)
-            cv2.circle(img, (x, y), 2, (255, 0, 0), 3)
+    decisions = []
+    for gray, circles in frames:
+        mean_inside, mean_edge = circle_stats_numpy(gray, circles)
+        decisions.append(
+            [
+                abs(inside - edge) < FILL_THRESHOLD
+                for inside, edge in zip(mean_inside, mean_edge, strict=True)
+            ]
+        )
+    return decisions
 
-        print("Detected circles:")
-        for res in results:
-            print(res)
 
-    else:
+def annotate(img, circles, filled, scale=1):
+    """
+    Draws the circles into img and returns the result list.
+    img was decoded at 1/scale; the results are in full resolution pixels.
+    """
+    results = []
+    if circles is None:
         print("No circles found.")
+        return results
+
+    for (x, y, r), is_filled in zip(circles, filled, strict=True):
+        fill_state = "filled" if is_filled else "unfilled"
 
+        results.append(
+            {
+                "x": int(x) * scale,
+                "y": int(y) * scale,
+                "radius": int(r) * scale,
+                "status": fill_state,
+            }
+        )
+
+        # Visualization
+        color = (0, 255, 0) if is_filled else (0, 0, 255)
+        cv2.circle(img, (x, y), r, color, 2)
+        cv2.circle(img, (x, y), 2, (255, 0, 0), 3)
+
+    print("Detected circles:")
+    for res in results:
+        print(res)
+
+    return results
+
+
+def detect_circles(image_path, native=None):
+    """
+    Detect circles in an image and determine whether each circle is filled or not.
+    Returns a list of results and the annotated image.
+    """
+
+    img = cv2.imread(image_path)
+    gray, circles = find_circles(img)
+
+    filled = []
+    if circles is not None:
+        filled = classify([(gray, circles)], native)[0]
+
+    return annotate(img, circles, filled), img
+
+
+def detect_circles_batch(image_paths, native=None, workers=None):
+    """
+    detect_circles() for several images: decoding and the Hough transform run in a
+    thread pool (OpenCV releases the GIL), the statistics of all circles of all
+    images in one call to the engine.
+    Returns one (results, annotated image) tuple per path, in order.
+    """
+
+    def load(path):
+        img = cv2.imread(path)
+        return (img, *find_circles(img))
+
+    with ThreadPoolExecutor(max_workers=workers) as pool:
+        loaded = list(pool.map(load, image_paths))
+
+    found = [(gray, circles) for _, gray, circles in loaded if circles is not None]
+    decisions = iter(classify(found, native))
+
+    output = []
+    for img, _, circles in loaded:
+        filled = next(decisions) if circles is not None else []
+        output.append((annotate(img, circles, filled), img))
+    return output
+
+
+def detect_circles_bytes(data, native=None, timings=None):
+    """
+    detect_circles() for an uploaded image in memory: decoded once, straight to
+    luma at 1/INGEST_SCALE, without a round trip through the file system.
+    The stage times in ms are added to timings (decode, hough, stats, annotate).
+    Returns a list of results and the annotated image, None if data is no image.
+    """
+    timings = {} if timings is None else timings
+
+    with stage(timings, "decode"):
+        luma = decode_luma(data, INGEST_SCALE)
+    if luma is None:
+        return None
+
+    with stage(timings, "hough"):
+        gray, circles = find_circles_gray(luma, INGEST_SCALE)
+
+    filled = []
+    with stage(timings, "stats"):
+        if circles is not None:
+            filled = classify([(gray, circles)], native)[0]
+
+    with stage(timings, "annotate"):
+        img = cv2.cvtColor(luma, cv2.COLOR_GRAY2BGR)
+        results = annotate(img, circles, filled, INGEST_SCALE)
     return results, img
+
+
+def detect_circles_bytes_batch(blobs, native=None, workers=None, timings=None):
+    """
+    detect_circles_bytes() for several uploads, like detect_circles_batch().
+    timings: optional list with one dict per blob; "stats" is the time of the
+    shared engine call.
+    Returns one (results, annotated image) tuple per blob, None for blobs
+    that are no image.
+    """
+    timings = [{} for _ in blobs] if timings is None else timings
+
+    def load(item):
+        data, stage_times = item
+        with stage(stage_times, "decode"):
+            luma = decode_luma(data, INGEST_SCALE)
+        if luma is None:
+            return None, None, None
+        with stage(stage_times, "hough"):
+            return (luma, *find_circles_gray(luma, INGEST_SCALE))
+
+    with ThreadPoolExecutor(max_workers=workers) as pool:
+        loaded = list(pool.map(load, zip(blobs, timings, strict=True)))
+
+    found = [(gray, circles) for _, gray, circles in loaded if circles is not None]
+    batch_stats = {}
+    with stage(batch_stats, "stats"):
+        decisions = iter(classify(found, native))
+
+    output = []
+    for (luma, _, circles), stage_times in zip(loaded, timings, strict=True):
+        if luma is None:
+            output.append(None)
+            continue
+
+        stage_times.update(batch_stats)
+        filled = next(decisions) if circles is not None else []
+        with stage(stage_times, "annotate"):
+            img = cv2.cvtColor(luma, cv2.COLOR_GRAY2BGR)
+            results = annotate(img, circles, filled, INGEST_SCALE)
+        output.append((results, img))
+    return output
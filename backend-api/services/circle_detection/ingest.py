@@ -0,0 +1,57 @@
+"""
+In-memory ingest of uploaded JPEGs.
+
+The request bytes are decoded once, straight to luma: libjpeg skips the chroma
+upsampling and color conversion, and for a scale of 2, 4 or 8 it scales in the
+DCT domain (IMREAD_REDUCED_GRAYSCALE_*), which is much cheaper than decoding at
+full resolution and resizing afterwards.
+"""
+
+import time
+from contextlib import contextmanager
+
+import cv2
+import numpy as np
+
+# libjpeg DCT scaling: 1/1, 1/2, 1/4, 1/8
+_LUMA_FLAGS = {
+    1: cv2.IMREAD_GRAYSCALE,
+    2: cv2.IMREAD_REDUCED_GRAYSCALE_2,
+    4: cv2.IMREAD_REDUCED_GRAYSCALE_4,
+    8: cv2.IMREAD_REDUCED_GRAYSCALE_8,
+}
+
+SCALES = tuple(_LUMA_FLAGS)
+
+
+def scale_for_dp(dp):
+    """
+    Largest decoder scale that is not coarser than the Hough accumulator (1/dp):
+    decoding finer than that only produces pixels the accumulator bins together.
+    """
+    return max(scale for scale in SCALES if scale <= dp)
+
+
+def decode_luma(data, scale=1):
+    """
+    Decodes encoded image bytes to a 2D uint8 luma array at 1/scale resolution.
+    Returns None if the bytes are no decodable image.
+    """
+    if scale not in _LUMA_FLAGS:
+        raise ValueError(f"unsupported decoder scale {scale}, use one of {SCALES}")
+    if not data:
+        return None
+    return cv2.imdecode(np.frombuffer(data, dtype=np.uint8), _LUMA_FLAGS[scale])
+
+
+@contextmanager
+def stage(timings, name):
+    """
+    Adds the wall time of the block in ms to timings[name].
+    """
+    start = time.perf_counter()
+    try:
+        yield
+    finally:
+        elapsed = (time.perf_counter() - start) * 1000
+        timings[name] = round(timings.get(name, 0.0) + elapsed, 2)
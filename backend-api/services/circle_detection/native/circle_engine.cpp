@@ -0,0 +1,489 @@
+/*
+  Native circle statistics for detect_circle.py
+
+  For every circle found by HoughCircles the backend needs the mean gray value
+  inside the circle and on its 2 px outline. The Python version draws both as
+  full-image masks (cv2.circle into np.zeros_like(gray)) and averages with
+  cv2.mean, which costs two image-sized buffers per circle.
+
+  This engine rasterizes the same pixels as cv2.circle, but into a buffer that
+  only covers the circle's bounding box, and sums the gray values from there:
+
+    inside  cv2.circle(mask, c, r, 255, -1)  -> Circle()       (filled, LINE_8)
+    outline cv2.circle(mask, c, r, 255, 2)   -> EllipseEx()    (polygon of thick lines)
+
+  The drawing code below follows OpenCV's drawing.cpp step by step (fixed point
+  with XY_SHIFT, same rounding, same clipping), so the means are bit-identical to
+  cv2.mean on the full masks and the filled / unfilled decisions do not change.
+
+  Plain C ABI for ctypes (circle_engine.py), no dependencies besides the
+  standard library:
+
+    g++ -O3 -std=c++17 -shared -fPIC -pthread circle_engine.cpp -o libcircle_engine.so
+*/
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+extern "C" {
+
+/* one grayscale frame and the circles found in it */
+typedef struct {
+  const uint8_t *gray;      /* width x height, rows stride bytes apart */
+  int32_t width;
+  int32_t height;
+  int32_t stride;
+  const int32_t *circles;   /* x, y, radius per circle */
+  int32_t count;
+  double *mean_inside;      /* out: count values */
+  double *mean_edge;        /* out: count values */
+  uint8_t *filled;          /* out: count values, |inside - edge| < threshold */
+} hh_frame_t;
+
+int hh_circle_stats(hh_frame_t *frame, double threshold);
+int hh_circle_stats_batch(hh_frame_t *frames, int32_t frame_count, double threshold, int32_t threads);
+
+}
+
+namespace {
+
+const int XY_SHIFT = 16;
+const int64_t XY_ONE = (int64_t)1 << XY_SHIFT;
+
+struct Point2l {
+  int64_t x, y;
+};
+
+/* OpenCV rounds with the FPU's round-to-nearest-even */
+inline int cvRound(double value) {
+  return (int)std::lrint(value);
+}
+
+/* OpenCV's SinTable: sin of 0..450 degrees, rounded to 7 decimals, as float */
+struct SinTable {
+  float values[451];
+  SinTable() {
+    for (int i = 0; i <= 450; i++) {
+      values[i] = (float)(std::floor(std::sin(i * M_PI / 180.0) * 1e7 + 0.5) / 1e7);
+    }
+  }
+};
+const SinTable SIN_TABLE;
+
+/*
+  Pixels of one mask, limited to a window around the circle.
+  Clipping decisions use the full image size, exactly like drawing into the full mask.
+*/
+class Mask {
+public:
+  Mask(int img_w, int img_h, int cx, int cy, int reach) : img_w(img_w), img_h(img_h) {
+    x0 = std::max(cx - reach, 0);
+    y0 = std::max(cy - reach, 0);
+    x1 = std::min(cx + reach, img_w - 1);
+    y1 = std::min(cy + reach, img_h - 1);
+    w = x1 >= x0 ? x1 - x0 + 1 : 0;
+    h = y1 >= y0 ? y1 - y0 + 1 : 0;
+    data.assign((size_t)w * h, 0);
+  }
+
+  int img_w, img_h;
+  int x0, y0, x1, y1, w, h;
+  std::vector<uint8_t> data;
+
+  void put(int x, int y) {
+    if (x < x0 || x > x1 || y < y0 || y > y1) return;
+    data[(size_t)(y - y0) * w + (x - x0)] = 1;
+  }
+
+  void hline(int y, int xa, int xb) {
+    if (y < y0 || y > y1) return;
+    xa = std::max(xa, x0);
+    xb = std::min(xb, x1);
+    if (xa <= xb) memset(&data[(size_t)(y - y0) * w + (xa - x0)], 1, xb - xa + 1);
+  }
+
+  /* sum * (1 / n), the way cv::mean computes it */
+  double mean(const uint8_t *gray, int stride) const {
+    uint64_t sum = 0;
+    uint64_t n = 0;
+    for (int y = 0; y < h; y++) {
+      const uint8_t *m = &data[(size_t)y * w];
+      const uint8_t *g = gray + (size_t)(y + y0) * stride + x0;
+      for (int x = 0; x < w; x++) {
+        sum += m[x] ? g[x] : 0;
+        n += m[x];
+      }
+    }
+    return (double)sum * (n ? 1. / n : 0);
+  }
+};
+
+/* drawing.cpp: Circle() with fill = 1 */
+void fillCircle(Mask &mask, int cx, int cy, int radius) {
+  int err = 0, dx = radius, dy = 0, plus = 1, minus = (radius << 1) - 1;
+
+  while (dx >= dy) {
+    int y11 = cy - dy, y12 = cy + dy, y21 = cy - dx, y22 = cy + dx;
+    int x11 = cx - dx, x12 = cx + dx, x21 = cx - dy, x22 = cx + dy;
+
+    /* the clipped branch of Circle() draws exactly the in-image part of these spans */
+    mask.hline(y11, x11, x12);
+    mask.hline(y12, x11, x12);
+    mask.hline(y21, x21, x22);
+    mask.hline(y22, x21, x22);
+
+    dy++;
+    err += plus;
+    plus += 2;
+
+    int m = (err <= 0) - 1;
+    err -= minus & m;
+    dx += m;
+    minus -= m & 2;
+  }
+}
+
+/* drawing.cpp: clipLine() for Size2l */
+bool clipLine(int64_t width, int64_t height, Point2l &pt1, Point2l &pt2) {
+  int64_t right = width - 1, bottom = height - 1;
+  if (width <= 0 || height <= 0) return false;
+
+  int64_t &x1 = pt1.x, &y1 = pt1.y, &x2 = pt2.x, &y2 = pt2.y;
+  int c1 = (x1 < 0) + (x1 > right) * 2 + (y1 < 0) * 4 + (y1 > bottom) * 8;
+  int c2 = (x2 < 0) + (x2 > right) * 2 + (y2 < 0) * 4 + (y2 > bottom) * 8;
+
+  if ((c1 & c2) == 0 && (c1 | c2) != 0) {
+    int64_t a;
+    if (c1 & 12) {
+      a = c1 < 8 ? 0 : bottom;
+      x1 += (int64_t)((double)(a - y1) * (x2 - x1) / (y2 - y1));
+      y1 = a;
+      c1 = (x1 < 0) + (x1 > right) * 2;
+    }
+    if (c2 & 12) {
+      a = c2 < 8 ? 0 : bottom;
+      x2 += (int64_t)((double)(a - y2) * (x2 - x1) / (y2 - y1));
+      y2 = a;
+      c2 = (x2 < 0) + (x2 > right) * 2;
+    }
+    if ((c1 & c2) == 0 && (c1 | c2) != 0) {
+      if (c1) {
+        a = c1 == 1 ? 0 : right;
+        y1 += (int64_t)((double)(a - x1) * (y2 - y1) / (x2 - x1));
+        x1 = a;
+        c1 = 0;
+      }
+      if (c2) {
+        a = c2 == 1 ? 0 : right;
+        y2 += (int64_t)((double)(a - x2) * (y2 - y1) / (x2 - x1));
+        x2 = a;
+        c2 = 0;
+      }
+    }
+  }
+  return (c1 | c2) == 0;
+}
+
+/* drawing.cpp: Line2(), 8-connected line between fixed point coordinates */
+void line2(Mask &mask, Point2l pt1, Point2l pt2) {
+  if (!clipLine((int64_t)mask.img_w << XY_SHIFT, (int64_t)mask.img_h << XY_SHIFT, pt1, pt2)) return;
+
+  int64_t dx = pt2.x - pt1.x;
+  int64_t dy = pt2.y - pt1.y;
+  int64_t j = dx < 0 ? -1 : 0;
+  int64_t ax = (dx ^ j) - j;
+  int64_t i = dy < 0 ? -1 : 0;
+  int64_t ay = (dy ^ i) - i;
+  int64_t x_step, y_step;
+  int ecount;
+
+  if (ax > ay) {
+    dy = (dy ^ j) - j;
+    pt1.x ^= pt2.x & j;
+    pt2.x ^= pt1.x & j;
+    pt1.x ^= pt2.x & j;
+    pt1.y ^= pt2.y & j;
+    pt2.y ^= pt1.y & j;
+    pt1.y ^= pt2.y & j;
+
+    x_step = XY_ONE;
+    y_step = (dy * XY_ONE) / (ax | 1);
+    ecount = (int)((pt2.x - pt1.x) >> XY_SHIFT);
+  } else {
+    dx = (dx ^ i) - i;
+    pt1.x ^= pt2.x & i;
+    pt2.x ^= pt1.x & i;
+    pt1.x ^= pt2.x & i;
+    pt1.y ^= pt2.y & i;
+    pt2.y ^= pt1.y & i;
+    pt1.y ^= pt2.y & i;
+
+    x_step = (dx * XY_ONE) / (ay | 1);
+    y_step = XY_ONE;
+    ecount = (int)((pt2.y - pt1.y) >> XY_SHIFT);
+  }
+
+  pt1.x += XY_ONE >> 1;
+  pt1.y += XY_ONE >> 1;
+
+  mask.put((int)((pt2.x + (XY_ONE >> 1)) >> XY_SHIFT), (int)((pt2.y + (XY_ONE >> 1)) >> XY_SHIFT));
+
+  if (ax > ay) {
+    pt1.x >>= XY_SHIFT;
+    while (ecount >= 0) {
+      mask.put((int)pt1.x, (int)(pt1.y >> XY_SHIFT));
+      pt1.x++;
+      pt1.y += y_step;
+      ecount--;
+    }
+  } else {
+    pt1.y >>= XY_SHIFT;
+    while (ecount >= 0) {
+      mask.put((int)(pt1.x >> XY_SHIFT), (int)pt1.y);
+      pt1.x += x_step;
+      pt1.y++;
+      ecount--;
+    }
+  }
+}
+
+/* drawing.cpp: FillConvexPoly() for LINE_8 and shift = XY_SHIFT */
+void fillConvexPoly(Mask &mask, const Point2l *v, int npts) {
+  struct {
+    int idx, di;
+    int64_t x, dx;
+    int ye;
+  } edge[2];
+
+  const int shift = XY_SHIFT;
+  const int64_t delta = (int64_t)1 << shift >> 1;
+  const int64_t delta1 = XY_ONE >> 1, delta2 = XY_ONE >> 1;
+  int i, y, imin = 0;
+  int edges = npts;
+  int64_t xmin, xmax, ymin, ymax;
+
+  Point2l p0 = v[npts - 1];
+  xmin = xmax = v[0].x;
+  ymin = ymax = v[0].y;
+
+  for (i = 0; i < npts; i++) {
+    Point2l p = v[i];
+    if (p.y < ymin) {
+      ymin = p.y;
+      imin = i;
+    }
+    ymax = std::max(ymax, p.y);
+    xmax = std::max(xmax, p.x);
+    xmin = std::min(xmin, p.x);
+
+    line2(mask, p0, p);
+    p0 = p;
+  }
+
+  xmin = (xmin + delta) >> shift;
+  xmax = (xmax + delta) >> shift;
+  ymin = (ymin + delta) >> shift;
+  ymax = (ymax + delta) >> shift;
+
+  if (npts < 3 || (int)xmax < 0 || (int)ymax < 0 || (int)xmin >= mask.img_w || (int)ymin >= mask.img_h) return;
+
+  ymax = std::min<int64_t>(ymax, mask.img_h - 1);
+  edge[0].idx = edge[1].idx = imin;
+  edge[0].ye = edge[1].ye = y = (int)ymin;
+  edge[0].di = 1;
+  edge[1].di = npts - 1;
+  edge[0].x = edge[1].x = -XY_ONE;
+  edge[0].dx = edge[1].dx = 0;
+
+  do {
+    for (i = 0; i < 2; i++) {
+      if (y >= edge[i].ye) {
+        int idx0 = edge[i].idx, di = edge[i].di;
+        int idx = idx0 + di;
+        if (idx >= npts) idx -= npts;
+        int ty = 0;
+
+        for (; edges-- > 0;) {
+          ty = (int)((v[idx].y + delta) >> shift);
+          if (ty > y) {
+            int64_t xs = v[idx0].x;
+            int64_t xe = v[idx].x;
+            edge[i].ye = ty;
+            edge[i].dx = ((xe - xs) * 2 + ((int64_t)ty - y)) / (2 * ((int64_t)ty - y));
+            edge[i].x = xs;
+            edge[i].idx = idx;
+            break;
+          }
+          idx0 = idx;
+          idx += di;
+          if (idx >= npts) idx -= npts;
+        }
+      }
+    }
+
+    if (edges < 0) break;
+
+    if (y >= 0) {
+      int left = 0, right = 1;
+      if (edge[0].x > edge[1].x) {
+        left = 1;
+        right = 0;
+      }
+      int xx1 = (int)((edge[left].x + delta1) >> XY_SHIFT);
+      int xx2 = (int)((edge[right].x + delta2) >> XY_SHIFT);
+      if (xx2 >= 0 && xx1 < mask.img_w) {
+        mask.hline(y, std::max(xx1, 0), std::min(xx2, mask.img_w - 1));
+      }
+    }
+
+    edge[0].x += edge[0].dx;
+    edge[1].x += edge[1].dx;
+  } while (++y <= (int)ymax);
+}
+
+/* drawing.cpp: ThickLine() for LINE_8, thickness > 1, shift = XY_SHIFT */
+void thickLine(Mask &mask, Point2l p0, Point2l p1, int thickness, int flags) {
+  const double INV_XY_ONE = 1. / XY_ONE;
+  double dx = (p0.x - p1.x) * INV_XY_ONE, dy = (p1.y - p0.y) * INV_XY_ONE;
+  double r = dx * dx + dy * dy;
+  int odd_thickness = thickness & 1;
+  thickness <<= XY_SHIFT - 1;
+
+  if (std::fabs(r) > DBL_EPSILON) {
+    r = (thickness + odd_thickness * XY_ONE * 0.5) / std::sqrt(r);
+    Point2l dp = { cvRound(dy * r), cvRound(dx * r) };
+    Point2l pt[4] = {
+      { p0.x + dp.x, p0.y + dp.y },
+      { p0.x - dp.x, p0.y - dp.y },
+      { p1.x - dp.x, p1.y - dp.y },
+      { p1.x + dp.x, p1.y + dp.y },
+    };
+    fillConvexPoly(mask, pt, 4);
+  }
+
+  for (int i = 0; i < 2; i++) {
+    if (flags & (i + 1)) {
+      int cx = (int)((p0.x + (XY_ONE >> 1)) >> XY_SHIFT);
+      int cy = (int)((p0.y + (XY_ONE >> 1)) >> XY_SHIFT);
+      fillCircle(mask, cx, cy, (int)((thickness + (XY_ONE >> 1)) >> XY_SHIFT));
+    }
+    p0 = p1;
+  }
+}
+
+/* drawing.cpp: cv::circle() with thickness > 1 -> EllipseEx() -> ellipse2Poly() + PolyLine() */
+void drawCircleOutline(Mask &mask, int cx, int cy, int radius, int thickness) {
+  Point2l center = { (int64_t)cx << XY_SHIFT, (int64_t)cy << XY_SHIFT };
+  int64_t axis = (int64_t)radius << XY_SHIFT;
+
+  int delta = (int)((axis + (XY_ONE >> 1)) >> XY_SHIFT);
+  delta = delta < 3 ? 90 : delta < 10 ? 30 : delta < 15 ? 18 : 5;
+
+  /* angle 0: cos = SinTable[450] = 1, sin = SinTable[0] = 0 */
+  const float alpha = SIN_TABLE.values[450], beta = SIN_TABLE.values[0];
+  std::vector<Point2l> v;
+  Point2l prev = { INT64_MIN, INT64_MIN };
+  for (int i = 0; i < 360 + delta; i += delta) {
+    int angle = std::min(i, 360);
+    double x = (double)axis * SIN_TABLE.values[450 - angle];
+    double y = (double)axis * SIN_TABLE.values[angle];
+    double px = (double)center.x + x * alpha - y * beta;
+    double py = (double)center.y + x * beta + y * alpha;
+
+    Point2l pt;
+    pt.x = (int64_t)cvRound(px / XY_ONE) << XY_SHIFT;
+    pt.y = (int64_t)cvRound(py / XY_ONE) << XY_SHIFT;
+    pt.x += cvRound(px - pt.x);
+    pt.y += cvRound(py - pt.y);
+    if (pt.x != prev.x || pt.y != prev.y) {
+      v.push_back(pt);
+      prev = pt;
+    }
+  }
+  if (v.size() == 1) {
+    v.assign(2, center);
+  }
+
+  /* open polyline: round caps on both ends of the first segment, end caps afterwards */
+  int flags = 3;
+  for (size_t i = 1; i < v.size(); i++) {
+    thickLine(mask, v[i - 1], v[i], thickness, flags);
+    flags = 2;
+  }
+}
+
+const int EDGE_THICKNESS = 2;
+
+void circleStats(const hh_frame_t *frame, int index, double threshold) {
+  int cx = frame->circles[index * 3];
+  int cy = frame->circles[index * 3 + 1];
+  int r = frame->circles[index * 3 + 2];
+
+  Mask inside(frame->width, frame->height, cx, cy, r);
+  fillCircle(inside, cx, cy, r);
+
+  /* polygon vertices lie on the circle, the line adds thickness / 2 plus its round caps */
+  Mask edge(frame->width, frame->height, cx, cy, r + EDGE_THICKNESS + 2);
+  drawCircleOutline(edge, cx, cy, r, EDGE_THICKNESS);
+
+  double mean_inside = inside.mean(frame->gray, frame->stride);
+  double mean_edge = edge.mean(frame->gray, frame->stride);
+  frame->mean_inside[index] = mean_inside;
+  frame->mean_edge[index] = mean_edge;
+  frame->filled[index] = std::fabs(mean_inside - mean_edge) < threshold;
+}
+
+bool validFrame(const hh_frame_t *frame) {
+  return frame->count == 0 ||
+         (frame->gray && frame->circles && frame->mean_inside && frame->mean_edge && frame->filled &&
+          frame->width > 0 && frame->height > 0 && frame->stride >= frame->width);
+}
+
+}  // namespace
+
+extern "C" {
+
+/* returns 0 on success, -1 on invalid arguments */
+int hh_circle_stats(hh_frame_t *frame, double threshold) {
+  return hh_circle_stats_batch(frame, 1, threshold, 1);
+}
+
+/*
+  Processes all circles of all frames. The work is split per circle, so one frame
+  with many circles spreads over the threads as well. threads <= 0 uses all cores.
+*/
+int hh_circle_stats_batch(hh_frame_t *frames, int32_t frame_count, double threshold, int32_t threads) {
+  if (frame_count < 0 || (frame_count > 0 && !frames)) return -1;
+
+  std::vector<std::pair<int, int>> work;
+  for (int f = 0; f < frame_count; f++) {
+    if (!validFrame(&frames[f])) return -1;
+    for (int c = 0; c < frames[f].count; c++) work.emplace_back(f, c);
+  }
+
+  if (threads <= 0) threads = (int32_t)std::max(1u, std::thread::hardware_concurrency());
+  threads = (int32_t)std::min<size_t>(threads, work.size());
+
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i; (i = next.fetch_add(1)) < work.size();) {
+      circleStats(&frames[work[i].first], work[i].second, threshold);
+    }
+  };
+
+  if (threads <= 1) {
+    worker();
+    return 0;
+  }
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+  for (std::thread &thread : pool) thread.join();
+  return 0;
+}
+
+}
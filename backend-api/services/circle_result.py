@@ -0,0 +1,62 @@
+"""
+Binary detection result, the compact alternative to the JSON response for the
+firmware (layout in ESP32-CAM/circle_result.h):
+
+    uint8 version, uint8 flags (0), uint16 count,
+    count x (uint16 x, uint16 y, uint16 radius | 0x8000 if filled)
+
+all little-endian. Clients ask for it with the Accept header; without one they
+get JSON.
+"""
+
+import struct
+
+CIRCLES_MIME = "application/vnd.hivehive.circles"
+VERSION = 1
+
+_HEADER = struct.Struct("<BBH")
+_RECORD = struct.Struct("<HHH")
+_FILLED = 0x8000
+_MAX = 0xFFFF
+
+
+def _field(value, limit):
+    return min(max(int(value), 0), limit)
+
+
+def encode_circles(circles):
+    circles = circles[:_MAX]
+    out = bytearray(_HEADER.pack(VERSION, 0, len(circles)))
+    for circle in circles:
+        radius = _field(circle["radius"], _FILLED - 1)
+        if circle["status"] == "filled":
+            radius |= _FILLED
+        out += _RECORD.pack(
+            _field(circle["x"], _MAX), _field(circle["y"], _MAX), radius
+        )
+    return bytes(out)
+
+
+def decode_circles(data):
+    if len(data) < _HEADER.size:
+        raise ValueError("not a binary detection result")
+    version, _, count = _HEADER.unpack_from(data)
+    if version != VERSION or len(data) != _HEADER.size + count * _RECORD.size:
+        raise ValueError("not a binary detection result")
+    return [
+        {
+            "x": x,
+            "y": y,
+            "radius": radius & ~_FILLED,
+            "status": "filled" if radius & _FILLED else "unfilled",
+        }
+        for x, y, radius in _RECORD.iter_unpack(data[_HEADER.size :])
+    ]
+
+
+def wants_binary(accept):
+    """
+    accept: request.accept_mimetypes. JSON wins ties, so a missing Accept
+    header or */* keeps JSON.
+    """
+    return accept.best_match(["application/json", CIRCLES_MIME]) == CIRCLES_MIME
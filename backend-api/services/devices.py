@@ -0,0 +1,111 @@
+"""
+Per-camera state: the latest detection result and preview frame of every device.
+
+Each device has its own slot. A slot's fields are replaced as a whole (never
+mutated in place), which is atomic in CPython, so uploads of different cameras
+never wait for each other and readers (result route, preview streams) take no
+lock to read. Locks are only taken to create the slot of a new device and to
+wake the preview streams waiting for a new frame (routes/preview.py).
+"""
+
+import re
+import threading
+import time
+
+# header the firmware sends with every upload (see ESP32-CAM/http_request.h)
+DEVICE_HEADER = "X-Device-ID"
+
+# uploads without the header (older firmware, curl)
+DEFAULT_DEVICE = "default"
+
+# bounds the memory a client can make us spend on made-up IDs
+MAX_DEVICES = 1024
+
+_DEVICE_ID = re.compile(r"^[A-Za-z0-9_.-]{1,64}$")
+
+
+def valid_device_id(device):
+    # IDs end up in file paths and S3 keys; no ".", ".." or hidden folders (.spill)
+    return bool(_DEVICE_ID.match(device)) and not device.startswith(".")
+
+
+class DeviceSlot:
+    __slots__ = (
+        "device",
+        "circles",
+        "updated",
+        "frame",
+        "frame_cond",
+        "jpeg",
+        "encode_lock",
+    )
+
+    def __init__(self, device):
+        self.device = device
+        self.circles = []
+        self.updated = None
+        # (version, BGR image) of the preview, notified on frame_cond
+        self.frame = None
+        self.frame_cond = threading.Condition()
+        # (version, JPEG bytes), encoded once per version under encode_lock
+        self.jpeg = None
+        self.encode_lock = threading.Lock()
+
+    def frame_version(self):
+        frame = self.frame
+        return frame[0] if frame is not None else 0
+
+
+class DeviceRegistry:
+    def __init__(self, max_devices=MAX_DEVICES):
+        self._slots = {}
+        self._create_lock = threading.Lock()
+        self._max_devices = max_devices
+        # device of the most recent upload, for the routes without a device
+        self.latest = None
+        # counts the preview frames of all devices, notified on frame_cond
+        self.frame_version = 0
+        self.frame_cond = threading.Condition()
+
+    def slot(self, device, create=True):
+        """
+        The slot of device; None if it is unknown and create is False, or if
+        the registry is full.
+        """
+        slot = self._slots.get(device)
+        if slot is not None or not create:
+            return slot
+
+        with self._create_lock:
+            slot = self._slots.get(device)
+            if slot is None and len(self._slots) < self._max_devices:
+                slot = DeviceSlot(device)
+                self._slots[device] = slot
+        return slot
+
+    def publish(self, slot, circles):
+        slot.circles = [circles]
+        slot.updated = time.time()
+        self.latest = slot.device
+
+    def push_frame(self, slot, img_bgr):
+        """
+        New preview frame for slot. Wakes the streams of this device and the
+        ones following the latest upload.
+        """
+        with slot.frame_cond:
+            slot.frame = (slot.frame_version() + 1, img_bgr)
+            slot.frame_cond.notify_all()
+        with self.frame_cond:
+            self.latest = slot.device
+            self.frame_version += 1
+            self.frame_cond.notify_all()
+
+    def latest_slot(self):
+        return self._slots.get(self.latest) if self.latest else None
+
+    def devices(self):
+        return sorted(self._slots)
+
+
+registry = DeviceRegistry()
@@ -0,0 +1,108 @@
+"""
+Reads the multipart body of /upload as a stream.
+
+The body is read from request.stream in READ_SIZE pieces and fed to werkzeug's
+sans-IO multipart decoder as it arrives, so an upload with Transfer-Encoding:
+chunked (ESP32-CAM/http_request.h) is parsed while the camera is still sending.
+Parts are collected in memory, never spooled to a temporary file; the request
+size is bounded by MAX_CONTENT_LENGTH (werkzeug enforces it on chunked bodies
+as well).
+
+A part cut out of a larger frame (grayscale capture with a region of interest,
+ESP32-CAM/roi.h) carries an X-ROI-Offset: x,y part header; it is kept with the
+part so the circles found in it can be moved back into frame coordinates.
+"""
+
+import time
+from collections import namedtuple
+
+from werkzeug.sansio.multipart import (
+    NEED_DATA,
+    Data,
+    Epilogue,
+    File,
+    MultipartDecoder,
+)
+
+READ_SIZE = 64 * 1024
+
+# parts of any name; only "image" parts are kept
+MAX_PARTS = 64
+
+# offset: (x, y) of the part in the captured frame, (0, 0) if it is the whole frame
+UploadPart = namedtuple("UploadPart", "filename data offset")
+
+ROI_HEADER = "X-ROI-Offset"
+
+
+class UploadError(ValueError):
+    pass
+
+
+def parse_offset(value):
+    """
+    (x, y) of an X-ROI-Offset header value "x,y"; (0, 0) without one.
+    Raises UploadError if it is not two non-negative integers.
+    """
+    if value is None:
+        return (0, 0)
+    try:
+        x, y = (int(field) for field in value.split(","))
+    except ValueError:
+        raise UploadError(f"Invalid {ROI_HEADER}: {value!r}") from None
+    if x < 0 or y < 0:
+        raise UploadError(f"Invalid {ROI_HEADER}: {value!r}")
+    return (x, y)
+
+
+def read_parts(request, name="image", timings=None):
+    """
+    Returns the file parts called name as UploadParts, in request order.
+    timings (dict) gets "receive": ms from the start of the handler until the
+    body was complete. Raises UploadError for bodies that are not multipart.
+    """
+    boundary = request.mimetype_params.get("boundary")
+    if request.mimetype != "multipart/form-data" or not boundary:
+        raise UploadError("Expected a multipart/form-data body")
+
+    started = time.perf_counter()
+    decoder = MultipartDecoder(boundary.encode(), max_parts=MAX_PARTS)
+    parts = []
+    current = None  # (filename, offset, [data pieces]) of an "image" part being read
+    done = False
+
+    try:
+        while not done:
+            chunk = request.stream.read(READ_SIZE)
+            decoder.receive_data(chunk or None)
+
+            event = decoder.next_event()
+            while event is not NEED_DATA:
+                if isinstance(event, File):
+                    current = None
+                    if event.name == name:
+                        offset = parse_offset(event.headers.get(ROI_HEADER))
+                        current = (event.filename, offset, [])
+                elif isinstance(event, Data):
+                    if current is not None:
+                        current[2].append(event.data)
+                        if not event.more_data:
+                            filename, offset, pieces = current
+                            parts.append(UploadPart(filename, b"".join(pieces), offset))
+                            current = None
+                elif isinstance(event, Epilogue):
+                    done = True
+                    break
+                event = decoder.next_event()
+
+            if not chunk:
+                break
+    except ValueError as error:
+        raise UploadError(f"Invalid multipart body: {error}") from error
+
+    if not done:
+        raise UploadError("Incomplete multipart body")
+
+    if timings is not None:
+        timings["receive"] = round((time.perf_counter() - started) * 1000, 2)
+    return parts
@@ -0,0 +1,319 @@
+"""
+Upload stage between the detection and the object store (S3, or a local folder).
+
+Uploads wait in a bounded queue for a small pool of worker threads. When the
+queue is full, the policy decides:
+
+    drop_oldest   the oldest waiting upload is dropped (default, keeps the newest frames)
+    drop_newest   the new upload is dropped
+    spill         the new upload is written to spill_dir; the workers send spilled
+                  files whenever the queue is empty, also after a restart
+
+Keys are "<device>/<capture time>_<sequence>.jpg", both taken from the file name
+the camera gave the frame (createFileName() in ESP32-CAM/client.cpp). A frame the
+camera sends again after a lost answer lands on the same key instead of a second
+copy. Names without them (test clients) get the UTC time with microseconds and a
+counter of this process, so frames of the same second (or of several cameras)
+never overwrite each other.
+"""
+
+import collections
+import io
+import itertools
+import os
+import queue
+import re
+import threading
+import time
+from datetime import UTC, datetime
+
+from PIL import Image
+
+POLICIES = ("drop_oldest", "drop_newest", "spill")
+
+# bytes/s is measured over this window
+RATE_WINDOW_S = 10.0
+
+
+# esp_capture_<YYYYMMDD>_<HHMMSS>_<sequence>.jpg, or with unknown_<ms since boot>
+# while the camera's clock is not set yet
+CAPTURE_NAME = re.compile(
+    r"esp_capture_"
+    r"(?:(\d{4})(\d{2})(\d{2})_(\d{2})(\d{2})(\d{2})|unknown_(\d+))"
+    r"_(\d+)\.jpg"
+)
+
+
+def object_key(device, sequence, now=None):
+    now = now or datetime.now(UTC)
+    return f"{device}/{now:%Y-%m-%d_%H-%M-%S-%f}_{sequence:06d}.jpg"
+
+
+def capture_key(device, filename):
+    """
+    Key from the capture time and sequence number in the camera's file name,
+    None if the name carries none.
+    """
+    match = CAPTURE_NAME.fullmatch(os.path.basename(filename or ""))
+    if match is None:
+        return None
+    *clock, uptime_ms, sequence = match.groups()
+    if uptime_ms is not None:
+        return f"{device}/unknown_{int(uptime_ms)}ms_{int(sequence):06d}.jpg"
+    year, month, day, hour, minute, second = clock
+    captured = f"{year}-{month}-{day}_{hour}-{minute}-{second}"
+    return f"{device}/{captured}_{int(sequence):06d}.jpg"
+
+
+def to_jpeg(data):
+    """
+    Uploads are stored as JPEG; anything else (PNG from a test client) is converted.
+    """
+    if data[:2] == b"\xff\xd8":
+        return data
+    with Image.open(io.BytesIO(data)) as img:
+        buf = io.BytesIO()
+        img.convert("RGB").save(buf, "JPEG")
+        return buf.getvalue()
+
+
+class FolderStore:
+    """
+    Keeps the uploads in a local folder, one subfolder per device
+    (used when no S3 bucket is configured).
+    """
+
+    def __init__(self, root):
+        self.root = root
+
+    def put(self, key, data):
+        path = os.path.join(self.root, *key.split("/"))
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, "wb") as file:
+            file.write(data)
+
+
+class S3Store:
+    def __init__(self, client, bucket):
+        self.client = client
+        self.bucket = bucket
+
+    def put(self, key, data):
+        self.client.put(self.bucket, key, data)
+
+
+class Uploader:
+    def __init__(
+        self,
+        store,
+        max_queue=64,
+        policy="drop_oldest",
+        workers=4,
+        spill_dir=None,
+        spill_max_bytes=512 * 1024 * 1024,
+    ):
+        if policy not in POLICIES:
+            raise ValueError(f"unknown upload policy {policy}, use one of {POLICIES}")
+        if policy == "spill" and not spill_dir:
+            raise ValueError("the spill policy needs a spill_dir")
+
+        self.store = store
+        self.policy = policy
+        self.max_queue = max_queue
+        self.spill_dir = spill_dir
+        self.spill_max_bytes = spill_max_bytes
+
+        self._queue = queue.Queue(maxsize=max_queue)
+        self._lock = threading.Lock()
+        self._sequence = itertools.count()
+        self._stop = threading.Event()
+        self._recent = collections.deque()  # (time, bytes) of the last RATE_WINDOW_S
+        self._counters = dict.fromkeys(
+            (
+                "enqueued",
+                "uploaded",
+                "failed",
+                "dropped",
+                "spilled",
+                "bytes_uploaded",
+                "in_flight",
+            ),
+            0,
+        )
+        self._last_error = None
+        self._spill_bytes = 0
+
+        if spill_dir:
+            os.makedirs(spill_dir, exist_ok=True)
+            self._spill_bytes = sum(
+                os.path.getsize(os.path.join(spill_dir, name))
+                for name in os.listdir(spill_dir)
+            )
+
+        self._workers = [
+            threading.Thread(target=self._run, name=f"uploader-{i}", daemon=True)
+            for i in range(max(workers, 1))
+        ]
+        for worker in self._workers:
+            worker.start()
+
+    # ---------- producer side ----------
+
+    def submit(self, device, data, filename=None):
+        """
+        Queues one upload under the key of its file name (capture_key()), or
+        the next key of this process. Returns the key, None if it was dropped.
+        Never blocks the request for longer than a spill write.
+        """
+        key = capture_key(device, filename) or object_key(
+            device, next(self._sequence)
+        )
+        item = (key, data)
+
+        with self._lock:
+            try:
+                self._queue.put_nowait(item)
+                self._counters["enqueued"] += 1
+                return key
+            except queue.Full:
+                pass
+
+            if self.policy == "drop_newest":
+                self._counters["dropped"] += 1
+                return None
+
+            if self.policy == "drop_oldest":
+                try:
+                    self._queue.get_nowait()
+                    self._queue.task_done()
+                    self._counters["dropped"] += 1
+                except queue.Empty:
+                    pass
+                # producers hold the lock, so the slot just freed is still free
+                self._queue.put_nowait(item)
+                self._counters["enqueued"] += 1
+                return key
+
+        return key if self._spill(key, data) else None
+
+    def saturated(self):
+        """True while the queue is full: a hint for the cameras to slow down."""
+        return self._queue.full()
+
+    # ---------- spill files ----------
+
+    def _spill_path(self, key):
+        # device IDs cannot contain "+", so the key can be restored from the name
+        return os.path.join(self.spill_dir, key.replace("/", "+"))
+
+    def _spill(self, key, data):
+        with self._lock:
+            if self._spill_bytes + len(data) > self.spill_max_bytes:
+                self._counters["dropped"] += 1
+                return False
+            self._spill_bytes += len(data)
+
+        try:
+            with open(self._spill_path(key), "wb") as file:
+                file.write(data)
+        except OSError as error:
+            with self._lock:
+                self._spill_bytes -= len(data)
+                self._counters["dropped"] += 1
+                self._last_error = f"spill: {error}"
+            return False
+
+        with self._lock:
+            self._counters["spilled"] += 1
+        return True
+
+    def _take_spilled(self):
+        """Oldest spilled upload as (key, data), removed from the spill folder."""
+        if not self.spill_dir:
+            return None
+
+        with self._lock:
+            try:
+                names = os.listdir(self.spill_dir)
+            except OSError:
+                return None
+            paths = [os.path.join(self.spill_dir, name) for name in names]
+            paths = [path for path in paths if os.path.isfile(path)]
+            if not paths:
+                return None
+            path = min(paths, key=os.path.getmtime)
+            with open(path, "rb") as file:
+                data = file.read()
+            os.remove(path)
+            self._spill_bytes -= len(data)
+
+        return os.path.basename(path).replace("+", "/"), data
+
+    # ---------- workers ----------
+
+    def _run(self):
+        while True:
+            try:
+                item = self._queue.get(timeout=0.5)
+            except queue.Empty:
+                if self._stop.is_set():
+                    return
+                item = self._take_spilled()
+                if item is not None:
+                    self._upload(*item)
+                continue
+
+            try:
+                self._upload(*item)
+            finally:
+                self._queue.task_done()
+
+    def _upload(self, key, data):
+        with self._lock:
+            self._counters["in_flight"] += 1
+        try:
+            data = to_jpeg(data)
+            self.store.put(key, data)
+        except Exception as error:  # noqa: BLE001 - any store error counts as a failure
+            with self._lock:
+                self._counters["failed"] += 1
+                self._last_error = f"{key}: {error}"
+            print(f"[S3] Upload of {key} failed: {error}")
+            # keep it for later if there is somewhere to keep it
+            if self.policy == "spill":
+                self._spill(key, data)
+            return
+        finally:
+            with self._lock:
+                self._counters["in_flight"] -= 1
+
+        now = time.monotonic()
+        with self._lock:
+            self._counters["uploaded"] += 1
+            self._counters["bytes_uploaded"] += len(data)
+            self._recent.append((now, len(data)))
+
+    # ---------- observability ----------
+
+    def metrics(self):
+        now = time.monotonic()
+        with self._lock:
+            while self._recent and self._recent[0][0] < now - RATE_WINDOW_S:
+                self._recent.popleft()
+            recent_bytes = sum(size for _, size in self._recent)
+            return {
+                **self._counters,
+                "queue_depth": self._queue.qsize(),
+                "queue_max": self.max_queue,
+                "policy": self.policy,
+                "spill_bytes": self._spill_bytes,
+                "bytes_per_s": round(recent_bytes / RATE_WINDOW_S),
+                "last_error": self._last_error,
+            }
+
+    def close(self, timeout=None):
+        """Waits until the queue is empty (spilled files stay) and stops the workers."""
+        self._queue.join()
+        self._stop.set()
+        for worker in self._workers:
+            worker.join(timeout)